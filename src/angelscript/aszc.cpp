@@ -10,7 +10,11 @@
 #include <zc_sys.h>
 #include <zdefs.h>
 #include <zelda.h>
+#include <zscriptprofiler.h>
+#include "scriptCache.h"
+#include "scriptContext.h"
 #include "scriptData.h"
+#include "scriptJIT.h"
 #include "util.h"
 #include "scriptarray/scriptarray.h"
 #include "scriptstdstring/scriptstdstring.h"
@@ -29,6 +33,13 @@ static sprite* currentSprite;
 static enemy* currentEnemy;
 static item* currentItem;
 static weapon* currentWeapon;
+
+// Entity scripts borrow a context from here for each call.
+static ScriptContextPool contextPool;
+
+// Compiles scripts to native code where the platform supports it.
+static ScriptJIT scriptJIT;
+
 static sprite* getRealSprite();
 static enemy* getRealEnemy();
 static item* getRealItem();
@@ -80,11 +91,38 @@ static void fixConsFloat(fix* addr, float value)
     new(addr) fix(value);
 }
 
-static int fixComp(fix f1, fix f2)
+// AngelScript copies a value type passed by value to the heap before a
+// native call, so anything taking another fix takes it by reference instead.
+static fix fixAdd(const fix& f1, const fix& f2)
+{
+    return f1+f2;
+}
+
+static fix fixSub(const fix& f1, const fix& f2)
+{
+    return f1-f2;
+}
+
+static fix fixMul(const fix& f1, const fix& f2)
 {
-    if(f1<f2)
+    return f1*f2;
+}
+
+static fix fixDiv(const fix& f1, const fix& f2)
+{
+    return f1/f2;
+}
+
+static int fixEquals(const fix& f1, const fix& f2)
+{
+    return f1.v==f2.v;
+}
+
+static int fixComp(const fix& f1, const fix& f2)
+{
+    if(f1.v<f2.v)
         return -1;
-    if(f1>f2)
+    if(f1.v>f2.v)
         return 1;
     return 0;
 }
@@ -118,16 +156,16 @@ static void registerFix()
     
     // Arithmetic
     r = asEngine->RegisterObjectMethod("fix", "fix opNeg() const", asMETHODPR(fix, operator-, () const, fix), asCALL_THISCALL); Assert(r >= 0);
-    r = asEngine->RegisterObjectMethod("fix", "fix opAdd(fix) const", asFUNCTIONPR(operator+, (fix, fix), fix), asCALL_CDECL_OBJFIRST); Assert(r >= 0);
+    r = asEngine->RegisterObjectMethod("fix", "fix opAdd(const fix &in) const", asFUNCTION(fixAdd), asCALL_CDECL_OBJFIRST); Assert(r >= 0);
     r = asEngine->RegisterObjectMethod("fix", "fix opAdd(int) const", asFUNCTIONPR(operator+, (fix, int), fix), asCALL_CDECL_OBJFIRST); Assert(r >= 0);
     r = asEngine->RegisterObjectMethod("fix", "fix opAdd(float) const", asFUNCTIONPR(operator+, (fix, float), fix), asCALL_CDECL_OBJFIRST); Assert(r >= 0);
-    r = asEngine->RegisterObjectMethod("fix", "fix opSub(fix) const", asFUNCTIONPR(operator-, (fix, fix), fix), asCALL_CDECL_OBJFIRST); Assert(r >= 0);
+    r = asEngine->RegisterObjectMethod("fix", "fix opSub(const fix &in) const", asFUNCTION(fixSub), asCALL_CDECL_OBJFIRST); Assert(r >= 0);
     r = asEngine->RegisterObjectMethod("fix", "fix opSub(int) const", asFUNCTIONPR(operator-, (fix, int), fix), asCALL_CDECL_OBJFIRST); Assert(r >= 0);
     r = asEngine->RegisterObjectMethod("fix", "fix opSub(float) const", asFUNCTIONPR(operator-, (fix, float), fix), asCALL_CDECL_OBJFIRST); Assert(r >= 0);
-    r = asEngine->RegisterObjectMethod("fix", "fix opMul(fix) const", asFUNCTIONPR(operator*, (fix, fix), fix), asCALL_CDECL_OBJFIRST); Assert(r >= 0);
+    r = asEngine->RegisterObjectMethod("fix", "fix opMul(const fix &in) const", asFUNCTION(fixMul), asCALL_CDECL_OBJFIRST); Assert(r >= 0);
     r = asEngine->RegisterObjectMethod("fix", "fix opMul(int) const", asFUNCTIONPR(operator*, (fix, int), fix), asCALL_CDECL_OBJFIRST); Assert(r >= 0);
     r = asEngine->RegisterObjectMethod("fix", "fix opMul(float) const", asFUNCTIONPR(operator*, (fix, float), fix), asCALL_CDECL_OBJFIRST); Assert(r >= 0);
-    r = asEngine->RegisterObjectMethod("fix", "fix opDiv(fix) const", asFUNCTIONPR(operator/, (fix, fix), fix), asCALL_CDECL_OBJFIRST); Assert(r >= 0);
+    r = asEngine->RegisterObjectMethod("fix", "fix opDiv(const fix &in) const", asFUNCTION(fixDiv), asCALL_CDECL_OBJFIRST); Assert(r >= 0);
     r = asEngine->RegisterObjectMethod("fix", "fix opDiv(int) const", asFUNCTIONPR(operator/, (fix, int), fix), asCALL_CDECL_OBJFIRST); Assert(r >= 0);
     r = asEngine->RegisterObjectMethod("fix", "fix opDiv(float) const", asFUNCTIONPR(operator/, (fix, float), fix), asCALL_CDECL_OBJFIRST); Assert(r >= 0);
     r = asEngine->RegisterObjectMethod("fix", "fix opPostInc()", asMETHODPR(fix, operator++, (), fix&), asCALL_THISCALL); Assert(r >= 0);
@@ -144,10 +182,10 @@ static void registerFix()
     
     // Allegro's comparison operators return int, not bool. Not sure if
     // this might be a problem on platforms where they're not the same size.
-    r = asEngine->RegisterObjectMethod("fix", "int opEquals(const fix) const", asFUNCTIONPR(operator==, (fix, fix), int), asCALL_CDECL_OBJFIRST); Assert(r >= 0);
+    r = asEngine->RegisterObjectMethod("fix", "int opEquals(const fix &in) const", asFUNCTION(fixEquals), asCALL_CDECL_OBJFIRST); Assert(r >= 0);
     r = asEngine->RegisterObjectMethod("fix", "int opEquals(const int) const", asFUNCTIONPR(operator==, (fix, int), int), asCALL_CDECL_OBJFIRST); Assert(r >= 0);
     r = asEngine->RegisterObjectMethod("fix", "int opEquals(const float) const", asFUNCTIONPR(operator==, (fix, float), int), asCALL_CDECL_OBJFIRST); Assert(r >= 0);
-    r = asEngine->RegisterObjectMethod("fix", "int opCmp(const fix) const", asFUNCTION(fixComp), asCALL_CDECL_OBJFIRST); Assert(r >= 0);
+    r = asEngine->RegisterObjectMethod("fix", "int opCmp(const fix &in) const", asFUNCTION(fixComp), asCALL_CDECL_OBJFIRST); Assert(r >= 0);
     
     // Casts
     r = asEngine->RegisterObjectMethod("fix", "int opImplConv() const", asMETHODPR(fix, operator int, () const, int), asCALL_THISCALL); Assert(r >= 0);
@@ -488,7 +526,7 @@ void registerEnemy()
     r = asEngine->RegisterObjectProperty("__RealEnemy", "bool haslink", asOFFSET(ASEnemy, haslink)); Assert(r >= 0);
     
     r = asEngine->RegisterObjectMethod("__RealEnemy", "void leave_item()", asMETHOD(ASEnemy, leave_item), asCALL_THISCALL); Assert(r >= 0);
-    r = asEngine->RegisterObjectMethod("__RealEnemy", "bool canmove(int, fix, int, int, int, int, int)", asMETHODPR(ASEnemy, canmove, (int, fix, int, int, int, int, int), bool), asCALL_THISCALL); Assert(r >= 0);
+    r = asEngine->RegisterObjectMethod("__RealEnemy", "bool canmove(int, const fix &in, int, int, int, int, int)", asMETHOD(ASEnemy, scriptCanMove), asCALL_THISCALL); Assert(r >= 0);
     r = asEngine->RegisterObjectMethod("__RealEnemy", "void fireWeapon()", asMETHOD(ASEnemy, fireWeapon), asCALL_THISCALL); Assert(r >= 0);
     r = asEngine->RegisterObjectMethod("__RealEnemy", "bool isFiring() const", asMETHOD(ASEnemy, isFiring), asCALL_THISCALL); Assert(r >= 0);
     r = asEngine->RegisterObjectMethod("__RealEnemy", "void updateFiring()", asMETHOD(ASEnemy, updateFiring), asCALL_THISCALL); Assert(r >= 0);
@@ -554,10 +592,99 @@ void registerWeapon()
     r = asEngine->RegisterObjectMethod("__RealWeapon", "void adjustDraggedItem(int)", asMETHOD(weapon, adjustDraggedItem), asCALL_THISCALL); Assert(r >= 0);
 }
 
+// These should be moved into a .dat file eventually; there's no reason
+// to let users edit them. They might even be distributed as bytecode.
+static const char* scriptFiles[]=
+{
+    "angelscript/common.as",
+    
+    "angelscript/sprite.as",
+    "angelscript/link.as",
+    "angelscript/enemy.as",
+    "angelscript/weapon.as",
+    
+    "angelscript/aquamentus.as",
+    "angelscript/fairy.as",
+    "angelscript/fallingRock.as",
+    "angelscript/fire.as",
+    "angelscript/digdogger.as",
+    "angelscript/dodongo.as",
+    "angelscript/ganon.as",
+    "angelscript/ghini.as",
+    "angelscript/gleeok.as",
+    "angelscript/gohma.as",
+    "angelscript/guy.as",
+    "angelscript/item.as",
+    "angelscript/keese.as",
+    "angelscript/lanmola.as",
+    "angelscript/leever.as",
+    "angelscript/manhandla.as",
+    "angelscript/moldorm.as",
+    "angelscript/npc.as",
+    "angelscript/other.as",
+    "angelscript/patra.as",
+    "angelscript/patraBS.as",
+    "angelscript/peahat.as",
+    "angelscript/projectileShooter.as",
+    "angelscript/spinningTile.as",
+    "angelscript/tektite.as",
+    "angelscript/trapConstant.as",
+    "angelscript/trapLOS.as",
+    "angelscript/trigger.as",
+    "angelscript/walkflagInfo.as",
+    "angelscript/walkingEnemy.as",
+    "angelscript/wallMaster.as",
+    "angelscript/wizzrobe.as",
+    "angelscript/zora.as",
+    0
+};
+
+// Where the compiled scripts are kept between runs.
+static const char* scriptCacheFile="angelscript/scripts.cache";
+
+// Everything AngelScript allocates is counted so benchmarkWeaponScripts()
+// can report it. The size is kept in front of the block.
+static size_t asBytesInUse=0;
+static unsigned long asAllocations=0;
+
+union AllocHeader
+{
+    size_t size;
+    double align;
+    void* palign;
+};
+
+static void* countedAlloc(size_t size)
+{
+    AllocHeader* h=(AllocHeader*)malloc(sizeof(AllocHeader)+size);
+    if(!h)
+        return 0;
+    h->size=size;
+    asBytesInUse+=size;
+    asAllocations++;
+    return h+1;
+}
+
+static void countedFree(void* p)
+{
+    if(!p)
+        return;
+    AllocHeader* h=(AllocHeader*)p-1;
+    asBytesInUse-=h->size;
+    free(h);
+}
+
 void initializeAngelScript()
 {
+    asSetGlobalMemoryFunctions(countedAlloc, countedFree);
     asEngine=asCreateScriptEngine();
     asEngine->SetMessageCallback(asFUNCTION(messageCallback), 0, asCALL_CDECL);
+#ifdef ZC_SCRIPT_JIT
+    // The JitEntries are always in the bytecode, so the JIT can be turned on
+    // and off without rebuilding or invalidating the cache.
+    asEngine->SetEngineProperty(asEP_INCLUDE_JIT_INSTRUCTIONS, true);
+    asEngine->SetJITCompiler(&scriptJIT);
+#endif
     RegisterScriptArray(asEngine, true);
     RegisterStdString(asEngine);
     RegisterScriptMath(asEngine);
@@ -572,63 +699,37 @@ void initializeAngelScript()
     registerItem();
     registerWeapon();
     
-    // These should be moved into a .dat file eventually; there's no reason
-    // to let users edit them. They might even be distributed as bytecode.
-    CScriptBuilder builder;
-    builder.StartNewModule(asEngine, "everything");
-    
-    builder.AddSectionFromFile("angelscript/common.as");
-    
-    builder.AddSectionFromFile("angelscript/sprite.as");
-    builder.AddSectionFromFile("angelscript/link.as");
-    builder.AddSectionFromFile("angelscript/enemy.as");
-    builder.AddSectionFromFile("angelscript/weapon.as");
-    
-    builder.AddSectionFromFile("angelscript/aquamentus.as");
-    builder.AddSectionFromFile("angelscript/fairy.as");
-    builder.AddSectionFromFile("angelscript/fallingRock.as");
-    builder.AddSectionFromFile("angelscript/fire.as");
-    builder.AddSectionFromFile("angelscript/digdogger.as");
-    builder.AddSectionFromFile("angelscript/dodongo.as");
-    builder.AddSectionFromFile("angelscript/ganon.as");
-    builder.AddSectionFromFile("angelscript/ghini.as");
-    builder.AddSectionFromFile("angelscript/gleeok.as");
-    builder.AddSectionFromFile("angelscript/gohma.as");
-    builder.AddSectionFromFile("angelscript/guy.as");
-    builder.AddSectionFromFile("angelscript/item.as");
-    builder.AddSectionFromFile("angelscript/keese.as");
-    builder.AddSectionFromFile("angelscript/lanmola.as");
-    builder.AddSectionFromFile("angelscript/leever.as");
-    builder.AddSectionFromFile("angelscript/manhandla.as");
-    builder.AddSectionFromFile("angelscript/moldorm.as");
-    builder.AddSectionFromFile("angelscript/npc.as");
-    builder.AddSectionFromFile("angelscript/other.as");
-    builder.AddSectionFromFile("angelscript/patra.as");
-    builder.AddSectionFromFile("angelscript/patraBS.as");
-    builder.AddSectionFromFile("angelscript/peahat.as");
-    builder.AddSectionFromFile("angelscript/projectileShooter.as");
-    builder.AddSectionFromFile("angelscript/spinningTile.as");
-    builder.AddSectionFromFile("angelscript/tektite.as");
-    builder.AddSectionFromFile("angelscript/trapConstant.as");
-    builder.AddSectionFromFile("angelscript/trapLOS.as");
-    builder.AddSectionFromFile("angelscript/trigger.as");
-    builder.AddSectionFromFile("angelscript/walkflagInfo.as");
-    builder.AddSectionFromFile("angelscript/walkingEnemy.as");
-    builder.AddSectionFromFile("angelscript/wallMaster.as");
-    builder.AddSectionFromFile("angelscript/wizzrobe.as");
-    builder.AddSectionFromFile("angelscript/zora.as");
-
-    int buildResult = builder.BuildModule(); //if this fails zc will crash.
-	Assert(buildResult == 0);
-	if(buildResult != 0)
-	{
-		exit(1);
-	}
+    // Loading the bytecode saved last time skips the compiler entirely. If the
+    // scripts or the registered API have changed since, it's rebuilt.
+    uint64 cacheKey=hashScriptAPI(asEngine);
+    for(int i=0; scriptFiles[i]; i++)
+        cacheKey=hashScriptFile(scriptFiles[i], cacheKey);
+    
+    asIScriptModule* module=asEngine->GetModule("everything", asGM_ALWAYS_CREATE);
+    if(!loadScriptCache(module, scriptCacheFile, cacheKey))
+    {
+        CScriptBuilder builder;
+        builder.StartNewModule(asEngine, "everything");
+        for(int i=0; scriptFiles[i]; i++)
+            builder.AddSectionFromFile(scriptFiles[i]);
+        
+        int buildResult = builder.BuildModule(); //if this fails zc will crash.
+        Assert(buildResult == 0);
+        if(buildResult != 0)
+        {
+            exit(1);
+        }
+        
+        if(!saveScriptCache(builder.GetModule(), scriptCacheFile, cacheKey))
+            al_trace("Unable to write AngelScript cache %s\n", scriptCacheFile);
+    }
+    
+    contextPool.Init(asEngine, 4);
+    initScriptMethodTables(asEngine);
     
     // Create global Link
     currentSprite=&Link;
     assignSpriteScript(&Link, "LinkClass");
-    Link.scriptInit();
     /*
     asIScriptContext* context=asEngine->CreateContext();
     asIScriptModule *module=asEngine->GetModuleByIndex(0);
@@ -641,9 +742,186 @@ void initializeAngelScript()
 
 void shutDownAngelScript()
 {
+    contextPool.Destroy();
     asEngine->ShutDownAndRelease();
 }
 
+void setAngelScriptJIT(bool on)
+{
+    scriptJIT.setEnabled(on);
+}
+
+bool angelScriptJITEnabled()
+{
+#ifdef ZC_SCRIPT_JIT
+    return scriptJIT.isEnabled();
+#else
+    return false;
+#endif
+}
+
+void benchmarkWeaponScripts()
+{
+    const int numWeapons=250;
+    const int numFrames=60;
+    const double ticksPerMs=ZScriptProfiler::ticksPerSecond()/1000.0;
+    
+    // Kept out of Lwpns so nothing in the room reacts to them.
+    sprite_list weapons;
+    
+    size_t startBytes=asBytesInUse;
+    unsigned long startAllocations=asAllocations;
+    uint32 startContexts=contextPool.totalAllocatedContextCount;
+    unsigned long long start=ZScriptProfiler::now();
+    
+    for(int i=0; i<numWeapons; i++)
+        weapons.add(new weapon((fix)(16+(i%14)*16), (fix)(16+(i/14)*8), (fix)0,
+          wScript1, 0, 0, i%4, -1, -1));
+    
+    double spawnMs=(ZScriptProfiler::now()-start)/ticksPerMs;
+    size_t spawnBytes=asBytesInUse-startBytes;
+    unsigned long spawnAllocations=asAllocations-startAllocations;
+    uint32 spawnContexts=contextPool.totalAllocatedContextCount-startContexts;
+    
+    // Each frame, every weapon runs a script call as well as its usual
+    // update, so the contexts are exercised.
+    // They're all the same class, so one lookup does for all of them.
+    asIScriptFunction* getPower=weapons.spr(0)->getScriptData()->getFunction("int get_power() const");
+    double minMs=0, maxMs=0, totalMs=0;
+    for(int f=0; f<numFrames; f++)
+    {
+        start=ZScriptProfiler::now();
+        
+        for(int i=0; getPower && i<weapons.Count(); i++)
+        {
+            EntityScriptData* sd=weapons.spr(i)->getScriptData();
+            sd->runFunction(getPower);
+            sd->getLastResult<int>();
+        }
+        weapons.animate();
+        
+        double ms=(ZScriptProfiler::now()-start)/ticksPerMs;
+        totalMs+=ms;
+        if(f==0 || ms<minMs)
+            minMs=ms;
+        if(f==0 || ms>maxMs)
+            maxMs=ms;
+    }
+    
+    start=ZScriptProfiler::now();
+    weapons.clear();
+    double clearMs=(ZScriptProfiler::now()-start)/ticksPerMs;
+    
+    al_trace("Weapon script benchmark, %d weapons:\n", numWeapons);
+    al_trace("  spawn %.2fms, %lu AngelScript allocations, %lu bytes, %u new contexts\n",
+      spawnMs, spawnAllocations, (unsigned long)spawnBytes, spawnContexts);
+    al_trace("  %d frames: min %.3fms, avg %.3fms, max %.3fms\n",
+      numFrames, minMs, totalMs/numFrames, maxMs);
+    al_trace("  clear %.2fms, %u contexts in the pool\n",
+      clearMs, contextPool.totalAllocatedContextCount);
+}
+
+void benchmarkEnemyScripts()
+{
+    const int numEnemies=200;
+    const int numFrames=60;
+    const double ticksPerMs=ZScriptProfiler::ticksPerSecond()/1000.0;
+    
+    // One of each scripted family that doesn't need anything else set up.
+    static const struct { int family; const char* script; } kinds[]=
+    {
+        { eeWALK, "WalkingEnemy" }, { eeKEESE, "Keese" }, { eeTEK, "Tektite" },
+        { eePEAHAT, "Peahat" }, { eeLEV, "Leever" }, { eeGHINI, "Ghini" }
+    };
+    const int numKinds=sizeof(kinds)/sizeof(kinds[0]);
+    int ids[numKinds];
+    const char* scripts[numKinds];
+    int found=0;
+    for(int k=0; k<numKinds; k++)
+    {
+        for(int id=1; id<eMAXGUYS; id++)
+        {
+            if(guysbuf[id].family==kinds[k].family)
+            {
+                ids[found]=id;
+                scripts[found]=kinds[k].script;
+                found++;
+                break;
+            }
+        }
+    }
+    
+    if(found==0)
+    {
+        al_trace("Enemy script benchmark: no suitable enemies in this quest\n");
+        return;
+    }
+    
+    // Kept out of guys so nothing in the room reacts to them. They're never
+    // given attacks, so they don't fire anything either.
+    sprite_list enemies;
+    for(int i=0; i<numEnemies; i++)
+        enemies.add(new ASEnemy(scripts[i%found], (fix)(16+(i%14)*16),
+          (fix)(16+((i/14)%10)*16), ids[i%found], 0));
+    
+    BITMAP* scratch=create_bitmap_ex(8, 256, 224);
+    bool wasEnabled=angelScriptJITEnabled();
+    
+    // Let the scripts get past spawning first.
+    for(int f=0; f<10; f++)
+    {
+        enemies.animate();
+        enemies.draw(scratch, false);
+    }
+    
+    // VM and JIT frames are interleaved so anything else going on affects
+    // both the same.
+#ifdef ZC_SCRIPT_JIT
+    const int numModes=2;
+#else
+    const int numModes=1;
+#endif
+    double minMs[2]={ 0, 0 }, maxMs[2]={ 0, 0 }, totalMs[2]={ 0, 0 };
+    for(int f=0; f<numFrames; f++)
+    {
+        for(int mode=0; mode<numModes; mode++)
+        {
+            setAngelScriptJIT(mode==1);
+            unsigned long long start=ZScriptProfiler::now();
+            
+            enemies.animate();
+            enemies.draw(scratch, false);
+            
+            double ms=(ZScriptProfiler::now()-start)/ticksPerMs;
+            totalMs[mode]+=ms;
+            if(f==0 || ms<minMs[mode])
+                minMs[mode]=ms;
+            if(f==0 || ms>maxMs[mode])
+                maxMs[mode]=ms;
+        }
+    }
+    
+    setAngelScriptJIT(wasEnabled);
+    int remaining=enemies.Count();
+    enemies.clear();
+    destroy_bitmap(scratch);
+    
+    al_trace("Enemy script benchmark, %d enemies of %d kinds, %d left after %d frames:\n",
+      numEnemies, found, remaining, numFrames);
+    al_trace("       min       avg       max\n");
+    al_trace("  VM   %.3fms  %.3fms  %.3fms\n",
+      minMs[0], totalMs[0]/numFrames, maxMs[0]);
+#ifdef ZC_SCRIPT_JIT
+    al_trace("  JIT  %.3fms  %.3fms  %.3fms\n",
+      minMs[1], totalMs[1]/numFrames, maxMs[1]);
+    al_trace("  %u functions compiled, %u of %u instructions native\n",
+      scriptJIT.compiledFunctions(), scriptJIT.nativeInstructions,
+      scriptJIT.totalInstructions);
+#else
+    al_trace("  (no JIT on this platform)\n");
+#endif
+}
+
 // This is kind of ugly, but it'll do...
 static sprite* getRealSprite()
 {
@@ -677,7 +955,7 @@ static void assignSpriteScript(sprite* spr, const char* scriptName)
     asIScriptModule *module=asEngine->GetModuleByIndex(0);
     asIObjectType* objType=module->GetObjectTypeByName(scriptName);
     asIScriptObject* scriptObj=(asIScriptObject*)asEngine->CreateScriptObject(objType);
-    spr->setScriptData(new EntityScriptData(scriptObj, asEngine->CreateContext()));
+    spr->setScriptData(new EntityScriptData(scriptObj, &contextPool));
 }
 
 void assignEnemyScript(enemy* en, const char* scriptName)
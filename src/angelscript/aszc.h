@@ -11,4 +11,17 @@ void assignEnemyScript(enemy* en, const char* scriptName);
 void assignItemScript(item* it, const char* scriptName);
 void assignWeaponScript(weapon* w, const char* scriptName);
 
+// Spawns a room's worth of weapons and traces how long they took to create
+// and update and how much AngelScript allocated for them.
+void benchmarkWeaponScripts();
+
+// Turns native code for scripts on or off. Only x86-64 Linux has it; it's
+// always off elsewhere.
+void setAngelScriptJIT(bool on);
+bool angelScriptJITEnabled();
+
+// Runs a room's worth of script-driven enemies and traces how long frames
+// take in the VM and with the JIT.
+void benchmarkEnemyScripts();
+
 #endif
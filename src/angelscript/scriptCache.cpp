@@ -0,0 +1,245 @@
+#include <angelscript.h>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "scriptCache.h"
+
+// Bump this if the file layout changes.
+static const char cacheMagic[8]={ 'Z', 'C', 'A', 'S', 'B', 'C', '0', '1' };
+
+// 64-bit FNV-1a
+static const uint64 hashStart=14695981039346656037ULL;
+
+static uint64 hashBytes(const void* data, size_t size, uint64 hash)
+{
+    const unsigned char* bytes=(const unsigned char*)data;
+    for(size_t i=0; i<size; i++)
+        hash=(hash^bytes[i])*1099511628211ULL;
+    return hash;
+}
+
+// The terminator is included so "ab","c" and "a","bc" hash differently.
+static uint64 hashString(const char* str, uint64 hash)
+{
+    if(!str)
+        str="";
+    return hashBytes(str, strlen(str)+1, hash);
+}
+
+static uint64 hashInt(int value, uint64 hash)
+{
+    return hashBytes(&value, sizeof(value), hash);
+}
+
+static uint64 hashFunction(asIScriptFunction* func, uint64 hash)
+{
+    if(!func)
+        return hashString("(null)", hash);
+    hash=hashString(func->GetDeclaration(true, true, true), hash);
+    return hashInt(func->GetFuncType(), hash);
+}
+
+uint64 hashScriptAPI(asIScriptEngine* engine)
+{
+    uint64 hash=hashStart;
+    hash=hashString(ANGELSCRIPT_VERSION_STRING, hash);
+    hash=hashString(asGetLibraryOptions(), hash);
+    hash=hashInt(sizeof(void*), hash);
+    hash=hashInt((int)engine->GetEngineProperty(asEP_INCLUDE_JIT_INSTRUCTIONS), hash);
+
+    for(asUINT i=0; i<engine->GetObjectTypeCount(); i++)
+    {
+        asIObjectType* type=engine->GetObjectTypeByIndex(i);
+        hash=hashString(type->GetNamespace(), hash);
+        hash=hashString(type->GetName(), hash);
+        hash=hashInt(type->GetFlags(), hash);
+        hash=hashInt(type->GetSize(), hash);
+
+        // Property offsets are compiled into the bytecode, so a class that's
+        // changed layout has to invalidate the cache.
+        for(asUINT j=0; j<type->GetPropertyCount(); j++)
+        {
+            int offset=0;
+            type->GetProperty(j, 0, 0, 0, 0, &offset);
+            hash=hashString(type->GetPropertyDeclaration(j, true), hash);
+            hash=hashInt(offset, hash);
+        }
+
+        for(asUINT j=0; j<type->GetBehaviourCount(); j++)
+        {
+            asEBehaviours beh;
+            asIScriptFunction* func=type->GetBehaviourByIndex(j, &beh);
+            hash=hashInt(beh, hash);
+            hash=hashFunction(func, hash);
+        }
+
+        for(asUINT j=0; j<type->GetFactoryCount(); j++)
+            hash=hashFunction(type->GetFactoryByIndex(j), hash);
+
+        for(asUINT j=0; j<type->GetMethodCount(); j++)
+            hash=hashFunction(type->GetMethodByIndex(j), hash);
+    }
+
+    for(asUINT i=0; i<engine->GetGlobalFunctionCount(); i++)
+        hash=hashFunction(engine->GetGlobalFunctionByIndex(i), hash);
+
+    for(asUINT i=0; i<engine->GetGlobalPropertyCount(); i++)
+    {
+        const char* name;
+        const char* nameSpace;
+        int typeId;
+        bool isConst;
+        engine->GetGlobalPropertyByIndex(i, &name, &nameSpace, &typeId, &isConst);
+        hash=hashString(nameSpace, hash);
+        hash=hashString(name, hash);
+        hash=hashString(engine->GetTypeDeclaration(typeId, true), hash);
+        hash=hashInt(isConst, hash);
+    }
+
+    for(asUINT i=0; i<engine->GetFuncdefCount(); i++)
+        hash=hashFunction(engine->GetFuncdefByIndex(i), hash);
+
+    for(asUINT i=0; i<engine->GetEnumCount(); i++)
+    {
+        int typeId;
+        const char* nameSpace;
+        hash=hashString(engine->GetEnumByIndex(i, &typeId, &nameSpace), hash);
+        hash=hashString(nameSpace, hash);
+        for(int j=0; j<engine->GetEnumValueCount(typeId); j++)
+        {
+            int value;
+            hash=hashString(engine->GetEnumValueByIndex(typeId, j, &value), hash);
+            hash=hashInt(value, hash);
+        }
+    }
+
+    for(asUINT i=0; i<engine->GetTypedefCount(); i++)
+    {
+        int typeId;
+        const char* nameSpace;
+        hash=hashString(engine->GetTypedefByIndex(i, &typeId, &nameSpace), hash);
+        hash=hashString(nameSpace, hash);
+        hash=hashString(engine->GetTypeDeclaration(typeId, true), hash);
+    }
+
+    return hash;
+}
+
+static bool readWholeFile(const char* filename, std::vector<char>& out)
+{
+    FILE* f=fopen(filename, "rb");
+    if(!f)
+        return false;
+
+    fseek(f, 0, SEEK_END);
+    long size=ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    out.resize(size>0 ? size : 0);
+    bool ok=size>=0 && (size==0 || fread(&out[0], 1, size, f)==(size_t)size);
+    fclose(f);
+    return ok;
+}
+
+uint64 hashScriptFile(const char* filename, uint64 hash)
+{
+    std::vector<char> contents;
+    hash=hashString(filename, hash);
+
+    // A missing file still changes the key, so it'll be noticed when it
+    // comes back.
+    if(!readWholeFile(filename, contents))
+        return hashString("(missing)", hash);
+
+    hash=hashInt((int)contents.size(), hash);
+    return contents.empty() ? hash : hashBytes(&contents[0], contents.size(), hash);
+}
+
+// Reading past the end gives zeroes; LoadByteCode() will fail on its own if
+// the data's no good.
+class MemoryStream: public asIBinaryStream
+{
+public:
+    MemoryStream(): readPos(0) {}
+
+    void Write(const void* ptr, asUINT size)
+    {
+        const char* bytes=(const char*)ptr;
+        data.insert(data.end(), bytes, bytes+size);
+    }
+
+    void Read(void* ptr, asUINT size)
+    {
+        size_t available=readPos<data.size() ? data.size()-readPos : 0;
+        size_t toCopy=size<available ? size : available;
+        if(toCopy>0)
+            memcpy(ptr, &data[readPos], toCopy);
+        if(toCopy<size)
+            memset((char*)ptr+toCopy, 0, size-toCopy);
+        readPos+=size;
+    }
+
+    std::vector<char> data;
+    size_t readPos;
+};
+
+// The file is the magic number, the key, the bytecode's size and hash,
+// and then the bytecode as SaveByteCode() writes it.
+struct CacheHeader
+{
+    char magic[8];
+    uint64 key;
+    uint64 size;
+    uint64 dataHash;
+};
+
+bool loadScriptCache(asIScriptModule* module, const char* filename, uint64 key)
+{
+    std::vector<char> contents;
+    if(!readWholeFile(filename, contents) || contents.size()<sizeof(CacheHeader))
+        return false;
+
+    CacheHeader header;
+    memcpy(&header, &contents[0], sizeof(header));
+    if(memcmp(header.magic, cacheMagic, sizeof(cacheMagic))!=0 || header.key!=key)
+        return false;
+
+    // Check the bytecode's intact before letting AngelScript at it; a
+    // truncated file isn't always caught by LoadByteCode().
+    if(header.size!=contents.size()-sizeof(header) || header.size==0)
+        return false;
+
+    MemoryStream stream;
+    stream.data.assign(contents.begin()+sizeof(header), contents.end());
+    if(hashBytes(&stream.data[0], stream.data.size(), hashStart)!=header.dataHash)
+        return false;
+
+    return module->LoadByteCode(&stream)>=0;
+}
+
+bool saveScriptCache(asIScriptModule* module, const char* filename, uint64 key)
+{
+    MemoryStream stream;
+    if(module->SaveByteCode(&stream)<0 || stream.data.empty())
+        return false;
+
+    CacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+    header.key=key;
+    header.size=stream.data.size();
+    header.dataHash=hashBytes(&stream.data[0], stream.data.size(), hashStart);
+
+    FILE* f=fopen(filename, "wb");
+    if(!f)
+        return false;
+
+    bool ok=fwrite(&header, sizeof(header), 1, f)==1 &&
+      fwrite(&stream.data[0], 1, stream.data.size(), f)==stream.data.size();
+    ok=fclose(f)==0 && ok;
+
+    // Don't leave a partial file to be read next time.
+    if(!ok)
+        remove(filename);
+    return ok;
+}
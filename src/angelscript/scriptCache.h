@@ -0,0 +1,25 @@
+#ifndef _ZC_ANGELSCRIPT_SCRIPTCACHE_H_
+#define _ZC_ANGELSCRIPT_SCRIPTCACHE_H_
+
+#include "config.h"
+class asIScriptEngine;
+class asIScriptModule;
+
+// Compiled bytecode for a module, saved so later runs can load it instead of
+// compiling the scripts again. The cache is keyed by a hash of everything that
+// went into it; if the key doesn't match, it's ignored.
+
+// Hashes the registered API and the AngelScript build. Scripts are
+// added to it with hashScriptFile().
+uint64 hashScriptAPI(asIScriptEngine* engine);
+
+// Adds a script file's name and contents to the hash.
+uint64 hashScriptFile(const char* filename, uint64 hash);
+
+// Loads the cache into the module if it was made with the same key.
+bool loadScriptCache(asIScriptModule* module, const char* filename, uint64 key);
+
+// Writes the module's bytecode to the cache.
+bool saveScriptCache(asIScriptModule* module, const char* filename, uint64 key);
+
+#endif
@@ -26,7 +26,14 @@ asIScriptContext* ScriptContextPool::AquireContext()
 void ScriptContextPool::ReleaseContext(asIScriptContext* ptr)
 {
 	Assert(ptr);
-	Assert(contextCount < MAX_SCRIPT_CONTEXTS);
+
+	if(contextCount == MAX_SCRIPT_CONTEXTS)
+	{
+		// The pool's full; this one was only needed for a burst of nested calls.
+		totalAllocatedContextCount--;
+		ptr->Release();
+		return;
+	}
 
 	ptr->Unprepare();
 	contexts[contextCount++] = ptr;
@@ -41,6 +48,7 @@ void ScriptContextPool::ReleaseAllUnusedContexts()
 	}
 
 	totalAllocatedContextCount -= contextCount;
+	contextCount = 0;
 }
 
 
@@ -51,18 +59,21 @@ void ScriptContextPool::Init(asIScriptEngine* engine, uint32 initialCapacity)
 	pEngine = engine;
 	reusableContext = engine->CreateContext();
 
+	if(initialCapacity > MAX_SCRIPT_CONTEXTS)
+		initialCapacity = MAX_SCRIPT_CONTEXTS;
+
 	for(uint32 i(0); i < initialCapacity; ++i)
-	{
 		contexts[i] = engine->CreateContext();
-		contextCount = initialCapacity;
-		totalAllocatedContextCount = initialCapacity;
-	}
+
+	contextCount = initialCapacity;
+	totalAllocatedContextCount = initialCapacity;
 }
 
 
 void ScriptContextPool::Destroy()
 {
 	reusableContext->Release();
+	reusableContext = 0;
 	ReleaseAllUnusedContexts();
 
 	// This will trigger if any contexts were leaked or were not returned properly.
@@ -1,14 +1,62 @@
 #include "scriptData.h"
+#include <cstring>
 
-EntityScriptData::EntityScriptData(asIScriptObject* o, asIScriptContext* c):
+// Must match the order of ScriptMethod.
+static const char* methodDecls[smNumMethods]=
+{
+    "bool Update(int)",
+    "void Draw()",
+    "void Draw2()",
+    "void DrawShadow()",
+    "int takehit(weapon@)",
+    "bool Hit(weapon@)",
+    "void break_shield()",
+    "void eatlink()",
+    
+    "int Update()",
+    "void Drown()",
+    "int weaponattackpower()",
+    "void positionSword(weapon@ w, int itemid)",
+    "void checkstab()",
+    "bool sideviewhammerpound()"
+};
+
+// The key the tables are stored under in each type's user data.
+static const asPWORD methodTableUserData=0x5A43; // 'ZC'
+
+static void freeMethodTable(asIObjectType* type)
+{
+    delete[] (asIScriptFunction**)type->GetUserData(methodTableUserData);
+}
+
+void initScriptMethodTables(asIScriptEngine* engine)
+{
+    engine->SetObjectTypeUserDataCleanupCallback(freeMethodTable, methodTableUserData);
+}
+
+static asIScriptFunction** getMethodTable(asIObjectType* type)
+{
+    asIScriptFunction** table=(asIScriptFunction**)type->GetUserData(methodTableUserData);
+    if(!table)
+    {
+        table=new asIScriptFunction*[smNumMethods];
+        for(int i=0; i<smNumMethods; i++)
+            table[i]=type->GetMethodByDecl(methodDecls[i]);
+        type->SetUserData(table, methodTableUserData);
+    }
+    return table;
+}
+
+EntityScriptData::EntityScriptData(asIScriptObject* o, ScriptContextPool* p):
     object(o),
-    context(c)
+    pool(p),
+    methods(getMethodTable(o->GetObjectType())),
+    lastResult(0)
 {
 }
 
 EntityScriptData::~EntityScriptData()
 {
-    context->Release();
     object->Release();
 }
 
@@ -19,7 +67,27 @@ asIScriptFunction* EntityScriptData::getFunction(const char* decl)
 
 void EntityScriptData::runFunction(asIScriptFunction* func)
 {
+    execute(prepare(func));
+}
+
+asIScriptContext* EntityScriptData::prepare(asIScriptFunction* func)
+{
+    asIScriptContext* context=pool->AquireContext();
     context->Prepare(func);
     context->SetObject(object);
-    context->Execute();
+    return context;
+}
+
+void EntityScriptData::execute(asIScriptContext* context)
+{
+    lastResult=0;
+    if(context->Execute()==asEXECUTION_FINISHED)
+    {
+        // Zero for void and anything that isn't a primitive.
+        int size=pool->pEngine->GetSizeOfPrimitiveType(context->GetFunction()->GetReturnTypeId());
+        void* ret=context->GetAddressOfReturnValue();
+        if(ret && size>0 && size<=(int)sizeof(lastResult))
+            memcpy(&lastResult, ret, size);
+    }
+    pool->ReleaseContext(context);
 }
@@ -2,19 +2,50 @@
 #define _ZC_ANGELSCRIPT_SCRIPTDATA_H_
 
 #include <angelscript.h>
+#include "scriptContext.h"
 
+// The methods the engine calls on scripts. Each script class's are looked up
+// once, the first time an object of that class is made, and kept with the
+// type; after that, finding one is just an array lookup.
+enum ScriptMethod
+{
+    // Enemies
+    smUpdate, smDraw, smDraw2, smDrawShadow, smTakeHit, smHit, smBreakShield,
+    smEatLink,
+    
+    // Link
+    smLinkUpdate, smDrown, smWeaponAttackPower, smPositionSword, smCheckStab,
+    smSideviewHammerPound,
+    
+    smNumMethods
+};
+
+// Sets the engine up to free the method tables along with their types.
+void initScriptMethodTables(asIScriptEngine* engine);
 
-// The script data and context.
+
+// The script data.
 // This class was created in anticipation of greater complexity.
 // It doesn't do much at the moment.
+//
+// Contexts are borrowed from the pool for each call rather than kept by
+// every entity, so only as many exist as there are calls running at once.
+// Nothing suspends yet; a script that does will have to keep its context
+// until it's resumed.
 class EntityScriptData
 {
 public:
-    EntityScriptData(asIScriptObject* object, asIScriptContext* context);
+    EntityScriptData(asIScriptObject* object, ScriptContextPool* pool);
     ~EntityScriptData();
     
     asIScriptFunction* getFunction(const char* decl);
     
+    // Returns null if the script doesn't have the method.
+    inline asIScriptFunction* getMethod(ScriptMethod method) const
+    {
+        return methods[method];
+    }
+    
     void runFunction(asIScriptFunction* func);
     
     // I'm not entirely certain this is safe in case of type mismatches
@@ -23,26 +54,26 @@ public:
     template<typename T>
     void runFunction(asIScriptFunction* func, T t)
     {
-        context->Prepare(func);
-        context->SetObject(object);
-        setArg(0, t);
-        context->Execute();
+        asIScriptContext* context=prepare(func);
+        setArg(context, 0, t);
+        execute(context);
     }
     
     template<typename T, typename U>
     void runFunction(asIScriptFunction* func, T t, U u)
     {
-        context->Prepare(func);
-        context->SetObject(object);
-        setArg(0, t);
-        setArg(1, u);
-        context->Execute();
+        asIScriptContext* context=prepare(func);
+        setArg(context, 0, t);
+        setArg(context, 1, u);
+        execute(context);
     }
     
+    // Only primitive return values are kept once the context's gone back
+    // to the pool.
     template<typename T>
     inline T getLastResult() const
     {
-        return *reinterpret_cast<T*>(context->GetAddressOfReturnValue());
+        return *reinterpret_cast<const T*>(&lastResult);
     }
     
     inline asIScriptObject* getObject()
@@ -52,14 +83,19 @@ public:
     
 private:
     asIScriptObject* object;
-    asIScriptContext* context;
+    ScriptContextPool* pool;
+    asIScriptFunction** methods;
+    asQWORD lastResult;
+    
+    asIScriptContext* prepare(asIScriptFunction* func);
+    void execute(asIScriptContext* context);
     
-    inline void setArg(int arg, int val)
+    inline void setArg(asIScriptContext* context, int arg, int val)
     {
         context->SetArgDWord(arg, val);
     }
     
-    inline void setArg(int arg, asIScriptObject* val)
+    inline void setArg(asIScriptContext* context, int arg, asIScriptObject* val)
     {
         context->SetArgObject(arg, val);
     }
@@ -0,0 +1,1077 @@
+#include "scriptJIT.h"
+#include <cstddef>
+#include <cstring>
+
+#ifdef ZC_SCRIPT_JIT
+#include <sys/mman.h>
+#include "angelscript/as_config.h"
+#include "angelscript/as_callfunc.h"
+#include "angelscript/as_context.h"
+#endif
+
+static const size_t codeBlockSize=64*1024;
+
+// Going into native code and back out costs about as much as a couple of
+// instructions in the VM, so shorter stretches aren't entered.
+static const asUINT minNativeRun=2;
+
+ScriptJIT::ScriptJIT():
+    totalInstructions(0),
+    nativeInstructions(0),
+    blockUsed(0),
+    enabled(true)
+{
+}
+
+ScriptJIT::~ScriptJIT()
+{
+#ifdef ZC_SCRIPT_JIT
+    for(size_t i=0; i<blocks.size(); i++)
+        munmap(blocks[i].first, blocks[i].second);
+#endif
+}
+
+void ScriptJIT::setEntryPoints(std::vector<EntryPoint>& entries, bool on)
+{
+    for(size_t i=0; i<entries.size(); i++)
+        *(asPWORD*)(entries[i].bytecode+1)=on ? entries[i].address : 0;
+}
+
+void ScriptJIT::setEnabled(bool on)
+{
+    if(on==enabled)
+        return;
+    enabled=on;
+
+    std::map<asJITFunction, std::vector<EntryPoint> >::iterator it;
+    for(it=functions.begin(); it!=functions.end(); ++it)
+        setEntryPoints(it->second, on);
+}
+
+void ScriptJIT::ReleaseJITFunction(asJITFunction func)
+{
+    // The code stays where it is until the JIT's destroyed.
+    functions.erase(func);
+}
+
+#ifndef ZC_SCRIPT_JIT
+
+unsigned char* ScriptJIT::allocateCode(size_t)
+{
+    return 0;
+}
+
+bool ScriptJIT::setCodeWritable(bool)
+{
+    return false;
+}
+
+int ScriptJIT::CompileFunction(asIScriptFunction*, asJITFunction*)
+{
+    return asNOT_SUPPORTED;
+}
+
+#else
+
+// A block is only ever writable or executable, not both. New blocks start
+// out writable; setCodeWritable(false) makes them executable once the code's
+// copied in.
+unsigned char* ScriptJIT::allocateCode(size_t size)
+{
+    size=(size+15)&~(size_t)15;
+    if(blocks.empty() || blockUsed+size>blocks.back().second)
+    {
+        size_t blockSize=size>codeBlockSize ? size : codeBlockSize;
+        void* mem=mmap(0, blockSize, PROT_READ|PROT_WRITE,
+          MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+        if(mem==MAP_FAILED)
+            return 0;
+        blocks.push_back(std::make_pair((unsigned char*)mem, blockSize));
+        blockUsed=0;
+    }
+    else if(!setCodeWritable(true))
+        return 0;
+
+    unsigned char* ret=blocks.back().first+blockUsed;
+    blockUsed+=size;
+    return ret;
+}
+
+bool ScriptJIT::setCodeWritable(bool writable)
+{
+    int prot=writable ? PROT_READ|PROT_WRITE : PROT_READ|PROT_EXEC;
+    return mprotect(blocks.back().first, blocks.back().second, prot)==0;
+}
+
+// In the generated code, rbx holds the asSVMRegisters, r12 the frame
+// pointer and r13 the stack pointer. rax, rcx, rdx, xmm0 and xmm1 are
+// scratch. The value register stays in asSVMRegisters.
+enum
+{
+    RAX=0, RCX=1, RDX=2, RBX=3, RSP=4, RBP=5, RSI=6, RDI=7,
+    R12=12, R13=13
+};
+
+// Condition codes, as in jcc and setcc
+enum
+{
+    ccB=0x2, ccAE=0x3, ccE=0x4, ccNE=0x5, ccA=0x7,
+    ccP=0xA, ccL=0xC, ccGE=0xD, ccLE=0xE, ccG=0xF
+};
+
+// Opcodes of more than one byte are written high byte first, so 0x0FAF is
+// 0F AF. A prefix (66, F2, F3) goes before the REX byte.
+class CodeWriter
+{
+public:
+    std::vector<unsigned char> code;
+
+    size_t pos() const { return code.size(); }
+
+    void byte(int b)
+    {
+        code.push_back((unsigned char)b);
+    }
+
+    void dword(uint32 d)
+    {
+        for(int i=0; i<4; i++)
+            byte(d>>(i*8));
+    }
+
+    void qword(uint64 q)
+    {
+        dword((uint32)q);
+        dword((uint32)(q>>32));
+    }
+
+    void patch32(size_t at, int value)
+    {
+        memcpy(&code[at], &value, 4);
+    }
+
+    // Instruction with a register and a memory operand, [base+disp]
+    void rm(int prefix, bool wide, int opcode, int reg, int base, int disp)
+    {
+        opStart(prefix, wide, opcode, reg, base);
+        int mod=(disp==0 && (base&7)!=RBP) ? 0 : (disp>=-128 && disp<=127) ? 1 : 2;
+        byte((mod<<6)|((reg&7)<<3)|(base&7));
+        if((base&7)==RSP)
+            byte(0x24);
+        if(mod==1)
+            byte(disp);
+        else if(mod==2)
+            dword(disp);
+    }
+
+    // Instruction with two register operands
+    void rr(int prefix, bool wide, int opcode, int reg, int rmReg)
+    {
+        opStart(prefix, wide, opcode, reg, rmReg);
+        byte(0xC0|((reg&7)<<3)|(rmReg&7));
+    }
+
+    void movImm64(int reg, uint64 value)
+    {
+        byte(0x48|(reg>>3));
+        byte(0xB8|(reg&7));
+        qword(value);
+    }
+
+    void movImm32(int reg, uint32 value)
+    {
+        byte(0xB8|reg);
+        dword(value);
+    }
+
+    // Moves r13 by a number of dwords
+    void moveStack(int dwords)
+    {
+        rm(0, true, 0x8D, R13, R13, dwords*4);
+    }
+
+    // Returns where the offset goes, for patch32()
+    size_t jump()
+    {
+        byte(0xE9);
+        dword(0);
+        return pos()-4;
+    }
+
+    size_t jumpIf(int cc)
+    {
+        byte(0x0F);
+        byte(0x80|cc);
+        dword(0);
+        return pos()-4;
+    }
+
+    void jumpTo(size_t target)
+    {
+        size_t at=jump();
+        patch32(at, (int)(target-pos()));
+    }
+
+    // Short jump past the next 'skip' bytes
+    void skipIf(int cc, int skip)
+    {
+        byte(0x70|cc);
+        byte(skip);
+    }
+
+    // setcc to al, cl or dl
+    void setIf(int cc, int reg)
+    {
+        byte(0x0F);
+        byte(0x90|cc);
+        byte(0xC0|reg);
+    }
+
+private:
+    void opStart(int prefix, bool wide, int opcode, int reg, int base)
+    {
+        if(prefix)
+            byte(prefix);
+        int rex=0x40|(wide ? 8 : 0)|((reg>>3)<<2)|(base>>3);
+        if(rex!=0x40)
+            byte(rex);
+        if(opcode>0xFF)
+            byte(opcode>>8);
+        byte(opcode);
+    }
+};
+
+// Called from native code for CALLSYS, doing what the VM would. Returns
+// the new stack pointer. This needs AngelScript's internals, so it has to
+// be built against the same version as the library.
+static asDWORD* callSystemFunction(asSVMRegisters* regs, asDWORD* sp, asDWORD* pp)
+{
+    asCContext* ctx=static_cast<asCContext*>(regs->ctx);
+    regs->programPointer=pp;
+    regs->stackPointer=sp;
+    sp+=CallSystemFunction(asBC_INTARG(pp), ctx);
+    if(regs->doProcessSuspend && ctx->m_doSuspend)
+        ctx->m_status=asEXECUTION_SUSPENDED;
+    return sp;
+}
+
+// Offsets in asSVMRegisters
+static const int regPP=offsetof(asSVMRegisters, programPointer);
+static const int regSP=offsetof(asSVMRegisters, stackPointer);
+static const int regFP=offsetof(asSVMRegisters, stackFramePointer);
+static const int regValue=offsetof(asSVMRegisters, valueRegister);
+static const int regSuspend=offsetof(asSVMRegisters, doProcessSuspend);
+
+// Translates one function. Every instruction gets a label, so jumps can go
+// anywhere; the ones that aren't supported go back to the VM from there.
+class FunctionCompiler
+{
+public:
+    FunctionCompiler(asDWORD* bytecode, asUINT size):
+        bc(bytecode),
+        length(size),
+        labels(size, 0),
+        native(size, false),
+        instructions(0),
+        nativeCount(0)
+    {
+    }
+
+    void compile();
+
+    // How many instructions in a row from i are native, not counting
+    // JitEntries.
+    asUINT nativeRun(asUINT i)
+    {
+        asUINT count=0;
+        while(i<length && native[i])
+        {
+            asEBCInstr op=asEBCInstr(*(asBYTE*)(bc+i));
+            if(op!=asBC_JitEntry)
+                count++;
+            i+=asBCTypeSize[asBCInfo[op].type];
+        }
+        return count;
+    }
+
+    asDWORD* bc;
+    asUINT length;
+    CodeWriter out;
+    std::vector<size_t> labels;
+    std::vector<bool> native;
+    uint32 instructions;
+    uint32 nativeCount;
+
+private:
+    size_t exitLabel;
+    std::vector<std::pair<size_t, asUINT> > jumps;
+
+    bool translate(asUINT i);
+
+    // Variables are addressed in dwords below the frame pointer.
+    static int var(short arg) { return -arg*4; }
+
+    // The asBC_ argument macros need a pointer, not an expression.
+    asDWORD* at(asUINT i) { return bc+i; }
+
+    short swordArg0(asUINT i) { return asBC_SWORDARG0(at(i)); }
+    short swordArg1(asUINT i) { return asBC_SWORDARG1(at(i)); }
+    short swordArg2(asUINT i) { return asBC_SWORDARG2(at(i)); }
+    asDWORD dwordArg(asUINT i) { return asBC_DWORDARG(at(i)); }
+    int intArg(asUINT i) { return asBC_INTARG(at(i)); }
+    asQWORD qwordArg(asUINT i) { return asBC_QWORDARG(at(i)); }
+    asPWORD ptrArg(asUINT i) { return asBC_PTRARG(at(i)); }
+
+    void exitAt(asUINT i)
+    {
+        out.movImm64(RAX, (uint64)(asPWORD)(bc+i));
+        out.jumpTo(exitLabel);
+    }
+
+    // Goes back to the VM at instruction i if the condition's true, so the
+    // VM can raise the exception.
+    void exitIf(int cc, asUINT i)
+    {
+        out.skipIf(cc^1, 15);
+        exitAt(i);
+    }
+
+    void branch(int cc, asUINT i)
+    {
+        size_t at=cc<0 ? out.jump() : out.jumpIf(cc);
+        jumps.push_back(std::make_pair(at, (asUINT)(i+2+intArg(i))));
+    }
+
+    void compareValue(bool lowByte)
+    {
+        if(lowByte)
+            out.rm(0, false, 0x80, 7, RBX, regValue);
+        else
+            out.rm(0, false, 0x83, 7, RBX, regValue);
+        out.byte(0);
+    }
+
+    // TZ and friends: the value register becomes 1 or 0.
+    void test(int cc)
+    {
+        out.rr(0, false, 0x33, RAX, RAX);
+        compareValue(false);
+        out.setIf(cc, RAX);
+        out.rm(0, true, 0x89, RAX, RBX, regValue);
+    }
+
+    // eax holds the first operand and the flags are set from comparing it
+    // with the second. The value register gets -1, 0 or 1.
+    void storeComparison(bool isSigned)
+    {
+        out.setIf(isSigned ? ccG : ccA, RCX);
+        out.setIf(isSigned ? ccL : ccB, RDX);
+        out.rr(0, false, 0x0FB6, RAX, RCX);
+        out.rr(0, false, 0x0FB6, RDX, RDX);
+        out.rr(0, false, 0x2B, RAX, RDX);
+        out.rm(0, false, 0x89, RAX, RBX, regValue);
+    }
+
+    // The same after ucomiss or ucomisd. NaN compares as greater, as in
+    // the VM.
+    void storeFloatComparison()
+    {
+        out.movImm32(RAX, 1);
+        out.skipIf(ccP, 16);
+        out.movImm32(RCX, 0);
+        out.rr(0, false, 0x0F44, RAX, RCX);
+        out.movImm32(RCX, (uint32)-1);
+        out.rr(0, false, 0x0F42, RAX, RCX);
+        out.rm(0, false, 0x89, RAX, RBX, regValue);
+    }
+
+    // a = b op c, on ints
+    void intOp(int opcode, asUINT i)
+    {
+        out.rm(0, false, 0x8B, RAX, R12, var(swordArg1(i)));
+        out.rm(0, false, opcode, RAX, R12, var(swordArg2(i)));
+        out.rm(0, false, 0x89, RAX, R12, var(swordArg0(i)));
+    }
+
+    void shiftOp(int ext, asUINT i)
+    {
+        out.rm(0, false, 0x8B, RAX, R12, var(swordArg1(i)));
+        out.rm(0, false, 0x8B, RCX, R12, var(swordArg2(i)));
+        out.rr(0, false, 0xD3, ext, RAX);
+        out.rm(0, false, 0x89, RAX, R12, var(swordArg0(i)));
+    }
+
+    // a = b op c with SSE; prefix is F3 for floats and F2 for doubles.
+    void floatOp(int prefix, int opcode, asUINT i)
+    {
+        out.rm(prefix, false, 0x0F10, 0, R12, var(swordArg1(i)));
+        out.rm(prefix, false, opcode, 0, R12, var(swordArg2(i)));
+        out.rm(prefix, false, 0x0F11, 0, R12, var(swordArg0(i)));
+    }
+
+    // a = b op immediate float
+    void floatImmOp(int opcode, asUINT i)
+    {
+        out.movImm32(RAX, dwordArg(i+1));
+        out.rr(0x66, false, 0x0F6E, 1, RAX);
+        out.rm(0xF3, false, 0x0F10, 0, R12, var(swordArg1(i)));
+        out.rr(0xF3, false, opcode, 0, 1);
+        out.rm(0xF3, false, 0x0F11, 0, R12, var(swordArg0(i)));
+    }
+
+    void floatDivide(bool isDouble, asUINT i)
+    {
+        int prefix=isDouble ? 0xF2 : 0xF3;
+        out.rm(prefix, false, 0x0F10, 1, R12, var(swordArg2(i)));
+        out.rr(0, false, 0x0F57, 0, 0);
+        out.rr(isDouble ? 0x66 : 0, false, 0x0F2E, 1, 0);
+        out.skipIf(ccP, 17);
+        out.skipIf(ccNE, 15);
+        exitAt(i);
+        out.rm(prefix, false, 0x0F10, 0, R12, var(swordArg1(i)));
+        out.rr(prefix, false, 0x0F5E, 0, 1);
+        out.rm(prefix, false, 0x0F11, 0, R12, var(swordArg0(i)));
+    }
+
+    void intDivide(bool isSigned, bool remainder, asUINT i)
+    {
+        out.rm(0, false, 0x8B, RCX, R12, var(swordArg2(i)));
+        out.rr(0, false, 0x85, RCX, RCX);
+        exitIf(ccE, i);
+        out.rm(0, false, 0x8B, RAX, R12, var(swordArg1(i)));
+        if(isSigned)
+        {
+            // INT_MIN/-1 overflows
+            out.rr(0, false, 0x81, 7, RCX);
+            out.dword((uint32)-1);
+            out.skipIf(ccNE, 6+17);
+            out.rr(0, false, 0x81, 7, RAX);
+            out.dword(0x80000000);
+            exitIf(ccE, i);
+            out.byte(0x99);
+            out.rr(0, false, 0xF7, 7, RCX);
+        }
+        else
+        {
+            out.rr(0, false, 0x33, RDX, RDX);
+            out.rr(0, false, 0xF7, 6, RCX);
+        }
+        out.rm(0, false, 0x89, remainder ? RDX : RAX, R12, var(swordArg0(i)));
+    }
+
+    // Loads the pointer on top of the stack into rax and leaves if it's null.
+    void loadStackPointer(asUINT i)
+    {
+        out.rm(0, true, 0x8B, RAX, R13, 0);
+        out.rr(0, true, 0x85, RAX, RAX);
+        exitIf(ccE, i);
+    }
+
+    void push32(int reg)
+    {
+        out.moveStack(-1);
+        out.rm(0, false, 0x89, reg, R13, 0);
+    }
+
+    void push64(int reg)
+    {
+        out.moveStack(-2);
+        out.rm(0, true, 0x89, reg, R13, 0);
+    }
+
+    // Reads the byte or word at a variable, extended, back into the whole
+    // dword.
+    void extend(int opcode, asUINT i)
+    {
+        out.rm(0, false, opcode, RAX, R12, var(swordArg0(i)));
+        out.rm(0, false, 0x89, RAX, R12, var(swordArg0(i)));
+    }
+};
+
+void FunctionCompiler::compile()
+{
+    // Entry: called as asJITFunction(registers, address to resume at)
+    out.byte(0x53);       // push rbx
+    out.byte(0x41);       // push r12
+    out.byte(0x54);
+    out.byte(0x41);       // push r13
+    out.byte(0x55);
+    out.rr(0, true, 0x8B, RBX, RDI);
+    out.rm(0, true, 0x8B, R12, RBX, regFP);
+    out.rm(0, true, 0x8B, R13, RBX, regSP);
+    out.rr(0, false, 0xFF, 4, RSI);
+
+    // Exit: rax holds the instruction the VM carries on from. The frame
+    // pointer never changes here, so it doesn't need writing back.
+    exitLabel=out.pos();
+    out.rm(0, true, 0x89, RAX, RBX, regPP);
+    out.rm(0, true, 0x89, R13, RBX, regSP);
+    out.byte(0x41);       // pop r13
+    out.byte(0x5D);
+    out.byte(0x41);       // pop r12
+    out.byte(0x5C);
+    out.byte(0x5B);       // pop rbx
+    out.byte(0xC3);       // ret
+
+    for(asUINT i=0; i<length;)
+    {
+        asEBCInstr op=asEBCInstr(*(asBYTE*)(bc+i));
+        labels[i]=out.pos();
+        instructions++;
+
+        if(translate(i))
+        {
+            native[i]=true;
+            nativeCount++;
+        }
+        else
+            exitAt(i);
+
+        i+=asBCTypeSize[asBCInfo[op].type];
+    }
+
+    for(size_t j=0; j<jumps.size(); j++)
+    {
+        size_t at=jumps[j].first;
+        out.patch32(at, (int)(labels[jumps[j].second]-(at+4)));
+    }
+}
+
+bool FunctionCompiler::translate(asUINT i)
+{
+    switch(*(asBYTE*)(bc+i))
+    {
+    case asBC_JitEntry:
+        // Already in native code
+        return true;
+
+    case asBC_SUSPEND:
+        out.rm(0, false, 0x80, 7, RBX, regSuspend);
+        out.byte(0);
+        exitIf(ccNE, i);
+        return true;
+
+    case asBC_CALLSYS:
+        out.rr(0, true, 0x8B, RDI, RBX);
+        out.rr(0, true, 0x8B, RSI, R13);
+        out.movImm64(RDX, (asPWORD)(bc+i));
+        out.movImm64(RAX, (asPWORD)&callSystemFunction);
+        out.rr(0, false, 0xFF, 2, RAX);
+        out.rr(0, true, 0x8B, R13, RAX);
+        // If the call raised an exception or suspended the context, the VM
+        // deals with it from the next instruction.
+        out.rm(0, false, 0x80, 7, RBX, regSuspend);
+        out.byte(0);
+        exitIf(ccNE, i+2);
+        return true;
+
+    // The stack
+    case asBC_PopPtr:
+        out.moveStack(AS_PTR_SIZE);
+        return true;
+
+    case asBC_PshC4:
+        out.moveStack(-1);
+        out.rm(0, false, 0xC7, 0, R13, 0);
+        out.dword(dwordArg(i));
+        return true;
+
+    case asBC_PshV4:
+        out.rm(0, false, 0x8B, RAX, R12, var(swordArg0(i)));
+        push32(RAX);
+        return true;
+
+    case asBC_PshG4:
+        out.movImm64(RAX, ptrArg(i));
+        out.rm(0, false, 0x8B, RAX, RAX, 0);
+        push32(RAX);
+        return true;
+
+    case asBC_PSF:
+        out.rm(0, true, 0x8D, RAX, R12, var(swordArg0(i)));
+        push64(RAX);
+        return true;
+
+    case asBC_PshVPtr:
+    case asBC_PshV8:
+        out.rm(0, true, 0x8B, RAX, R12, var(swordArg0(i)));
+        push64(RAX);
+        return true;
+
+    case asBC_PshRPtr:
+        out.rm(0, true, 0x8B, RAX, RBX, regValue);
+        push64(RAX);
+        return true;
+
+    case asBC_PshNull:
+        out.moveStack(-2);
+        out.rm(0, true, 0xC7, 0, R13, 0);
+        out.dword(0);
+        return true;
+
+    case asBC_PGA:
+        out.movImm64(RAX, ptrArg(i));
+        push64(RAX);
+        return true;
+
+    case asBC_PshC8:
+        out.movImm64(RAX, qwordArg(i));
+        push64(RAX);
+        return true;
+
+    case asBC_VAR:
+        out.movImm64(RAX, (asPWORD)swordArg0(i));
+        push64(RAX);
+        return true;
+
+    case asBC_PopRPtr:
+        out.rm(0, true, 0x8B, RAX, R13, 0);
+        out.rm(0, true, 0x89, RAX, RBX, regValue);
+        out.moveStack(AS_PTR_SIZE);
+        return true;
+
+    case asBC_SwapPtr:
+        out.rm(0, true, 0x8B, RAX, R13, 0);
+        out.rm(0, true, 0x8B, RCX, R13, 8);
+        out.rm(0, true, 0x89, RCX, R13, 0);
+        out.rm(0, true, 0x89, RAX, R13, 8);
+        return true;
+
+    case asBC_GETREF:
+    {
+        // The variable index on the stack becomes its address.
+        int offset=asBC_WORDARG0(at(i))*4;
+        out.rm(0, true, 0x63, RAX, R13, offset);
+        out.rr(0, true, 0xC1, 4, RAX);
+        out.byte(2);
+        out.rr(0, true, 0x8B, RCX, R12);
+        out.rr(0, true, 0x2B, RCX, RAX);
+        out.rm(0, true, 0x89, RCX, R13, offset);
+        return true;
+    }
+
+    case asBC_ADDSi:
+        loadStackPointer(i);
+        out.rm(0, true, 0x8D, RAX, RAX, swordArg0(i));
+        out.rm(0, true, 0x89, RAX, R13, 0);
+        return true;
+
+    case asBC_RDSPtr:
+        loadStackPointer(i);
+        out.rm(0, true, 0x8B, RAX, RAX, 0);
+        out.rm(0, true, 0x89, RAX, R13, 0);
+        return true;
+
+    case asBC_ChkRefS:
+        out.rm(0, true, 0x8B, RAX, R13, 0);
+        out.rm(0, true, 0x8B, RAX, RAX, 0);
+        out.rr(0, true, 0x85, RAX, RAX);
+        exitIf(ccE, i);
+        return true;
+
+    case asBC_ChkNullV:
+        out.rm(0, true, 0x8B, RAX, R12, var(swordArg0(i)));
+        out.rr(0, true, 0x85, RAX, RAX);
+        exitIf(ccE, i);
+        return true;
+
+    case asBC_LoadThisR:
+        out.rm(0, true, 0x8B, RAX, R12, 0);
+        out.rr(0, true, 0x85, RAX, RAX);
+        exitIf(ccE, i);
+        out.rm(0, true, 0x8D, RAX, RAX, swordArg0(i));
+        out.rm(0, true, 0x89, RAX, RBX, regValue);
+        return true;
+
+    // Jumps and tests
+    case asBC_JMP:
+        branch(-1, i);
+        return true;
+
+    case asBC_JZ:
+    case asBC_JNZ:
+    case asBC_JS:
+    case asBC_JNS:
+    case asBC_JP:
+    case asBC_JNP:
+    case asBC_JLowZ:
+    case asBC_JLowNZ:
+    {
+        int cc;
+        bool lowByte=false;
+        switch(*(asBYTE*)(bc+i))
+        {
+        case asBC_JZ:     cc=ccE; break;
+        case asBC_JNZ:    cc=ccNE; break;
+        case asBC_JS:     cc=ccL; break;
+        case asBC_JNS:    cc=ccGE; break;
+        case asBC_JP:     cc=ccG; break;
+        case asBC_JNP:    cc=ccLE; break;
+        case asBC_JLowZ:  cc=ccE; lowByte=true; break;
+        default:          cc=ccNE; lowByte=true; break;
+        }
+        compareValue(lowByte);
+        branch(cc, i);
+        return true;
+    }
+
+    case asBC_TZ:  test(ccE); return true;
+    case asBC_TNZ: test(ccNE); return true;
+    case asBC_TS:  test(ccL); return true;
+    case asBC_TNS: test(ccGE); return true;
+    case asBC_TP:  test(ccG); return true;
+    case asBC_TNP: test(ccLE); return true;
+
+    case asBC_NOT:
+        out.rr(0, false, 0x33, RAX, RAX);
+        out.rm(0, false, 0x80, 7, R12, var(swordArg0(i)));
+        out.byte(0);
+        out.setIf(ccE, RAX);
+        out.rm(0, false, 0x89, RAX, R12, var(swordArg0(i)));
+        return true;
+
+    case asBC_ClrHi:
+        out.rm(0, false, 0x81, 4, RBX, regValue);
+        out.dword(0xFF);
+        return true;
+
+    // Comparisons
+    case asBC_CMPi:
+    case asBC_CMPu:
+        out.rm(0, false, 0x8B, RAX, R12, var(swordArg0(i)));
+        out.rm(0, false, 0x3B, RAX, R12, var(swordArg1(i)));
+        storeComparison(*(asBYTE*)(bc+i)==asBC_CMPi);
+        return true;
+
+    case asBC_CMPIi:
+    case asBC_CMPIu:
+        out.rm(0, false, 0x8B, RAX, R12, var(swordArg0(i)));
+        out.rr(0, false, 0x81, 7, RAX);
+        out.dword(dwordArg(i));
+        storeComparison(*(asBYTE*)(bc+i)==asBC_CMPIi);
+        return true;
+
+    case asBC_CmpPtr:
+        out.rm(0, true, 0x8B, RAX, R12, var(swordArg0(i)));
+        out.rm(0, true, 0x3B, RAX, R12, var(swordArg1(i)));
+        storeComparison(false);
+        return true;
+
+    case asBC_CMPf:
+        out.rm(0xF3, false, 0x0F10, 0, R12, var(swordArg0(i)));
+        out.rm(0, false, 0x0F2E, 0, R12, var(swordArg1(i)));
+        storeFloatComparison();
+        return true;
+
+    case asBC_CMPIf:
+        out.movImm32(RAX, dwordArg(i));
+        out.rr(0x66, false, 0x0F6E, 1, RAX);
+        out.rm(0xF3, false, 0x0F10, 0, R12, var(swordArg0(i)));
+        out.rr(0, false, 0x0F2E, 0, 1);
+        storeFloatComparison();
+        return true;
+
+    case asBC_CMPd:
+        out.rm(0xF2, false, 0x0F10, 0, R12, var(swordArg0(i)));
+        out.rm(0x66, false, 0x0F2E, 0, R12, var(swordArg1(i)));
+        storeFloatComparison();
+        return true;
+
+    // Integer arithmetic
+    case asBC_ADDi: intOp(0x03, i); return true;
+    case asBC_SUBi: intOp(0x2B, i); return true;
+    case asBC_MULi: intOp(0x0FAF, i); return true;
+    case asBC_BAND: intOp(0x23, i); return true;
+    case asBC_BOR:  intOp(0x0B, i); return true;
+    case asBC_BXOR: intOp(0x33, i); return true;
+    case asBC_BSLL: shiftOp(4, i); return true;
+    case asBC_BSRL: shiftOp(5, i); return true;
+    case asBC_BSRA: shiftOp(7, i); return true;
+    case asBC_DIVi: intDivide(true, false, i); return true;
+    case asBC_MODi: intDivide(true, true, i); return true;
+    case asBC_DIVu: intDivide(false, false, i); return true;
+    case asBC_MODu: intDivide(false, true, i); return true;
+
+    case asBC_ADDIi:
+    case asBC_SUBIi:
+        out.rm(0, false, 0x8B, RAX, R12, var(swordArg1(i)));
+        out.rr(0, false, 0x81, *(asBYTE*)(bc+i)==asBC_ADDIi ? 0 : 5, RAX);
+        out.dword(dwordArg(i+1));
+        out.rm(0, false, 0x89, RAX, R12, var(swordArg0(i)));
+        return true;
+
+    case asBC_MULIi:
+        out.rm(0, false, 0x69, RAX, R12, var(swordArg1(i)));
+        out.dword(dwordArg(i+1));
+        out.rm(0, false, 0x89, RAX, R12, var(swordArg0(i)));
+        return true;
+
+    case asBC_NEGi:
+        out.rm(0, false, 0xF7, 3, R12, var(swordArg0(i)));
+        return true;
+
+    case asBC_BNOT:
+        out.rm(0, false, 0xF7, 2, R12, var(swordArg0(i)));
+        return true;
+
+    case asBC_IncVi:
+        out.rm(0, false, 0xFF, 0, R12, var(swordArg0(i)));
+        return true;
+
+    case asBC_DecVi:
+        out.rm(0, false, 0xFF, 1, R12, var(swordArg0(i)));
+        return true;
+
+    case asBC_INCi:
+    case asBC_DECi:
+        out.rm(0, true, 0x8B, RAX, RBX, regValue);
+        out.rm(0, false, 0xFF, *(asBYTE*)(bc+i)==asBC_INCi ? 0 : 1, RAX, 0);
+        return true;
+
+    // Floating point
+    case asBC_ADDf: floatOp(0xF3, 0x0F58, i); return true;
+    case asBC_SUBf: floatOp(0xF3, 0x0F5C, i); return true;
+    case asBC_MULf: floatOp(0xF3, 0x0F59, i); return true;
+    case asBC_ADDd: floatOp(0xF2, 0x0F58, i); return true;
+    case asBC_SUBd: floatOp(0xF2, 0x0F5C, i); return true;
+    case asBC_MULd: floatOp(0xF2, 0x0F59, i); return true;
+    case asBC_ADDIf: floatImmOp(0x0F58, i); return true;
+    case asBC_SUBIf: floatImmOp(0x0F5C, i); return true;
+    case asBC_MULIf: floatImmOp(0x0F59, i); return true;
+    case asBC_DIVf: floatDivide(false, i); return true;
+    case asBC_DIVd: floatDivide(true, i); return true;
+
+    case asBC_NEGf:
+        out.rm(0, false, 0x81, 6, R12, var(swordArg0(i)));
+        out.dword(0x80000000);
+        return true;
+
+    case asBC_NEGd:
+        out.rm(0, false, 0x81, 6, R12, var(swordArg0(i))+4);
+        out.dword(0x80000000);
+        return true;
+
+    // Conversions
+    case asBC_iTOf:
+        out.rm(0xF3, false, 0x0F2A, 0, R12, var(swordArg0(i)));
+        out.rm(0xF3, false, 0x0F11, 0, R12, var(swordArg0(i)));
+        return true;
+
+    case asBC_uTOf:
+        out.rm(0, false, 0x8B, RAX, R12, var(swordArg0(i)));
+        out.rr(0xF3, true, 0x0F2A, 0, RAX);
+        out.rm(0xF3, false, 0x0F11, 0, R12, var(swordArg0(i)));
+        return true;
+
+    case asBC_fTOi:
+    case asBC_fTOu:
+        out.rm(0xF3, false, 0x0F2C, RAX, R12, var(swordArg0(i)));
+        out.rm(0, false, 0x89, RAX, R12, var(swordArg0(i)));
+        return true;
+
+    case asBC_dTOi:
+    case asBC_dTOu:
+        out.rm(0xF2, false, 0x0F2C, RAX, R12, var(swordArg1(i)));
+        out.rm(0, false, 0x89, RAX, R12, var(swordArg0(i)));
+        return true;
+
+    case asBC_dTOf:
+        out.rm(0xF2, false, 0x0F5A, 0, R12, var(swordArg1(i)));
+        out.rm(0xF3, false, 0x0F11, 0, R12, var(swordArg0(i)));
+        return true;
+
+    case asBC_fTOd:
+        out.rm(0xF3, false, 0x0F5A, 0, R12, var(swordArg1(i)));
+        out.rm(0xF2, false, 0x0F11, 0, R12, var(swordArg0(i)));
+        return true;
+
+    case asBC_iTOd:
+        out.rm(0xF2, false, 0x0F2A, 0, R12, var(swordArg1(i)));
+        out.rm(0xF2, false, 0x0F11, 0, R12, var(swordArg0(i)));
+        return true;
+
+    case asBC_uTOd:
+        out.rm(0, false, 0x8B, RAX, R12, var(swordArg1(i)));
+        out.rr(0xF2, true, 0x0F2A, 0, RAX);
+        out.rm(0xF2, false, 0x0F11, 0, R12, var(swordArg0(i)));
+        return true;
+
+    case asBC_sbTOi: extend(0x0FBE, i); return true;
+    case asBC_swTOi: extend(0x0FBF, i); return true;
+    case asBC_ubTOi:
+    case asBC_iTOb:  extend(0x0FB6, i); return true;
+    case asBC_uwTOi:
+    case asBC_iTOw:  extend(0x0FB7, i); return true;
+
+    // Copying values
+    case asBC_SetV1:
+    case asBC_SetV2:
+    case asBC_SetV4:
+        out.rm(0, false, 0xC7, 0, R12, var(swordArg0(i)));
+        out.dword(dwordArg(i));
+        return true;
+
+    case asBC_SetV8:
+        out.movImm64(RAX, qwordArg(i));
+        out.rm(0, true, 0x89, RAX, R12, var(swordArg0(i)));
+        return true;
+
+    case asBC_ClrVPtr:
+        out.rm(0, true, 0xC7, 0, R12, var(swordArg0(i)));
+        out.dword(0);
+        return true;
+
+    case asBC_CpyVtoV4:
+        out.rm(0, false, 0x8B, RAX, R12, var(swordArg1(i)));
+        out.rm(0, false, 0x89, RAX, R12, var(swordArg0(i)));
+        return true;
+
+    case asBC_CpyVtoV8:
+        out.rm(0, true, 0x8B, RAX, R12, var(swordArg1(i)));
+        out.rm(0, true, 0x89, RAX, R12, var(swordArg0(i)));
+        return true;
+
+    case asBC_CpyVtoR4:
+        out.rm(0, false, 0x8B, RAX, R12, var(swordArg0(i)));
+        out.rm(0, false, 0x89, RAX, RBX, regValue);
+        return true;
+
+    case asBC_CpyVtoR8:
+        out.rm(0, true, 0x8B, RAX, R12, var(swordArg0(i)));
+        out.rm(0, true, 0x89, RAX, RBX, regValue);
+        return true;
+
+    case asBC_CpyRtoV4:
+        out.rm(0, false, 0x8B, RAX, RBX, regValue);
+        out.rm(0, false, 0x89, RAX, R12, var(swordArg0(i)));
+        return true;
+
+    case asBC_CpyRtoV8:
+        out.rm(0, true, 0x8B, RAX, RBX, regValue);
+        out.rm(0, true, 0x89, RAX, R12, var(swordArg0(i)));
+        return true;
+
+    case asBC_CpyVtoG4:
+        out.movImm64(RCX, ptrArg(i));
+        out.rm(0, false, 0x8B, RAX, R12, var(swordArg0(i)));
+        out.rm(0, false, 0x89, RAX, RCX, 0);
+        return true;
+
+    case asBC_CpyGtoV4:
+        out.movImm64(RCX, ptrArg(i));
+        out.rm(0, false, 0x8B, RAX, RCX, 0);
+        out.rm(0, false, 0x89, RAX, R12, var(swordArg0(i)));
+        return true;
+
+    case asBC_SetG4:
+        out.movImm64(RCX, ptrArg(i));
+        out.rm(0, false, 0xC7, 0, RCX, 0);
+        out.dword(dwordArg(i+AS_PTR_SIZE));
+        return true;
+
+    case asBC_LdGRdR4:
+        out.movImm64(RCX, ptrArg(i));
+        out.rm(0, true, 0x89, RCX, RBX, regValue);
+        out.rm(0, false, 0x8B, RAX, RCX, 0);
+        out.rm(0, false, 0x89, RAX, R12, var(swordArg0(i)));
+        return true;
+
+    case asBC_LDG:
+        out.movImm64(RAX, ptrArg(i));
+        out.rm(0, true, 0x89, RAX, RBX, regValue);
+        return true;
+
+    case asBC_LDV:
+        out.rm(0, true, 0x8D, RAX, R12, var(swordArg0(i)));
+        out.rm(0, true, 0x89, RAX, RBX, regValue);
+        return true;
+
+    // Through the address in the value register
+    case asBC_RDR1:
+    case asBC_RDR2:
+    case asBC_RDR4:
+    case asBC_RDR8:
+    {
+        asBYTE op=*(asBYTE*)(bc+i);
+        out.rm(0, true, 0x8B, RCX, RBX, regValue);
+        if(op==asBC_RDR1)
+            out.rm(0, false, 0x0FB6, RAX, RCX, 0);
+        else if(op==asBC_RDR2)
+            out.rm(0, false, 0x0FB7, RAX, RCX, 0);
+        else
+            out.rm(0, op==asBC_RDR8, 0x8B, RAX, RCX, 0);
+        out.rm(0, op==asBC_RDR8, 0x89, RAX, R12, var(swordArg0(i)));
+        return true;
+    }
+
+    case asBC_WRTV1:
+    case asBC_WRTV2:
+    case asBC_WRTV4:
+    case asBC_WRTV8:
+    {
+        asBYTE op=*(asBYTE*)(bc+i);
+        out.rm(0, true, 0x8B, RCX, RBX, regValue);
+        out.rm(0, op==asBC_WRTV8, 0x8B, RAX, R12, var(swordArg0(i)));
+        if(op==asBC_WRTV1)
+            out.rm(0, false, 0x88, RAX, RCX, 0);
+        else if(op==asBC_WRTV2)
+            out.rm(0x66, false, 0x89, RAX, RCX, 0);
+        else
+            out.rm(0, op==asBC_WRTV8, 0x89, RAX, RCX, 0);
+        return true;
+    }
+
+    default:
+        return false;
+    }
+}
+
+int ScriptJIT::CompileFunction(asIScriptFunction* function, asJITFunction* output)
+{
+    asUINT length;
+    asDWORD* bytecode=function->GetByteCode(&length);
+    if(!bytecode)
+        return asERROR;
+
+    FunctionCompiler compiler(bytecode, length);
+    compiler.compile();
+
+    // Only the JitEntries followed by something native are worth entering
+    // at; the rest stay nops.
+    std::vector<EntryPoint> entries;
+    for(asUINT i=0; i<length;)
+    {
+        asEBCInstr op=asEBCInstr(*(asBYTE*)(bytecode+i));
+        asUINT next=i+asBCTypeSize[asBCInfo[op].type];
+        if(op==asBC_JitEntry && compiler.nativeRun(next)>=minNativeRun)
+        {
+            EntryPoint entry;
+            entry.bytecode=bytecode+i;
+            entry.address=compiler.labels[next];
+            entries.push_back(entry);
+        }
+        i=next;
+    }
+
+    totalInstructions+=compiler.instructions;
+    if(entries.empty())
+        return asNOT_SUPPORTED;
+
+    unsigned char* code=allocateCode(compiler.out.code.size());
+    if(!code)
+        return asOUT_OF_MEMORY;
+    memcpy(code, &compiler.out.code[0], compiler.out.code.size());
+    if(!setCodeWritable(false))
+        return asERROR;
+    nativeInstructions+=compiler.nativeCount;
+
+    for(size_t i=0; i<entries.size(); i++)
+        entries[i].address+=(asPWORD)code;
+    setEntryPoints(entries, enabled);
+
+    *output=(asJITFunction)code;
+    functions[*output]=entries;
+    return asSUCCESS;
+}
+
+#endif
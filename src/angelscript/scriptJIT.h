@@ -0,0 +1,66 @@
+#ifndef _ZC_ANGELSCRIPT_SCRIPTJIT_H_
+#define _ZC_ANGELSCRIPT_SCRIPTJIT_H_
+
+#include <angelscript.h>
+#include <map>
+#include <vector>
+#include "config.h"
+
+// Only x86-64 Linux has a code generator. Everywhere else the scripts just
+// run in the VM.
+#if defined(__x86_64__) && defined(__linux__)
+#define ZC_SCRIPT_JIT
+#endif
+
+// Compiles script functions to native code. Simple instructions - moving
+// values around, arithmetic, comparisons, jumps and calls to registered
+// functions - are translated; anything else, including calls to script
+// functions, hands control back to the VM, which picks up native code again
+// at the next JitEntry it reaches.
+//
+// The engine has to have asEP_INCLUDE_JIT_INSTRUCTIONS set before anything's
+// built for there to be any JitEntries.
+class ScriptJIT: public asIJITCompiler
+{
+public:
+    ScriptJIT();
+    ~ScriptJIT();
+
+    int CompileFunction(asIScriptFunction* function, asJITFunction* output);
+    void ReleaseJITFunction(asJITFunction func);
+
+    // Switches between native code and the VM without recompiling anything.
+    // Don't call this while a script is running.
+    void setEnabled(bool on);
+    bool isEnabled() const { return enabled; }
+
+    uint32 compiledFunctions() const { return (uint32)functions.size(); }
+
+    // How many instructions there were and how many of them are native.
+    uint32 totalInstructions;
+    uint32 nativeInstructions;
+
+private:
+    // Each JitEntry the native code can be entered from, and the address it
+    // enters at. Disabling the JIT zeroes these, which the VM treats as a nop.
+    struct EntryPoint
+    {
+        asDWORD* bytecode;
+        asPWORD address;
+    };
+
+    std::map<asJITFunction, std::vector<EntryPoint> > functions;
+
+    // Code goes in blocks of memory, which aren't freed until the JIT is.
+    std::vector<std::pair<unsigned char*, size_t> > blocks;
+    size_t blockUsed;
+
+    bool enabled;
+
+    unsigned char* allocateCode(size_t size);
+    // Switches the newest block between writable and executable.
+    bool setCodeWritable(bool writable);
+    void setEntryPoints(std::vector<EntryPoint>& entries, bool on);
+};
+
+#endif
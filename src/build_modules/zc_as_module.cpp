@@ -3,6 +3,7 @@
 #include "config.h"
 
 #include "angelscript/aszc.cpp"
+#include "angelscript/scriptCache.cpp"
 #include "angelscript/scriptData.cpp"
 #include "angelscript/util.cpp"
 
@@ -13,3 +14,4 @@
 
 #include "angelscript/scriptContext.cpp"
 #include "angelscript/scriptGC.cpp"
+#include "angelscript/scriptJIT.cpp"
@@ -10,6 +10,10 @@
 
 
 #include "zscriptversion.cpp"
+#include "zscriptprofiler.cpp"
+#include "ffdebug.cpp"
+#include "ffjit.cpp"
+#include "spatialIndex.cpp"
 #include "ffscript.cpp"
 #include "ffc.cpp"
 #include "refInfo.cpp"
@@ -3,6 +3,7 @@
 #include "config.h"
 
 
+#include "angelscript/scriptContext.cpp"
 #include "angelscript/scriptData.cpp"
 
 #include "angelscript/scriptmath/scriptmath.cpp"
@@ -8,6 +8,7 @@
 #include "parser/DataStructs.cpp"
 #include "parser/GlobalSymbols.cpp"
 #include "parser/lex.yy.cpp"
+#include "parser/Optimizer.cpp"
 #include "parser/ParseError.cpp"
 #include "parser/ScriptParser.cpp"
 #include "parser/SymbolVisitors.cpp"
@@ -153,6 +153,7 @@ const RuleData miscRules[]={
   { qr_NOGUYPOOF, "Special Room Guys Don't Create A Puff When Appearing" },
   { qr_LOG, "Log Game Events To Allegro.log" },
   { qr_SCRIPTERRLOG, "Log Script Errors To Allegro.log" },
+  { qr_KILLRUNAWAYSCRIPTS, "Kill Scripts That Run Too Long Without Waiting" },
   { qr_SHOPCHEAT, "Draining Rupees Can Still Be Spent" },
   { -1, "" }
 };
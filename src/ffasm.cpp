@@ -11,11 +11,14 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <map>
+#include <vector>
 
 #include "zc_malloc.h"
 #include "ffasm.h"
 #include "zquest.h"
 #include "zsys.h"
+#include "parser/Compiler.h"
 #ifdef ALLEGRO_MACOSX
 #define strnicmp strncasecmp
 #endif
@@ -271,6 +274,10 @@ script_command command_list[NUMCOMMANDS+1]=
     { "GETTILEWARPSCR",      1,   0,   0,   0},
     { "GETTILEWARPTYPE",     1,   0,   0,   0},
     { "GETFFCSCRIPT",        1,   0,   0,   0},
+    { "WAITFRAMESR",         1,   0,   0,   0},
+    { "QUERYRADIUS",         2,   0,   1,   0},
+    { "QUERYRECT",           2,   0,   1,   0},
+    { "QUERYNEAREST",        2,   0,   1,   0},
     { "",                    0,   0,   0,   0}
 };
 
@@ -694,6 +701,137 @@ char labels[65536][80];
 int lines[65536];
 int numlines;
 
+// Commands, variables and labels are looked up by hashing the name rather than comparing it
+// against every entry in command_list, variable_list and labels. Each table keeps the first
+// entry given a name, which is the one the old linear searches found.
+#define ASM_NAME_BUCKETS 4096
+
+struct asm_name
+{
+    char name[24];
+    int value;
+    int next;
+};
+
+struct asm_names
+{
+    int heads[ASM_NAME_BUCKETS];
+    std::vector<asm_name> entries;
+};
+
+static asm_names command_names;
+static asm_names variable_names;
+static bool asm_names_built = false;
+static bool command_jumps[NUMCOMMANDS];
+
+static int label_heads[ASM_NAME_BUCKETS];
+static int label_next[65536];
+
+// Case-insensitive, since variables and labels are matched that way
+static unsigned int asm_hash(const char *name)
+{
+    unsigned int hash = 2166136261u;
+    
+    for(; *name; name++)
+        hash = (hash ^ (unsigned char)tolower(*name)) * 16777619u;
+        
+    return hash & (ASM_NAME_BUCKETS - 1);
+}
+
+static int find_asm_name(asm_names &table, const char *name, bool nocase)
+{
+    for(int i = table.heads[asm_hash(name)]; i >= 0; i = table.entries[i].next)
+    {
+        if((nocase ? stricmp(name, table.entries[i].name) : strcmp(name, table.entries[i].name)) == 0)
+            return table.entries[i].value;
+    }
+    
+    return -1;
+}
+
+static void add_asm_name(asm_names &table, const char *name, int value, bool nocase)
+{
+    if(find_asm_name(table, name, nocase) >= 0)
+        return;
+        
+    asm_name entry;
+    strncpy(entry.name, name, sizeof(entry.name) - 1);
+    entry.name[sizeof(entry.name) - 1] = '\0';
+    entry.value = value;
+    unsigned int bucket = asm_hash(name);
+    entry.next = table.heads[bucket];
+    table.heads[bucket] = (int)table.entries.size();
+    table.entries.push_back(entry);
+}
+
+static void build_asm_names()
+{
+    if(asm_names_built)
+        return;
+        
+    for(int i=0; i<ASM_NAME_BUCKETS; ++i)
+    {
+        command_names.heads[i] = -1;
+        variable_names.heads[i] = -1;
+    }
+    
+    for(int i=0; i<NUMCOMMANDS; ++i)
+    {
+        add_asm_name(command_names, command_list[i].name, i, false);
+        const char *name = command_list[i].name;
+        command_jumps[i] = ((strnicmp(name,"GOTO",4)==0)||(strnicmp(name,"LOOP",4)==0)) && stricmp(name, "GOTOR");
+    }
+    
+    char tempvar[24];
+    
+    for(int i=0; variable_list[i].id>-1; ++i)
+    {
+        if(variable_list[i].maxcount>1)
+        {
+            for(int j=0; j<variable_list[i].maxcount; ++j)
+            {
+                if(strcmp(variable_list[i].name,"A")==0)
+                    sprintf(tempvar, "%s%d", variable_list[i].name, j+1);
+                else sprintf(tempvar, "%s%d", variable_list[i].name, j);
+                
+                add_asm_name(variable_names, tempvar, variable_list[i].id+(j*zc_max(1,variable_list[i].multiple)), true);
+            }
+        }
+        else
+        {
+            add_asm_name(variable_names, variable_list[i].name, variable_list[i].id, true);
+        }
+    }
+    
+    asm_names_built = true;
+}
+
+static int find_label(const char *name)
+{
+    for(int i = label_heads[asm_hash(name)]; i >= 0; i = label_next[i])
+    {
+        if(stricmp(name, labels[i])==0)
+            return lines[i];
+    }
+    
+    return -1;
+}
+
+// Called once labels[] is filled in. Chains are walked newest first, so each is built from
+// the last label back to keep the first of any duplicates in front.
+static void build_label_names()
+{
+    for(int i=0; i<ASM_NAME_BUCKETS; ++i)
+        label_heads[i] = -1;
+        
+    for(int i=numlines-1; i>=0; --i)
+    {
+        unsigned int bucket = asm_hash(labels[i]);
+        label_next[i] = label_heads[bucket];
+        label_heads[bucket] = i;
+    }
+}
+
 int parse_script(ffscript **script)
 {
     if(!getname("Import Script (.txt)","txt",NULL,datapath,false))
@@ -793,6 +931,7 @@ int parse_script_file(ffscript **script, const char *path, bool report_success)
         }
     }
     
+    build_label_names();
     fseek(fscript, 0, SEEK_SET);
     stop = false;
     
@@ -951,7 +1090,7 @@ int parse_script_file(ffscript **script, const char *path, bool report_success)
 
 int set_argument(char *argbuf, ffscript **script, int com, int argument)
 {
-    long *arg;
+    int *arg;
     
     if(argument)
     {
@@ -962,40 +1101,14 @@ int set_argument(char *argbuf, ffscript **script, int com, int argument)
         arg = &((*script)[com].arg1);
     }
     
-    int i=0;
-    char tempvar[20];
+    build_asm_names();
+    int id = find_asm_name(variable_names, argbuf, true);
     
-    while(variable_list[i].id>-1)
-    {
-        if(variable_list[i].maxcount>1)
-        {
-            for(int j=0; j<variable_list[i].maxcount; ++j)
-            {
-                if(strcmp(variable_list[i].name,"A")==0)
-                    sprintf(tempvar, "%s%d", variable_list[i].name, j+1);
-                else sprintf(tempvar, "%s%d", variable_list[i].name, j);
-                
-                if(stricmp(argbuf,tempvar)==0)
-                {
-                    long temp = variable_list[i].id+(j*zc_max(1,variable_list[i].multiple));
-                    *arg = temp;
-                    return 1;
-                }
-            }
-        }
-        else
-        {
-            if(stricmp(argbuf,variable_list[i].name)==0)
-            {
-                *arg = variable_list[i].id;
-                return 1;
-            }
-        }
+    if(id < 0)
+        return 0;
         
-        ++i;
-    }
-    
-    return 0;
+    *arg = id;
+    return 1;
 }
 
 #define ERR_INSTRUCTION 0
@@ -1007,36 +1120,75 @@ int parse_script_section(char *combuf, char *arg1buf, char *arg2buf, ffscript **
     (*script)[com].arg1 = 0;
     (*script)[com].arg2 = 0;
     bool found_command=false;
+    build_asm_names();
+    int i = find_asm_name(command_names, combuf, false);
     
-    for(int i=0; i<NUMCOMMANDS&&!found_command; ++i)
+    if(i >= 0)
     {
-        if(strcmp(combuf,command_list[i].name)==0)
+        found_command=true;
+        (*script)[com].command = i;
+        
+        if(command_jumps[i])
         {
-            found_command=true;
-            (*script)[com].command = i;
+            int line = find_label(arg1buf);
             
-            if(((strnicmp(combuf,"GOTO",4)==0)||(strnicmp(combuf,"LOOP",4)==0)) && stricmp(combuf, "GOTOR"))
+            if(line >= 0)
             {
-                bool nomatch = true;
-                
-                for(int j=0; j<numlines; j++)
+                (*script)[com].arg1 = line;
+            }
+            else
+            {
+                (*script)[com].arg1 = atoi(arg1buf)-1;
+            }
+            
+            if(strnicmp(combuf,"LOOP",4)==0)
+            {
+                if(command_list[i].arg2_type==1)  //this should NEVER happen with a loop, as arg2 needs to be a variable
                 {
-                    if(stricmp(arg1buf,labels[j])==0)
+                    if(!ffcheck(arg2buf))
                     {
-                        (*script)[com].arg1 = lines[j];
-                        nomatch = false;
-                        j=numlines;
+                        retcode=ERR_PARAM2;
+                        return 0;
                     }
+                    
+                    (*script)[com].arg2 = ffparse(arg2buf);
                 }
-                
-                if(nomatch)
+                else
+                {
+                    if(!set_argument(arg2buf, script, com, 1))
+                    {
+                        retcode=ERR_PARAM2;
+                        return 0;
+                    }
+                }
+            }
+        }
+        else
+        {
+            if(command_list[i].args>0)
+            {
+                if(command_list[i].arg1_type==1)
+                {
+                    if(!ffcheck(arg1buf))
+                    {
+                        retcode=ERR_PARAM1;
+                        return 0;
+                    }
+                    
+                    (*script)[com].arg1 = ffparse(arg1buf);
+                }
+                else
                 {
-                    (*script)[com].arg1 = atoi(arg1buf)-1;
+                    if(!set_argument(arg1buf, script, com, 0))
+                    {
+                        retcode=ERR_PARAM1;
+                        return 0;
+                    }
                 }
                 
-                if(strnicmp(combuf,"LOOP",4)==0)
+                if(command_list[i].args>1)
                 {
-                    if(command_list[i].arg2_type==1)  //this should NEVER happen with a loop, as arg2 needs to be a variable
+                    if(command_list[i].arg2_type==1)
                     {
                         if(!ffcheck(arg2buf))
                         {
@@ -1056,52 +1208,6 @@ int parse_script_section(char *combuf, char *arg1buf, char *arg2buf, ffscript **
                     }
                 }
             }
-            else
-            {
-                if(command_list[i].args>0)
-                {
-                    if(command_list[i].arg1_type==1)
-                    {
-                        if(!ffcheck(arg1buf))
-                        {
-                            retcode=ERR_PARAM1;
-                            return 0;
-                        }
-                        
-                        (*script)[com].arg1 = ffparse(arg1buf);
-                    }
-                    else
-                    {
-                        if(!set_argument(arg1buf, script, com, 0))
-                        {
-                            retcode=ERR_PARAM1;
-                            return 0;
-                        }
-                    }
-                    
-                    if(command_list[i].args>1)
-                    {
-                        if(command_list[i].arg2_type==1)
-                        {
-                            if(!ffcheck(arg2buf))
-                            {
-                                retcode=ERR_PARAM2;
-                                return 0;
-                            }
-                            
-                            (*script)[com].arg2 = ffparse(arg2buf);
-                        }
-                        else
-                        {
-                            if(!set_argument(arg2buf, script, com, 1))
-                            {
-                                retcode=ERR_PARAM2;
-                                return 0;
-                            }
-                        }
-                    }
-                }
-            }
         }
     }
     
@@ -1114,3 +1220,114 @@ int parse_script_section(char *combuf, char *arg1buf, char *arg2buf, ffscript **
     return 0;
 }
 
+
+// The compiler numbers variables differently from ffscript.h, and they only match up by name,
+// so each one is looked up by the name printLine() would give it the first time it's seen
+static std::map<long, int> compiled_variables;
+static std::map<long, int> compiled_globals;
+
+static bool set_compiled_argument(OpcodeArgument &arg, int type, int &value)
+{
+    switch(arg.kind)
+    {
+    case OpcodeArgument::NUMBER:
+        value = arg.value;
+        return type==1;
+        
+    case OpcodeArgument::LABEL:
+        // Printed as the line number, which ffparse() reads as a number like any other
+        value = arg.value*10000;
+        return type==1;
+    }
+    
+    if(type==1)
+        return false;
+        
+    std::map<long, int> &ids = arg.kind==OpcodeArgument::GLOBAL ? compiled_globals : compiled_variables;
+    std::map<long, int>::iterator it = ids.find(arg.value);
+    
+    if(it == ids.end())
+        it = ids.insert(std::make_pair(arg.value, find_asm_name(variable_names, arg.getName().c_str(), true))).first;
+        
+    value = it->second;
+    return value >= 0;
+}
+
+// Gives the same result as parse_script_file() on the printLine() text of code, without
+// writing it out and reading it back in
+int load_compiled_script(ffscript **script, std::vector<Opcode *> &code, const char *name)
+{
+    saved=false;
+    build_asm_names();
+    
+    if((*script)!=NULL) delete [](*script);
+    
+    int num_commands = (int)code.size();
+    (*script) = new ffscript[num_commands+1];
+    (*script)[num_commands].command = 0xFFFF;
+    
+    for(int i=0; i<num_commands; i++)
+    {
+        ffscript &line = (*script)[i];
+        line.arg1 = 0;
+        line.arg2 = 0;
+        OpcodeArgument args[2];
+        int numargs = code[i]->getArguments(args);
+        int com = find_asm_name(command_names, code[i]->getMnemonic(), false);
+        int parse_err = ERR_INSTRUCTION;
+        bool ok = com >= 0;
+        
+        if(ok)
+        {
+            line.command = com;
+            
+            if(command_jumps[com])
+            {
+                parse_err = ERR_PARAM1;
+                ok = numargs>0 && args[0].kind==OpcodeArgument::LABEL;
+                
+                if(ok)
+                    line.arg1 = args[0].value-1;
+                    
+                if(ok && strnicmp(command_list[com].name,"LOOP",4)==0)
+                {
+                    parse_err = ERR_PARAM2;
+                    ok = numargs>1 && set_compiled_argument(args[1], command_list[com].arg2_type, line.arg2);
+                }
+            }
+            else
+            {
+                if(ok && command_list[com].args>0)
+                {
+                    parse_err = ERR_PARAM1;
+                    ok = numargs>0 && set_compiled_argument(args[0], command_list[com].arg1_type, line.arg1);
+                }
+                
+                if(ok && command_list[com].args>1)
+                {
+                    parse_err = ERR_PARAM2;
+                    ok = numargs>1 && set_compiled_argument(args[1], command_list[com].arg2_type, line.arg2);
+                }
+            }
+        }
+        
+        if(!ok)
+        {
+            char buf[80],buf2[80],buf3[80];
+            const char* errstrbuf[] =
+            {
+                "invalid instruction!",
+                "parameter 1 invalid!",
+                "parameter 2 invalid!"
+            };
+            sprintf(buf,"Unable to parse instruction %d from script %.32s",i+1,name);
+            sprintf(buf2,"The error was: %s",errstrbuf[parse_err]);
+            sprintf(buf3,"The command was (%.60s)",code[i]->toString().c_str());
+            jwin_alert("Error",buf,buf2,buf3,"O&K",NULL,'k',0,lfont);
+            (*script)[0].command = 0xFFFF;
+            return D_CLOSE;
+        }
+    }
+    
+    return D_O_K;
+}
@@ -3,10 +3,16 @@
 #ifndef _FFASM_H_
 #define _FFASM_H_
 
+#include <vector>
+
+class Opcode;
+
 int set_argument(char *argbuf, ffscript **script, int com, int argument);
 int parse_script_section(char *combuf, char *arg1buf, char *arg2buf, ffscript **script, int com, int &retcode);
 int parse_script(ffscript **script);
 int parse_script_file(ffscript **script, const char *path, bool report_success);
+//Loads code straight from the compiler, rather than from its text
+int load_compiled_script(ffscript **script, std::vector<Opcode *> &code, const char *name);
 long ffparse(char *string);
 
 #endif
@@ -1,4 +1,5 @@
 #include "ffdebug.h"
+#include <stdio.h>
 
 extern long sarg1;
 extern long sarg2;
@@ -1132,7 +1133,7 @@ script_command command_list[NUMCOMMANDS+1]=
     { "LOADEWEAPONV",        1,   1,   0,   0},
     { "ALLOCATEMEMR",        2,   0,   0,   0},
     { "ALLOCATEMEMV",        2,   0,   1,   0},
-    { "ALLOCATEGMEM",        2,   0,   1,   0},
+    { "ALLOCATEGMEMV",       2,   0,   1,   0},
     { "DEALLOCATEMEMR",      1,   0,   0,   0},
     { "DEALLOCATEMEMV",      1,   1,   0,   0},
     { "WAITDRAW",			   0,   0,   0,   0},
@@ -1184,14 +1185,24 @@ script_command command_list[NUMCOMMANDS+1]=
     { "COMBOTILE",           2,   0,   0,   0},
     { "SETTILEWARP",         0,   0,   0,   0},
     { "GETSCREENEFLAGS",     1,   0,   0,   0},
-    { "GETSAVENAMER",        1,   0,   0,   0},
+    { "GETSAVENAME",         1,   0,   0,   0},
     { "ARRAYSIZE",           1,   0,   0,   0},
-    { "ITEMNAMER",           1,   0,   0,   0},
-    { "SETSAVENAMER",        1,   0,   0,   0},
+    { "ITEMNAME",            1,   0,   0,   0},
+    { "SETSAVENAME",         1,   0,   0,   0},
+    { "NPCNAME",             1,   0,   0,   0},
+    { "GETMESSAGE",          2,   0,   0,   0},
+    { "GETDMAPNAME",         2,   0,   0,   0},
+    { "GETDMAPTITLE",        2,   0,   0,   0},
+    { "GETDMAPINTRO",        2,   0,   0,   0},
+    { "ALLOCATEGMEMR",       2,   0,   0,   0},
+    { "DRAWBITMAP",          0,   0,   0,   0},
+    { "SETRENDERTARGET",     0,   0,   0,   0},
     { "PLAYENHMUSIC",        2,   0,   0,   0},
     { "GETMUSICFILE",        2,   0,   0,   0},
     { "GETMUSICTRACK",       1,   0,   0,   0},
     { "SETDMAPENHMUSIC",     0,   0,   0,   0},
+    { "DRAWLAYER",           0,   0,   0,   0},
+    { "DRAWSCREEN",          0,   0,   0,   0},
     { "BREAKSHIELD",         1,   0,   0,   0},
     { "SAVESCREEN",          1,   0,   0,   0},
     { "SAVEQUITSCREEN",      0,   0,   0,   0},
@@ -1205,6 +1216,11 @@ script_command command_list[NUMCOMMANDS+1]=
     { "GETTILEWARPDMAP",     1,   0,   0,   0},
     { "GETTILEWARPSCR",      1,   0,   0,   0},
     { "GETTILEWARPTYPE",     1,   0,   0,   0},
+    { "GETFFCSCRIPT",        1,   0,   0,   0},
+    { "WAITFRAMESR",         1,   0,   0,   0},
+    { "QUERYRADIUS",         2,   0,   1,   0},
+    { "QUERYRECT",           2,   0,   1,   0},
+    { "QUERYNEAREST",        2,   0,   1,   0},
     { "",                    0,   0,   0,   0}
 };
 
@@ -10,6 +10,7 @@
 
 namespace ffdebug
 {
+extern script_command command_list[NUMCOMMANDS+1];
 void print_disassembly(const word scommand);
 }
 
@@ -0,0 +1,639 @@
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// modified version 3 of the GNU General Public License. See License.txt for details.
+
+
+#include "precompiled.h" //always first
+
+#include <string.h>
+#include <vector>
+#include "zc_alleg.h"
+#include "ffjit.h"
+#include "ffdebug.h"
+#include "refInfo.h"
+
+extern refInfo *ri;
+
+#if defined(__x86_64__) || defined(_M_X64)
+
+#ifndef ALLEGRO_WINDOWS
+#include <sys/mman.h>
+#endif
+
+struct jit_script
+{
+    unsigned char *code;
+    size_t size;
+    const threaded_op *ops;
+    dword count;
+    unsigned char **labels; //Where the code for each op starts
+    bool verify;
+};
+
+//The machine code keeps ri in rbx and the commands left until the next poll in r13.
+//Calls go through rax, so only rbx and r13 need saving; both ABIs treat them as callee-saved.
+#ifdef ALLEGRO_WINDOWS
+#define JIT_FRAME 40 //32 bytes of shadow space, and 8 to keep the stack 16-byte aligned
+#else
+#define JIT_FRAME 8
+#endif
+
+typedef void (*jit_entry)(unsigned char *start, refInfo *r);
+
+//The running script, for the helpers called from the machine code
+static jit_script *jit_running = NULL;
+static jit_poller jit_poll = NULL;
+static dword jit_interval = 0;
+static dword jit_commands = 0; //Commands run up to the last poll
+static int jit_left = 0; //r13, while the script isn't running
+
+//Verification
+static refInfo jit_shadow;
+static const threaded_op *jit_expected = NULL;
+static dword jit_mismatches = 0;
+
+// Where a handler didn't just carry on with the next op: a jump, or a backward
+// jump once it's time to poll. Returns the code to go to, or NULL to stop.
+static unsigned char *jit_continue(const threaded_op *next, int left)
+{
+    if(left <= 0)
+    {
+        jit_commands += jit_interval - left;
+        left = jit_interval;
+        next = jit_poll(next, jit_commands);
+    }
+    
+    jit_left = left;
+    return next ? jit_running->labels[next - jit_running->ops] : NULL;
+}
+
+// Runs op's handler on a copy of ri, to check the inline code against
+static void jit_verify_before(const threaded_op *op)
+{
+    refInfo *real = ri;
+    jit_shadow = *real;
+    ri = &jit_shadow;
+    jit_expected = op->unfused(op);
+    ri = real;
+}
+
+static const threaded_op *jit_verify_after(const threaded_op *op, const threaded_op *next)
+{
+    const bool d_differ = memcmp(ri->d, jit_shadow.d, sizeof(ri->d)) != 0;
+    
+    if(d_differ || ri->scriptflag != jit_shadow.scriptflag || next != jit_expected)
+    {
+        if(++jit_mismatches <= 100)
+        {
+            al_trace("ZASM JIT: %s %ld %ld at %ld differs:%s%s%s\n",
+                     op->command < NUMCOMMANDS ? ffdebug::command_list[op->command].name : "?", op->arg1, op->arg2,
+                     long(op - jit_running->ops), d_differ ? " D registers" : "",
+                     ri->scriptflag != jit_shadow.scriptflag ? " flags" : "", next != jit_expected ? " next command" : "");
+            
+            for(int j = 0; d_differ && j < 8; j++)
+                al_trace("  d%d: %ld, threaded %ld\n", j, ri->d[j], jit_shadow.d[j]);
+        }
+    }
+    
+    return next;
+}
+
+// Machine code being put together, with jumps to be filled in once every op has been placed
+class jit_buffer
+{
+public:
+    std::vector<unsigned char> code;
+    std::vector<size_t> targets; //Offset of each op, then the two stubs below
+    
+    enum { SLOW, EXIT };
+    
+    jit_buffer(const dword count) : targets(count + 2, 0), stubs(count) {}
+    
+    void b(const int x)
+    {
+        code.push_back((unsigned char)x);
+    }
+    
+    void b(const int x, const int y)
+    {
+        b(x);
+        b(y);
+    }
+    
+    void b(const int x, const int y, const int z)
+    {
+        b(x);
+        b(y);
+        b(z);
+    }
+    
+    void d32(const long x)
+    {
+        for(int j = 0; j < 4; j++)
+            b(int(x >> (j * 8)) & 0xFF);
+    }
+    
+    void q64(const unsigned long long x)
+    {
+        for(int j = 0; j < 8; j++)
+            b(int(x >> (j * 8)) & 0xFF);
+    }
+    
+    void ptr(const void *p)
+    {
+        q64((unsigned long long)(size_t)p);
+    }
+    
+    //rel32 to an op, or to SLOW or EXIT
+    void rel(const dword target, const bool stub = false)
+    {
+        fixup f = { code.size(), stub ? stubs + target : target };
+        fixups.push_back(f);
+        d32(0);
+    }
+    
+    void place(const dword target)
+    {
+        targets[target] = code.size();
+    }
+    
+    void placeStub(const dword stub)
+    {
+        targets[stubs + stub] = code.size();
+    }
+    
+    void link()
+    {
+        for(unsigned int j = 0; j < fixups.size(); j++)
+        {
+            const long rel32 = long(targets[fixups[j].target]) - long(fixups[j].at + 4);
+            
+            for(int k = 0; k < 4; k++)
+                code[fixups[j].at + k] = (unsigned char)((rel32 >> (k * 8)) & 0xFF);
+        }
+    }
+
+private:
+    struct fixup
+    {
+        size_t at;
+        dword target;
+    };
+    
+    std::vector<fixup> fixups;
+    dword stubs;
+};
+
+static long jit_d_offset;
+static long jit_flag_offset;
+static const bool jit_d_wide = sizeof(long) == 8;
+static const bool jit_flag_wide = sizeof(dword) == 8;
+
+//op reg/opcode, [rbx+disp32], with REX.W when wide
+static void jit_mem(jit_buffer &c, const bool wide, const int opcode, const int reg, const long disp)
+{
+    if(wide)
+        c.b(0x48);
+    
+    c.b(opcode, 0x80 | (reg << 3) | 3);
+    c.d32(disp);
+}
+
+static inline long jit_d(const long arg)
+{
+    return jit_d_offset + arg * long(sizeof(long));
+}
+
+static void jit_arg1(jit_buffer &c, const void *p)
+{
+#ifdef ALLEGRO_WINDOWS
+    c.b(0x48, 0xB9); //mov rcx, imm64
+#else
+    c.b(0x48, 0xBF); //mov rdi, imm64
+#endif
+    c.ptr(p);
+}
+
+static void jit_call(jit_buffer &c, const void *fn)
+{
+    c.b(0x48, 0xB8); //mov rax, imm64
+    c.ptr(fn);
+    c.b(0xFF, 0xD0); //call rax
+}
+
+// Jumps from op j to op t; going backwards, checks whether it's time to poll first
+static void jit_jump(jit_buffer &c, const threaded_op *ops, const dword j, const dword t)
+{
+    if(t > j)
+    {
+        c.b(0xE9); //jmp
+        c.rel(t);
+        return;
+    }
+    
+    c.b(0x45, 0x85, 0xED); //test r13d, r13d
+    c.b(0x0F, 0x8F); //jg
+    c.rel(t);
+    c.b(0x48, 0xB8); //mov rax, imm64
+    c.ptr(ops + t);
+    c.b(0xE9); //jmp
+    c.rel(jit_buffer::SLOW, true);
+}
+
+static inline bool jit_is_d(const long arg)
+{
+    return arg >= REG_D(0) && arg <= REG_D(7);
+}
+
+// Whether op gets inline code rather than a call to its handler
+static bool jit_inline(const threaded_op &op, const dword count)
+{
+    switch(op.command)
+    {
+    case SETV:
+    case ADDV:
+    case SUBV:
+    case COMPAREV:
+        return jit_is_d(op.arg1) && op.arg2 >= -0x7FFFFFFFL - 1 && op.arg2 <= 0x7FFFFFFFL;
+    
+    case SETR:
+    case ADDR:
+    case SUBR:
+    case COMPARER:
+        return jit_is_d(op.arg1) && jit_is_d(op.arg2);
+    
+    // GOTOLESS depends on a quest rule, so is left to its handler
+    case GOTO:
+    case GOTOTRUE:
+    case GOTOFALSE:
+    case GOTOMORE:
+        return dword(op.arg1) < count;
+    }
+    
+    return false;
+}
+
+static void jit_test_flag(jit_buffer &c, const int flag)
+{
+    jit_mem(c, false, 0xF7, 0, jit_flag_offset); //test dword [flags], imm32
+    c.d32(flag);
+}
+
+static void jit_emit_inline(jit_buffer &c, const threaded_op *ops, const dword j, const bool verify)
+{
+    const threaded_op &op = ops[j];
+    const bool w = jit_d_wide;
+    
+    switch(op.command)
+    {
+    case SETV:
+        jit_mem(c, w, 0xC7, 0, jit_d(op.arg1)); //mov [d1], imm32
+        c.d32(op.arg2);
+        break;
+    
+    case SETR:
+        jit_mem(c, w, 0x8B, 0, jit_d(op.arg2)); //mov rax, [d2]
+        jit_mem(c, w, 0x89, 0, jit_d(op.arg1)); //mov [d1], rax
+        break;
+    
+    case ADDV:
+    case SUBV:
+        jit_mem(c, w, 0x81, op.command == ADDV ? 0 : 5, jit_d(op.arg1)); //add/sub [d1], imm32
+        c.d32(op.arg2);
+        break;
+    
+    case ADDR:
+    case SUBR:
+        jit_mem(c, w, 0x8B, 0, jit_d(op.arg2)); //mov rax, [d2]
+        jit_mem(c, w, op.command == ADDR ? 0x01 : 0x29, 0, jit_d(op.arg1)); //add/sub [d1], rax
+        break;
+    
+    case COMPAREV:
+    case COMPARER:
+        jit_mem(c, w, 0x8B, 0, jit_d(op.arg1)); //mov rax, [d1]
+        
+        if(op.command == COMPAREV)
+        {
+            if(w)
+                c.b(0x48);
+            
+            c.b(0x3D); //cmp rax, imm32
+            c.d32(op.arg2);
+        }
+        else
+            jit_mem(c, w, 0x3B, 0, jit_d(op.arg2)); //cmp rax, [d2]
+        
+        c.b(0x0F, 0x9D, 0xC1); //setge cl
+        c.b(0x0F, 0x94, 0xC2); //sete dl
+        c.b(0x0F, 0xB6, 0xC9); //movzx ecx, cl
+        c.b(0x0F, 0xB6, 0xD2); //movzx edx, dl
+        c.b(0x6B, 0xC9, MOREFLAG); //imul ecx, ecx, MOREFLAG
+        c.b(0x6B, 0xD2, TRUEFLAG); //imul edx, edx, TRUEFLAG
+        jit_mem(c, jit_flag_wide, 0x8B, 0, jit_flag_offset); //mov rax, [flags]
+        
+        if(jit_flag_wide)
+            c.b(0x48);
+        
+        c.b(0x25); //and rax, imm32
+        c.d32(~long(MOREFLAG | TRUEFLAG));
+        c.b(0x48, 0x09, 0xC8); //or rax, rcx
+        c.b(0x48, 0x09, 0xD0); //or rax, rdx
+        jit_mem(c, jit_flag_wide, 0x89, 0, jit_flag_offset); //mov [flags], rax
+        break;
+    
+    case GOTO:
+    case GOTOTRUE:
+    case GOTOFALSE:
+    case GOTOMORE:
+    {
+        const dword t = dword(op.arg1);
+        const int flag = (op.command == GOTOMORE) ? MOREFLAG : TRUEFLAG;
+        const bool when_set = op.command != GOTOFALSE;
+        
+        if(verify)
+        {
+            //Work out the next op as a pointer, check it, then carry on through SLOW
+            c.b(0x48, 0xB8); //mov rax, imm64
+            c.ptr(ops + (op.command == GOTO ? t : j + 1));
+            
+            if(op.command != GOTO)
+            {
+                c.b(0x48, 0xB9); //mov rcx, imm64
+                c.ptr(ops + t);
+                jit_test_flag(c, flag);
+                c.b(0x48, 0x0F, when_set ? 0x45 : 0x44); //cmovnz/cmovz rax, rcx
+                c.b(0xC1);
+            }
+
+#ifdef ALLEGRO_WINDOWS
+            c.b(0x48, 0x89, 0xC2); //mov rdx, rax
+#else
+            c.b(0x48, 0x89, 0xC6); //mov rsi, rax
+#endif
+            jit_arg1(c, &op);
+            jit_call(c, (const void *)&jit_verify_after);
+            c.b(0xE9); //jmp
+            c.rel(jit_buffer::SLOW, true);
+            return;
+        }
+        
+        if(op.command == GOTO)
+        {
+            jit_jump(c, ops, j, t);
+            return;
+        }
+        
+        jit_test_flag(c, flag);
+        
+        if(t > j)
+        {
+            c.b(0x0F, when_set ? 0x85 : 0x84); //jnz/jz
+            c.rel(t);
+        }
+        else
+        {
+            //Skip over the jump when it isn't taken
+            c.b(0x0F, when_set ? 0x84 : 0x85); //jz/jnz
+            c.rel(j + 1);
+            jit_jump(c, ops, j, t);
+        }
+        
+        return;
+    }
+    }
+    
+    if(verify)
+    {
+#ifdef ALLEGRO_WINDOWS
+        c.b(0x48, 0xBA); //mov rdx, imm64
+#else
+        c.b(0x48, 0xBE); //mov rsi, imm64
+#endif
+        c.ptr(&op + 1);
+        jit_arg1(c, &op);
+        jit_call(c, (const void *)&jit_verify_after);
+    }
+}
+
+static unsigned char *jit_alloc(const size_t size)
+{
+#ifdef ALLEGRO_WINDOWS
+    return (unsigned char *)VirtualAlloc(NULL, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+#else
+    void *p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+    return (p == MAP_FAILED) ? NULL : (unsigned char *)p;
+#endif
+}
+
+// Never writable and executable at once
+static bool jit_protect(unsigned char *p, const size_t size)
+{
+#ifdef ALLEGRO_WINDOWS
+    DWORD old;
+    return VirtualProtect(p, size, PAGE_EXECUTE_READ, &old) != 0;
+#else
+    return mprotect(p, size, PROT_READ | PROT_EXEC) == 0;
+#endif
+}
+
+static void jit_release(unsigned char *p, const size_t size)
+{
+#ifdef ALLEGRO_WINDOWS
+    (void)size;
+    VirtualFree(p, 0, MEM_RELEASE);
+#else
+    munmap(p, size);
+#endif
+}
+
+bool jit_available()
+{
+    return true;
+}
+
+jit_script *jit_compile(const threaded_op *ops, const dword count, const bool verify)
+{
+    if(!count)
+        return NULL;
+    
+    {
+        refInfo probe;
+        jit_d_offset = long((char *)&probe.d[0] - (char *)&probe);
+        jit_flag_offset = long((char *)&probe.scriptflag - (char *)&probe);
+    }
+    
+    jit_buffer c(count);
+    
+    //Entry: save rbx and r13, then go to the first op
+    c.b(0x53); //push rbx
+    c.b(0x41, 0x55); //push r13
+    c.b(0x48, 0x83, 0xEC); //sub rsp, JIT_FRAME
+    c.b(JIT_FRAME);
+#ifdef ALLEGRO_WINDOWS
+    c.b(0x48, 0x89, 0xD3); //mov rbx, rdx
+#else
+    c.b(0x48, 0x89, 0xF3); //mov rbx, rsi
+#endif
+    c.b(0x48, 0xB8); //mov rax, imm64
+    c.ptr(&jit_left);
+    c.b(0x44, 0x8B, 0x28); //mov r13d, [rax]
+#ifdef ALLEGRO_WINDOWS
+    c.b(0xFF, 0xE1); //jmp rcx
+#else
+    c.b(0xFF, 0xE7); //jmp rdi
+#endif
+    
+    dword inlined = 0;
+    
+    for(dword j = 0; j < count; j++)
+    {
+        const threaded_op &op = ops[j];
+        c.place(j);
+        c.b(0x41, 0xFF, 0xCD); //dec r13d
+        
+        if(jit_inline(op, count))
+        {
+            if(verify)
+            {
+                jit_arg1(c, &op);
+                jit_call(c, (const void *)&jit_verify_before);
+            }
+            
+            jit_emit_inline(c, ops, j, verify);
+            inlined++;
+            continue;
+        }
+        
+        //Anything else is left to its handler
+        jit_arg1(c, &op);
+        jit_call(c, (const void *)op.unfused);
+        c.b(0x48, 0xB9); //mov rcx, imm64
+        c.ptr(&op + 1);
+        c.b(0x48, 0x39, 0xC8); //cmp rax, rcx
+        c.b(0x0F, 0x85); //jne
+        c.rel(jit_buffer::SLOW, true);
+    }
+    
+    //SLOW: carry on from the op in rax (NULL to stop) through jit_continue()
+    c.placeStub(jit_buffer::SLOW);
+    c.b(0x48, 0x85, 0xC0); //test rax, rax
+    c.b(0x0F, 0x84); //jz
+    c.rel(jit_buffer::EXIT, true);
+#ifdef ALLEGRO_WINDOWS
+    c.b(0x48, 0x89, 0xC1); //mov rcx, rax
+    c.b(0x44, 0x89, 0xEA); //mov edx, r13d
+#else
+    c.b(0x48, 0x89, 0xC7); //mov rdi, rax
+    c.b(0x44, 0x89, 0xEE); //mov esi, r13d
+#endif
+    jit_call(c, (const void *)&jit_continue);
+    c.b(0x48, 0xB9); //mov rcx, imm64
+    c.ptr(&jit_left);
+    c.b(0x44, 0x8B, 0x29); //mov r13d, [rcx]
+    c.b(0x48, 0x85, 0xC0); //test rax, rax
+    c.b(0x0F, 0x84); //jz
+    c.rel(jit_buffer::EXIT, true);
+    c.b(0xFF, 0xE0); //jmp rax
+    
+    //EXIT: put r13 back in jit_left and return
+    c.placeStub(jit_buffer::EXIT);
+    c.b(0x48, 0xB9); //mov rcx, imm64
+    c.ptr(&jit_left);
+    c.b(0x44, 0x89, 0x29); //mov [rcx], r13d
+    c.b(0x48, 0x83, 0xC4); //add rsp, JIT_FRAME
+    c.b(JIT_FRAME);
+    c.b(0x41, 0x5D); //pop r13
+    c.b(0x5B); //pop rbx
+    c.b(0xC3); //ret
+    
+    c.link();
+    
+    unsigned char *code = jit_alloc(c.code.size());
+    
+    if(!code)
+    {
+        al_trace("ZASM JIT: couldn't allocate %lu bytes\n", (unsigned long)c.code.size());
+        return NULL;
+    }
+    
+    memcpy(code, &c.code[0], c.code.size());
+    
+    if(!jit_protect(code, c.code.size()))
+    {
+        al_trace("ZASM JIT: couldn't make the code executable\n");
+        jit_release(code, c.code.size());
+        return NULL;
+    }
+    
+    jit_script *s = new jit_script;
+    s->code = code;
+    s->size = c.code.size();
+    s->ops = ops;
+    s->count = count;
+    s->labels = new unsigned char*[count];
+    s->verify = verify;
+    
+    for(dword j = 0; j < count; j++)
+        s->labels[j] = code + c.targets[j];
+    
+    if(count > 1)
+        al_trace("ZASM JIT: %lu commands, %lu inline, %lu bytes%s\n", (unsigned long)count, (unsigned long)inlined,
+                 (unsigned long)s->size, verify ? ", verifying" : "");
+    
+    return s;
+}
+
+void jit_free(jit_script *s)
+{
+    if(!s)
+        return;
+    
+    jit_release(s->code, s->size);
+    delete[] s->labels;
+    delete s;
+}
+
+dword jit_run(jit_script *s, const dword pc, jit_poller poll, const dword poll_interval)
+{
+    jit_running = s;
+    jit_poll = poll;
+    jit_interval = poll_interval;
+    jit_commands = 0;
+    jit_left = int(poll_interval);
+    
+    const dword mismatches = jit_mismatches;
+    
+    reinterpret_cast<jit_entry>(s->code)(s->labels[pc < s->count ? pc : s->count - 1], ri);
+    
+    if(jit_mismatches != mismatches)
+        al_trace("ZASM JIT: %lu differences from the threaded engine this run\n", (unsigned long)(jit_mismatches - mismatches));
+    
+    jit_running = NULL;
+    return jit_commands + (poll_interval - jit_left);
+}
+
+#else
+
+struct jit_script
+{
+};
+
+bool jit_available()
+{
+    return false;
+}
+
+jit_script *jit_compile(const threaded_op *, const dword, const bool)
+{
+    return NULL;
+}
+
+void jit_free(jit_script *)
+{
+}
+
+dword jit_run(jit_script *, const dword, jit_poller, const dword)
+{
+    return 0;
+}
+
+#endif
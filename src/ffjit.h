@@ -0,0 +1,29 @@
+//Compiles decoded ZASM scripts to x86-64 machine code. The simple register
+//commands (SETV, ADDR, COMPAREV, GOTOTRUE and so on) become inline code, and
+//everything else calls the command's threaded handler, so the two engines share
+//the code for anything with side effects. Anywhere else, jit_available() is
+//false and run_script_threaded() carries on as before.
+
+#ifndef _FFJIT_H
+#define _FFJIT_H
+
+#include "ffscript.h"
+
+struct jit_script;
+
+//Called every poll_interval commands with the next op and the running total;
+//returns the op to carry on from, or NULL to stop (see zasm_poll)
+typedef const threaded_op *(*jit_poller)(const threaded_op *op, const dword commands);
+
+bool jit_available();
+
+//With verify set, every inline command is also run through its handler on a copy
+//of ri, and any difference is logged
+jit_script *jit_compile(const threaded_op *ops, const dword count, const bool verify);
+void jit_free(jit_script *s);
+
+//Runs from ops[pc] until a handler returns NULL, the same as the threaded loop.
+//Returns how many commands were run.
+dword jit_run(jit_script *s, const dword pc, jit_poller poll, const dword poll_interval);
+
+#endif
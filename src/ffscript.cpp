@@ -31,6 +31,9 @@
 #include "messageManager.h"
 #include "sfxManager.h"
 #include "sound.h"
+#include "zscriptprofiler.h"
+#include "ffjit.h"
+#include "spatialIndex.h"
 
 #ifdef _FFDEBUG
 #include "ffdebug.h"
@@ -59,6 +62,7 @@ extern MessageManager messageMgr;
 extern SFXManager sfxMgr;
 
 extern sprite_list particles;
+extern sprite_list guys, items, Ewpns, Lwpns;
 extern LinkClass Link;
 extern char *guy_string[];
 extern int skipcont;
@@ -73,6 +77,7 @@ ffscript *curscript = NULL;
 static bool scriptCanSave = true;
 byte curScriptType;
 word curScriptNum;
+byte curScriptIndex;
 
 //Global script data
 refInfo globalScriptData;
@@ -88,6 +93,23 @@ long ffc_stack[32][256];
 long global_stack[256];
 long item_stack[256];
 
+//The lowest item stack slot written to since it was last cleared. The item stack is cleared every
+//time an item script starts, but only from where the last ones got down to.
+static int item_stack_low = 256;
+static bool item_clear_all = false; //For benchmark_item_scripts()
+
+//For Screen->NPCsInRadius() and the like; thrown away whenever a script might see the sprites
+//somewhere else, i.e. before each batch of scripts and when one moves or clears them
+static SpatialIndex guys_index(guys), items_index(items), ewpns_index(Ewpns), lwpns_index(Lwpns);
+
+static void invalidate_spatial_index()
+{
+    guys_index.invalidate();
+    items_index.invalidate();
+    ewpns_index.invalidate();
+    lwpns_index.invalidate();
+}
+
 void clear_ffc_stack(const byte i)
 {
     memset(ffc_stack[i], 0, 256 * sizeof(long));
@@ -135,6 +157,9 @@ public:
         }
         
         (*stack)[stackoffset] = value;
+        
+        if(stack == &item_stack && stackoffset < item_stack_low && stackoffset > 0)
+            item_stack_low = stackoffset;
     }
     
     static long read_stack(const int stackoffset)
@@ -871,6 +896,92 @@ public:
     }
 };
 
+// Which localRAM slots are in use: a bit for each slot, and a bit for each word of those that's
+// full. Allocating takes the lowest free slot, as it always has, so scripts see the same pointers,
+// but finds it straight away rather than checking every slot up to it.
+#define LOCAL_ARRAY_WORDS (MAX_ZCARRAY_SIZE / 32)
+static unsigned int local_array_used[LOCAL_ARRAY_WORDS] = { 1 };
+static unsigned int local_array_full[(LOCAL_ARRAY_WORDS + 31) / 32];
+static int local_array_count = 0;
+
+static INLINE int lowest_bit(unsigned int x) //x can't be 0
+{
+#ifdef __GNUC__
+    return __builtin_ctz(x);
+#else
+    int n = 0;
+    
+    for(; !(x & 1); x >>= 1)
+        n++;
+        
+    return n;
+#endif
+}
+
+static void mark_local_array(const long ptrval, const bool used)
+{
+    const int slot_word = ptrval / 32;
+    
+    if(used)
+        local_array_used[slot_word] |= 1u << (ptrval % 32);
+    else
+        local_array_used[slot_word] &= ~(1u << (ptrval % 32));
+        
+    if(local_array_used[slot_word] == 0xFFFFFFFF)
+        local_array_full[slot_word / 32] |= 1u << (slot_word % 32);
+    else
+        local_array_full[slot_word / 32] &= ~(1u << (slot_word % 32));
+}
+
+// Called with localRAM emptied
+void clearLocalArraySlots()
+{
+    memset(local_array_used, 0, sizeof(local_array_used));
+    memset(local_array_full, 0, sizeof(local_array_full));
+    local_array_count = 0;
+    mark_local_array(0, true); //localRAM[0] is never used
+}
+
+// MAX_ZCARRAY_SIZE if they're all in use
+static long find_free_local_array()
+{
+    for(int j = 0; j < (LOCAL_ARRAY_WORDS + 31) / 32; j++)
+    {
+        if(local_array_full[j] == 0xFFFFFFFF)
+            continue;
+            
+        const int slot_word = j * 32 + lowest_bit(~local_array_full[j]);
+        
+        if(slot_word >= LOCAL_ARRAY_WORDS)
+            break;
+            
+        return slot_word * 32 + lowest_bit(~local_array_used[slot_word]);
+    }
+    
+    return MAX_ZCARRAY_SIZE;
+}
+
+// The next local array in use after ptrval, or MAX_ZCARRAY_SIZE
+long nextLocalArray(const long ptrval)
+{
+    long next = ptrval + 1;
+    
+    for(int slot_word = next / 32; slot_word < LOCAL_ARRAY_WORDS; slot_word++, next = slot_word * 32)
+    {
+        const unsigned int bits = local_array_used[slot_word] & (0xFFFFFFFF << (next % 32));
+        
+        if(bits)
+            return slot_word * 32 + lowest_bit(bits);
+    }
+    
+    return MAX_ZCARRAY_SIZE;
+}
+
+int localArrayCount()
+{
+    return local_array_count;
+}
+
 // Called when leaving a screen; deallocate arrays created by FFCs that aren't carried over
 void deallocateArray(const long ptrval)
 {
@@ -883,7 +994,11 @@ void deallocateArray(const long ptrval)
         if(localRAM[ptrval].Size() == 0)
             Z_scripterrlog("Script tried to deallocate memory that was not allocated at address %ld\n", ptrval);
         else
+        {
             localRAM[ptrval].Clear();
+            mark_local_array(ptrval, false);
+            local_array_count--;
+        }
     }
 }
 
@@ -2877,7 +2992,7 @@ void set_register(const long arg, const long value)
         break;
         
     case FFSCRIPT:
-        for(long i = 1; i < MAX_ZCARRAY_SIZE; i++)
+        for(long i = nextLocalArray(0); i < MAX_ZCARRAY_SIZE; i = nextLocalArray(i))
         {
             if(arrayOwner[i]==ri->ffcref)
                 deallocateArray(i);
@@ -3290,6 +3405,7 @@ void set_register(const long arg, const long value)
         if(0!=(s=checkItem(ri->itemref)))
         {
             (s->x)=(fix)(value/10000);
+            invalidate_spatial_index();
             
             // Move the Fairy enemy as well.
             if(itemsbuf[((item*)(s))->id].family==itype_fairy && itemsbuf[((item*)(s))->id].misc3)
@@ -3302,6 +3418,7 @@ void set_register(const long arg, const long value)
         if(0!=(s=checkItem(ri->itemref)))
         {
             (s->y)=(fix)(value/10000);
+            invalidate_spatial_index();
             
             // Move the Fairy enemy as well.
             if(itemsbuf[((item*)(s))->id].family==itype_fairy && itemsbuf[((item*)(s))->id].misc3)
@@ -3640,14 +3757,20 @@ void set_register(const long arg, const long value)
 //LWeapon Variables
     case LWPNX:
         if(0!=(s=checkLWpn(ri->lwpn,"X")))
+        {
             ((weapon*)s)->x=(fix)(value/10000);
-            
+            lwpns_index.invalidate();
+        }
+        
         break;
         
     case LWPNY:
         if(0!=(s=checkLWpn(ri->lwpn,"Y")))
+        {
             ((weapon*)s)->y=(fix)(value/10000);
-            
+            lwpns_index.invalidate();
+        }
+        
         break;
         
     case LWPNZ:
@@ -3861,14 +3984,20 @@ void set_register(const long arg, const long value)
 //EWeapon Variables
     case EWPNX:
         if(0!=(s=checkEWpn(ri->ewpn,"X")))
+        {
             ((weapon*)s)->x=(fix)(value/10000);
-            
+            ewpns_index.invalidate();
+        }
+        
         break;
         
     case EWPNY:
         if(0!=(s=checkEWpn(ri->ewpn,"Y")))
+        {
             ((weapon*)s)->y=(fix)(value/10000);
-            
+            ewpns_index.invalidate();
+        }
+        
         break;
         
     case EWPNZ:
@@ -4087,6 +4216,7 @@ void set_register(const long arg, const long value)
         if(GuyH::loadNPC(ri->guyref, "npc->X") == SH::_NoError)
         {
             GuyH::getNPC()->x = fix(value / 10000);
+            guys_index.invalidate();
             
             if(GuyH::hasLink())
                 Link.setX(fix(value / 10000));
@@ -4101,6 +4231,7 @@ void set_register(const long arg, const long value)
             fix oldy = GuyH::getNPC()->y;
             GuyH::getNPC()->y = fix(value / 10000);
             GuyH::getNPC()->floor_y += ((value / 10000) - oldy);
+            guys_index.invalidate();
             
             if(GuyH::hasLink())
                 Link.setY(fix(value / 10000));
@@ -4897,6 +5028,14 @@ void do_comp(const bool v)
     else                ri->scriptflag &= ~TRUEFLAG;
 }
 
+static dword global_array_next = 0;
+
+// Called when game->globalRAM is set up again
+void clearGlobalArraySlots()
+{
+    global_array_next = 0;
+}
+
 void do_allocatemem(const bool v, const bool local, const byte i)
 {
     const long size = SH::get_arg(sarg2, v) / 10000;
@@ -4912,7 +5051,7 @@ void do_allocatemem(const bool v, const bool local, const byte i)
     if(local)
     {
         //localRAM[0] is used as an invalid container, so 0 can be the NULL pointer in ZScript
-        for(ptrval = 1; localRAM[ptrval].Size() != 0; ptrval++) ;
+        ptrval = find_free_local_array();
         
         if(ptrval >= MAX_ZCARRAY_SIZE)
         {
@@ -4924,32 +5063,36 @@ void do_allocatemem(const bool v, const bool local, const byte i)
             ZScriptArray &a = localRAM[ptrval]; //marginally faster for large arrays if we use a reference
             
             a.Resize(size);
+            a.Zero();
+            mark_local_array(ptrval, true);
+            local_array_count++;
             
-            for(dword j = 0; j < (dword)size; j++)
-                a[j] = 0; //initialize array
-                
             // Keep track of which FFC created the array so we know which to deallocate when changing screens
             arrayOwner[ptrval]=i;
         }
     }
     else
     {
-        //Globals are only allocated here at first play, otherwise in init_game
-        for(ptrval = 0; game->globalRAM[ptrval].Size() != 0; ptrval++) ;
+        //Globals are only allocated here at first play, otherwise in init_game. They're never
+        //freed, so everything before global_array_next is in use.
+        while(global_array_next < game->globalRAM.size() && game->globalRAM[global_array_next].Size() != 0)
+            global_array_next++;
+            
+        ptrval = global_array_next;
         
         if(ptrval >= game->globalRAM.size())
         {
             al_trace("Invalid pointer value of %ld passed to global allocate\n", ptrval);
             //this shouldn't happen, unless people are putting ALLOCATEGMEM in their ZASM scripts where they shouldn't be
+            set_register(sarg1, 0);
+            return;
         }
         
         ZScriptArray &a = game->globalRAM[ptrval];
         
         a.Resize(size);
+        a.Zero();
         
-        for(dword j = 0; j < (dword)size; j++)
-            a[j] = 0;
-            
         ptrval += MAX_ZCARRAY_SIZE; //so each pointer has a unique value
     }
     
@@ -5685,6 +5828,8 @@ void do_clearsprites(const bool v)
     if(BC::checkBounds(spritelist, 0, 5, "Screen->ClearSprites") != SH::_NoError)
         return;
         
+    invalidate_spatial_index();
+    
     switch(spritelist)
     {
     case 0:
@@ -5873,6 +6018,91 @@ void do_createnpc(const bool v)
     }
 }
 
+///----------------------------------------------------------------------------------------------------//
+//Spatial queries
+
+//The second argument is the sprite list, numbered as in Screen->ClearSprites. The rest are on the
+//stack, with any array last.
+static SpatialIndex *get_spatial_index(const long list)
+{
+    switch(list)
+    {
+    case 0:
+        return &guys_index;
+        
+    case 1:
+        return &items_index;
+        
+    case 2:
+        return &ewpns_index;
+        
+    case 3:
+        return &lwpns_index;
+    }
+    
+    Z_scripterrlog("Invalid sprite list %ld for a spatial query\n", list);
+    return NULL;
+}
+
+//Stores as many of the (1-based) indices as fit in the array; returns how many did
+static long set_query_results(const long arrayptr, const int *results, const int found)
+{
+    ZScriptArray &a = ArrayH::getArray(arrayptr);
+    
+    if(a == INVALIDARRAY)
+        return 0;
+        
+    const int n = zc_min(found, int(a.Size()));
+    
+    for(int j = 0; j < n; j++)
+        a[j] = (results[j] + 1) * 10000;
+        
+    return n * 10000;
+}
+
+void do_queryradius()
+{
+    SpatialIndex *index = get_spatial_index(sarg2 / 10000);
+    long ret = 0;
+    
+    if(index)
+    {
+        int results[SLMAX];
+        const int found = index->inRadius(SH::read_stack(ri->sp + 3), SH::read_stack(ri->sp + 2),
+                                          SH::read_stack(ri->sp + 1), results);
+        ret = set_query_results(SH::read_stack(ri->sp) / 10000, results, found);
+    }
+    
+    set_register(sarg1, ret);
+}
+
+void do_queryrect()
+{
+    SpatialIndex *index = get_spatial_index(sarg2 / 10000);
+    long ret = 0;
+    
+    if(index)
+    {
+        int results[SLMAX];
+        const int found = index->inRect(SH::read_stack(ri->sp + 4), SH::read_stack(ri->sp + 3),
+                                        SH::read_stack(ri->sp + 2), SH::read_stack(ri->sp + 1), results);
+        ret = set_query_results(SH::read_stack(ri->sp) / 10000, results, found);
+    }
+    
+    set_register(sarg1, ret);
+}
+
+void do_querynearest()
+{
+    SpatialIndex *index = get_spatial_index(sarg2 / 10000);
+    long ret = 0;
+    
+    if(index)
+        ret = (index->nearest(SH::read_stack(ri->sp + 1), SH::read_stack(ri->sp)) + 1) * 10000;
+        
+    set_register(sarg1, ret);
+}
+
 ///----------------------------------------------------------------------------------------------------//
 //Drawing & Sound
 
@@ -6136,20 +6366,14 @@ void do_trace(bool v)
     sprintf(tmp, (temp < 0 ? "%06ld" : "%05ld"), temp);
     string s2(tmp);
     s2 = s2.substr(0, s2.size() - 4) + "." + s2.substr(s2.size() - 4, 4);
-    al_trace("%s\n", s2.c_str());
-    
-    if(zconsole)
-        printf("%s\n", s2.c_str());
+    zc_trace_console((s2 + "\n").c_str());
 }
 
 void do_tracebool(const bool v)
 {
     long temp = SH::get_arg(sarg1, v);
     
-    al_trace("%s\n", temp ? "true": "false");
-    
-    if(zconsole)
-        printf("%s\n", temp ? "true": "false");
+    zc_trace_console(temp ? "true\n" : "false\n");
 }
 
 void do_tracestring()
@@ -6157,18 +6381,12 @@ void do_tracestring()
     long arrayptr = get_register(sarg1) / 10000;
     string str;
     ArrayH::getString(arrayptr, str, 512);
-    al_trace("%s", str.c_str());
-    
-    if(zconsole)
-        printf("%s", str.c_str());
+    zc_trace_console(str.c_str());
 }
 
 void do_tracenl()
 {
-    al_trace("\n");
-    
-    if(zconsole)
-        printf("\n");
+    zc_trace_console("\n");
 }
 
 void do_cleartrace()
@@ -6230,10 +6448,7 @@ void do_tracetobase()
         break;
     }
     
-    al_trace("%s\n", s2.c_str());
-    
-    if(zconsole)
-        printf("%s\n", s2.c_str());
+    zc_trace_console((s2 + "\n").c_str());
 }
 
 ///----------------------------------------------------------------------------------------------------//
@@ -6473,26 +6688,32 @@ INLINE void check_quit()
     }
 }
 
-// Let's do this
-int run_script(const byte type, const word script, const byte i)
+#define ZASM_POLL_COMMANDS 4096 //How often running scripts check for Alt+F4 and their budget; a power of 2
+
+dword zasm_command_budget = 10000000;
+
+// A script has run zasm_command_budget commands without waiting. Returns WAITFRAME to carry on
+// from pc next frame, or 0xFFFF to end it, depending on the quest rule.
+static word runaway_script(const dword commands, const dword pc)
+{
+    const bool kill = get_bit(quest_rules, qr_KILLRUNAWAYSCRIPTS) != 0;
+    
+    if(curScriptType == SCRIPT_FFC)
+        Z_scripterrlog("Script on FFC %d ran %lu commands without waiting, %s at command %lu\n",
+                       curScriptIndex + 1, (unsigned long)commands, kill ? "killed" : "stopped until next frame", (unsigned long)pc);
+    else
+        Z_scripterrlog("Script ran %lu commands without waiting, %s at command %lu\n",
+                       (unsigned long)commands, kill ? "killed" : "stopped until next frame", (unsigned long)pc);
+                       
+    return kill ? 0xFFFF : WAITFRAME;
+}
+
+// Points ri, curscript and stack at the data for this script
+static bool begin_script(const byte type, const word script, const byte i)
 {
     curScriptType=type;
     curScriptNum=script;
-    
-#ifdef _SCRIPT_COUNTER
-    dword script_timer[NUMCOMMANDS];
-    dword script_execount[NUMCOMMANDS];
-    
-    for(int j = 0; j < NUMCOMMANDS; j++)
-    {
-        script_timer[j]=0;
-        script_execount[j]=0;
-    }
-    
-    dword start_time, end_time;
-    
-    script_counter = 0;
-#endif
+    curScriptIndex=i;
     
     switch(type)
     {
@@ -6516,11 +6737,24 @@ int run_script(const byte type, const word script, const byte i)
     case SCRIPT_ITEM:
     {
         ri = &itemScriptData;
-        ri->Clear(); //Only runs for one frame so we just zero it out
+        invalidate_spatial_index();
+        
+        //Only runs for one frame so we just zero it out; d and a are set below anyway
+        if(item_clear_all)
+            ri->Clear();
+        else
+            ri->ClearState();
         
         curscript = itemscripts[script];
         stack = &item_stack;
-        memset(stack, 0, 256 * sizeof(long)); //zero here too
+        
+        //zero here too, as far as the last one used
+        if(item_clear_all)
+            memset(stack, 0, 256 * sizeof(long));
+        else if(item_stack_low < 256)
+            memset(&item_stack[item_stack_low], 0, (256 - item_stack_low) * sizeof(long));
+        
+        item_stack_low = 256;
         
         memcpy(ri->d, itemsbuf[i].initiald, 8 * sizeof(long));
         memcpy(ri->a, itemsbuf[i].initiala, 2 * sizeof(long));
@@ -6533,6 +6767,7 @@ int run_script(const byte type, const word script, const byte i)
     case SCRIPT_GLOBAL:
     {
         ri = &globalScriptData;
+        invalidate_spatial_index();
         
         curscript = globalscripts[script];
         stack = &global_stack;
@@ -6541,10 +6776,131 @@ int run_script(const byte type, const word script, const byte i)
     
     default:
         al_trace("No other scripts are currently supported\n");
-        return 1;
+        return false;
+    }
+    
+    return true;
+}
+
+// Stores the script's state once it has stopped running for this frame
+static void end_script(const byte type, const byte i, const word scommand, dword pc)
+{
+    if(!scriptCanSave)
+        scriptCanSave=true;
+    
+    if(scommand == WAITDRAW)
+    {
+        switch(type)
+        {
+        case SCRIPT_GLOBAL:
+            global_wait = true;
+            break;
+            
+        default:
+            Z_scripterrlog("Waitdraw can only be used in the active global script\n");
+            break;
+        }
+    }
+    
+    if(scommand == 0xFFFF) //Quit/command list end reached/bad command
+    {
+        switch(type)
+        {
+        case SCRIPT_FFC:
+            tmpscr->ffcs[i].script = 0;
+            break;
+            
+        case SCRIPT_GLOBAL:
+            g_doscript = 0;
+            break;
+            
+        case SCRIPT_ITEM:
+            break; //item scripts aren't gonna go again anyway
+        }
+    }
+    else
+        pc++;
+        
+    ri->pc = pc; //Put it back where we got it from
+}
+
+// WAITFRAMESR: the first frame is waited out like a WAITFRAME, and script_sleeping() skips
+// the rest without running the script. As with the loop in std.zh it replaces, part of a
+// frame counts as a whole one. Returns whether the script should stop.
+static bool begin_waitframes(const long n)
+{
+    const long long frames = ((long long)n + 9999) / 10000;
+    
+    if(frames <= 0)
+        return false;
+        
+    ri->waitframes = dword(frames - 1);
+    return true;
+}
+
+bool script_sleeping(const byte type, const byte i)
+{
+    refInfo *r;
+    
+    switch(type)
+    {
+    case SCRIPT_FFC:
+        r = &(tmpscr->ffcs[i].scriptData);
+        break;
+        
+    case SCRIPT_GLOBAL:
+        r = &globalScriptData;
         break;
+        
+    default:
+        return false; //Item scripts start again every time
+    }
+    
+    if(!r->waitframes)
+        return false;
+        
+    r->waitframes--;
+    return true;
+}
+
+// Let's do this
+// Runs an empty item script 100000 times, clearing the whole stack and refInfo each time as it used
+// to, then clearing them lazily, and writes both times to allegro.log
+void benchmark_item_scripts()
+{
+    static ffscript empty[1];
+    empty[0].command = 0xFFFF;
+    
+    const int runs = 100000;
+    ffscript *old = itemscripts[0];
+    itemscripts[0] = empty;
+    
+    unsigned long long ticks[2];
+    
+    for(int pass = 0; pass < 2; pass++)
+    {
+        item_clear_all = (pass == 0);
+        const unsigned long long start = ZScriptProfiler::now();
+        
+        for(int j = 0; j < runs; j++)
+            run_script(SCRIPT_ITEM, 0, 0);
+        
+        ticks[pass] = ZScriptProfiler::now() - start;
     }
     
+    item_clear_all = false;
+    itemscripts[0] = old;
+    
+    const double ticks_per_us = ZScriptProfiler::ticksPerSecond() / 1000000.0;
+    al_trace("Item script benchmark, %d runs: full clear %.0fus, lazy clear %.0fus\n",
+             runs, ticks[0] / ticks_per_us, ticks[1] / ticks_per_us);
+}
+
+int run_script(const byte type, const word script, const byte i)
+{
+    if(!begin_script(type, script, i))
+        return 1;
+        
     dword pc = ri->pc; //this is (marginally) quicker than dereferencing ri each time
     word scommand = curscript[pc].command;
     sarg1 = curscript[pc].arg1;
@@ -6578,26 +6934,52 @@ int run_script(const byte type, const word script, const byte i)
 #endif
     
     bool increment = true;
+    const bool profiling = ZScriptProfiler::Enabled;
+    dword commands = 0;
+    unsigned long long ticks = 0, start_time = 0;
     
     while(scommand != 0xFFFF && scommand != WAITFRAME && scommand != WAITDRAW)
     {
-        check_quit();
-        
 #ifdef _FFDEBUG
 #ifdef _FFDISSASSEMBLY
         ffdebug::print_dissassembly(scommand);
 #endif
-#ifdef _SCRIPT_COUNTER
-        start_time = script_counter;
-#endif
 #endif
         
+        const word command = scommand; //Some of them change scommand
+        
+        if(profiling)
+            start_time = ZScriptProfiler::now();
+            
+
         switch(scommand)
         {
         case QUIT:
             scommand = 0xFFFF;
             break;
             
+        case QUERYRADIUS:
+            do_queryradius();
+            break;
+            
+        case QUERYRECT:
+            do_queryrect();
+            break;
+            
+        case QUERYNEAREST:
+            do_querynearest();
+            break;
+            
+        case WAITFRAMESR:
+            if(begin_waitframes(get_register(sarg1)))
+            {
+                // Stops here, as if at a WAITFRAME
+                scommand = WAITFRAME;
+                increment = false;
+            }
+            
+            break;
+            
         case GOTO:
             pc = sarg1;
             increment = false;
@@ -7466,78 +7848,1160 @@ int run_script(const byte type, const word script, const byte i)
             break;
         }
         
-#ifdef _SCRIPT_COUNTER
-        end_time = script_counter;
-        script_timer[*command] += end_time - start_time;
-        ++script_execount[*command];
-#endif
+        if(profiling)
+        {
+            const unsigned long long elapsed = ZScriptProfiler::now() - start_time;
+            ZScriptProfiler::recordCommand(command, elapsed);
+            ticks += elapsed;
+        }
         
         if(increment)	pc++;
         else			increment = true;
         
-        if(scommand != 0xFFFF)
+        if(scommand != 0xFFFF && scommand != WAITFRAME)
         {
             scommand = curscript[pc].command;
             sarg1 = curscript[pc].arg1;
             sarg2 = curscript[pc].arg2;
         }
+        
+        if((++commands & (ZASM_POLL_COMMANDS - 1)) == 0)
+        {
+            check_quit();
+            
+            // If it's about to stop anyway, it can
+            if(zasm_command_budget && commands >= zasm_command_budget &&
+                    scommand != 0xFFFF && scommand != WAITFRAME && scommand != WAITDRAW)
+            {
+                scommand = runaway_script(commands, pc);
+                
+                // pc hasn't been run yet, and end_script() moves on one
+                if(scommand == WAITFRAME)
+                    pc--;
+                    
+                break;
+            }
+        }
     }
     
-    if(!scriptCanSave)
-        scriptCanSave=true;
+    end_script(type, i, scommand, pc);
     
-    if(scommand == WAITDRAW)
+    if(profiling)
+        ZScriptProfiler::recordScript(type, script, i, commands, ticks);
+        
+    return 0;
+}
+
+///----------------------------------------------------------------------------------------------------//
+//                                  Run the script (threaded)                                          //
+///----------------------------------------------------------------------------------------------------//
+
+// Each script is decoded once, when the quest is loaded, into an array of threaded_ops that point
+// straight at the code for their command. run_script_threaded() then just hops from one handler to
+// the next, rather than going back through the big switch in run_script() for every command.
+// run_script() is still there (see ZScriptVersion::setThreaded) so the two can be compared.
+
+struct threaded_script
+{
+    const ffscript *source; //The script this was decoded from
+    threaded_op *ops;
+    dword count;
+    jit_script *jit; //Compiled the first time it runs with zasm_jit on
+};
+
+static threaded_script threaded_ffscripts[NUMSCRIPTFFC];
+static threaded_script threaded_itemscripts[NUMSCRIPTITEM];
+static threaded_script threaded_globalscripts[NUMSCRIPTGLOBAL];
+
+bool zasm_optimize = true;
+bool zasm_jit = false;
+bool zasm_jit_verify = false;
+
+static const threaded_op *thread_base = NULL; //First op of the running script
+static dword thread_count = 0;
+static word thread_stop = 0xFFFF; //The command which stopped the script..
+static dword thread_stop_pc = 0; //..and where it was
+
+static INLINE const threaded_op *zasm_stop(const threaded_op *op, const word command)
+{
+    thread_stop = command;
+    thread_stop_pc = dword(op - thread_base);
+    return NULL;
+}
+
+// Every ZASM_POLL_COMMANDS commands, op being the next one to run
+static const threaded_op *zasm_poll(const threaded_op *op, const dword commands)
+{
+    check_quit();
+    
+    if(zasm_command_budget && commands >= zasm_command_budget && op->command != WAITFRAME && op->command != WAITDRAW)
     {
-        switch(type)
+        thread_stop = runaway_script(commands, dword(op - thread_base));
+        // op hasn't been run yet, and end_script() moves on one
+        thread_stop_pc = dword(op - thread_base) - (thread_stop == WAITFRAME ? 1 : 0);
+        return NULL;
+    }
+    
+    return op;
+}
+
+static INLINE const threaded_op *zasm_jump(const threaded_op *op, const long target)
+{
+    if(dword(target) >= thread_count)
+    {
+        Z_scripterrlog("Script tried to jump to invalid command %ld\n", target);
+        return zasm_stop(op, 0xFFFF);
+    }
+    
+    return thread_base + target;
+}
+
+#define ZASM_HANDLER(name, body) \
+static const threaded_op *zasm_##name(const threaded_op *op) \
+{ \
+    sarg1 = op->arg1; \
+    sarg2 = op->arg2; \
+    body; \
+    return op + 1; \
+}
+
+//Flow control
+static const threaded_op *zasm_end(const threaded_op *op)
+{
+    return zasm_stop(op, 0xFFFF);
+}
+
+static const threaded_op *zasm_QUIT(const threaded_op *op)
+{
+    return zasm_stop(op, 0xFFFF);
+}
+
+static const threaded_op *zasm_WAITFRAME(const threaded_op *op)
+{
+    return zasm_stop(op, WAITFRAME);
+}
+
+static const threaded_op *zasm_WAITDRAW(const threaded_op *op)
+{
+    return zasm_stop(op, WAITDRAW);
+}
+
+static const threaded_op *zasm_WAITFRAMESR(const threaded_op *op)
+{
+    if(begin_waitframes(op->get1(op->arg1)))
+        return zasm_stop(op, WAITFRAME);
+        
+    return op + 1;
+}
+
+static const threaded_op *zasm_GAMEEND(const threaded_op *op)
+{
+    Quit = qQUIT;
+    skipcont = 1;
+    return zasm_stop(op, 0xFFFF);
+}
+
+static const threaded_op *zasm_GOTO(const threaded_op *op)
+{
+    return zasm_jump(op, op->arg1);
+}
+
+static const threaded_op *zasm_GOTOR(const threaded_op *op)
+{
+    return zasm_jump(op, (op->get1(op->arg1) / 10000) - 1);
+}
+
+static const threaded_op *zasm_GOTOTRUE(const threaded_op *op)
+{
+    if(ri->scriptflag & TRUEFLAG)
+        return zasm_jump(op, op->arg1);
+        
+    return op + 1;
+}
+
+static const threaded_op *zasm_GOTOFALSE(const threaded_op *op)
+{
+    if(!(ri->scriptflag & TRUEFLAG))
+        return zasm_jump(op, op->arg1);
+        
+    return op + 1;
+}
+
+static const threaded_op *zasm_GOTOMORE(const threaded_op *op)
+{
+    if(ri->scriptflag & MOREFLAG)
+        return zasm_jump(op, op->arg1);
+        
+    return op + 1;
+}
+
+static const threaded_op *zasm_GOTOLESS(const threaded_op *op)
+{
+    if(!(ri->scriptflag & MOREFLAG) || (!get_bit(quest_rules,qr_GOTOLESSNOTEQUAL) && (ri->scriptflag & TRUEFLAG)))
+        return zasm_jump(op, op->arg1);
+        
+    return op + 1;
+}
+
+static const threaded_op *zasm_LOOP(const threaded_op *op)
+{
+    if(op->get2(op->arg2) > 0)
+        return zasm_jump(op, op->arg1);
+        
+    op->set1(op->arg1, op->arg1 - 1);
+    return op + 1;
+}
+
+static const threaded_op *zasm_SAVE(const threaded_op *op)
+{
+    if(scriptCanSave)
+    {
+        save_game(false);
+        scriptCanSave=false;
+    }
+    
+    return op + 1;
+}
+
+ZASM_HANDLER(drawing, do_drawing_command(op->command))
+
+static const threaded_op *zasm_nop(const threaded_op *op)
+{
+    return op + 1;
+}
+
+static const threaded_op *zasm_invalid(const threaded_op *op)
+{
+    Z_scripterrlog("Invalid ZASM command %ld reached\n", op->command);
+    return op + 1;
+}
+
+//Commands which use the operand accessors bound by bind_operands()
+static const threaded_op *zasm_set(const threaded_op *op)
+{
+    op->set1(op->arg1, op->get2(op->arg2));
+    return op + 1;
+}
+
+#define ZASM_ARITHMETIC(name, result) \
+static const threaded_op *zasm_##name(const threaded_op *op) \
+{ \
+    const long temp = op->get2(op->arg2); \
+    const long temp2 = op->get1(op->arg1); \
+    op->set1(op->arg1, result); \
+    return op + 1; \
+}
+
+ZASM_ARITHMETIC(add, temp2 + temp)
+ZASM_ARITHMETIC(sub, temp2 - temp)
+ZASM_ARITHMETIC(mult, long(((long long)temp * temp2) / 10000))
+ZASM_ARITHMETIC(min, zc_min(temp2, temp))
+ZASM_ARITHMETIC(max, zc_max(temp2, temp))
+ZASM_ARITHMETIC(and, ((temp2 / 10000) & (temp / 10000)) * 10000)
+ZASM_ARITHMETIC(or, ((temp2 / 10000) | (temp / 10000)) * 10000)
+ZASM_ARITHMETIC(xor, ((temp2 / 10000) ^ (temp / 10000)) * 10000)
+ZASM_ARITHMETIC(nand, (~((temp2 / 10000) & (temp / 10000))) * 10000)
+ZASM_ARITHMETIC(nor, (~((temp2 / 10000) | (temp / 10000))) * 10000)
+ZASM_ARITHMETIC(xnor, (~((temp2 / 10000) ^ (temp / 10000))) * 10000)
+ZASM_ARITHMETIC(lshift, ((temp2 / 10000) << (temp / 10000)) * 10000)
+ZASM_ARITHMETIC(rshift, ((temp2 / 10000) >> (temp / 10000)) * 10000)
+#undef ZASM_ARITHMETIC
+
+static const threaded_op *zasm_div(const threaded_op *op)
+{
+    const long long temp = op->get2(op->arg2);
+    const long long temp2 = op->get1(op->arg1);
+    
+    if(temp == 0)
+    {
+        Z_scripterrlog("Script attempted to divide %ld by zero!\n", temp2);
+        op->set1(op->arg1, long(sign(temp2) * LONG_MAX));
+    }
+    else
+        op->set1(op->arg1, long((temp2 * 10000) / temp));
+        
+    return op + 1;
+}
+
+static const threaded_op *zasm_mod(const threaded_op *op)
+{
+    long temp = op->get2(op->arg2);
+    const long temp2 = op->get1(op->arg1);
+    
+    if(temp == 0)
+    {
+        Z_scripterrlog("Script attempted to modulo %ld by zero!\n",temp2);
+        temp = 1;
+    }
+    
+    op->set1(op->arg1, temp2 % temp);
+    return op + 1;
+}
+
+static const threaded_op *zasm_not(const threaded_op *op)
+{
+    op->set1(op->arg1, !op->get2(op->arg2));
+    return op + 1;
+}
+
+static const threaded_op *zasm_comp(const threaded_op *op)
+{
+    const long temp = op->get2(op->arg2);
+    const long temp2 = op->get1(op->arg1);
+    
+    if(temp2 >= temp)   ri->scriptflag |= MOREFLAG;
+    else                ri->scriptflag &= ~MOREFLAG;
+    
+    if(temp2 == temp)   ri->scriptflag |= TRUEFLAG;
+    else                ri->scriptflag &= ~TRUEFLAG;
+    
+    return op + 1;
+}
+
+static const threaded_op *zasm_settrue(const threaded_op *op)
+{
+    op->set1(op->arg1, (ri->scriptflag & TRUEFLAG) ? 1 : 0);
+    return op + 1;
+}
+
+static const threaded_op *zasm_setfalse(const threaded_op *op)
+{
+    op->set1(op->arg1, (ri->scriptflag & TRUEFLAG) ? 0 : 1);
+    return op + 1;
+}
+
+static const threaded_op *zasm_setmore(const threaded_op *op)
+{
+    op->set1(op->arg1, (ri->scriptflag & MOREFLAG) ? 1 : 0);
+    return op + 1;
+}
+
+static const threaded_op *zasm_setless(const threaded_op *op)
+{
+    op->set1(op->arg1, (!(ri->scriptflag & MOREFLAG) || (ri->scriptflag & TRUEFLAG)) ? 1 : 0);
+    return op + 1;
+}
+
+static const threaded_op *zasm_push(const threaded_op *op)
+{
+    const long value = op->get1(op->arg1);
+    ri->sp--;
+    SH::write_stack(ri->sp, value);
+    return op + 1;
+}
+
+static const threaded_op *zasm_pop(const threaded_op *op)
+{
+    const long value = SH::read_stack(ri->sp);
+    ri->sp++;
+    op->set1(op->arg1, value);
+    return op + 1;
+}
+
+static const threaded_op *zasm_loadi(const threaded_op *op)
+{
+    const long stackoffset = op->get2(op->arg2) / 10000;
+    op->set1(op->arg1, SH::read_stack(stackoffset));
+    return op + 1;
+}
+
+static const threaded_op *zasm_storei(const threaded_op *op)
+{
+    const long stackoffset = op->get2(op->arg2) / 10000;
+    SH::write_stack(stackoffset, op->get1(op->arg1));
+    return op + 1;
+}
+
+//Everything else
+ZASM_HANDLER(SETV, do_set(true, curScriptType==SCRIPT_FFC ? curScriptIndex : -1))
+ZASM_HANDLER(SETR, do_set(false, curScriptType==SCRIPT_FFC ? curScriptIndex : -1))
+ZASM_HANDLER(LOAD1, do_loada(0))
+ZASM_HANDLER(LOAD2, do_loada(1))
+ZASM_HANDLER(SETA1, do_seta(0))
+ZASM_HANDLER(SETA2, do_seta(1))
+ZASM_HANDLER(ALLOCATEGMEMR, if(curScriptType == SCRIPT_GLOBAL) do_allocatemem(false, false, curScriptType==SCRIPT_FFC ? curScriptIndex : 255))
+ZASM_HANDLER(ALLOCATEGMEMV, if(curScriptType == SCRIPT_GLOBAL) do_allocatemem(true, false, curScriptType==SCRIPT_FFC ? curScriptIndex : 255))
+ZASM_HANDLER(ALLOCATEMEMR, do_allocatemem(false, true, curScriptType==SCRIPT_FFC ? curScriptIndex : 255))
+ZASM_HANDLER(ALLOCATEMEMV, do_allocatemem(true, true, curScriptType==SCRIPT_FFC ? curScriptIndex : 255))
+ZASM_HANDLER(DEALLOCATEMEMR, do_deallocatemem())
+ZASM_HANDLER(ARRAYSIZE, do_arraysize())
+ZASM_HANDLER(GETFFCSCRIPT, do_getffcscript())
+ZASM_HANDLER(QUERYRADIUS, do_queryradius())
+ZASM_HANDLER(QUERYRECT, do_queryrect())
+ZASM_HANDLER(QUERYNEAREST, do_querynearest())
+ZASM_HANDLER(SINV, do_trig(true, 0))
+ZASM_HANDLER(SINR, do_trig(false, 0))
+ZASM_HANDLER(COSV, do_trig(true, 1))
+ZASM_HANDLER(COSR, do_trig(false, 1))
+ZASM_HANDLER(TANV, do_trig(true, 2))
+ZASM_HANDLER(TANR, do_trig(false, 2))
+ZASM_HANDLER(ARCSINR, do_asin(false))
+ZASM_HANDLER(ARCCOSR, do_acos(false))
+ZASM_HANDLER(ARCTANR, do_arctan())
+ZASM_HANDLER(ABSR, do_abs(false))
+ZASM_HANDLER(RNDR, do_rnd(false))
+ZASM_HANDLER(RNDV, do_rnd(true))
+ZASM_HANDLER(FACTORIAL, do_factorial(false))
+ZASM_HANDLER(SQROOTV, do_sqroot(true))
+ZASM_HANDLER(SQROOTR, do_sqroot(false))
+ZASM_HANDLER(POWERR, do_power(false))
+ZASM_HANDLER(POWERV, do_power(true))
+ZASM_HANDLER(IPOWERR, do_ipower(false))
+ZASM_HANDLER(IPOWERV, do_ipower(true))
+ZASM_HANDLER(LOG10, do_log10(false))
+ZASM_HANDLER(LOGE, do_naturallog(false))
+ZASM_HANDLER(BITNOT, do_bitwisenot(false))
+ZASM_HANDLER(TRACER, do_trace(false))
+ZASM_HANDLER(TRACEV, do_trace(true))
+ZASM_HANDLER(TRACE2R, do_tracebool(false))
+ZASM_HANDLER(TRACE2V, do_tracebool(true))
+ZASM_HANDLER(TRACE3, do_tracenl())
+ZASM_HANDLER(TRACE4, do_cleartrace())
+ZASM_HANDLER(TRACE5, do_tracetobase())
+ZASM_HANDLER(TRACE6, do_tracestring())
+ZASM_HANDLER(WARP, do_warp(true))
+ZASM_HANDLER(WARPR, do_warp(false))
+ZASM_HANDLER(PITWARP, do_pitwarp(true))
+ZASM_HANDLER(PITWARPR, do_pitwarp(false))
+ZASM_HANDLER(BREAKSHIELD, do_breakshield())
+ZASM_HANDLER(SELECTAWPNV, do_selectweapon(true, true))
+ZASM_HANDLER(SELECTAWPNR, do_selectweapon(false, true))
+ZASM_HANDLER(SELECTBWPNV, do_selectweapon(true, false))
+ZASM_HANDLER(SELECTBWPNR, do_selectweapon(false, false))
+ZASM_HANDLER(PLAYSOUNDR, do_sfx(false))
+ZASM_HANDLER(PLAYSOUNDV, do_sfx(true))
+ZASM_HANDLER(PLAYMIDIR, do_midi(false))
+ZASM_HANDLER(PLAYMIDIV, do_midi(true))
+ZASM_HANDLER(PLAYENHMUSIC, do_enh_music(false))
+ZASM_HANDLER(GETMUSICFILE, do_get_enh_music_filename(false))
+ZASM_HANDLER(GETMUSICTRACK, do_get_enh_music_track(false))
+ZASM_HANDLER(SETDMAPENHMUSIC, do_set_dmap_enh_music(false))
+ZASM_HANDLER(MSGSTRR, do_message(false))
+ZASM_HANDLER(MSGSTRV, do_message(true))
+ZASM_HANDLER(ITEMNAME, do_getitemname())
+ZASM_HANDLER(NPCNAME, do_getnpcname())
+ZASM_HANDLER(GETSAVENAME, do_getsavename())
+ZASM_HANDLER(SETSAVENAME, do_setsavename())
+ZASM_HANDLER(GETMESSAGE, do_getmessage(false))
+ZASM_HANDLER(GETDMAPNAME, do_getdmapname(false))
+ZASM_HANDLER(GETDMAPTITLE, do_getdmaptitle(false))
+ZASM_HANDLER(GETDMAPINTRO, do_getdmapintro(false))
+ZASM_HANDLER(LOADLWEAPONR, do_loadlweapon(false))
+ZASM_HANDLER(LOADLWEAPONV, do_loadlweapon(true))
+ZASM_HANDLER(LOADEWEAPONR, do_loadeweapon(false))
+ZASM_HANDLER(LOADEWEAPONV, do_loadeweapon(true))
+ZASM_HANDLER(LOADITEMR, do_loaditem(false))
+ZASM_HANDLER(LOADITEMV, do_loaditem(true))
+ZASM_HANDLER(LOADITEMDATAR, do_loaditemdata(false))
+ZASM_HANDLER(LOADITEMDATAV, do_loaditemdata(true))
+ZASM_HANDLER(LOADNPCR, do_loadnpc(false))
+ZASM_HANDLER(LOADNPCV, do_loadnpc(true))
+ZASM_HANDLER(CREATELWEAPONR, do_createlweapon(false))
+ZASM_HANDLER(CREATELWEAPONV, do_createlweapon(true))
+ZASM_HANDLER(CREATEEWEAPONR, do_createeweapon(false))
+ZASM_HANDLER(CREATEEWEAPONV, do_createeweapon(true))
+ZASM_HANDLER(CREATEITEMR, do_createitem(false))
+ZASM_HANDLER(CREATEITEMV, do_createitem(true))
+ZASM_HANDLER(CREATENPCR, do_createnpc(false))
+ZASM_HANDLER(CREATENPCV, do_createnpc(true))
+ZASM_HANDLER(ISVALIDITEM, do_isvaliditem())
+ZASM_HANDLER(ISVALIDNPC, do_isvalidnpc())
+ZASM_HANDLER(ISVALIDLWPN, do_isvalidlwpn())
+ZASM_HANDLER(ISVALIDEWPN, do_isvalidewpn())
+ZASM_HANDLER(LWPNUSESPRITER, do_lwpnusesprite(false))
+ZASM_HANDLER(LWPNUSESPRITEV, do_lwpnusesprite(true))
+ZASM_HANDLER(EWPNUSESPRITER, do_ewpnusesprite(false))
+ZASM_HANDLER(EWPNUSESPRITEV, do_ewpnusesprite(true))
+ZASM_HANDLER(CLEARSPRITESR, do_clearsprites(false))
+ZASM_HANDLER(CLEARSPRITESV, do_clearsprites(true))
+ZASM_HANDLER(ISSOLID, do_issolid())
+ZASM_HANDLER(SETSIDEWARP, do_setsidewarp())
+ZASM_HANDLER(SETTILEWARP, do_settilewarp())
+ZASM_HANDLER(GETSIDEWARPDMAP, do_getsidewarpdmap(false))
+ZASM_HANDLER(GETSIDEWARPSCR, do_getsidewarpscr(false))
+ZASM_HANDLER(GETSIDEWARPTYPE, do_getsidewarptype(false))
+ZASM_HANDLER(GETTILEWARPDMAP, do_gettilewarpdmap(false))
+ZASM_HANDLER(GETTILEWARPSCR, do_gettilewarpscr(false))
+ZASM_HANDLER(GETTILEWARPTYPE, do_gettilewarptype(false))
+ZASM_HANDLER(LAYERSCREEN, do_layerscreen())
+ZASM_HANDLER(LAYERMAP, do_layermap())
+ZASM_HANDLER(SECRETS, do_triggersecrets())
+ZASM_HANDLER(GETSCREENFLAGS, do_getscreenflags())
+ZASM_HANDLER(GETSCREENEFLAGS, do_getscreeneflags())
+ZASM_HANDLER(COMBOTILE, do_combotile(false))
+ZASM_HANDLER(COPYTILEVV, do_copytile(true, true))
+ZASM_HANDLER(COPYTILEVR, do_copytile(true, false))
+ZASM_HANDLER(COPYTILERV, do_copytile(false, true))
+ZASM_HANDLER(COPYTILERR, do_copytile(false, false))
+ZASM_HANDLER(SWAPTILEVV, do_swaptile(true, true))
+ZASM_HANDLER(SWAPTILEVR, do_swaptile(true, false))
+ZASM_HANDLER(SWAPTILERV, do_swaptile(false, true))
+ZASM_HANDLER(SWAPTILERR, do_swaptile(false, false))
+ZASM_HANDLER(CLEARTILEV, do_cleartile(true))
+ZASM_HANDLER(CLEARTILER, do_cleartile(false))
+ZASM_HANDLER(OVERLAYTILEVV, do_overlaytile(true, true))
+ZASM_HANDLER(OVERLAYTILEVR, do_overlaytile(true, false))
+ZASM_HANDLER(OVERLAYTILERV, do_overlaytile(false, true))
+ZASM_HANDLER(OVERLAYTILERR, do_overlaytile(false, false))
+ZASM_HANDLER(FLIPROTTILEVV, do_fliprotatetile(true, true))
+ZASM_HANDLER(FLIPROTTILEVR, do_fliprotatetile(true, false))
+ZASM_HANDLER(FLIPROTTILERV, do_fliprotatetile(false, true))
+ZASM_HANDLER(FLIPROTTILERR, do_fliprotatetile(false, false))
+ZASM_HANDLER(GETTILEPIXELV, do_gettilepixel(true))
+ZASM_HANDLER(GETTILEPIXELR, do_gettilepixel(false))
+ZASM_HANDLER(SETTILEPIXELV, do_settilepixel(true))
+ZASM_HANDLER(SETTILEPIXELR, do_settilepixel(false))
+ZASM_HANDLER(SHIFTTILEVV, do_shifttile(true, true))
+ZASM_HANDLER(SHIFTTILEVR, do_shifttile(true, false))
+ZASM_HANDLER(SHIFTTILERV, do_shifttile(false, true))
+ZASM_HANDLER(SHIFTTILERR, do_shifttile(false, false))
+ZASM_HANDLER(SETRENDERTARGET, do_set_rendertarget(true))
+ZASM_HANDLER(SAVESCREEN, do_showsavescreen())
+ZASM_HANDLER(SAVEQUITSCREEN, save_game(false, 1))
+ZASM_HANDLER(ENQUEUER, do_enqueue(false))
+ZASM_HANDLER(ENQUEUEV, do_enqueue(true))
+ZASM_HANDLER(DEQUEUE, do_dequeue(false))
+
+#undef ZASM_HANDLER
+
+//Indexed by command
+static const zasm_handler zasm_handlers[NUMCOMMANDS] =
+{
+    &zasm_set,             //SETV
+    &zasm_set,             //SETR
+    &zasm_add,             //ADDR
+    &zasm_add,             //ADDV
+    &zasm_sub,             //SUBR
+    &zasm_sub,             //SUBV
+    &zasm_mult,            //MULTR
+    &zasm_mult,            //MULTV
+    &zasm_div,             //DIVR
+    &zasm_div,             //DIVV
+    &zasm_WAITFRAME,
+    &zasm_GOTO,
+    &zasm_invalid,         //CHECKTRIG
+    &zasm_WARP,
+    &zasm_comp,            //COMPARER
+    &zasm_comp,            //COMPAREV
+    &zasm_GOTOTRUE,
+    &zasm_GOTOFALSE,
+    &zasm_GOTOLESS,
+    &zasm_GOTOMORE,
+    &zasm_LOAD1,
+    &zasm_LOAD2,
+    &zasm_SETA1,
+    &zasm_SETA2,
+    &zasm_QUIT,
+    &zasm_SINR,
+    &zasm_SINV,
+    &zasm_COSR,
+    &zasm_COSV,
+    &zasm_TANR,
+    &zasm_TANV,
+    &zasm_mod,             //MODR
+    &zasm_mod,             //MODV
+    &zasm_ABSR,
+    &zasm_min,             //MINR
+    &zasm_min,             //MINV
+    &zasm_max,             //MAXR
+    &zasm_max,             //MAXV
+    &zasm_RNDR,
+    &zasm_RNDV,
+    &zasm_FACTORIAL,
+    &zasm_POWERR,
+    &zasm_POWERV,
+    &zasm_IPOWERR,
+    &zasm_IPOWERV,
+    &zasm_and,             //ANDR
+    &zasm_and,             //ANDV
+    &zasm_or,              //ORR
+    &zasm_or,              //ORV
+    &zasm_xor,             //XORR
+    &zasm_xor,             //XORV
+    &zasm_nand,            //NANDR
+    &zasm_nand,            //NANDV
+    &zasm_nor,             //NORR
+    &zasm_nor,             //NORV
+    &zasm_xnor,            //XNORR
+    &zasm_xnor,            //XNORV
+    &zasm_not,             //NOT
+    &zasm_lshift,          //LSHIFTR
+    &zasm_lshift,          //LSHIFTV
+    &zasm_rshift,          //RSHIFTR
+    &zasm_rshift,          //RSHIFTV
+    &zasm_TRACER,
+    &zasm_TRACEV,
+    &zasm_TRACE3,
+    &zasm_LOOP,
+    &zasm_push,            //PUSHR
+    &zasm_push,            //PUSHV
+    &zasm_pop,             //POP
+    &zasm_ENQUEUER,
+    &zasm_ENQUEUEV,
+    &zasm_DEQUEUE,
+    &zasm_PLAYSOUNDR,
+    &zasm_PLAYSOUNDV,
+    &zasm_LOADLWEAPONR,
+    &zasm_LOADLWEAPONV,
+    &zasm_LOADITEMR,
+    &zasm_LOADITEMV,
+    &zasm_LOADNPCR,
+    &zasm_LOADNPCV,
+    &zasm_CREATELWEAPONR,
+    &zasm_CREATELWEAPONV,
+    &zasm_CREATEITEMR,
+    &zasm_CREATEITEMV,
+    &zasm_CREATENPCR,
+    &zasm_CREATENPCV,
+    &zasm_loadi,           //LOADI
+    &zasm_storei,          //STOREI
+    &zasm_GOTOR,
+    &zasm_SQROOTV,
+    &zasm_SQROOTR,
+    &zasm_CREATEEWEAPONR,
+    &zasm_CREATEEWEAPONV,
+    &zasm_PITWARP,
+    &zasm_WARPR,
+    &zasm_PITWARPR,
+    &zasm_CLEARSPRITESR,
+    &zasm_CLEARSPRITESV,
+    &zasm_drawing,         //RECTR
+    &zasm_drawing,         //CIRCLER
+    &zasm_drawing,         //ARCR
+    &zasm_drawing,         //ELLIPSER
+    &zasm_drawing,         //LINER
+    &zasm_drawing,         //PUTPIXELR
+    &zasm_drawing,         //DRAWTILER
+    &zasm_drawing,         //DRAWCOMBOR
+    &zasm_nop,             //ELLIPSE2
+    &zasm_drawing,         //SPLINER
+    &zasm_nop,             //FLOODFILL
+    &zasm_invalid,         //COMPOUNDR
+    &zasm_invalid,         //COMPOUNDV
+    &zasm_MSGSTRR,
+    &zasm_MSGSTRV,
+    &zasm_ISVALIDITEM,
+    &zasm_ISVALIDNPC,
+    &zasm_PLAYMIDIR,
+    &zasm_PLAYMIDIV,
+    &zasm_COPYTILEVV,
+    &zasm_COPYTILEVR,
+    &zasm_COPYTILERV,
+    &zasm_COPYTILERR,
+    &zasm_SWAPTILEVV,
+    &zasm_SWAPTILEVR,
+    &zasm_SWAPTILERV,
+    &zasm_SWAPTILERR,
+    &zasm_CLEARTILEV,
+    &zasm_CLEARTILER,
+    &zasm_OVERLAYTILEVV,
+    &zasm_OVERLAYTILEVR,
+    &zasm_OVERLAYTILERV,
+    &zasm_OVERLAYTILERR,
+    &zasm_FLIPROTTILEVV,
+    &zasm_FLIPROTTILEVR,
+    &zasm_FLIPROTTILERV,
+    &zasm_FLIPROTTILERR,
+    &zasm_GETTILEPIXELV,
+    &zasm_GETTILEPIXELR,
+    &zasm_SETTILEPIXELV,
+    &zasm_SETTILEPIXELR,
+    &zasm_SHIFTTILEVV,
+    &zasm_SHIFTTILEVR,
+    &zasm_SHIFTTILERV,
+    &zasm_SHIFTTILERR,
+    &zasm_ISVALIDLWPN,
+    &zasm_ISVALIDEWPN,
+    &zasm_LOADEWEAPONR,
+    &zasm_LOADEWEAPONV,
+    &zasm_ALLOCATEMEMR,
+    &zasm_ALLOCATEMEMV,
+    &zasm_ALLOCATEGMEMV,
+    &zasm_DEALLOCATEMEMR,
+    &zasm_invalid,         //DEALLOCATEMEMV
+    &zasm_WAITDRAW,
+    &zasm_ARCTANR,
+    &zasm_LWPNUSESPRITER,
+    &zasm_LWPNUSESPRITEV,
+    &zasm_EWPNUSESPRITER,
+    &zasm_EWPNUSESPRITEV,
+    &zasm_LOADITEMDATAR,
+    &zasm_LOADITEMDATAV,
+    &zasm_BITNOT,
+    &zasm_LOG10,
+    &zasm_LOGE,
+    &zasm_ISSOLID,
+    &zasm_LAYERSCREEN,
+    &zasm_LAYERMAP,
+    &zasm_TRACE2R,
+    &zasm_TRACE2V,
+    &zasm_TRACE4,
+    &zasm_TRACE5,
+    &zasm_SECRETS,
+    &zasm_drawing,         //DRAWCHARR
+    &zasm_GETSCREENFLAGS,
+    &zasm_drawing,         //QUADR
+    &zasm_drawing,         //TRIANGLER
+    &zasm_ARCSINR,
+    &zasm_invalid,         //ARCSINV
+    &zasm_ARCCOSR,
+    &zasm_invalid,         //ARCCOSV
+    &zasm_GAMEEND,
+    &zasm_drawing,         //DRAWINTR
+    &zasm_settrue,         //SETTRUE
+    &zasm_setfalse,        //SETFALSE
+    &zasm_setmore,         //SETMORE
+    &zasm_setless,         //SETLESS
+    &zasm_drawing,         //FASTTILER
+    &zasm_drawing,         //FASTCOMBOR
+    &zasm_drawing,         //DRAWSTRINGR
+    &zasm_SETSIDEWARP,
+    &zasm_SAVE,
+    &zasm_TRACE6,
+    &zasm_invalid,         //WHATNO0x00BF
+    &zasm_drawing,         //QUAD3DR
+    &zasm_drawing,         //TRIANGLE3DR
+    &zasm_nop,             //SETCOLORB
+    &zasm_nop,             //SETDEPTHB
+    &zasm_nop,             //GETCOLORB
+    &zasm_nop,             //GETDEPTHB
+    &zasm_COMBOTILE,
+    &zasm_SETTILEWARP,
+    &zasm_GETSCREENEFLAGS,
+    &zasm_GETSAVENAME,
+    &zasm_ARRAYSIZE,
+    &zasm_ITEMNAME,
+    &zasm_SETSAVENAME,
+    &zasm_NPCNAME,
+    &zasm_GETMESSAGE,
+    &zasm_GETDMAPNAME,
+    &zasm_GETDMAPTITLE,
+    &zasm_GETDMAPINTRO,
+    &zasm_ALLOCATEGMEMR,
+    &zasm_drawing,         //BITMAPR
+    &zasm_SETRENDERTARGET,
+    &zasm_PLAYENHMUSIC,
+    &zasm_GETMUSICFILE,
+    &zasm_GETMUSICTRACK,
+    &zasm_SETDMAPENHMUSIC,
+    &zasm_drawing,         //DRAWLAYERR
+    &zasm_drawing,         //DRAWSCREENR
+    &zasm_BREAKSHIELD,
+    &zasm_SAVESCREEN,
+    &zasm_SAVEQUITSCREEN,
+    &zasm_SELECTAWPNR,
+    &zasm_SELECTAWPNV,
+    &zasm_SELECTBWPNR,
+    &zasm_SELECTBWPNV,
+    &zasm_GETSIDEWARPDMAP,
+    &zasm_GETSIDEWARPSCR,
+    &zasm_GETSIDEWARPTYPE,
+    &zasm_GETTILEWARPDMAP,
+    &zasm_GETTILEWARPSCR,
+    &zasm_GETTILEWARPTYPE,
+    &zasm_GETFFCSCRIPT,
+    &zasm_WAITFRAMESR,
+    &zasm_QUERYRADIUS,
+    &zasm_QUERYRECT,
+    &zasm_QUERYNEAREST
+};
+
+//Operand accessors for the registers that don't need to go through get_register/set_register
+static long get_immediate(const long arg)
+{
+    return arg;
+}
+
+static long get_d(const long arg)
+{
+    return ri->d[arg - REG_D(0)];
+}
+
+static void set_d(const long arg, const long value)
+{
+    ri->d[arg - REG_D(0)] = value;
+}
+
+static long get_sp(const long)
+{
+    return ri->sp * 10000;
+}
+
+static void set_sp(const long, const long value)
+{
+    ri->sp = value / 10000;
+}
+
+static long get_gd(const long arg)
+{
+    return game->global_d[arg - GD(0)];
+}
+
+static void set_gd(const long arg, const long value)
+{
+    game->global_d[arg - GD(0)] = value;
+}
+
+static INLINE bool is_d(const long arg)
+{
+    return arg >= REG_D(0) && arg <= REG_D(7);
+}
+
+static void bind_register(const long arg, zasm_getter &get, zasm_setter &set)
+{
+    if(is_d(arg))
+    {
+        get = &get_d;
+        set = &set_d;
+    }
+    else if(arg == SP)
+    {
+        get = &get_sp;
+        set = &set_sp;
+    }
+    else if(arg >= GD(0) && arg <= GD(255))
+    {
+        get = &get_gd;
+        set = &set_gd;
+    }
+    else
+    {
+        get = &get_register;
+        set = &set_register;
+    }
+}
+
+// Works out once how each operand will be read and written, so that the handlers
+// above never have to switch on the register number
+static void bind_operands(threaded_op &op)
+{
+    zasm_setter set2;
+    bind_register(op.arg1, op.get1, op.set1);
+    bind_register(op.arg2, op.get2, set2);
+    
+    switch(op.command)
+    {
+    case PUSHV:
+        op.get1 = &get_immediate;
+        break;
+        
+    case SETV:
+    case ADDV:
+    case SUBV:
+    case MULTV:
+    case DIVV:
+    case MODV:
+    case MINV:
+    case MAXV:
+    case ANDV:
+    case ORV:
+    case XORV:
+    case NANDV:
+    case NORV:
+    case XNORV:
+    case LSHIFTV:
+    case RSHIFTV:
+    case COMPAREV:
+        op.get2 = &get_immediate;
+        break;
+    }
+    
+    // Setting an FFC's script has to check it isn't the FFC that's running
+    if(op.arg1 == FFSCRIPT)
+    {
+        if(op.command == SETV)
+            op.handler = &zasm_SETV;
+        else if(op.command == SETR)
+            op.handler = &zasm_SETR;
+    }
+}
+
+// Superinstructions. The compiler writes the same few sequences over and over, so those get one
+// handler which does the whole sequence. It sits in the slot of the first command and skips over
+// the rest, which are left as they were; a jump into the middle of a sequence still works, and every
+// command keeps its number, so GOTOs and the return addresses pushed by function calls stay valid.
+
+//SETR a,b  ADDV a,k  LOADI c,a - reading a local variable off the stack frame
+static const threaded_op *zasm_loadlocal(const threaded_op *op)
+{
+    const long address = ri->d[op[0].arg2 - REG_D(0)] + op[1].arg2;
+    ri->d[op[0].arg1 - REG_D(0)] = address;
+    ri->d[op[2].arg1 - REG_D(0)] = SH::read_stack(address / 10000);
+    return op + 3;
+}
+
+//SETR a,b  ADDV a,k  STOREI c,a - writing one
+static const threaded_op *zasm_storelocal(const threaded_op *op)
+{
+    const long address = ri->d[op[0].arg2 - REG_D(0)] + op[1].arg2;
+    ri->d[op[0].arg1 - REG_D(0)] = address;
+    SH::write_stack(address / 10000, ri->d[op[2].arg1 - REG_D(0)]);
+    return op + 3;
+}
+
+//PUSHR a  POP b - the value doesn't need to go through the stack at all
+static const threaded_op *zasm_pushpop(const threaded_op *op)
+{
+    if(ri->sp == 1) //Let the stack complain about it as usual
+        return zasm_pop(zasm_push(op));
+        
+    op[1].set1(op[1].arg1, op[0].get1(op[0].arg1));
+    return op + 2;
+}
+
+#define ZASM_FUSED(name, first, second) \
+static const threaded_op *zasm_##name(const threaded_op *op) \
+{ \
+    return second(first(op)); \
+}
+
+ZASM_FUSED(comp_gototrue, zasm_comp, zasm_GOTOTRUE)
+ZASM_FUSED(comp_gotofalse, zasm_comp, zasm_GOTOFALSE)
+ZASM_FUSED(comp_gotomore, zasm_comp, zasm_GOTOMORE)
+ZASM_FUSED(comp_gotoless, zasm_comp, zasm_GOTOLESS)
+ZASM_FUSED(comp_settrue, zasm_comp, zasm_settrue)
+ZASM_FUSED(comp_setfalse, zasm_comp, zasm_setfalse)
+ZASM_FUSED(comp_setmore, zasm_comp, zasm_setmore)
+ZASM_FUSED(comp_setless, zasm_comp, zasm_setless)
+ZASM_FUSED(set_comp, zasm_set, zasm_comp)
+#undef ZASM_FUSED
+
+struct zasm_pair
+{
+    zasm_handler first;
+    zasm_handler second;
+    zasm_handler fused;
+};
+
+static const zasm_pair zasm_pairs[] =
+{
+    { &zasm_comp, &zasm_GOTOTRUE, &zasm_comp_gototrue },
+    { &zasm_comp, &zasm_GOTOFALSE, &zasm_comp_gotofalse },
+    { &zasm_comp, &zasm_GOTOMORE, &zasm_comp_gotomore },
+    { &zasm_comp, &zasm_GOTOLESS, &zasm_comp_gotoless },
+    { &zasm_comp, &zasm_settrue, &zasm_comp_settrue },
+    { &zasm_comp, &zasm_setfalse, &zasm_comp_setfalse },
+    { &zasm_comp, &zasm_setmore, &zasm_comp_setmore },
+    { &zasm_comp, &zasm_setless, &zasm_comp_setless },
+    { &zasm_set, &zasm_comp, &zasm_set_comp },
+    { &zasm_push, &zasm_pop, &zasm_pushpop }
+};
+
+static bool is_goto(const word command)
+{
+    return command == GOTO || command == GOTOTRUE || command == GOTOFALSE ||
+           command == GOTOMORE || command == GOTOLESS;
+}
+
+// Returns how many commands are fused into one starting at ops[j], or 1 if none are
+static dword fuse(threaded_op *ops, const dword j, const dword count)
+{
+    threaded_op &op = ops[j];
+    
+    if(j + 2 < count && op.command == SETR && op.handler == &zasm_set && is_d(op.arg1) && is_d(op.arg2) &&
+            ops[j+1].command == ADDV && ops[j+1].arg1 == op.arg1 &&
+            (ops[j+2].command == LOADI || ops[j+2].command == STOREI) && ops[j+2].arg2 == op.arg1 && is_d(ops[j+2].arg1))
+    {
+        op.handler = (ops[j+2].command == LOADI) ? &zasm_loadlocal : &zasm_storelocal;
+        return 3;
+    }
+    
+    if(j + 1 < count)
+    {
+        for(dword k = 0; k < sizeof(zasm_pairs) / sizeof(zasm_pair); k++)
         {
-        case SCRIPT_GLOBAL:
-            global_wait = true;
-            break;
-            
-        default:
-            Z_scripterrlog("Waitdraw can only be used in the active global script\n");
-            break;
+            if(op.handler == zasm_pairs[k].first && ops[j+1].handler == zasm_pairs[k].second)
+            {
+                op.handler = zasm_pairs[k].fused;
+                return 2;
+            }
         }
     }
     
-    if(scommand == 0xFFFF) //Quit/command list end reached/bad command
+    return 1;
+}
+
+// Optional pass over a decoded script, see zasm_optimize. Only the decoded copy is changed, never
+// the ffscript array it came from, so nothing different is ever saved to the quest.
+static void optimize_script(threaded_script &t, const char *kind, const int slot)
+{
+    threaded_op *ops = t.ops;
+    const dword count = t.count;
+    dword threaded = 0;
+    
+    // A jump to a GOTO can go straight to where that GOTO goes
+    for(dword j = 0; j < count; j++)
     {
-        switch(type)
-        {
-        case SCRIPT_FFC:
-            tmpscr->ffcs[i].script = 0;
-            break;
-            
-        case SCRIPT_GLOBAL:
-            g_doscript = 0;
-            break;
+        if(!is_goto(ops[j].command))
+            continue;
             
-        case SCRIPT_ITEM:
-            break; //item scripts aren't gonna go again anyway
+        long target = ops[j].arg1;
+        
+        for(dword hops = 0; hops < count && dword(target) < count && ops[target].command == GOTO; hops++)
+        {
+            if(ops[target].arg1 == target)
+                break;
+                
+            target = ops[target].arg1;
+        }
+        
+        if(target != ops[j].arg1)
+        {
+            ops[j].arg1 = target;
+            threaded++;
         }
     }
-    else
-        pc++;
+    
+    dword dispatched = 0;
+    
+    for(dword j = 0; j < count; dispatched++)
+        j += fuse(ops, j, count);
         
-    ri->pc = pc; //Put it back where we got it from
+    if(count > 1)
+        al_trace("ZASM optimizer: %s script %d: %lu commands to %lu, %lu jumps threaded\n",
+                 kind, slot, (unsigned long)count, (unsigned long)dispatched, (unsigned long)threaded);
+}
+
+static void decode_script(threaded_script &t, const ffscript *script, const char *kind, const int slot)
+{
+    delete[] t.ops;
+    jit_free(t.jit);
+    t.jit = NULL;
+    
+    dword count = 0;
+    
+    while(script[count].command != 0xFFFF)
+        count++;
+        
+    count++; //The 0xFFFF gets an op too
     
-#ifdef _SCRIPT_COUNTER
+    t.ops = new threaded_op[count];
+    t.count = count;
+    t.source = script;
     
-    for(int j = 0; j < NUMCOMMANDS; j++)
+    for(dword j = 0; j < count; j++)
     {
-        if(script_execount[j] != 0)
-            al_trace("Command %s took %ld ticks in all to complete in %ld executions.\n",
-                     command_list[j].name, script_timer[j], script_execount[j]);
+        const word command = script[j].command;
+        threaded_op &op = t.ops[j];
+        
+        op.command = command;
+        op.arg1 = script[j].arg1;
+        op.arg2 = script[j].arg2;
+        
+        if(command == 0xFFFF)
+            op.handler = &zasm_end;
+        else if(command < NUMCOMMANDS)
+            op.handler = zasm_handlers[command];
+        else
+            op.handler = &zasm_invalid;
+            
+        bind_operands(op);
+        op.unfused = op.handler;
     }
     
-    remove_int(update_script_counter);
-#endif
+    if(zasm_optimize)
+        optimize_script(t, kind, slot);
+}
+
+// Called whenever the quest's scripts have been (re)loaded
+void decode_scripts()
+{
+    for(int j = 0; j < NUMSCRIPTFFC; j++)
+        decode_script(threaded_ffscripts[j], ffscripts[j], "FFC", j);
+        
+    for(int j = 0; j < NUMSCRIPTITEM; j++)
+        decode_script(threaded_itemscripts[j], itemscripts[j], "Item", j);
+        
+    for(int j = 0; j < NUMSCRIPTGLOBAL; j++)
+        decode_script(threaded_globalscripts[j], globalscripts[j], "Global", j);
+}
+
+int run_script_threaded(const byte type, const word script, const byte i)
+{
+    if(!begin_script(type, script, i))
+        return 1;
+        
+    threaded_script *t;
+    const char *kind;
+    
+    switch(type)
+    {
+    case SCRIPT_FFC:
+        t = &threaded_ffscripts[script];
+        kind = "FFC";
+        break;
+        
+    case SCRIPT_ITEM:
+        t = &threaded_itemscripts[script];
+        kind = "Item";
+        break;
+        
+    default:
+        t = &threaded_globalscripts[script];
+        kind = "Global";
+        break;
+    }
+    
+    // In case the script was replaced without being decoded again
+    if(t->source != curscript)
+        decode_script(*t, curscript, kind, script);
+        
+    if(zasm_jit && !t->jit && jit_available())
+        t->jit = jit_compile(t->ops, t->count, zasm_jit_verify);
+        
+    thread_base = t->ops;
+    thread_count = t->count;
+    
+    const threaded_op *op = (ri->pc < thread_count) ? thread_base + ri->pc : thread_base + thread_count - 1;
+    
+    dword commands = 0;
+    
+    if(ZScriptProfiler::Enabled)
+    {
+        // One command at a time, so that each is timed on its own
+        unsigned long long ticks = 0;
+        
+        while(op)
+        {
+            const word command = op->command;
+            const unsigned long long start_time = ZScriptProfiler::now();
+            op = op->unfused(op);
+            const unsigned long long elapsed = ZScriptProfiler::now() - start_time;
+            ZScriptProfiler::recordCommand(command, elapsed);
+            ticks += elapsed;
+            
+            if((++commands & (ZASM_POLL_COMMANDS - 1)) == 0 && op)
+                op = zasm_poll(op, commands);
+        }
+        
+        ZScriptProfiler::recordScript(type, script, i, commands, ticks);
+    }
+    else if(zasm_jit && t->jit)
+        jit_run(t->jit, dword(op - thread_base), &zasm_poll, ZASM_POLL_COMMANDS);
+    else
+    {
+        for(;;)
+        {
+            for(dword n = ZASM_POLL_COMMANDS; op && n; n--)
+                op = op->handler(op);
+                
+            if(!op)
+                break;
+                
+            commands += ZASM_POLL_COMMANDS;
+            op = zasm_poll(op, commands);
+        }
+    }
+    
+    end_script(type, i, thread_stop, thread_stop_pc);
     
     return 0;
 }
 
 int ffscript_engine(const bool preload)
 {
+    invalidate_spatial_index();
+    
     for(byte i = 0; i < MAXFFCS; i++)
     {
         if(tmpscr->ffcs[i].script == 0)
@@ -7,11 +7,23 @@
 
 long get_register(const long arg);
 int run_script(const byte type, const word script, const byte i = -1); //Global scripts don't need 'i'
+int run_script_threaded(const byte type, const word script, const byte i = -1);
 int ffscript_engine(const bool preload);
+void benchmark_item_scripts(); //Times an empty item script with and without lazy clearing
+bool script_sleeping(const byte type, const byte i); //Counts down a WAITFRAMESR; true if the script shouldn't run
+void decode_scripts();
+extern bool zasm_optimize; //Fuse common command sequences when decoding the scripts
+extern bool zasm_jit; //Run the scripts as x86-64 code where possible (see ffjit.h)
+extern bool zasm_jit_verify; //Check the JIT's inline code against the threaded handlers as it runs
+extern dword zasm_command_budget; //Commands a script can run in one go before it's stopped, or 0 for no limit
 
 void clear_ffc_stack(const byte i);
 void clear_global_stack();
 void deallocateArray(const long ptrval);
+long nextLocalArray(const long ptrval); //The next local array in use, for going through them
+int localArrayCount();
+void clearLocalArraySlots();
+void clearGlobalArraySlots();
 void clearScriptHelperData();
 
 struct script_command
@@ -31,6 +43,28 @@ struct script_variable
     byte multiple;
 };
 
+//A ZASM command decoded ahead of time for run_script_threaded()
+struct threaded_op;
+typedef const threaded_op *(*zasm_handler)(const threaded_op *op);
+typedef long (*zasm_getter)(const long arg);
+typedef void (*zasm_setter)(const long arg, const long value);
+
+struct threaded_op
+{
+    zasm_handler handler; //Carries out the command and returns the next one to run, or NULL to stop
+    zasm_handler unfused; //Just this command, even if handler was fused with the ones after it
+    word command;
+    long arg1;
+    long arg2;
+    
+    //How to read and write arg1 and arg2, worked out when the script is decoded. For most registers
+    //this is just get_register/set_register, but the D registers, SP and the global D registers
+    //go straight to their storage, and immediate values are returned as they are.
+    zasm_getter get1;
+    zasm_setter set1;
+    zasm_getter get2;
+};
+
 // Defines for script flags
 #define TRUEFLAG          0x0001
 #define MOREFLAG          0x0002
@@ -276,6 +310,10 @@ enum ASM_DEFINE
     GETTILEWARPSCR,       //0x00E6
     GETTILEWARPTYPE,      //0x00E7
     GETFFCSCRIPT,         //0x00E8
+    WAITFRAMESR,          //0x00E9
+    QUERYRADIUS,          //0x00EA
+    QUERYRECT,            //0x00EB
+    QUERYNEAREST,         //0x00EC
     /* ..sorry, forgot about these ...for now. -Gleeok
       CALCSPLINE,           //0x00
       COLLISIONRECT,  ?      //0x00
@@ -285,7 +323,7 @@ enum ASM_DEFINE
       CLEARBITMAPBUFFER,
       RENDERBITMAPBUFFER,
     */
-    NUMCOMMANDS           //0x00E9
+    NUMCOMMANDS           //0x00ED
 };
 
 //ZASM registers
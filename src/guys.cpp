@@ -1255,21 +1255,14 @@ ASEnemy::ASEnemy(const char* scriptName, fix x, fix y, int id, int clk):
     scriptFlags(0)
 {
     assignEnemyScript(this, scriptName);
-    asUpdate=scriptData->getFunction("bool Update(int)");
-    asDraw=scriptData->getFunction("void Draw()");
-    asDraw2=scriptData->getFunction("void Draw2()");
-    asDrawShadow=scriptData->getFunction("void DrawShadow()");
-    asTakeHit=scriptData->getFunction("int takehit(weapon@)");
-    asHit=scriptData->getFunction("bool Hit(weapon@)");
-    asBreakShield=scriptData->getFunction("void break_shield()");
-    asEatLink=scriptData->getFunction("void eatlink()");
 }
 
 bool ASEnemy::animate(int index)
 {
-    if(asUpdate)
+    asIScriptFunction* func=scriptData->getMethod(smUpdate);
+    if(func)
     {
-        scriptData->runFunction(asUpdate, index);
+        scriptData->runFunction(func, index);
         return scriptData->getLastResult<bool>();
     }
     
@@ -1278,11 +1271,12 @@ bool ASEnemy::animate(int index)
 
 void ASEnemy::drawshadow(BITMAP *dest, bool translucent)
 {
-    if(asDrawShadow)
+    asIScriptFunction* func=scriptData->getMethod(smDrawShadow);
+    if(func)
     {
         scriptDrawingTarget=dest;
         scriptShadowTrans=translucent;
-        scriptData->runFunction(asDrawShadow);
+        scriptData->runFunction(func);
     }
     else
         enemy::drawshadow(dest, translucent);
@@ -1290,10 +1284,11 @@ void ASEnemy::drawshadow(BITMAP *dest, bool translucent)
 
 void ASEnemy::draw(BITMAP *dest)
 {
-    if(asDraw)
+    asIScriptFunction* func=scriptData->getMethod(smDraw);
+    if(func)
     {
         scriptDrawingTarget=dest;
-        scriptData->runFunction(asDraw);
+        scriptData->runFunction(func);
     }
     else
         enemy::draw(dest);
@@ -1301,10 +1296,11 @@ void ASEnemy::draw(BITMAP *dest)
 
 void ASEnemy::draw2(BITMAP *dest)
 {
-    if(asDraw2)
+    asIScriptFunction* func=scriptData->getMethod(smDraw2);
+    if(func)
     {
         scriptDrawingTarget=dest;
-        scriptData->runFunction(asDraw2);
+        scriptData->runFunction(func);
     }
     else
         enemy::draw2(dest);
@@ -1327,9 +1323,10 @@ void ASEnemy::playHitSFX(int pan)
 
 bool ASEnemy::hit(weapon *w)
 {
-    if(asHit)
+    asIScriptFunction* func=scriptData->getMethod(smHit);
+    if(func)
     {
-        scriptData->runFunction(asHit, w->getScriptObject());
+        scriptData->runFunction(func, w->getScriptObject());
         return scriptData->getLastResult<bool>();
     }
     else
@@ -1338,9 +1335,10 @@ bool ASEnemy::hit(weapon *w)
 
 int ASEnemy::takehit(weapon *w)
 {
-    if(asTakeHit)
+    asIScriptFunction* func=scriptData->getMethod(smTakeHit);
+    if(func)
     {
-        scriptData->runFunction(asTakeHit, w->getScriptObject());
+        scriptData->runFunction(func, w->getScriptObject());
         return scriptData->getLastResult<int>();
     }
     else
@@ -1358,14 +1356,16 @@ int ASEnemy::defend(int wpnId, int *power, int edef)
 
 void ASEnemy::break_shield()
 {
-    if(asBreakShield)
-        scriptData->runFunction(asBreakShield);
+    asIScriptFunction* func=scriptData->getMethod(smBreakShield);
+    if(func)
+        scriptData->runFunction(func);
 }
 
 void ASEnemy::eatlink()
 {
-    if(asEatLink)
-        scriptData->runFunction(asEatLink);
+    asIScriptFunction* func=scriptData->getMethod(smEatLink);
+    if(func)
+        scriptData->runFunction(func);
 }
 
 void ASEnemy::fireWeapon()
@@ -1465,6 +1465,12 @@ int ASEnemy::getDefendedItemPower()
     return wpnPower;
 }
 
+// Taking the fix by reference saves AngelScript copying it to the heap.
+bool ASEnemy::scriptCanMove(int ndir, const fix& s, int special, int dx1, int dy1, int dx2, int dy2)
+{
+    return canmove(ndir, s, special, dx1, dy1, dx2, dy2);
+}
+
 void ASEnemy::setDeathAttack(EnemyAttack* att)
 {
     deathAttack.reset(att);
@@ -154,8 +154,6 @@ public:
     friend void registerEnemy();
 };
 
-class asIScriptFunction;
-
 class ASEnemy: public enemy
 {
 public:
@@ -174,15 +172,6 @@ public:
     void setDeathAttack(EnemyAttack* att);
     
 private:
-    asIScriptFunction* asUpdate;
-    asIScriptFunction* asDraw;
-    asIScriptFunction* asDraw2;
-    asIScriptFunction* asDrawShadow;
-    asIScriptFunction* asTakeHit;
-    asIScriptFunction* asHit;
-    asIScriptFunction* asBreakShield;
-    asIScriptFunction* asEatLink;
-    
     int scriptFlags;
     int wpnPower;
     scoped_ptr<EnemyAttack> deathAttack;
@@ -207,6 +196,7 @@ private:
     void kickbucket();
     int scriptDefendItemClass(int wpnId, int power);
     int getDefendedItemPower();
+    bool scriptCanMove(int ndir, const fix& s, int special, int dx1, int dy1, int dx2, int dy2);
     
     friend void registerEnemy();
 };
@@ -163,7 +163,7 @@ void LinkClass::unfreeze()
 
 void LinkClass::Drown()
 {
-    asIScriptFunction* func=scriptData->getFunction("void Drown()");
+    asIScriptFunction* func=scriptData->getMethod(smDrown);
     scriptData->runFunction(func);
 }
 
@@ -636,11 +636,6 @@ void LinkClass::init()
     diagonalMovement=get_bit(quest_rules,qr_LTTPWALK);
 }
 
-void LinkClass::scriptInit()
-{
-    asUpdate=scriptData->getFunction("int Update()");
-}
-
 void LinkClass::draw_under(BITMAP* dest)
 {
     int c_raft=current_item_id(itype_raft);
@@ -728,7 +723,7 @@ bool LinkClass::agonyflag(int flag)
 // The Whimsical Ring is applied on a target-by-target basis.
 int LinkClass::weaponattackpower()
 {
-    asIScriptFunction* func=scriptData->getFunction("int weaponattackpower()");
+    asIScriptFunction* func=scriptData->getMethod(smWeaponAttackPower);
     scriptData->runFunction(func);
     return scriptData->getLastResult<int>();
 }
@@ -736,7 +731,7 @@ int LinkClass::weaponattackpower()
 // Must only be called once per frame!
 void LinkClass::positionSword(weapon *w, int itemid)
 {
-    asIScriptFunction* func=scriptData->getFunction("void positionSword(weapon@ w, int itemid)");
+    asIScriptFunction* func=scriptData->getMethod(smPositionSword);
     scriptData->runFunction(func, w->getScriptObject(), itemid);
 }
 
@@ -1443,7 +1438,7 @@ void LinkClass::masked_draw(BITMAP* dest)
 // the main weapon checking is in the global function check_collisions()
 void LinkClass::checkstab()
 {
-    asIScriptFunction* func=scriptData->getFunction("void checkstab()");
+    asIScriptFunction* func=scriptData->getMethod(smCheckStab);
     scriptData->runFunction(func);
 }
 
@@ -2562,7 +2557,7 @@ bool LinkClass::animate(int)
     itemEffects.update();
     int lsave=0;
     
-    scriptData->runFunction(asUpdate);
+    scriptData->runFunction(scriptData->getMethod(smLinkUpdate));
     int asRet=scriptData->getLastResult<int>();
     if(asRet==1)
         return true;
@@ -11187,7 +11182,7 @@ int LinkClass::ringpower(int dmg)
 
 bool LinkClass::sideviewhammerpound()
 {
-    asIScriptFunction* func=scriptData->getFunction("bool sideviewhammerpound()");
+    asIScriptFunction* func=scriptData->getMethod(smSideviewHammerPound);
     scriptData->runFunction(func);
     return scriptData->getLastResult<bool>();
 }
@@ -32,7 +32,6 @@
 #include "zc_custom.h"
 #include "subscr.h"
 #include "item/itemEffect.h"
-class asIScriptFunction;
 class ItemAction;
 
 extern movingblock mblock2;                                 //mblock[4]?
@@ -363,12 +362,7 @@ public:
     // Cancels charging when the wand or sword hits an enemy.
     void onMeleeWeaponHit();
     
-    // Load up script functions
-    void scriptInit();
-    
 private:
-    asIScriptFunction* asUpdate;
-    
     void updateGravity();
     void checkLadderRemoval();
     
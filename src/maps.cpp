@@ -3620,7 +3620,7 @@ void loadscr(int tmp,int destdmap, int scr,int ldir,bool overlay=false)
         // Before loading new FFCs, deallocate the arrays the current ones own
         // except those that carry over without resetting.
         // TODO: It would be nice if the FFCs handled this themselves...
-        for(long i=1; i<MAX_ZCARRAY_SIZE; i++)
+        for(long i=nextLocalArray(0); i<MAX_ZCARRAY_SIZE; i=nextLocalArray(i))
         {
             if(arrayOwner[i]<MAXFFCS)
             {
@@ -30,6 +30,12 @@ inline void mutex_unlock(CRITICAL_SECTION* m)
     return LeaveCriticalSection(m);
 }
 
+// Returns true if the lock was taken.
+inline bool mutex_trylock(CRITICAL_SECTION* m)
+{
+    return TryEnterCriticalSection(m)!=0;
+}
+
 #else // Non-Windows
 
 #include <pthread.h>
@@ -56,6 +62,12 @@ inline int mutex_unlock(pthread_mutex_t* m)
     return pthread_mutex_unlock(m);
 }
 
+// Returns true if the lock was taken.
+inline bool mutex_trylock(pthread_mutex_t* m)
+{
+    return pthread_mutex_trylock(m)==0;
+}
+
 #endif
 
 #endif
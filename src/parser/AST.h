@@ -373,7 +373,7 @@ public:
     string fname;
 };
 //////////////////////////////////////////////////////////////////////////////
-class AST
+class AST : public ArenaObject
 {
 public:
     AST(LocationData Loc) : loc(Loc) {}
@@ -839,6 +839,13 @@ public:
     {
         return type;
     }
+    //Hands the type over to the caller, so it can be reused without cloning it
+    ASTType *releaseType()
+    {
+        ASTType *rval = type;
+        type = NULL;
+        return rval;
+    }
     string getName()
     {
         return name;
@@ -152,5 +152,19 @@ public:
     }
 };
 
+//Changes the labels in the map to the ones they map to, and leaves the rest
+class RenameLabels : public ArgumentVisitor
+{
+public:
+    void caseLabel(LabelArgument &host, void *param)
+    {
+        map<int, int> *labels = (map<int, int> *)param;
+        map<int, int>::iterator it = labels->find(host.getID());
+        
+        if(it != labels->end())
+            host.setID(it->second);
+    }
+};
+
 #endif
 
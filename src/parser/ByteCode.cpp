@@ -8,6 +8,7 @@
 #include <assert.h>
 #include <iostream>
 #include <cstdlib>
+#include <typeinfo>
 
 string LiteralArgument::toString()
 {
@@ -1033,6 +1034,80 @@ string LabelArgument::toString()
     }
 }
 
+string OpcodeArgument::getName()
+{
+    if(kind == GLOBAL)
+        return GlobalArgument(value).toString();
+        
+    return VarArgument(value).toString();
+}
+
+struct TypeInfoLess
+{
+    bool operator()(const std::type_info *a, const std::type_info *b) const
+    {
+        return a->before(*b) != 0;
+    }
+};
+
+static map<const std::type_info *, string, TypeInfoLess> mnemonics;
+
+const char *Opcode::getMnemonic()
+{
+    const std::type_info *type = &typeid(*this);
+    map<const std::type_info *, string, TypeInfoLess>::iterator it = mnemonics.find(type);
+    
+    if(it == mnemonics.end())
+    {
+        string line = toString();
+        it = mnemonics.insert(make_pair(type, line.substr(0, line.find(' ')))).first;
+    }
+    
+    return it->second.c_str();
+}
+
+class GetOpcodeArguments : public ArgumentVisitor
+{
+public:
+    GetOpcodeArguments(OpcodeArgument *Args) : args(Args), count(0) {}
+    void caseLiteral(LiteralArgument &host, void *)
+    {
+        add(OpcodeArgument::NUMBER, host.getValue());
+    }
+    void caseVar(VarArgument &host, void *)
+    {
+        add(OpcodeArgument::VARIABLE, host.getID());
+    }
+    void caseLabel(LabelArgument &host, void *)
+    {
+        add(OpcodeArgument::LABEL, host.getLineNo());
+    }
+    void caseGlobal(GlobalArgument &host, void *)
+    {
+        add(OpcodeArgument::GLOBAL, host.getID());
+    }
+    int getCount()
+    {
+        return count;
+    }
+private:
+    void add(int kind, long value)
+    {
+        args[count].kind = kind;
+        args[count].value = value;
+        count++;
+    }
+    OpcodeArgument *args;
+    int count;
+};
+
+int Opcode::getArguments(OpcodeArgument *args)
+{
+    GetOpcodeArguments temp(args);
+    execute(temp, NULL);
+    return temp.getCount();
+}
+
 string OSetTrue::toString()
 {
     return "SETTRUE " + getArgument()->toString();
@@ -1124,6 +1199,11 @@ string OWaitdraw::toString()
     return "WAITDRAW";
 }
 
+string OWaitframesRegister::toString()
+{
+    return "WAITFRAMESR " + getArgument()->toString();
+}
+
 string OGotoImmediate::toString()
 {
     return "GOTO " + getArgument()->toString();
@@ -1846,6 +1926,21 @@ string OGetFFCScript::toString()
     return "GETFFCSCRIPT " + getArgument()->toString();
 }
 
+string OQueryRadius::toString()
+{
+    return "QUERYRADIUS " + getFirstArgument()->toString() + "," + getSecondArgument()->toString();
+}
+
+string OQueryRect::toString()
+{
+    return "QUERYRECT " + getFirstArgument()->toString() + "," + getSecondArgument()->toString();
+}
+
+string OQueryNearest::toString()
+{
+    return "QUERYNEAREST " + getFirstArgument()->toString() + "," + getSecondArgument()->toString();
+}
+
 //////////////////////////////////////////////////////////////////////////////////////
 
 int LinkTable::functionToLabel(int fid)
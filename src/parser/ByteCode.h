@@ -396,7 +396,7 @@ public:
     virtual ~ArgumentVisitor() {}
 };
 
-class Argument
+class Argument : public ArenaObject
 {
 public:
     virtual string toString()=0;
@@ -418,6 +418,10 @@ public:
     {
         return new LiteralArgument(value);
     }
+    long getValue()
+    {
+        return value;
+    }
 private:
     long value;
 };
@@ -435,6 +439,10 @@ public:
     {
         return new VarArgument(ID);
     }
+    int getID()
+    {
+        return ID;
+    }
 private:
     int ID;
 };
@@ -452,6 +460,10 @@ public:
     {
         return new GlobalArgument(ID);
     }
+    int getID()
+    {
+        return ID;
+    }
 private:
     int ID;
 };
@@ -473,11 +485,19 @@ public:
     {
         return ID;
     }
+    void setID(int id)
+    {
+        ID=id;
+    }
     void setLineNo(int l)
     {
         haslineno=true;
         lineno=l;
     }
+    int getLineNo()
+    {
+        return lineno;
+    }
 private:
     int ID;
     int lineno;
@@ -727,6 +747,17 @@ public:
     }
 };
 
+class OWaitframesRegister : public UnaryOpcode
+{
+public:
+    OWaitframesRegister(Argument *A) : UnaryOpcode(A) {}
+    string toString();
+    Opcode *clone()
+    {
+        return new OWaitframesRegister(a->clone());
+    }
+};
+
 class OGotoImmediate : public UnaryOpcode
 {
 public:
@@ -2271,5 +2302,38 @@ public:
     }
 };
 
+class OQueryRadius : public BinaryOpcode
+{
+public:
+    OQueryRadius(Argument *A, Argument *B) : BinaryOpcode(A,B) {}
+    string toString();
+    Opcode *clone()
+    {
+        return new OQueryRadius(a->clone(), b->clone());
+    }
+};
+
+class OQueryRect : public BinaryOpcode
+{
+public:
+    OQueryRect(Argument *A, Argument *B) : BinaryOpcode(A,B) {}
+    string toString();
+    Opcode *clone()
+    {
+        return new OQueryRect(a->clone(), b->clone());
+    }
+};
+
+class OQueryNearest : public BinaryOpcode
+{
+public:
+    OQueryNearest(Argument *A, Argument *B) : BinaryOpcode(A,B) {}
+    string toString();
+    Opcode *clone()
+    {
+        return new OQueryNearest(a->clone(), b->clone());
+    }
+};
+
 #endif
 
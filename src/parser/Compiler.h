@@ -13,7 +13,64 @@
 
 class ArgumentVisitor;
 
-class Opcode
+//One of an opcode's arguments, as the assembler would read it from the printed line
+struct OpcodeArgument
+{
+    enum { NUMBER, LABEL, VARIABLE, GLOBAL };
+    int kind;
+    //The number times 10000, the line a label is on, or the variable's ID
+    long value;
+    //The variable's name as printLine() writes it
+    std::string getName();
+};
+
+//Where the AST, opcodes and arguments made during a compile go. Everything in an arena is freed
+//at once when the arena is destroyed; deleting something in it just runs the destructor.
+class CompileArena
+{
+public:
+    //Becomes the current arena until it's destroyed
+    CompileArena();
+    ~CompileArena();
+    void *allocate(size_t size);
+    unsigned long getObjectCount()
+    {
+        return objects;
+    }
+    size_t getBytesUsed()
+    {
+        return bytes;
+    }
+    size_t getBlockCount()
+    {
+        return blocks.size();
+    }
+    //Takes over everything allocated in another arena, so it's freed with this one
+    void adopt(CompileArena &other);
+    //The arena new objects go in, or NULL to use the heap. Each thread has its own.
+    static CompileArena *getCurrent();
+    static void setCurrent(CompileArena *arena);
+private:
+    std::vector<char *> blocks;
+    char *next;
+    size_t left;
+    unsigned long objects;
+    size_t bytes;
+    CompileArena *previous;
+    //NOT IMPLEMENTED - do not use
+    CompileArena(CompileArena &);
+    CompileArena &operator=(CompileArena &);
+};
+
+//Allocated in the current CompileArena if there is one
+class ArenaObject
+{
+public:
+    static void *operator new(size_t size);
+    static void operator delete(void *p);
+};
+
+class Opcode : public ArenaObject
 {
 public:
     Opcode() : label(-1) {}
@@ -27,6 +84,10 @@ public:
     {
         label=l;
     }
+    //The first word of toString(), worked out once for each kind of opcode
+    const char *getMnemonic();
+    //Fills in args (which has room for two) and returns how many there are
+    int getArguments(OpcodeArgument *args);
     std::string printLine(bool showlabel = false)
     {
         char buf[100];
@@ -61,7 +122,10 @@ struct ScriptsData
     std::map<std::string, int> scriptTypes;
 };
 
-ScriptsData *compile(const char *filename);
+//Called with the name of each pass as it finishes, for timing them
+typedef void (*compile_phase_callback)(const char *phase);
+
+ScriptsData *compile(const char *filename, compile_phase_callback phase_done = NULL);
 
 
 struct SymbolData;
@@ -81,10 +145,7 @@ public:
     {
         return fid++;
     }
-    static int getUniqueLabelID()
-    {
-        return lid++;
-    }
+    static int getUniqueLabelID();
     static int getUniqueGlobalID()
     {
         return gid++;
@@ -106,6 +167,8 @@ public:
     static SymbolData *buildSymbolTable(AST *theAST, std::map<std::string, long> *constants);
     static FunctionData *typeCheck(SymbolData *sdata);
     static IntermediateData *generateOCode(FunctionData *fdata);
+    static bool inlineFunctions(IntermediateData *id);
+    static void optimize(IntermediateData *id);
     static ScriptsData *assemble(IntermediateData *id);
     static void resetState()
     {
@@ -114,6 +177,40 @@ public:
         gid=1;
         lid=0;
     }
+    //Directories to look in for imports not found relative to the working directory
+    static void addIncludePath(const std::string &path)
+    {
+        includePaths.push_back(path);
+    }
+    //Whether compile() runs the object code through optimize()
+    static void setOptimizing(bool on)
+    {
+        optimizing = on;
+    }
+    static bool isOptimizing()
+    {
+        return optimizing;
+    }
+    //How many threads code generation, optimization and assembly use; 1 means just the caller
+    static void setThreads(int n)
+    {
+        threads = n < 1 ? 1 : n;
+    }
+    static int getThreads()
+    {
+        return threads;
+    }
+    //The file parsed imports are kept in between runs, or empty to only keep them in memory
+    static void setImportCacheFile(const std::string &filename)
+    {
+        if(filename != importCacheFile)
+        {
+            importCacheFile = filename;
+            importCacheRead = false;
+        }
+    }
+    //Writes the import cache file, if any imports have been added to it
+    static void writeImportCache();
     static std::pair<long,bool> parseLong(std::pair<std::string,std::string> parts);
     static std::string printType(int type)
     {
@@ -164,11 +261,40 @@ public:
     }
 private:
     static std::string trimQuotes(std::string quoteds);
+    static std::string findImport(const std::string &fn);
+    static AST *parseImport(const std::string &fn);
     static std::vector<Opcode *> assembleOne(std::vector<Opcode *> script, std::map<int, std::vector<Opcode *> > &otherfuncs, int numparams);
+    static void assembleScript(int i, void *param);
+    static void runJobs(int count, void (*job)(int, void *), void *param);
     static int vid;
     static int fid;
     static int gid;
     static int lid;
+    static std::vector<std::string> includePaths;
+    static bool optimizing;
+    static int threads;
+    //The parsed AST of each file imported so far, and the text it was parsed from
+    struct CachedImport
+    {
+        CachedImport() : ast(NULL) {}
+        std::string text;
+        AST *ast;
+    };
+    static std::map<std::string, CachedImport> importCache;
+    //What's in the import cache file: each import's parsed AST as SaveAST wrote it, and the
+    //hash and size of the text it was parsed from
+    struct SavedImport
+    {
+        SavedImport() : hash(0), size(0) {}
+        unsigned long long hash;
+        size_t size;
+        std::string ast;
+    };
+    static std::map<std::string, SavedImport> savedImports;
+    static std::string importCacheFile;
+    static bool importCacheRead;
+    static bool importCacheChanged;
+    static void readImportCache();
 };
 
 
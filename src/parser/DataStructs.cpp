@@ -2,6 +2,7 @@
 #include "../precompiled.h" //always first
 
 #include "DataStructs.h"
+#include "ParseError.h"
 #include "../zsyssimple.h"
 #include <assert.h>
 #include <iostream>
@@ -12,12 +13,11 @@ int StackFrame::getOffset(int vid)
     
     if(it == stackoffset.end())
     {
-        box_out("Internal Error: Can't find stack offset for variable!");
-        box_eol();
+        printErrorLine("Internal Error: Can't find stack offset for variable!");
         return 0;
     }
     
-    return stackoffset[vid];
+    return it->second;
 }
 
 int SymbolTable::getVarType(AST *obj)
@@ -26,8 +26,7 @@ int SymbolTable::getVarType(AST *obj)
     
     if(it == astToID.end())
     {
-        box_out("Internal Error: Can't find the AST ID!");
-        box_eol();
+        printErrorLine("Internal Error: Can't find the AST ID!");
         return -1;
     }
     
@@ -40,8 +39,7 @@ int SymbolTable::getVarType(int varID)
     
     if(it == varTypes.end())
     {
-        box_out("Internal Error: Can't find the variable type!");
-        box_eol();
+        printErrorLine("Internal Error: Can't find the variable type!");
         return -1;
     }
     
@@ -55,7 +53,8 @@ bool SymbolTable::isConstant(string name)
 
 long SymbolTable::getConstantVal(string name)
 {
-    return (*constants)[name];
+    map<string, long>::iterator it = constants->find(name);
+    return it == constants->end() ? 0 : it->second;
 }
 
 int VariableSymbols::addVariable(string name, int type)
@@ -130,6 +129,30 @@ vector<int> FunctionSymbols::getFuncIDs(string name)
     return it->second;
 }
 
+void FunctionSymbols::removeFunction(string name, vector<int> &params)
+{
+    map<pair<string, vector<int> >, pair<int, int> >::iterator it = symbols.find(pair<string, vector<int> >(name, params));
+    
+    if(it == symbols.end())
+        return;
+        
+    int id = it->second.second;
+    symbols.erase(it);
+    vector<int> &ids = ambiguous[name];
+    
+    for(vector<int>::iterator it2 = ids.begin(); it2 != ids.end(); it2++)
+    {
+        if(*it2 == id)
+        {
+            ids.erase(it2);
+            break;
+        }
+    }
+    
+    if(ids.empty())
+        ambiguous.erase(name);
+}
+
 bool Scope::addNamedChild(string name, Scope *child)
 {
     map<string, Scope *>::iterator it = namedChildren.find(name);
@@ -230,7 +253,7 @@ void SymbolTable::putAST(AST *obj, int ID)
 
 int SymbolTable::getFuncType(AST *obj)
 {
-    return getFuncType(astToID[obj]);
+    return getFuncType(getID(obj));
 }
 
 void SymbolTable::printDiagnostics()
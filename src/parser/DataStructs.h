@@ -30,11 +30,13 @@ public:
     bool containsFunction(string name, vector<int> &params);
     int getID(string name, vector<int> &params);
     vector<int> getFuncIDs(string name);
+    void removeFunction(string name, vector<int> &params);
 private:
     map<pair<string, vector<int> >, pair<int,int> > symbols;
     map<string, vector<int> > ambiguous;
 };
 
+//The lookups never add to the table, so code generation workers can share one
 class SymbolTable
 {
 public:
@@ -42,7 +44,8 @@ public:
     int getVarType(int varID);
     int getFuncType(int funcID)
     {
-        return funcTypes[funcID];
+        map<int, int>::iterator it = funcTypes.find(funcID);
+        return it == funcTypes.end() ? 0 : it->second;
     }
     void putVar(int ID, int type)
     {
@@ -62,15 +65,18 @@ public:
     int getFuncType(AST *obj);
     vector<int> getFuncParams(int funcID)
     {
-        return funcParams[funcID];
+        map<int, vector<int> >::iterator it = funcParams.find(funcID);
+        return it == funcParams.end() ? vector<int>() : it->second;
     }
     vector<int> getAmbiguousFuncs(AST *func)
     {
-        return astToAmbiguousFuncIDs[func];
+        map<AST *, vector<int> >::iterator it = astToAmbiguousFuncIDs.find(func);
+        return it == astToAmbiguousFuncIDs.end() ? vector<int>() : it->second;
     }
     int getID(AST *obj)
     {
-        return astToID[obj];
+        map<AST *, int>::iterator it = astToID.find(obj);
+        return it == astToID.end() ? 0 : it->second;
     }
     void printDiagnostics();
     vector<int> &getGlobalPointers(void)
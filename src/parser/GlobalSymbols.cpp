@@ -5,6 +5,8 @@
 #include "ByteCode.h"
 #include "../zsyssimple.h"
 #include <assert.h>
+#include <string.h>
+#include <algorithm>
 
 const int radsperdeg = 572958;
 
@@ -14,8 +16,12 @@ const int radsperdeg = 572958;
 #define S ScriptParser::TYPE_SCREEN
 #define F ScriptParser::TYPE_FLOAT
 
+#define ARGS_2(t, arg1, arg2) \
+	{ t, arg1, arg2, -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1 }
 #define ARGS_4(t, arg1, arg2, arg3, arg4) \
 	{ t, arg1, arg2, arg3, arg4, -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1 }
+#define ARGS_5(t, arg1, arg2, arg3, arg4, arg5) \
+	{ t, arg1, arg2, arg3, arg4, arg5, -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1 }
 #define ARGS_6(t, arg1, arg2, arg3, arg4, arg5, arg6) \
 	{ t, arg1, arg2, arg3, arg4, arg5, arg6, -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1 }
 #define ARGS_8(t, arg1, arg2, arg3, arg4, arg5, arg6, arg7, arg8) \
@@ -27,14 +33,124 @@ const int radsperdeg = 572958;
 
 
 
+static unsigned int accessorHash(const char *name, unsigned int seed)
+{
+    unsigned int hash = 2166136261u ^ seed;
+    
+    for(; *name; name++)
+        hash = (hash ^ (unsigned char)*name) * 16777619u;
+        
+    return hash;
+}
+
+//No bucket should ever get anywhere near this; only a repeated name can exhaust it
+static const unsigned int maxAccessorSeed = 1<<20;
+
+//Hash and displace: the names are split into small buckets, and each bucket, biggest first,
+//gets the first seed that puts all of its names in free slots
+void AccessorIndex::build(AccessorTable *t)
+{
+    int count = 0;
+    
+    while(t[count].name[0])
+        count++;
+        
+    unsigned int numslots = count + count/4 + 1;
+    unsigned int numbuckets = count/4 + 1;
+    vector<vector<int> > buckets(numbuckets);
+    
+    for(int i=0; i<count; i++)
+        buckets[accessorHash(t[i].name, 0) % numbuckets].push_back(i);
+        
+    vector<pair<int, int> > order;
+    
+    for(unsigned int b=0; b<numbuckets; b++)
+        order.push_back(pair<int, int>(-(int)buckets[b].size(), b));
+        
+    std::sort(order.begin(), order.end());
+    displacements.assign(numbuckets, 0);
+    rows.assign(numslots, -1);
+    vector<unsigned int> slots;
+    
+    for(vector<pair<int, int> >::iterator it = order.begin(); it != order.end() && it->first < 0; it++)
+    {
+        vector<int> &bucket = buckets[it->second];
+        
+        unsigned int seed;
+        
+        for(seed = 1; seed < maxAccessorSeed; seed++)
+        {
+            slots.clear();
+            
+            for(vector<int>::iterator row = bucket.begin(); row != bucket.end(); row++)
+            {
+                unsigned int slot = accessorHash(t[*row].name, seed) % numslots;
+                
+                if(rows[slot] != -1 || std::find(slots.begin(), slots.end(), slot) != slots.end())
+                    break;
+                    
+                slots.push_back(slot);
+            }
+            
+            if(slots.size() == bucket.size())
+            {
+                for(size_t i=0; i<slots.size(); i++)
+                    rows[slots[i]] = bucket[i];
+                    
+                displacements[it->second] = seed;
+                break;
+            }
+        }
+        
+        //Only two rows with the same name can't be separated by any seed
+        if(seed == maxAccessorSeed)
+        {
+            for(size_t i=0; i<bucket.size(); i++)
+                for(size_t j=i+1; j<bucket.size(); j++)
+                    if(!strcmp(t[bucket[i]].name, t[bucket[j]].name))
+                    {
+                        char buf[100];
+                        sprintf(buf, "Accessor table has \"%s\" twice", t[bucket[i]].name);
+                        box_out(buf);
+                        box_eol();
+                    }
+                    
+            displacements.clear();
+            rows.clear();
+            break;
+        }
+    }
+    
+    table = t;
+}
+
+int AccessorIndex::find(const char *name)
+{
+    //No perfect hash could be found, so fall back to searching the table
+    if(rows.empty())
+    {
+        for(int i=0; table[i].name[0]; i++)
+            if(!strcmp(table[i].name, name))
+                return i;
+                
+        return -1;
+    }
+    
+    unsigned int seed = displacements[accessorHash(name, 0) % displacements.size()];
+    int row = rows[accessorHash(name, seed) % rows.size()];
+    return row != -1 && !strcmp(table[row].name, name) ? row : -1;
+}
+
 void LibrarySymbols::addSymbolsToScope(Scope *scope, SymbolTable *t)
 {
+    if(!index.isBuilt())
+        index.build(table);
+        
     //waste an ID, OH WELL
-    memberids.clear();
     firstid = ScriptParser::getUniqueFuncID()+1;
     int id = firstid;
     
-    for(int i=0; table[i].name != ""; i++,id++)
+    for(int i=0; table[i].name[0]; i++,id++)
     {
         vector<int> param;
         
@@ -45,19 +161,14 @@ void LibrarySymbols::addSymbolsToScope(Scope *scope, SymbolTable *t)
         scope->getFuncSymbols().addFunction(name, table[i].rettype,param);
         t->putFunc(id, table[i].rettype);
         t->putFuncDecl(id, param);
-        memberids[name]=id;
     }
 }
 
-pair<int, vector<int> > LibrarySymbols::matchFunction(string name, SymbolTable *t)
+pair<int, vector<int> > LibrarySymbols::matchFunction(const string &name, SymbolTable *t)
 {
     pair<int,vector<int> > rval;
-    int id = -1;
-    map<string, int>::iterator it = memberids.find(name);
+    int id = getMemberID(name.c_str());
     
-    if(it != memberids.end())
-        id = it->second;
-        
     if(id == -1)
     {
         rval.first = -1;
@@ -74,12 +185,11 @@ map<int, vector<Opcode *> > LibrarySymbols::addSymbolsCode(LinkTable &lt)
 {
     map<int, vector<Opcode *> > rval;
     
-    for(int i=0; table[i].name != ""; i++)
+    for(int i=0; table[i].name[0]; i++)
     {
         int var = table[i].var;
-        string name = table[i].name;
         bool isIndexed = table[i].numindex > 1;
-        int id = memberids[name];
+        int id = firstid + i;
         int label = lt.functionToLabel(id);
         
         switch(table[i].setorget)
@@ -230,6 +340,7 @@ static AccessorTable GlobalTable[] =
     { "Quit",                   ScriptParser::TYPE_VOID,          FUNCTION,     0,                    1,      { -1,                               -1,                               -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1                           } },
     { "Waitframe",              ScriptParser::TYPE_VOID,          FUNCTION,     0,                    1,      { -1,                               -1,                               -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1                           } },
     { "Waitdraw",               ScriptParser::TYPE_VOID,          FUNCTION,     0,                    1,      { -1,                               -1,                               -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1                           } },
+    { "Waitframes",             ScriptParser::TYPE_VOID,          FUNCTION,     0,                    1,      {  ScriptParser::TYPE_FLOAT,        -1,                               -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1                           } },
     { "Trace",                  ScriptParser::TYPE_VOID,          FUNCTION,     0,                    1,      {  ScriptParser::TYPE_FLOAT,        -1,                               -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1                           } },
     { "TraceB",                 ScriptParser::TYPE_VOID,          FUNCTION,     0,                    1,      {  ScriptParser::TYPE_BOOL,         -1,                               -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1                           } },
     { "TraceS",                 ScriptParser::TYPE_VOID,          FUNCTION,     0,                    1,      {  ScriptParser::TYPE_FLOAT,        -1,                               -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1                           } },
@@ -284,7 +395,7 @@ map<int, vector<Opcode *> > GlobalSymbols::addSymbolsCode(LinkTable &lt)
     int id;
     //int Rand(int maxval)
     {
-        id = memberids["Rand"];
+        id = getMemberID("Rand");
         int label  = lt.functionToLabel(id);
         vector<Opcode *> code;
         //pop maxval
@@ -298,7 +409,7 @@ map<int, vector<Opcode *> > GlobalSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void Quit()
     {
-        id = memberids["Quit"];
+        id = getMemberID("Quit");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OPopRegister(new VarArgument(EXP2));
@@ -309,7 +420,7 @@ map<int, vector<Opcode *> > GlobalSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void Waitframe()
     {
-        id = memberids["Waitframe"];
+        id = getMemberID("Waitframe");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OWaitframe();
@@ -321,7 +432,7 @@ map<int, vector<Opcode *> > GlobalSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void Waitdraw()
     {
-        id = memberids["Waitdraw"];
+        id = getMemberID("Waitdraw");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OWaitdraw();
@@ -331,9 +442,23 @@ map<int, vector<Opcode *> > GlobalSymbols::addSymbolsCode(LinkTable &lt)
         code.push_back(new OGotoRegister(new VarArgument(EXP2)));
         rval[label]=code;
     }
+    //void Waitframes(int n)
+    {
+        id = getMemberID("Waitframes");
+        int label = lt.functionToLabel(id);
+        vector<Opcode *> code;
+        //pop n
+        Opcode *first = new OPopRegister(new VarArgument(EXP2));
+        first->setLabel(label);
+        code.push_back(first);
+        code.push_back(new OWaitframesRegister(new VarArgument(EXP2)));
+        code.push_back(new OPopRegister(new VarArgument(EXP2)));
+        code.push_back(new OGotoRegister(new VarArgument(EXP2)));
+        rval[label]=code;
+    }
     //void Trace(int val)
     {
-        id = memberids["Trace"];
+        id = getMemberID("Trace");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OPopRegister(new VarArgument(EXP2));
@@ -346,7 +471,7 @@ map<int, vector<Opcode *> > GlobalSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void TraceB(bool val)
     {
-        id = memberids["TraceB"];
+        id = getMemberID("TraceB");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OPopRegister(new VarArgument(EXP2));
@@ -359,7 +484,7 @@ map<int, vector<Opcode *> > GlobalSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void TraceS(bool val)
     {
-        id = memberids["TraceS"];
+        id = getMemberID("TraceS");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OPopRegister(new VarArgument(INDEX));
@@ -372,7 +497,7 @@ map<int, vector<Opcode *> > GlobalSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void TraceNL()
     {
-        id = memberids["TraceNL"];
+        id = getMemberID("TraceNL");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OTrace3();
@@ -384,7 +509,7 @@ map<int, vector<Opcode *> > GlobalSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void ClearTrace()
     {
-        id = memberids["ClearTrace"];
+        id = getMemberID("ClearTrace");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OTrace4();
@@ -396,7 +521,7 @@ map<int, vector<Opcode *> > GlobalSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void TraceToBase(float, float, float)
     {
-        id = memberids["TraceToBase"];
+        id = getMemberID("TraceToBase");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OTrace5Register();
@@ -412,7 +537,7 @@ map<int, vector<Opcode *> > GlobalSymbols::addSymbolsCode(LinkTable &lt)
     }
     //int Sin(int val)
     {
-        id = memberids["Sin"];
+        id = getMemberID("Sin");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OPopRegister(new VarArgument(EXP2));
@@ -425,7 +550,7 @@ map<int, vector<Opcode *> > GlobalSymbols::addSymbolsCode(LinkTable &lt)
     }
     //int RadianSin(int val)
     {
-        id = memberids["RadianSin"];
+        id = getMemberID("RadianSin");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OPopRegister(new VarArgument(EXP2));
@@ -439,7 +564,7 @@ map<int, vector<Opcode *> > GlobalSymbols::addSymbolsCode(LinkTable &lt)
     }
     //int ArcSin(int val)
     {
-        id = memberids["ArcSin"];
+        id = getMemberID("ArcSin");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OPopRegister(new VarArgument(EXP2));
@@ -452,7 +577,7 @@ map<int, vector<Opcode *> > GlobalSymbols::addSymbolsCode(LinkTable &lt)
     }
     //int Cos(int val)
     {
-        id = memberids["Cos"];
+        id = getMemberID("Cos");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OPopRegister(new VarArgument(EXP2));
@@ -465,7 +590,7 @@ map<int, vector<Opcode *> > GlobalSymbols::addSymbolsCode(LinkTable &lt)
     }
     //int RadianCos(int val)
     {
-        id = memberids["RadianCos"];
+        id = getMemberID("RadianCos");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OPopRegister(new VarArgument(EXP2));
@@ -479,7 +604,7 @@ map<int, vector<Opcode *> > GlobalSymbols::addSymbolsCode(LinkTable &lt)
     }
     //int ArcCos(int val)
     {
-        id = memberids["ArcCos"];
+        id = getMemberID("ArcCos");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OPopRegister(new VarArgument(EXP2));
@@ -492,7 +617,7 @@ map<int, vector<Opcode *> > GlobalSymbols::addSymbolsCode(LinkTable &lt)
     }
     //int Tan(int val)
     {
-        id = memberids["Tan"];
+        id = getMemberID("Tan");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OPopRegister(new VarArgument(EXP2));
@@ -505,7 +630,7 @@ map<int, vector<Opcode *> > GlobalSymbols::addSymbolsCode(LinkTable &lt)
     }
     //int ArcTan(int X, int Y)
     {
-        id = memberids["ArcTan"];
+        id = getMemberID("ArcTan");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OPopRegister(new VarArgument(INDEX2));
@@ -519,7 +644,7 @@ map<int, vector<Opcode *> > GlobalSymbols::addSymbolsCode(LinkTable &lt)
     }
     //int RadianTan(int val)
     {
-        id = memberids["RadianTan"];
+        id = getMemberID("RadianTan");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OPopRegister(new VarArgument(EXP2));
@@ -533,7 +658,7 @@ map<int, vector<Opcode *> > GlobalSymbols::addSymbolsCode(LinkTable &lt)
     }
     //int Max(int first, int second)
     {
-        id = memberids["Max"];
+        id = getMemberID("Max");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OPopRegister(new VarArgument(EXP2));
@@ -547,7 +672,7 @@ map<int, vector<Opcode *> > GlobalSymbols::addSymbolsCode(LinkTable &lt)
     }
     //int Min(int first, int second)
     {
-        id = memberids["Min"];
+        id = getMemberID("Min");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OPopRegister(new VarArgument(EXP2));
@@ -561,7 +686,7 @@ map<int, vector<Opcode *> > GlobalSymbols::addSymbolsCode(LinkTable &lt)
     }
     //int Pow(int first, int second)
     {
-        id = memberids["Pow"];
+        id = getMemberID("Pow");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OPopRegister(new VarArgument(EXP2));
@@ -575,7 +700,7 @@ map<int, vector<Opcode *> > GlobalSymbols::addSymbolsCode(LinkTable &lt)
     }
     //int InvPow(int first, int second)
     {
-        id = memberids["InvPow"];
+        id = getMemberID("InvPow");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OPopRegister(new VarArgument(EXP2));
@@ -589,7 +714,7 @@ map<int, vector<Opcode *> > GlobalSymbols::addSymbolsCode(LinkTable &lt)
     }
     //int Factorial(int val)
     {
-        id = memberids["Factorial"];
+        id = getMemberID("Factorial");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OPopRegister(new VarArgument(EXP1));
@@ -602,7 +727,7 @@ map<int, vector<Opcode *> > GlobalSymbols::addSymbolsCode(LinkTable &lt)
     }
     //int Abs(int val)
     {
-        id = memberids["Abs"];
+        id = getMemberID("Abs");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OPopRegister(new VarArgument(EXP1));
@@ -615,7 +740,7 @@ map<int, vector<Opcode *> > GlobalSymbols::addSymbolsCode(LinkTable &lt)
     }
     //int Log10(int val)
     {
-        id = memberids["Log10"];
+        id = getMemberID("Log10");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OPopRegister(new VarArgument(EXP1));
@@ -628,7 +753,7 @@ map<int, vector<Opcode *> > GlobalSymbols::addSymbolsCode(LinkTable &lt)
     }
     //int Ln(int val)
     {
-        id = memberids["Ln"];
+        id = getMemberID("Ln");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OPopRegister(new VarArgument(EXP1));
@@ -641,7 +766,7 @@ map<int, vector<Opcode *> > GlobalSymbols::addSymbolsCode(LinkTable &lt)
     }
     //int Sqrt(int val)
     {
-        id = memberids["Sqrt"];
+        id = getMemberID("Sqrt");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OPopRegister(new VarArgument(EXP1));
@@ -656,7 +781,7 @@ map<int, vector<Opcode *> > GlobalSymbols::addSymbolsCode(LinkTable &lt)
     
     //int CopyTile(int source, int dest)
     {
-        id = memberids["CopyTile"];
+        id = getMemberID("CopyTile");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OPopRegister(new VarArgument(EXP2));
@@ -670,7 +795,7 @@ map<int, vector<Opcode *> > GlobalSymbols::addSymbolsCode(LinkTable &lt)
     }
     //int SwapTile(int first, int second)
     {
-        id = memberids["SwapTile"];
+        id = getMemberID("SwapTile");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OPopRegister(new VarArgument(EXP2));
@@ -684,7 +809,7 @@ map<int, vector<Opcode *> > GlobalSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void ClearTile(int tile)
     {
-        id = memberids["ClearTile"];
+        id = getMemberID("ClearTile");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OPopRegister(new VarArgument(EXP2));
@@ -697,7 +822,7 @@ map<int, vector<Opcode *> > GlobalSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void GetGlobalRAM(int)
     {
-        int id2 = memberids["GetGlobalRAM"];
+        int id2 = getMemberID("GetGlobalRAM");
         int label = lt.functionToLabel(id2);
         vector<Opcode *> code;
         //pop off the params
@@ -711,7 +836,7 @@ map<int, vector<Opcode *> > GlobalSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void SetGlobalRAM(int, int)
     {
-        int id2 = memberids["SetGlobalRAM"];
+        int id2 = getMemberID("SetGlobalRAM");
         int label = lt.functionToLabel(id2);
         vector<Opcode *> code;
         //pop off the params
@@ -726,7 +851,7 @@ map<int, vector<Opcode *> > GlobalSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void GetScriptRAM(int)
     {
-        int id2 = memberids["GetScriptRAM"];
+        int id2 = getMemberID("GetScriptRAM");
         int label = lt.functionToLabel(id2);
         vector<Opcode *> code;
         //pop off the params
@@ -741,7 +866,7 @@ map<int, vector<Opcode *> > GlobalSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void SetScriptRAM(int, int)
     {
-        int id2 = memberids["SetScriptRAM"];
+        int id2 = getMemberID("SetScriptRAM");
         int label = lt.functionToLabel(id2);
         vector<Opcode *> code;
         //pop off the params
@@ -756,7 +881,7 @@ map<int, vector<Opcode *> > GlobalSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void SetColorBuffer(int amount, int offset, int stride, int *ptr)
     {
-        id = memberids["SetColorBuffer"];
+        id = getMemberID("SetColorBuffer");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OSetColorBufferRegister();
@@ -772,7 +897,7 @@ map<int, vector<Opcode *> > GlobalSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void SetDepthBuffer(int amount, int offset, int stride, int *ptr)
     {
-        id = memberids["SetDepthBuffer"];
+        id = getMemberID("SetDepthBuffer");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OSetDepthBufferRegister();
@@ -788,7 +913,7 @@ map<int, vector<Opcode *> > GlobalSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void GetColorBuffer(int amount, int offset, int stride, int *ptr)
     {
-        id = memberids["GetColorBuffer"];
+        id = getMemberID("GetColorBuffer");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OGetColorBufferRegister();
@@ -804,7 +929,7 @@ map<int, vector<Opcode *> > GlobalSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void GetDepthBuffer(int amount, int offset, int stride, int *ptr)
     {
-        id = memberids["GetDepthBuffer"];
+        id = getMemberID("GetDepthBuffer");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OGetDepthBufferRegister();
@@ -820,7 +945,7 @@ map<int, vector<Opcode *> > GlobalSymbols::addSymbolsCode(LinkTable &lt)
     }
     //int SizeOfArray(int val)
     {
-        id = memberids["SizeOfArray"];
+        id = getMemberID("SizeOfArray");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OPopRegister(new VarArgument(EXP1));
@@ -892,7 +1017,7 @@ map<int, vector<Opcode *> > FFCSymbols::addSymbolsCode(LinkTable &lt)
     map<int, vector<Opcode *> > rval = LibrarySymbols::addSymbolsCode(lt);
     //bool WasTriggered(ffc)
     /*{
-    	int id = memberids["WasTriggered"];
+    	int id = getMemberID("WasTriggered");
     	int label  = lt.functionToLabel(id);
     	vector<Opcode *> code;
     	//pop ffc
@@ -1093,7 +1218,7 @@ map<int, vector<Opcode *> > LinkSymbols::addSymbolsCode(LinkTable &lt)
     map<int, vector<Opcode *> > rval = LibrarySymbols::addSymbolsCode(lt);
     //Warp(link, int, int)
     {
-        int id = memberids["Warp"];
+        int id = getMemberID("Warp");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         //pop off the params
@@ -1111,7 +1236,7 @@ map<int, vector<Opcode *> > LinkSymbols::addSymbolsCode(LinkTable &lt)
     }
     //PitWarp(link, int, int)
     {
-        int id = memberids["PitWarp"];
+        int id = getMemberID("PitWarp");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         //pop off the params
@@ -1129,7 +1254,7 @@ map<int, vector<Opcode *> > LinkSymbols::addSymbolsCode(LinkTable &lt)
     }
     //SelectAWeapon(link, int)
     {
-        int id = memberids["SelectAWeapon"];
+        int id = getMemberID("SelectAWeapon");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         //pop off the param
@@ -1145,7 +1270,7 @@ map<int, vector<Opcode *> > LinkSymbols::addSymbolsCode(LinkTable &lt)
     }
     //SelectBWeapon(link, int)
     {
-        int id = memberids["SelectBWeapon"];
+        int id = getMemberID("SelectBWeapon");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         //pop off the param
@@ -1261,6 +1386,18 @@ static AccessorTable ScreenTable[] =
     { "GetTileWarpDMap",        ScriptParser::TYPE_FLOAT,         FUNCTION,     0,                    1,      {  ScriptParser::TYPE_SCREEN,          ScriptParser::TYPE_FLOAT,         -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1                           } },
     { "GetTileWarpScreen",      ScriptParser::TYPE_FLOAT,         FUNCTION,     0,                    1,      {  ScriptParser::TYPE_SCREEN,          ScriptParser::TYPE_FLOAT,         -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1                           } },
     { "GetTileWarpType",        ScriptParser::TYPE_FLOAT,         FUNCTION,     0,                    1,      {  ScriptParser::TYPE_SCREEN,          ScriptParser::TYPE_FLOAT,         -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1                           } },
+    { "NPCsInRadius",      F, FUNCTION, 0, 1, ARGS_4(S,F,F,F,F) },
+    { "ItemsInRadius",     F, FUNCTION, 0, 1, ARGS_4(S,F,F,F,F) },
+    { "EWeaponsInRadius",  F, FUNCTION, 0, 1, ARGS_4(S,F,F,F,F) },
+    { "LWeaponsInRadius",  F, FUNCTION, 0, 1, ARGS_4(S,F,F,F,F) },
+    { "NPCsInRect",        F, FUNCTION, 0, 1, ARGS_5(S,F,F,F,F,F) },
+    { "ItemsInRect",       F, FUNCTION, 0, 1, ARGS_5(S,F,F,F,F,F) },
+    { "EWeaponsInRect",    F, FUNCTION, 0, 1, ARGS_5(S,F,F,F,F,F) },
+    { "LWeaponsInRect",    F, FUNCTION, 0, 1, ARGS_5(S,F,F,F,F,F) },
+    { "NearestNPC",        F, FUNCTION, 0, 1, ARGS_2(S,F,F) },
+    { "NearestItem",       F, FUNCTION, 0, 1, ARGS_2(S,F,F) },
+    { "NearestEWeapon",    F, FUNCTION, 0, 1, ARGS_2(S,F,F) },
+    { "NearestLWeapon",    F, FUNCTION, 0, 1, ARGS_2(S,F,F) },
     { "",                      -1,                               -1,           -1,                   -1,      { -1,                                -1,                              -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1,                           -1                           } }
 };
 
@@ -1276,7 +1413,7 @@ map<int, vector<Opcode *> > ScreenSymbols::addSymbolsCode(LinkTable &lt)
     map<int, vector<Opcode *> > rval = LibrarySymbols::addSymbolsCode(lt);
     //item LoadItem(screen, int)
     {
-        int id = memberids["LoadItem"];
+        int id = getMemberID("LoadItem");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         //pop off the param
@@ -1295,7 +1432,7 @@ map<int, vector<Opcode *> > ScreenSymbols::addSymbolsCode(LinkTable &lt)
     }
     //item CreateItem(screen, int)
     {
-        int id = memberids["CreateItem"];
+        int id = getMemberID("CreateItem");
         
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
@@ -1313,7 +1450,7 @@ map<int, vector<Opcode *> > ScreenSymbols::addSymbolsCode(LinkTable &lt)
     }
     //ffc LoadFFC(screen, int)
     {
-        int id = memberids["LoadFFC"];
+        int id = getMemberID("LoadFFC");
         
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
@@ -1331,7 +1468,7 @@ map<int, vector<Opcode *> > ScreenSymbols::addSymbolsCode(LinkTable &lt)
     }
     //npc LoadNPC(screen, int)
     {
-        int id = memberids["LoadNPC"];
+        int id = getMemberID("LoadNPC");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         //pop off the param
@@ -1350,7 +1487,7 @@ map<int, vector<Opcode *> > ScreenSymbols::addSymbolsCode(LinkTable &lt)
     }
     //npc CreateNPC(screen, int)
     {
-        int id = memberids["CreateNPC"];
+        int id = getMemberID("CreateNPC");
         
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
@@ -1368,7 +1505,7 @@ map<int, vector<Opcode *> > ScreenSymbols::addSymbolsCode(LinkTable &lt)
     }
     //npc LoadLWeapon(screen, int)
     {
-        int id = memberids["LoadLWeapon"];
+        int id = getMemberID("LoadLWeapon");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         //pop off the param
@@ -1387,7 +1524,7 @@ map<int, vector<Opcode *> > ScreenSymbols::addSymbolsCode(LinkTable &lt)
     }
     //npc CreateLWeapon(screen, int)
     {
-        int id = memberids["CreateLWeapon"];
+        int id = getMemberID("CreateLWeapon");
         
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
@@ -1405,7 +1542,7 @@ map<int, vector<Opcode *> > ScreenSymbols::addSymbolsCode(LinkTable &lt)
     }
     //ewpn LoadEWeapon(screen, int)
     {
-        int id = memberids["LoadEWeapon"];
+        int id = getMemberID("LoadEWeapon");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         //pop off the param
@@ -1424,7 +1561,7 @@ map<int, vector<Opcode *> > ScreenSymbols::addSymbolsCode(LinkTable &lt)
     }
     //ewpn CreateEWeapon(screen, int)
     {
-        int id = memberids["CreateEWeapon"];
+        int id = getMemberID("CreateEWeapon");
         
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
@@ -1442,7 +1579,7 @@ map<int, vector<Opcode *> > ScreenSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void ClearSprites(screen, int)
     {
-        int id = memberids["ClearSprites"];
+        int id = getMemberID("ClearSprites");
         
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
@@ -1460,7 +1597,7 @@ map<int, vector<Opcode *> > ScreenSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void Rectangle(screen, float, float, float, float, float, float, float, float, float, float, bool, float)
     {
-        int id = memberids["Rectangle"];
+        int id = getMemberID("Rectangle");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new ORectangleRegister();
@@ -1476,7 +1613,7 @@ map<int, vector<Opcode *> > ScreenSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void Circle(screen, float, float, float, float, float, float, float, float, float, bool, float)
     {
-        int id = memberids["Circle"];
+        int id = getMemberID("Circle");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OCircleRegister();
@@ -1492,7 +1629,7 @@ map<int, vector<Opcode *> > ScreenSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void Arc(screen, float, float, float, float, float, float, float, float, float, float, float, bool, bool, float)
     {
-        int id = memberids["Arc"];
+        int id = getMemberID("Arc");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OArcRegister();
@@ -1508,7 +1645,7 @@ map<int, vector<Opcode *> > ScreenSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void Ellipse(screen, float, float, float, float, float, bool, float, float, float)
     {
-        int id = memberids["Ellipse"];
+        int id = getMemberID("Ellipse");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OEllipseRegister();
@@ -1524,7 +1661,7 @@ map<int, vector<Opcode *> > ScreenSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void Line(screen, float, float, float, float, float, float, float, float, float, float, float)
     {
-        int id = memberids["Line"];
+        int id = getMemberID("Line");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OLineRegister();
@@ -1540,7 +1677,7 @@ map<int, vector<Opcode *> > ScreenSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void Spline(screen, float, float, float, float, float, float, float, float, float, float, float)
     {
-        int id = memberids["Spline"];
+        int id = getMemberID("Spline");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OSplineRegister();
@@ -1556,7 +1693,7 @@ map<int, vector<Opcode *> > ScreenSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void PutPixel(screen, float, float, float, float, float, float, float, float)
     {
-        int id = memberids["PutPixel"];
+        int id = getMemberID("PutPixel");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OPutPixelRegister();
@@ -1572,7 +1709,7 @@ map<int, vector<Opcode *> > ScreenSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void DrawCharacter(screen, float, float, float, float, float, float, float, float, float, float)
     {
-        int id = memberids["DrawCharacter"];
+        int id = getMemberID("DrawCharacter");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new ODrawCharRegister();
@@ -1588,7 +1725,7 @@ map<int, vector<Opcode *> > ScreenSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void DrawInteger(screen, float, float, float, float, float, float, float, float, float, float, float)
     {
-        int id = memberids["DrawInteger"];
+        int id = getMemberID("DrawInteger");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new ODrawIntRegister();
@@ -1604,7 +1741,7 @@ map<int, vector<Opcode *> > ScreenSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void DrawTile(screen, float, float, float, float, float, bool, float, float, float)
     {
-        int id = memberids["DrawTile"];
+        int id = getMemberID("DrawTile");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new ODrawTileRegister();
@@ -1620,7 +1757,7 @@ map<int, vector<Opcode *> > ScreenSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void DrawCombo(screen, float, float, float, float, float, bool, float, float, float)
     {
-        int id = memberids["DrawCombo"];
+        int id = getMemberID("DrawCombo");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new ODrawComboRegister();
@@ -1636,7 +1773,7 @@ map<int, vector<Opcode *> > ScreenSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void Quad(screen, float, float, float, float, float, float, float, float, float)
     {
-        int id = memberids["Quad"];
+        int id = getMemberID("Quad");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OQuadRegister();
@@ -1652,7 +1789,7 @@ map<int, vector<Opcode *> > ScreenSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void Triangle(screen, float, float, float, float, float, float, float, float, float)
     {
-        int id = memberids["Triangle"];
+        int id = getMemberID("Triangle");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OTriangleRegister();
@@ -1669,7 +1806,7 @@ map<int, vector<Opcode *> > ScreenSymbols::addSymbolsCode(LinkTable &lt)
     
     //void Quad3D(screen, float, float, float, float, float, float, float, float, float)
     {
-        int id = memberids["Quad3D"];
+        int id = getMemberID("Quad3D");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OQuad3DRegister();
@@ -1685,7 +1822,7 @@ map<int, vector<Opcode *> > ScreenSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void Triangle3D(screen, float, float, float, float, float, float, float, float, float)
     {
-        int id = memberids["Triangle3D"];
+        int id = getMemberID("Triangle3D");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OTriangle3DRegister();
@@ -1702,7 +1839,7 @@ map<int, vector<Opcode *> > ScreenSymbols::addSymbolsCode(LinkTable &lt)
     
     //void FastTile(screen, float, float, float, float, float)
     {
-        int id = memberids["FastTile"];
+        int id = getMemberID("FastTile");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OFastTileRegister();
@@ -1718,7 +1855,7 @@ map<int, vector<Opcode *> > ScreenSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void FastCombo(screen, float, float, float, float, float)
     {
-        int id = memberids["FastCombo"];
+        int id = getMemberID("FastCombo");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OFastComboRegister();
@@ -1734,7 +1871,7 @@ map<int, vector<Opcode *> > ScreenSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void DrawString(screen, float, float, float, float, float, float, float, int *string)
     {
-        int id = memberids["DrawString"];
+        int id = getMemberID("DrawString");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new ODrawStringRegister();
@@ -1750,7 +1887,7 @@ map<int, vector<Opcode *> > ScreenSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void DrawLayer(screen, float, float, float, float, float, float, float, float)
     {
-        int id = memberids["DrawLayer"];
+        int id = getMemberID("DrawLayer");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new ODrawLayerRegister();
@@ -1766,7 +1903,7 @@ map<int, vector<Opcode *> > ScreenSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void DrawScreen(screen, float, float, float, float, float, float)
     {
-        int id = memberids["DrawScreen"];
+        int id = getMemberID("DrawScreen");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new ODrawScreenRegister();
@@ -1782,7 +1919,7 @@ map<int, vector<Opcode *> > ScreenSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void DrawBitmap(screen, float, float, float, float, float, float, float, float, float, bool)
     {
-        int id = memberids["DrawBitmap"];
+        int id = getMemberID("DrawBitmap");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new ODrawBitmapRegister();
@@ -1798,7 +1935,7 @@ map<int, vector<Opcode *> > ScreenSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void SetRenderTarget(bitmap)
     {
-        int id = memberids["SetRenderTarget"];
+        int id = getMemberID("SetRenderTarget");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OSetRenderTargetRegister();
@@ -1814,7 +1951,7 @@ map<int, vector<Opcode *> > ScreenSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void Message(screen, float)
     {
-        int id = memberids["Message"];
+        int id = getMemberID("Message");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OPopRegister(new VarArgument(EXP2));
@@ -1829,7 +1966,7 @@ map<int, vector<Opcode *> > ScreenSymbols::addSymbolsCode(LinkTable &lt)
     }
     //bool isSolid(screen, int, int)
     {
-        int id = memberids["isSolid"];
+        int id = getMemberID("isSolid");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         //pop off the params
@@ -1846,7 +1983,7 @@ map<int, vector<Opcode *> > ScreenSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void SetSideWarp(screen, float, float, float, float)
     {
-        int id = memberids["SetSideWarp"];
+        int id = getMemberID("SetSideWarp");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OSetSideWarpRegister();
@@ -1865,7 +2002,7 @@ map<int, vector<Opcode *> > ScreenSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void SetTileWarp(screen, float, float, float, float)
     {
-        int id = memberids["SetTileWarp"];
+        int id = getMemberID("SetTileWarp");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OSetTileWarpRegister();
@@ -1884,7 +2021,7 @@ map<int, vector<Opcode *> > ScreenSymbols::addSymbolsCode(LinkTable &lt)
     }
     //float LayerScreen(screen, float)
     {
-        int id = memberids["LayerScreen"];
+        int id = getMemberID("LayerScreen");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OPopRegister(new VarArgument(EXP2));
@@ -1899,7 +2036,7 @@ map<int, vector<Opcode *> > ScreenSymbols::addSymbolsCode(LinkTable &lt)
     }
     //float LayerMap(screen, float)
     {
-        int id = memberids["LayerMap"];
+        int id = getMemberID("LayerMap");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OPopRegister(new VarArgument(EXP2));
@@ -1914,7 +2051,7 @@ map<int, vector<Opcode *> > ScreenSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void TriggerSecrets(screen)
     {
-        int id = memberids["TriggerSecrets"];
+        int id = getMemberID("TriggerSecrets");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         //pop pointer, and ignore it
@@ -1928,7 +2065,7 @@ map<int, vector<Opcode *> > ScreenSymbols::addSymbolsCode(LinkTable &lt)
     }
     //int GetSideWarpDMap(screen, int)
     {
-        int id = memberids["GetSideWarpDMap"];
+        int id = getMemberID("GetSideWarpDMap");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OPopRegister(new VarArgument(EXP1));
@@ -1943,7 +2080,7 @@ map<int, vector<Opcode *> > ScreenSymbols::addSymbolsCode(LinkTable &lt)
     }
     //int GetSideWarpScreen(screen, int)
     {
-        int id = memberids["GetSideWarpScreen"];
+        int id = getMemberID("GetSideWarpScreen");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OPopRegister(new VarArgument(EXP1));
@@ -1958,7 +2095,7 @@ map<int, vector<Opcode *> > ScreenSymbols::addSymbolsCode(LinkTable &lt)
     }
     //int GetSideWarpType(screen, int)
     {
-        int id = memberids["GetSideWarpType"];
+        int id = getMemberID("GetSideWarpType");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OPopRegister(new VarArgument(EXP1));
@@ -1973,7 +2110,7 @@ map<int, vector<Opcode *> > ScreenSymbols::addSymbolsCode(LinkTable &lt)
     }
     //int GetTileWarpDMap(screen, int)
     {
-        int id = memberids["GetTileWarpDMap"];
+        int id = getMemberID("GetTileWarpDMap");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OPopRegister(new VarArgument(EXP1));
@@ -1988,7 +2125,7 @@ map<int, vector<Opcode *> > ScreenSymbols::addSymbolsCode(LinkTable &lt)
     }
     //int GetTileWarpScreen(screen, int)
     {
-        int id = memberids["GetTileWarpScreen"];
+        int id = getMemberID("GetTileWarpScreen");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OPopRegister(new VarArgument(EXP1));
@@ -2003,7 +2140,7 @@ map<int, vector<Opcode *> > ScreenSymbols::addSymbolsCode(LinkTable &lt)
     }
     //int GetTileWarpType(screen, int)
     {
-        int id = memberids["GetTileWarpType"];
+        int id = getMemberID("GetTileWarpType");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OPopRegister(new VarArgument(EXP1));
@@ -2016,6 +2153,42 @@ map<int, vector<Opcode *> > ScreenSymbols::addSymbolsCode(LinkTable &lt)
         code.push_back(new OGotoRegister(new VarArgument(EXP2)));
         rval[label]=code;
     }
+    //int NPCsInRadius(screen, float, float, float, float) and the rest; the commands read
+    //the arguments off the stack, and take the sprite list as in ClearSprites()
+    {
+        static const char *const radius[] = { "NPCsInRadius", "ItemsInRadius", "EWeaponsInRadius", "LWeaponsInRadius" };
+        static const char *const rect[] = { "NPCsInRect", "ItemsInRect", "EWeaponsInRect", "LWeaponsInRect" };
+        static const char *const nearest[] = { "NearestNPC", "NearestItem", "NearestEWeapon", "NearestLWeapon" };
+        
+        for(int list = 0; list < 4; list++)
+        {
+            for(int kind = 0; kind < 3; kind++)
+            {
+                int id = getMemberID(kind == 0 ? radius[list] : (kind == 1 ? rect[list] : nearest[list]));
+                int label = lt.functionToLabel(id);
+                vector<Opcode *> code;
+                Opcode *first;
+                int args = kind == 0 ? 4 : (kind == 1 ? 5 : 2);
+                
+                if(kind == 0)
+                    first = new OQueryRadius(new VarArgument(EXP1), new LiteralArgument(list * 10000));
+                else if(kind == 1)
+                    first = new OQueryRect(new VarArgument(EXP1), new LiteralArgument(list * 10000));
+                else
+                    first = new OQueryNearest(new VarArgument(EXP1), new LiteralArgument(list * 10000));
+                    
+                first->setLabel(label);
+                code.push_back(first);
+                POP_ARGS(args, EXP2);
+                //pop pointer, and ignore it
+                code.push_back(new OPopRegister(new VarArgument(NUL)));
+                
+                code.push_back(new OPopRegister(new VarArgument(EXP2)));
+                code.push_back(new OGotoRegister(new VarArgument(EXP2)));
+                rval[label]=code;
+            }
+        }
+    }
     return rval;
 }
 
@@ -2097,7 +2270,7 @@ map<int, vector<Opcode *> > ItemSymbols::addSymbolsCode(LinkTable &lt)
     map<int, vector<Opcode *> > rval = LibrarySymbols::addSymbolsCode(lt);
     //bool isValid(item)
     {
-        int id = memberids["isValid"];
+        int id = getMemberID("isValid");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         //pop off the pointer
@@ -2152,7 +2325,7 @@ map<int, vector<Opcode *> > ItemclassSymbols::addSymbolsCode(LinkTable &lt)
     map<int, vector<Opcode *> > rval = LibrarySymbols::addSymbolsCode(lt);
     //void GetName(itemclass, int)
     {
-        int id = memberids["GetName"];
+        int id = getMemberID("GetName");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         //pop off the param
@@ -2283,7 +2456,7 @@ map<int, vector<Opcode *> > GameSymbols::addSymbolsCode(LinkTable &lt)
     map<int,vector<Opcode *> > rval = LibrarySymbols::addSymbolsCode(lt);
     //itemclass LoadItemData(game, int)
     {
-        int id = memberids["LoadItemData"];
+        int id = getMemberID("LoadItemData");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         //pop off the param
@@ -2300,7 +2473,7 @@ map<int, vector<Opcode *> > GameSymbols::addSymbolsCode(LinkTable &lt)
     }
     //bool GetScreenState(game, int,int,int)
     {
-        int id = memberids["GetScreenState"];
+        int id = getMemberID("GetScreenState");
         int label = lt.functionToLabel(id);
         int done = ScriptParser::getUniqueLabelID();
         vector<Opcode *> code;
@@ -2328,7 +2501,7 @@ map<int, vector<Opcode *> > GameSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void SetScreenState(game, int,int,int,bool)
     {
-        int id = memberids["SetScreenState"];
+        int id = getMemberID("SetScreenState");
         int label = lt.functionToLabel(id);
         int done = ScriptParser::getUniqueLabelID();
         vector<Opcode *> code;
@@ -2356,7 +2529,7 @@ map<int, vector<Opcode *> > GameSymbols::addSymbolsCode(LinkTable &lt)
     }
     //int GetScreenD(game, int,int)
     {
-        int id = memberids["GetScreenD"];
+        int id = getMemberID("GetScreenD");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         //pop off the params
@@ -2373,7 +2546,7 @@ map<int, vector<Opcode *> > GameSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void SetScreenD(game, int,int,int)
     {
-        int id = memberids["SetScreenD"];
+        int id = getMemberID("SetScreenD");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         //pop off the params
@@ -2391,7 +2564,7 @@ map<int, vector<Opcode *> > GameSymbols::addSymbolsCode(LinkTable &lt)
     }
     //int GetDMapScreenD(game, int,int,int)
     {
-        int id = memberids["GetDMapScreenD"];
+        int id = getMemberID("GetDMapScreenD");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         //pop off the params
@@ -2409,7 +2582,7 @@ map<int, vector<Opcode *> > GameSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void SetDMapScreenD(game, int,int,int,int)
     {
-        int id = memberids["SetDMapScreenD"];
+        int id = getMemberID("SetDMapScreenD");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         //pop off the params
@@ -2428,7 +2601,7 @@ map<int, vector<Opcode *> > GameSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void PlaySound(game, int)
     {
-        int id = memberids["PlaySound"];
+        int id = getMemberID("PlaySound");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         //pop off the param
@@ -2444,7 +2617,7 @@ map<int, vector<Opcode *> > GameSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void PlayMIDI(game, int)
     {
-        int id = memberids["PlayMIDI"];
+        int id = getMemberID("PlayMIDI");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         //pop off the param
@@ -2460,7 +2633,7 @@ map<int, vector<Opcode *> > GameSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void PlayEnhancedMusic(game, int, int)
     {
-        int id = memberids["PlayEnhancedMusic"];
+        int id = getMemberID("PlayEnhancedMusic");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         //pop off the params
@@ -2477,7 +2650,7 @@ map<int, vector<Opcode *> > GameSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void GetDMapMusicFilename(game, int, int)
     {
-        int id = memberids["GetDMapMusicFilename"];
+        int id = getMemberID("GetDMapMusicFilename");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         //pop off the params
@@ -2494,7 +2667,7 @@ map<int, vector<Opcode *> > GameSymbols::addSymbolsCode(LinkTable &lt)
     }
     //int GetDMapMusicTrack(game, int)
     {
-        int id = memberids["GetDMapMusicTrack"];
+        int id = getMemberID("GetDMapMusicTrack");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OPopRegister(new VarArgument(EXP1));
@@ -2509,7 +2682,7 @@ map<int, vector<Opcode *> > GameSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void SetDMapEnhancedMusic(game, int,int,int)
     {
-        int id = memberids["SetDMapEnhancedMusic"];
+        int id = getMemberID("SetDMapEnhancedMusic");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OSetDMapEnhancedMusic();
@@ -2527,7 +2700,7 @@ map<int, vector<Opcode *> > GameSymbols::addSymbolsCode(LinkTable &lt)
     }
     //int GetComboData(int,int,int)
     {
-        int id = memberids["GetComboData"];
+        int id = getMemberID("GetComboData");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         //pop off the params
@@ -2545,7 +2718,7 @@ map<int, vector<Opcode *> > GameSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void SetComboData(int,int,int,int)
     {
-        int id = memberids["SetComboData"];
+        int id = getMemberID("SetComboData");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         //pop off the params
@@ -2564,7 +2737,7 @@ map<int, vector<Opcode *> > GameSymbols::addSymbolsCode(LinkTable &lt)
     }
     //int GetComboCSet(int,int,int)
     {
-        int id = memberids["GetComboCSet"];
+        int id = getMemberID("GetComboCSet");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         //pop off the params
@@ -2582,7 +2755,7 @@ map<int, vector<Opcode *> > GameSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void SetComboCSet(int,int,int,int)
     {
-        int id = memberids["SetComboCSet"];
+        int id = getMemberID("SetComboCSet");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         //pop off the params
@@ -2601,7 +2774,7 @@ map<int, vector<Opcode *> > GameSymbols::addSymbolsCode(LinkTable &lt)
     }
     //int GetComboFlag(int,int,int)
     {
-        int id = memberids["GetComboFlag"];
+        int id = getMemberID("GetComboFlag");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         //pop off the params
@@ -2619,7 +2792,7 @@ map<int, vector<Opcode *> > GameSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void SetComboFlag(int,int,int,int)
     {
-        int id = memberids["SetComboFlag"];
+        int id = getMemberID("SetComboFlag");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         //pop off the params
@@ -2638,7 +2811,7 @@ map<int, vector<Opcode *> > GameSymbols::addSymbolsCode(LinkTable &lt)
     }
     //int GetComboType(int,int,int)
     {
-        int id = memberids["GetComboType"];
+        int id = getMemberID("GetComboType");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         //pop off the params
@@ -2656,7 +2829,7 @@ map<int, vector<Opcode *> > GameSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void SetComboType(int,int,int,int)
     {
-        int id = memberids["SetComboType"];
+        int id = getMemberID("SetComboType");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         //pop off the params
@@ -2675,7 +2848,7 @@ map<int, vector<Opcode *> > GameSymbols::addSymbolsCode(LinkTable &lt)
     }
     //int GetComboInherentFlag(int,int,int)
     {
-        int id = memberids["GetComboInherentFlag"];
+        int id = getMemberID("GetComboInherentFlag");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         //pop off the params
@@ -2693,7 +2866,7 @@ map<int, vector<Opcode *> > GameSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void SetComboInherentFlag(int,int,int,int)
     {
-        int id = memberids["SetComboInherentFlag"];
+        int id = getMemberID("SetComboInherentFlag");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         //pop off the params
@@ -2712,7 +2885,7 @@ map<int, vector<Opcode *> > GameSymbols::addSymbolsCode(LinkTable &lt)
     }
     //int GetComboCollision(int,int,int)
     {
-        int id = memberids["GetComboSolid"];
+        int id = getMemberID("GetComboSolid");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         //pop off the params
@@ -2730,7 +2903,7 @@ map<int, vector<Opcode *> > GameSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void SetComboCollision(int,int,int,int)
     {
-        int id = memberids["SetComboSolid"];
+        int id = getMemberID("SetComboSolid");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         //pop off the params
@@ -2749,7 +2922,7 @@ map<int, vector<Opcode *> > GameSymbols::addSymbolsCode(LinkTable &lt)
     }
     //int GetScreenFlags(game,int,int,int)
     {
-        int id = memberids["GetScreenFlags"];
+        int id = getMemberID("GetScreenFlags");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         //pop off the params
@@ -2767,7 +2940,7 @@ map<int, vector<Opcode *> > GameSymbols::addSymbolsCode(LinkTable &lt)
     }
     //int GetScreenEFlags(game,int,int,int)
     {
-        int id = memberids["GetScreenEFlags"];
+        int id = getMemberID("GetScreenEFlags");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         //pop off the params
@@ -2785,7 +2958,7 @@ map<int, vector<Opcode *> > GameSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void Save(game)
     {
-        int id = memberids["Save"];
+        int id = getMemberID("Save");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         //pop pointer, and ignore it
@@ -2799,7 +2972,7 @@ map<int, vector<Opcode *> > GameSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void End(game)
     {
-        int id = memberids["End"];
+        int id = getMemberID("End");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         //pop pointer, and ignore it
@@ -2813,7 +2986,7 @@ map<int, vector<Opcode *> > GameSymbols::addSymbolsCode(LinkTable &lt)
     }
     //int ComboTile(game,int)
     {
-        int id = memberids["ComboTile"];
+        int id = getMemberID("ComboTile");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         Opcode *first = new OPopRegister(new VarArgument(EXP2));
@@ -2828,7 +3001,7 @@ map<int, vector<Opcode *> > GameSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void GetSaveName(game, int)
     {
-        int id = memberids["GetSaveName"];
+        int id = getMemberID("GetSaveName");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         //pop off the param
@@ -2844,7 +3017,7 @@ map<int, vector<Opcode *> > GameSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void GetSaveName(game, int)
     {
-        int id = memberids["SetSaveName"];
+        int id = getMemberID("SetSaveName");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         //pop off the param
@@ -2860,7 +3033,7 @@ map<int, vector<Opcode *> > GameSymbols::addSymbolsCode(LinkTable &lt)
     }
     //GetMessage(game, int, int)
     {
-        int id = memberids["GetMessage"];
+        int id = getMemberID("GetMessage");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         //pop off the params
@@ -2877,7 +3050,7 @@ map<int, vector<Opcode *> > GameSymbols::addSymbolsCode(LinkTable &lt)
     }
     //GetDMapName(game, int, int)
     {
-        int id = memberids["GetDMapName"];
+        int id = getMemberID("GetDMapName");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         //pop off the params
@@ -2894,7 +3067,7 @@ map<int, vector<Opcode *> > GameSymbols::addSymbolsCode(LinkTable &lt)
     }
     //GetDMapTitle(game, int, int)
     {
-        int id = memberids["GetDMapTitle"];
+        int id = getMemberID("GetDMapTitle");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         //pop off the params
@@ -2911,7 +3084,7 @@ map<int, vector<Opcode *> > GameSymbols::addSymbolsCode(LinkTable &lt)
     }
     //GetDMapIntro(game, int, int)
     {
-        int id = memberids["GetDMapIntro"];
+        int id = getMemberID("GetDMapIntro");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         //pop off the params
@@ -2929,7 +3102,7 @@ map<int, vector<Opcode *> > GameSymbols::addSymbolsCode(LinkTable &lt)
     
     //bool ShowSaveScreen(game)
     {
-        int id = memberids["ShowSaveScreen"];
+        int id = getMemberID("ShowSaveScreen");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         //pop pointer, and ignore it
@@ -2944,7 +3117,7 @@ map<int, vector<Opcode *> > GameSymbols::addSymbolsCode(LinkTable &lt)
     
     //void ShowSaveQuitScreen(game)
     {
-        int id = memberids["ShowSaveQuitScreen"];
+        int id = getMemberID("ShowSaveQuitScreen");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         //pop pointer, and ignore it
@@ -2959,7 +3132,7 @@ map<int, vector<Opcode *> > GameSymbols::addSymbolsCode(LinkTable &lt)
     
     //int GetFFCScript(game, int)
     {
-        int id = memberids["GetFFCScript"];
+        int id = getMemberID("GetFFCScript");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         //pop off the param
@@ -3080,7 +3253,7 @@ map<int, vector<Opcode *> > NPCSymbols::addSymbolsCode(LinkTable &lt)
     map<int, vector<Opcode *> > rval = LibrarySymbols::addSymbolsCode(lt);
     //bool isValid(npc)
     {
-        int id = memberids["isValid"];
+        int id = getMemberID("isValid");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         //pop off the pointer
@@ -3095,7 +3268,7 @@ map<int, vector<Opcode *> > NPCSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void GetName(npc, int)
     {
-        int id = memberids["GetName"];
+        int id = getMemberID("GetName");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         //pop off the param
@@ -3111,7 +3284,7 @@ map<int, vector<Opcode *> > NPCSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void BreakShield(npc)
     {
-        int id = memberids["BreakShield"];
+        int id = getMemberID("BreakShield");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         //pop off the pointer
@@ -3221,7 +3394,7 @@ map<int, vector<Opcode *> > LinkWeaponSymbols::addSymbolsCode(LinkTable &lt)
     int id=-1;
     //bool isValid(lweapon)
     {
-        id = memberids["isValid"];
+        id = getMemberID("isValid");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         //pop off the pointer
@@ -3236,7 +3409,7 @@ map<int, vector<Opcode *> > LinkWeaponSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void UseSprite(lweapon, int val)
     {
-        id = memberids["UseSprite"];
+        id = getMemberID("UseSprite");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         //pop off the val
@@ -3348,7 +3521,7 @@ map<int, vector<Opcode *> > EnemyWeaponSymbols::addSymbolsCode(LinkTable &lt)
     int id=-1;
     //bool isValid(eweapon)
     {
-        id = memberids["isValid"];
+        id = getMemberID("isValid");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         //pop off the pointer
@@ -3363,7 +3536,7 @@ map<int, vector<Opcode *> > EnemyWeaponSymbols::addSymbolsCode(LinkTable &lt)
     }
     //void UseSprite(eweapon, int val)
     {
-        id = memberids["UseSprite"];
+        id = getMemberID("UseSprite");
         int label = lt.functionToLabel(id);
         vector<Opcode *> code;
         //pop off the val
@@ -19,7 +19,7 @@ static const int FUNCTION = 2;
 
 struct AccessorTable
 {
-    string name;
+    const char *name;
     int rettype;
     int setorget;
     int var;
@@ -27,19 +27,44 @@ struct AccessorTable
     int params[20];
 };
 
+//Finds a name's row in an AccessorTable with one probe. The hash is worked out from the table
+//the first time it's used, and is perfect: no two rows share a slot.
+class AccessorIndex
+{
+public:
+    AccessorIndex() : table(NULL) {}
+    void build(AccessorTable *t);
+    bool isBuilt()
+    {
+        return table != NULL;
+    }
+    //The row with this name, or -1
+    int find(const char *name);
+private:
+    AccessorTable *table;
+    vector<unsigned int> displacements;
+    vector<int> rows;
+};
+
 class LibrarySymbols
 {
 public:
     virtual void addSymbolsToScope(Scope *scope, SymbolTable *t);
     virtual map<int, vector<Opcode *> > addSymbolsCode(LinkTable &lt);
-    virtual pair<int, vector<int> > matchFunction(string name, SymbolTable *t);
+    virtual pair<int, vector<int> > matchFunction(const string &name, SymbolTable *t);
     virtual ~LibrarySymbols();
 protected:
     AccessorTable *table;
     LibrarySymbols() {}
     int firstid;
     int refVar;
-    map<string, int> memberids;
+    AccessorIndex index;
+    //The function ID given to a row of the table in the current compile
+    int getMemberID(const char *name)
+    {
+        int row = index.find(name);
+        return row == -1 ? -1 : firstid + row;
+    }
     virtual vector<Opcode *> getVariable(LinkTable &lt, int id, int var);
     virtual vector<Opcode *> setVariable(LinkTable &lt, int id, int var);
     virtual vector<Opcode *> setBoolVariable(LinkTable &lt, int id, int var);
@@ -0,0 +1,1492 @@
+
+//The optimization pass, run on each function's object code between generateOCode() and
+//assemble(). BuildOpcodes evaluates every expression through the stack and EXP1/EXP2, and
+//turns every comparison into a chain of SETs and COMPAREs, so there's a lot to take out:
+//
+// - constants and copies are propagated through each block, and arithmetic, comparisons and
+//   branches on known values are folded
+// - a PUSHR and the POP matching it in the same block become a SETR, or nothing
+// - a comparison followed by SETs and COMPAREVs against 0 and then a branch or a SET is
+//   cut down to the comparison and one branch or SET
+// - instructions whose results are never used are removed
+// - jumps to jumps go straight to the end, jumps to the next instruction are removed, and
+//   so is code that can't be reached
+//
+//Only d0-d7 and the comparison flag are tracked. Anything else (the stack, globals, and the
+//registers that read d0-d2 as indices) is left alone, and instructions not listed here are
+//assumed to use and change everything. Functions no script calls are skipped, since
+//assemble() leaves them out anyway, and so is the code in ~Init.
+
+#include "../precompiled.h" //always first
+
+#include "BuildVisitors.h"
+#include "DataStructs.h"
+#include <set>
+
+using std::set;
+
+namespace
+{
+
+enum
+{
+    OP_OTHER, OP_SETV, OP_SETR, OP_ADDV, OP_ADDR, OP_SUBV, OP_SUBR, OP_MULTV, OP_MULTR, OP_DIVV, OP_DIVR,
+    OP_COMPAREV, OP_COMPARER, OP_SETTRUE, OP_SETFALSE, OP_SETMORE, OP_SETLESS,
+    OP_GOTO, OP_GOTOTRUE, OP_GOTOFALSE, OP_GOTOMORE, OP_GOTOLESS, OP_GOTOR, OP_QUIT,
+    OP_PUSHR, OP_POP, OP_LOADI, OP_STOREI
+};
+
+const struct
+{
+    const char *name;
+    int op;
+} mnemonics[] =
+{
+    { "SETV", OP_SETV }, { "SETR", OP_SETR }, { "ADDV", OP_ADDV }, { "ADDR", OP_ADDR },
+    { "SUBV", OP_SUBV }, { "SUBR", OP_SUBR }, { "MULTV", OP_MULTV }, { "MULTR", OP_MULTR },
+    { "DIVV", OP_DIVV }, { "DIVR", OP_DIVR }, { "COMPAREV", OP_COMPAREV }, { "COMPARER", OP_COMPARER },
+    { "SETTRUE", OP_SETTRUE }, { "SETFALSE", OP_SETFALSE }, { "SETMORE", OP_SETMORE }, { "SETLESS", OP_SETLESS },
+    { "GOTO", OP_GOTO }, { "GOTOTRUE", OP_GOTOTRUE }, { "GOTOFALSE", OP_GOTOFALSE }, { "GOTOMORE", OP_GOTOMORE },
+    { "GOTOLESS", OP_GOTOLESS }, { "GOTOR", OP_GOTOR }, { "QUIT", OP_QUIT },
+    { "PUSHR", OP_PUSHR }, { "POP", OP_POP }, { "LOADI", OP_LOADI }, { "STOREI", OP_STOREI },
+    { NULL, OP_OTHER }
+};
+
+//Registers d0-d7 are bits 0-7 of a use or def mask, and the flag is bit 8
+const int REGS = 0xFF;
+const int FLAG = 0x100;
+const int EVERYTHING = REGS | FLAG;
+
+//The largest value ffparse() reads back correctly, 214747.9999
+const long long MAX_LITERAL = 2147479999LL;
+
+//The states a COMPARE can leave the flag in, and the conditions on them as sets of states
+enum { EQUAL = 1, GREATER = 2, LESS = 4 };
+enum { COND_NEVER = 0, COND_TRUE = EQUAL, COND_FALSE = GREATER | LESS, COND_MORE = EQUAL | GREATER,
+       COND_LESS = EQUAL | LESS, COND_ALWAYS = EQUAL | GREATER | LESS
+     };
+
+struct Operand
+{
+    enum { NONE, REG, VAR, GLOBAL, LITERAL, LABEL };
+    
+    int type;
+    long value;
+    
+    Operand() : type(NONE), value(0) {}
+    Operand(int t, long v) : type(t), value(v) {}
+    
+    bool operator==(const Operand &other) const
+    {
+        return type == other.type && value == other.value;
+    }
+};
+
+struct Instr
+{
+    int op;
+    Operand a, b;
+    int label;
+    //The opcode this came from, until it's changed
+    Opcode *code;
+    bool deleted;
+};
+
+class GetOperands : public ArgumentVisitor
+{
+public:
+    void caseLiteral(LiteralArgument &host, void *param)
+    {
+        ((vector<Operand> *)param)->push_back(Operand(Operand::LITERAL, host.getValue()));
+    }
+    void caseVar(VarArgument &host, void *param)
+    {
+        int type = (host.getID() >= 0 && host.getID() < 8) ? Operand::REG : Operand::VAR;
+        ((vector<Operand> *)param)->push_back(Operand(type, host.getID()));
+    }
+    void caseGlobal(GlobalArgument &host, void *param)
+    {
+        ((vector<Operand> *)param)->push_back(Operand(Operand::GLOBAL, host.getID()));
+    }
+    void caseLabel(LabelArgument &host, void *param)
+    {
+        ((vector<Operand> *)param)->push_back(Operand(Operand::LABEL, host.getID()));
+    }
+};
+
+bool isRegister(const Operand &o)
+{
+    return o.type == Operand::REG;
+}
+
+bool isLiteral(const Operand &o)
+{
+    return o.type == Operand::LITERAL;
+}
+
+bool isJump(int op)
+{
+    return op >= OP_GOTO && op <= OP_GOTOLESS;
+}
+
+bool endsBlock(int op)
+{
+    return isJump(op) || op == OP_GOTOR || op == OP_QUIT;
+}
+
+// Whether the operands are the kinds the instruction is optimized with
+bool wellFormed(const Instr &in)
+{
+    const Operand &a = in.a, &b = in.b;
+    bool aVar = a.type == Operand::REG || a.type == Operand::VAR || a.type == Operand::GLOBAL;
+    bool bVar = b.type == Operand::REG || b.type == Operand::VAR || b.type == Operand::GLOBAL;
+    
+    switch(in.op)
+    {
+    case OP_SETV:
+        return aVar && (isLiteral(b) || b.type == Operand::LABEL);
+    
+    case OP_SETR:
+        return aVar && bVar;
+    
+    case OP_ADDV:
+    case OP_SUBV:
+    case OP_MULTV:
+    case OP_DIVV:
+    case OP_COMPAREV:
+        return isRegister(a) && isLiteral(b);
+    
+    case OP_ADDR:
+    case OP_SUBR:
+    case OP_MULTR:
+    case OP_DIVR:
+    case OP_COMPARER:
+    case OP_LOADI:
+    case OP_STOREI:
+        return isRegister(a) && isRegister(b);
+    
+    case OP_SETTRUE:
+    case OP_SETFALSE:
+    case OP_SETMORE:
+    case OP_SETLESS:
+    case OP_GOTOR:
+    case OP_PUSHR:
+    case OP_POP:
+        return isRegister(a);
+    
+    case OP_GOTO:
+    case OP_GOTOTRUE:
+    case OP_GOTOFALSE:
+    case OP_GOTOMORE:
+    case OP_GOTOLESS:
+        return a.type == Operand::LABEL;
+    }
+    
+    return true;
+}
+
+Instr decode(Opcode *code)
+{
+    Instr in;
+    in.code = code;
+    in.label = code->getLabel();
+    in.deleted = false;
+    in.op = OP_OTHER;
+    
+    string text = code->toString();
+    string name = text.substr(0, text.find(' '));
+    
+    for(int i = 0; mnemonics[i].name; i++)
+    {
+        if(name == mnemonics[i].name)
+        {
+            in.op = mnemonics[i].op;
+            break;
+        }
+    }
+    
+    vector<Operand> operands;
+    GetOperands temp;
+    code->execute(temp, &operands);
+    
+    if(operands.size() > 0)
+        in.a = operands[0];
+    
+    if(operands.size() > 1)
+        in.b = operands[1];
+    
+    if(!wellFormed(in))
+        in.op = OP_OTHER;
+    
+    return in;
+}
+
+Argument *argument(const Operand &o)
+{
+    switch(o.type)
+    {
+    case Operand::LITERAL:
+        return new LiteralArgument(o.value);
+    
+    case Operand::GLOBAL:
+        return new GlobalArgument(o.value);
+    
+    case Operand::LABEL:
+        return new LabelArgument(o.value);
+    }
+    
+    return new VarArgument(o.value);
+}
+
+Opcode *encode(const Instr &in)
+{
+    Opcode *rval = NULL;
+    
+    switch(in.op)
+    {
+    case OP_SETV:
+        rval = new OSetImmediate(argument(in.a), argument(in.b));
+        break;
+    
+    case OP_SETR:
+        rval = new OSetRegister(argument(in.a), argument(in.b));
+        break;
+    
+    case OP_ADDV:
+        rval = new OAddImmediate(argument(in.a), argument(in.b));
+        break;
+    
+    case OP_ADDR:
+        rval = new OAddRegister(argument(in.a), argument(in.b));
+        break;
+    
+    case OP_SUBV:
+        rval = new OSubImmediate(argument(in.a), argument(in.b));
+        break;
+    
+    case OP_SUBR:
+        rval = new OSubRegister(argument(in.a), argument(in.b));
+        break;
+    
+    case OP_MULTV:
+        rval = new OMultImmediate(argument(in.a), argument(in.b));
+        break;
+    
+    case OP_MULTR:
+        rval = new OMultRegister(argument(in.a), argument(in.b));
+        break;
+    
+    case OP_DIVV:
+        rval = new ODivImmediate(argument(in.a), argument(in.b));
+        break;
+    
+    case OP_DIVR:
+        rval = new ODivRegister(argument(in.a), argument(in.b));
+        break;
+    
+    case OP_COMPAREV:
+        rval = new OCompareImmediate(argument(in.a), argument(in.b));
+        break;
+    
+    case OP_COMPARER:
+        rval = new OCompareRegister(argument(in.a), argument(in.b));
+        break;
+    
+    case OP_SETTRUE:
+        rval = new OSetTrue(argument(in.a));
+        break;
+    
+    case OP_SETFALSE:
+        rval = new OSetFalse(argument(in.a));
+        break;
+    
+    case OP_SETMORE:
+        rval = new OSetMore(argument(in.a));
+        break;
+    
+    case OP_SETLESS:
+        rval = new OSetLess(argument(in.a));
+        break;
+    
+    case OP_GOTO:
+        rval = new OGotoImmediate(argument(in.a));
+        break;
+    
+    case OP_GOTOTRUE:
+        rval = new OGotoTrueImmediate(argument(in.a));
+        break;
+    
+    case OP_GOTOFALSE:
+        rval = new OGotoFalseImmediate(argument(in.a));
+        break;
+    
+    case OP_GOTOMORE:
+        rval = new OGotoMoreImmediate(argument(in.a));
+        break;
+    
+    case OP_GOTOLESS:
+        rval = new OGotoLessImmediate(argument(in.a));
+        break;
+    
+    case OP_GOTOR:
+        rval = new OGotoRegister(argument(in.a));
+        break;
+    
+    case OP_QUIT:
+        rval = new OQuit();
+        break;
+    
+    case OP_PUSHR:
+        rval = new OPushRegister(argument(in.a));
+        break;
+    
+    case OP_POP:
+        rval = new OPopRegister(argument(in.a));
+        break;
+    
+    case OP_LOADI:
+        rval = new OLoadIndirect(argument(in.a), argument(in.b));
+        break;
+    
+    case OP_STOREI:
+        rval = new OStoreIndirect(argument(in.a), argument(in.b));
+        break;
+    }
+    
+    return rval;
+}
+
+int bit(const Operand &o)
+{
+    return isRegister(o) ? 1 << o.value : 0;
+}
+
+// What an instruction reads and writes, and whether it can be removed when nothing it writes is
+// used. Reading or writing a register other than d0-d7 may read d0-d2 as indices.
+void effects(const Instr &in, int &use, int &def, bool &removable)
+{
+    use = def = 0;
+    removable = false;
+    
+    switch(in.op)
+    {
+    case OP_SETV:
+    case OP_SETR:
+        if(isRegister(in.a) && (in.op == OP_SETV || isRegister(in.b)))
+        {
+            def = bit(in.a);
+            use = bit(in.b);
+            removable = true;
+        }
+        //Reading SP doesn't depend on anything
+        else if(in.op == OP_SETR && isRegister(in.a) && in.b == Operand(Operand::VAR, SP))
+        {
+            def = bit(in.a);
+            removable = true;
+        }
+        else
+        {
+            def = bit(in.a);
+            use = REGS;
+        }
+        
+        break;
+    
+    case OP_ADDV:
+    case OP_SUBV:
+    case OP_MULTV:
+        def = use = bit(in.a);
+        removable = true;
+        break;
+    
+    //Dividing by 0 writes to the log
+    case OP_DIVV:
+        def = use = bit(in.a);
+        removable = in.b.value != 0;
+        break;
+    
+    case OP_ADDR:
+    case OP_SUBR:
+    case OP_MULTR:
+        def = bit(in.a);
+        use = bit(in.a) | bit(in.b);
+        removable = true;
+        break;
+    
+    case OP_DIVR:
+        def = bit(in.a);
+        use = bit(in.a) | bit(in.b);
+        break;
+    
+    case OP_COMPAREV:
+    case OP_COMPARER:
+        def = FLAG;
+        use = bit(in.a) | bit(in.b);
+        removable = true;
+        break;
+    
+    case OP_SETTRUE:
+    case OP_SETFALSE:
+    case OP_SETMORE:
+    case OP_SETLESS:
+        def = bit(in.a);
+        use = FLAG;
+        removable = true;
+        break;
+    
+    case OP_GOTO:
+        break;
+    
+    case OP_GOTOTRUE:
+    case OP_GOTOFALSE:
+    case OP_GOTOMORE:
+    case OP_GOTOLESS:
+        use = FLAG;
+        break;
+    
+    case OP_PUSHR:
+        use = bit(in.a);
+        break;
+    
+    case OP_POP:
+        def = bit(in.a);
+        break;
+    
+    case OP_LOADI:
+        def = bit(in.a);
+        use = bit(in.b);
+        break;
+    
+    case OP_STOREI:
+        use = bit(in.a) | bit(in.b);
+        break;
+    
+    //The flag is always set again before it's read in a function or after a return
+    case OP_GOTOR:
+        use = REGS;
+        break;
+    
+    case OP_QUIT:
+        break;
+    
+    default:
+        use = def = EVERYTHING;
+    }
+}
+
+// Whether the instruction can read or move the stack; LOADI and STOREI only reach the
+// variables in the stack frame, which are above anything pushed in the middle of a block.
+bool touchesStack(const Instr &in)
+{
+    if(in.op == OP_PUSHR || in.op == OP_POP || in.op == OP_OTHER || endsBlock(in.op))
+        return true;
+    
+    return (in.a.type == Operand::VAR && in.a.value == SP) || (in.b.type == Operand::VAR && in.b.value == SP);
+}
+
+// The states of the flag in which each instruction that reads it is true
+int condition(int op)
+{
+    switch(op)
+    {
+    case OP_SETTRUE:
+    case OP_GOTOTRUE:
+        return COND_TRUE;
+    
+    case OP_SETFALSE:
+    case OP_GOTOFALSE:
+        return COND_FALSE;
+    
+    case OP_SETMORE:
+    case OP_GOTOMORE:
+        return COND_MORE;
+    
+    case OP_SETLESS:
+        return COND_LESS;
+    }
+    
+    return -1;
+}
+
+// Swaps GREATER and LESS, for a COMPARER with its operands the other way round
+int mirror(int cond)
+{
+    return (cond & EQUAL) | ((cond & GREATER) ? LESS : 0) | ((cond & LESS) ? GREATER : 0);
+}
+
+// GOTOLESS depends on a quest rule, so it's never made
+int setFor(int cond)
+{
+    switch(cond)
+    {
+    case COND_TRUE:
+        return OP_SETTRUE;
+    
+    case COND_FALSE:
+        return OP_SETFALSE;
+    
+    case COND_MORE:
+        return OP_SETMORE;
+    
+    case COND_LESS:
+        return OP_SETLESS;
+    }
+    
+    return -1;
+}
+
+int gotoFor(int cond)
+{
+    switch(cond)
+    {
+    case COND_TRUE:
+        return OP_GOTOTRUE;
+    
+    case COND_FALSE:
+        return OP_GOTOFALSE;
+    
+    case COND_MORE:
+        return OP_GOTOMORE;
+    }
+    
+    return -1;
+}
+
+int flagState(long long lhs, long long rhs)
+{
+    return lhs == rhs ? EQUAL : (lhs > rhs ? GREATER : LESS);
+}
+
+// Follows chains of renamings to the end
+void resolveAliases(map<int, int> &aliases)
+{
+    for(map<int, int>::iterator it = aliases.begin(); it != aliases.end(); it++)
+    {
+        int label = it->second;
+        
+        for(map<int, int>::iterator next = aliases.find(label); next != aliases.end(); next = aliases.find(label))
+            label = next->second;
+        
+        it->second = label;
+    }
+}
+
+class FunctionOptimizer
+{
+public:
+    FunctionOptimizer(vector<Opcode *> &opcodes, const set<int> &pinnedLabels, map<int, int> &labelAliases) :
+        source(opcodes), pinned(pinnedLabels), aliases(labelAliases)
+    {
+        for(vector<Opcode *>::iterator it = opcodes.begin(); it != opcodes.end(); it++)
+            code.push_back(decode(*it));
+        
+        compact();
+    }
+    
+    void run()
+    {
+        for(int pass = 0; pass < 16; pass++)
+        {
+            bool changed = propagate();
+            changed |= pairPushes();
+            compact();
+            computeLiveness();
+            changed |= simplifyConditions();
+            compact();
+            computeLiveness();
+            changed |= removeDeadCode();
+            compact();
+            changed |= threadJumps();
+            compact();
+            changed |= removeUnreachable();
+            compact();
+            
+            if(!changed)
+                break;
+        }
+        
+        source.clear();
+        
+        for(vector<Instr>::iterator it = code.begin(); it != code.end(); it++)
+        {
+            if(!it->code)
+                it->code = encode(*it);
+            
+            it->code->setLabel(it->label);
+            source.push_back(it->code);
+        }
+    }
+
+private:
+    vector<Opcode *> &source;
+    //labels other functions refer to, which are shared, and labels this one moved them to
+    const set<int> &pinned;
+    set<int> morePinned;
+    map<int, int> &aliases;
+    vector<Instr> code;
+    map<int, int> labels;
+    vector<int> liveAfter;
+    
+    bool isPinned(int label)
+    {
+        return pinned.find(label) != pinned.end() || morePinned.find(label) != morePinned.end();
+    }
+    
+    //The operands are copied, since they're often the instruction's own
+    void change(Instr &in, int op, Operand a, Operand b)
+    {
+        delete in.code;
+        in.code = NULL;
+        in.op = op;
+        in.a = a;
+        in.b = b;
+    }
+    
+    void change(Instr &in, int op, Operand a)
+    {
+        change(in, op, a, Operand());
+    }
+    
+    void remove(Instr &in)
+    {
+        in.deleted = true;
+    }
+    
+    // Takes out the deleted instructions, moving their labels on to the next one. If that one
+    // has its own label, it becomes another name for the earlier label, so the first instruction
+    // of a function keeps the label the function is known by.
+    void compact()
+    {
+        map<int, int> renamed;
+        
+        for(size_t i = code.size(); i-- > 0;)
+        {
+            if(!code[i].deleted || code[i].label == -1)
+                continue;
+            
+            size_t j = i + 1;
+            
+            while(j < code.size() && code[j].deleted)
+                j++;
+            
+            //Nowhere to move the label to, so it stays
+            if(j == code.size())
+            {
+                code[i].deleted = false;
+                continue;
+            }
+            
+            if(code[j].label != -1)
+                renamed[code[j].label] = code[i].label;
+            
+            code[j].label = code[i].label;
+            code[i].label = -1;
+        }
+        
+        vector<Instr> kept;
+        
+        for(vector<Instr>::iterator it = code.begin(); it != code.end(); it++)
+        {
+            if(it->deleted)
+                delete it->code;
+            else
+                kept.push_back(*it);
+        }
+        
+        code.swap(kept);
+        labels.clear();
+        
+        for(size_t i = 0; i < code.size(); i++)
+        {
+            if(code[i].label != -1)
+                labels[code[i].label] = int(i);
+        }
+        
+        if(renamed.empty())
+            return;
+        
+        resolveAliases(renamed);
+        
+        for(map<int, int>::iterator it = renamed.begin(); it != renamed.end(); it++)
+        {
+            aliases[it->first] = it->second;
+            
+            if(isPinned(it->first))
+                morePinned.insert(it->second);
+        }
+        
+        for(vector<Instr>::iterator it = code.begin(); it != code.end(); it++)
+        {
+            bool uses = false;
+            
+            if(it->a.type == Operand::LABEL && renamed.find(it->a.value) != renamed.end())
+            {
+                it->a.value = renamed[it->a.value];
+                uses = true;
+            }
+            
+            if(it->b.type == Operand::LABEL && renamed.find(it->b.value) != renamed.end())
+            {
+                it->b.value = renamed[it->b.value];
+                uses = true;
+            }
+            
+            if(uses && it->code)
+            {
+                RenameLabels temp;
+                it->code->execute(temp, &renamed);
+            }
+        }
+    }
+    
+    // The instruction with the given label, or -1 if it's in another function
+    int find(int label)
+    {
+        map<int, int>::iterator it = labels.find(label);
+        return it == labels.end() ? -1 : it->second;
+    }
+    
+    // Where code[i] can go next, and whether it can leave the function; returns how many
+    // places there are
+    int successors(size_t i, int succ[2], bool &exits)
+    {
+        const Instr &in = code[i];
+        int count = 0;
+        exits = false;
+        
+        if(in.op == OP_QUIT)
+            return 0;
+        
+        if(in.op == OP_GOTOR)
+        {
+            exits = true;
+            return 0;
+        }
+        
+        if(in.op != OP_GOTO)
+        {
+            if(i + 1 < code.size())
+                succ[count++] = int(i + 1);
+            else
+                exits = true;
+        }
+        
+        if(isJump(in.op))
+        {
+            int target = find(in.a.value);
+            
+            if(target >= 0)
+                succ[count++] = target;
+            else
+                exits = true;
+        }
+        
+        return count;
+    }
+    
+    // Fills in liveAfter. Every register is live wherever the code leaves the function.
+    void computeLiveness()
+    {
+        size_t n = code.size();
+        vector<int> liveBefore(n, 0), use(n), def(n), succ(2 * n), count(n);
+        vector<bool> exits(n);
+        liveAfter.assign(n, 0);
+        
+        for(size_t i = 0; i < n; i++)
+        {
+            bool e, removable;
+            count[i] = successors(i, &succ[2 * i], e);
+            exits[i] = e;
+            effects(code[i], use[i], def[i], removable);
+        }
+        
+        bool changed = true;
+        
+        while(changed)
+        {
+            changed = false;
+            
+            for(size_t k = n; k-- > 0;)
+            {
+                int after = exits[k] ? REGS : 0;
+                
+                for(int s = 0; s < count[k]; s++)
+                    after |= liveBefore[succ[2 * k + s]];
+                
+                int before = use[k] | (after & ~def[k]);
+                
+                if(after != liveAfter[k] || before != liveBefore[k])
+                {
+                    liveAfter[k] = after;
+                    liveBefore[k] = before;
+                    changed = true;
+                }
+            }
+        }
+    }
+    
+    // Constant and copy propagation within each block
+    bool propagate()
+    {
+        bool changed = false;
+        bool known[8];
+        long value[8];
+        int copyOf[8];
+        bool flagKnown = false;
+        int flag = 0;
+        
+        for(int r = 0; r < 8; r++)
+        {
+            known[r] = false;
+            copyOf[r] = -1;
+        }
+        
+        for(size_t i = 0; i < code.size(); i++)
+        {
+            Instr &in = code[i];
+            
+            if(in.label != -1)
+            {
+                for(int r = 0; r < 8; r++)
+                {
+                    known[r] = false;
+                    copyOf[r] = -1;
+                }
+                
+                flagKnown = false;
+            }
+            
+            //Replace registers that are only read with what's known about them
+            Operand *read = NULL;
+            
+            switch(in.op)
+            {
+            case OP_SETR:
+            case OP_ADDR:
+            case OP_SUBR:
+            case OP_MULTR:
+            case OP_DIVR:
+            case OP_COMPARER:
+            case OP_LOADI:
+                read = &in.b;
+                break;
+            
+            case OP_PUSHR:
+                read = &in.a;
+                break;
+            }
+            
+            if(read && isRegister(*read))
+            {
+                int r = read->value;
+                static const int immediate[][2] =
+                {
+                    { OP_SETR, OP_SETV }, { OP_ADDR, OP_ADDV }, { OP_SUBR, OP_SUBV }, { OP_MULTR, OP_MULTV },
+                    { OP_DIVR, OP_DIVV }, { OP_COMPARER, OP_COMPAREV }, { -1, -1 }
+                };
+                int op = -1;
+                
+                for(int k = 0; known[r] && immediate[k][0] != -1; k++)
+                {
+                    if(immediate[k][0] == in.op)
+                        op = immediate[k][1];
+                }
+                
+                if(op != -1)
+                {
+                    change(in, op, in.a, Operand(Operand::LITERAL, value[r]));
+                    changed = true;
+                }
+                else if(copyOf[r] != -1)
+                {
+                    Operand a = in.a, b = in.b;
+                    (read == &in.a ? a : b).value = copyOf[r];
+                    change(in, in.op, a, b);
+                    changed = true;
+                }
+            }
+            
+            //These read their first operand too
+            if(in.op == OP_STOREI || in.op == OP_COMPAREV || in.op == OP_COMPARER)
+            {
+                Operand a = in.a, b = in.b;
+                
+                if(copyOf[a.value] != -1)
+                    a.value = copyOf[a.value];
+                
+                if(in.op == OP_STOREI && copyOf[b.value] != -1)
+                    b.value = copyOf[b.value];
+                
+                if(!(a == in.a && b == in.b))
+                {
+                    change(in, in.op, a, b);
+                    changed = true;
+                }
+            }
+            
+            changed |= fold(in, known, value, flagKnown, flag);
+            
+            //Forget what's no longer true
+            int use, def;
+            bool removable;
+            effects(in, use, def, removable);
+            
+            if(in.deleted)
+                def = 0;
+            
+            for(int r = 0; r < 8; r++)
+            {
+                if(def & (1 << r))
+                {
+                    for(int s = 0; s < 8; s++)
+                    {
+                        if(copyOf[s] == r)
+                            copyOf[s] = -1;
+                    }
+                }
+            }
+            
+            if(!in.deleted)
+                record(in, def, known, value, copyOf, flagKnown, flag);
+            
+            if(endsBlock(in.op) && !in.deleted)
+            {
+                for(int r = 0; r < 8; r++)
+                {
+                    known[r] = false;
+                    copyOf[r] = -1;
+                }
+                
+                flagKnown = false;
+            }
+        }
+        
+        return changed;
+    }
+    
+    // Works out an instruction whose operands are known; returns whether it changed anything
+    bool fold(Instr &in, bool *known, long *value, bool flagKnown, int flag)
+    {
+        if(in.deleted)
+            return false;
+        
+        int r = isRegister(in.a) ? in.a.value : -1;
+        long long result = 0;
+        bool folded = false;
+        
+        switch(in.op)
+        {
+        case OP_SETR:
+            if(r != -1 && in.a == in.b)
+            {
+                remove(in);
+                return true;
+            }
+            
+            return false;
+        
+        case OP_ADDV:
+        case OP_SUBV:
+        case OP_MULTV:
+        case OP_DIVV:
+        {
+            long v = in.b.value;
+            
+            //Adding 0 or multiplying by 1
+            if(((in.op == OP_ADDV || in.op == OP_SUBV) && v == 0) || ((in.op == OP_MULTV || in.op == OP_DIVV) && v == 10000))
+            {
+                remove(in);
+                return true;
+            }
+            
+            if(!known[r] || (in.op == OP_DIVV && v == 0))
+                return false;
+            
+            if(in.op == OP_ADDV)
+                result = (long long)value[r] + v;
+            else if(in.op == OP_SUBV)
+                result = (long long)value[r] - v;
+            else if(in.op == OP_MULTV)
+                result = ((long long)v * value[r]) / 10000;
+            else
+                result = ((long long)value[r] * 10000) / v;
+            
+            folded = true;
+            break;
+        }
+        
+        case OP_SETTRUE:
+        case OP_SETFALSE:
+        case OP_SETMORE:
+        case OP_SETLESS:
+            if(!flagKnown)
+                return false;
+            
+            result = (condition(in.op) & flag) ? 1 : 0;
+            folded = true;
+            break;
+        
+        case OP_GOTOTRUE:
+        case OP_GOTOFALSE:
+        case OP_GOTOMORE:
+        case OP_GOTOLESS:
+        {
+            if(!flagKnown)
+                return false;
+            
+            bool taken;
+            
+            //GOTOLESS on equal depends on the quest rule
+            if(in.op == OP_GOTOLESS)
+            {
+                if(flag == EQUAL)
+                    return false;
+                
+                taken = flag == LESS;
+            }
+            else
+                taken = (condition(in.op) & flag) != 0;
+            
+            if(taken)
+                change(in, OP_GOTO, in.a);
+            else
+                remove(in);
+            
+            return true;
+        }
+        
+        default:
+            return false;
+        }
+        
+        if(!folded || result > MAX_LITERAL || result < -MAX_LITERAL)
+            return false;
+        
+        change(in, OP_SETV, in.a, Operand(Operand::LITERAL, long(result)));
+        return true;
+    }
+    
+    void record(const Instr &in, int def, bool *known, long *value, int *copyOf, bool &flagKnown, int &flag)
+    {
+        int r = isRegister(in.a) ? in.a.value : -1;
+        
+        for(int s = 0; s < 8; s++)
+        {
+            if(def & (1 << s))
+            {
+                known[s] = false;
+                copyOf[s] = -1;
+            }
+        }
+        
+        if(def & FLAG)
+            flagKnown = false;
+        
+        switch(in.op)
+        {
+        case OP_SETV:
+            if(r != -1 && isLiteral(in.b))
+            {
+                known[r] = true;
+                value[r] = in.b.value;
+            }
+            
+            break;
+        
+        case OP_SETR:
+            if(r != -1 && isRegister(in.b))
+                copyOf[r] = in.b.value;
+            
+            break;
+        
+        case OP_COMPAREV:
+            if(known[r])
+            {
+                flagKnown = true;
+                flag = flagState(value[r], in.b.value);
+            }
+            
+            break;
+        }
+    }
+    
+    // A PUSHR and the POP that takes the value off again, with nothing in between that uses
+    // the stack, are replaced with a SETR
+    bool pairPushes()
+    {
+        bool changed = false;
+        
+        for(size_t i = code.size(); i-- > 0;)
+        {
+            if(code[i].op != OP_PUSHR || code[i].deleted)
+                continue;
+            
+            int uses = 0, defs = 0;
+            size_t j;
+            
+            for(j = i + 1; j < code.size(); j++)
+            {
+                if(code[j].deleted)
+                    continue;
+                
+                if(code[j].label != -1 || touchesStack(code[j]))
+                    break;
+                
+                int use, def;
+                bool removable;
+                effects(code[j], use, def, removable);
+                uses |= use;
+                defs |= def;
+            }
+            
+            if(j == code.size() || code[j].op != OP_POP || code[j].label != -1)
+                continue;
+            
+            Operand pushed = code[i].a, popped = code[j].a;
+            
+            if(!(defs & bit(pushed)))
+            {
+                remove(code[i]);
+                
+                if(pushed == popped)
+                    remove(code[j]);
+                else
+                    change(code[j], OP_SETR, popped, pushed);
+            }
+            else if(!((uses | defs) & bit(popped)))
+            {
+                change(code[i], OP_SETR, popped, pushed);
+                remove(code[j]);
+            }
+            else
+                continue;
+            
+            changed = true;
+        }
+        
+        return changed;
+    }
+    
+    // A comparison followed by pairs of SETx r and COMPAREV r,0 and then a GOTOx or SETx
+    // depends only on the first comparison, so if the registers and flags in between aren't
+    // used afterwards, the middle can go.
+    bool simplifyConditions()
+    {
+        bool changed = false;
+        
+        for(size_t k = 0; k < code.size(); k++)
+        {
+            if(code[k].op != OP_COMPAREV && code[k].op != OP_COMPARER)
+                continue;
+            
+            //What the flag is in for each state of the first comparison's flag
+            int state[LESS + 1];
+            state[EQUAL] = EQUAL;
+            state[GREATER] = GREATER;
+            state[LESS] = LESS;
+            int written = 0;
+            size_t i = k + 1;
+            
+            while(i + 1 < code.size() && condition(code[i].op) != -1 && code[i + 1].op == OP_COMPAREV
+                    && code[i + 1].a == code[i].a && code[i + 1].b.value == 0
+                    && code[i].label == -1 && code[i + 1].label == -1)
+            {
+                int cond = condition(code[i].op);
+                
+                //SETx r leaves 1 or 0 in r, and comparing that with 0 gives GREATER or EQUAL
+                for(int s = EQUAL; s <= LESS; s <<= 1)
+                    state[s] = (cond & state[s]) ? GREATER : EQUAL;
+                
+                written |= bit(code[i].a);
+                i += 2;
+            }
+            
+            if(i == k + 1 || i >= code.size() || code[i].label != -1 || condition(code[i].op) == -1)
+                continue;
+            
+            Instr &last = code[i];
+            int cond = 0;
+            
+            for(int s = EQUAL; s <= LESS; s <<= 1)
+            {
+                if(condition(last.op) & state[s])
+                    cond |= s;
+            }
+            
+            bool isGoto = isJump(last.op);
+            int result = isGoto ? written : written & ~bit(last.a);
+            
+            if((liveAfter[i] & (result | FLAG)) != 0)
+                continue;
+            
+            int op = isGoto ? gotoFor(cond) : setFor(cond);
+            bool swap = false;
+            
+            if(op == -1 && code[k].op == OP_COMPARER)
+            {
+                op = isGoto ? gotoFor(mirror(cond)) : setFor(mirror(cond));
+                swap = true;
+            }
+            
+            if(isGoto && cond == COND_ALWAYS)
+                op = OP_GOTO;
+            
+            if(op == -1 && !(isGoto && cond == COND_NEVER))
+                continue;
+            
+            for(size_t j = k + 1; j < i; j++)
+                remove(code[j]);
+            
+            if(swap)
+                change(code[k], OP_COMPARER, code[k].b, code[k].a);
+            
+            if(op == -1)
+                remove(last);
+            else
+                change(last, op, last.a);
+            
+            changed = true;
+            k = i;
+        }
+        
+        return changed;
+    }
+    
+    bool removeDeadCode()
+    {
+        bool changed = false;
+        
+        for(size_t i = 0; i < code.size(); i++)
+        {
+            int use, def;
+            bool removable;
+            effects(code[i], use, def, removable);
+            
+            if(removable && !(def & liveAfter[i]))
+            {
+                remove(code[i]);
+                changed = true;
+            }
+        }
+        
+        return changed;
+    }
+    
+    // Jumps to GOTOs go straight to where the GOTOs go
+    bool threadJumps()
+    {
+        bool changed = false;
+        
+        for(size_t i = 0; i < code.size(); i++)
+        {
+            Instr &in = code[i];
+            
+            if(!isJump(in.op) || in.deleted)
+                continue;
+            
+            int label = in.a.value;
+            int target = find(label);
+            
+            for(int hops = 0; target >= 0 && hops < 16 && code[target].op == OP_GOTO; hops++)
+            {
+                label = code[target].a.value;
+                target = find(label);
+            }
+            
+            if(label != in.a.value)
+            {
+                change(in, in.op, Operand(Operand::LABEL, label));
+                changed = true;
+            }
+            
+            //A jump to the next instruction
+            if(target == int(i + 1))
+            {
+                remove(in);
+                changed = true;
+                continue;
+            }
+            
+            //GOTOTRUE a; GOTO b; a: becomes GOTOFALSE b; a:
+            if((in.op == OP_GOTOTRUE || in.op == OP_GOTOFALSE) && target == int(i + 2)
+                    && code[i + 1].op == OP_GOTO && code[i + 1].label == -1)
+            {
+                change(in, in.op == OP_GOTOTRUE ? OP_GOTOFALSE : OP_GOTOTRUE, code[i + 1].a);
+                remove(code[i + 1]);
+                changed = true;
+                i++;
+            }
+        }
+        
+        return changed;
+    }
+    
+    // Code not reachable from the start of the function or from a label used elsewhere
+    bool removeUnreachable()
+    {
+        vector<bool> reached(code.size(), false);
+        vector<int> work;
+        
+        for(size_t i = 0; i < code.size(); i++)
+        {
+            if(i == 0 || (code[i].label != -1 && isPinned(code[i].label)))
+            {
+                reached[i] = true;
+                work.push_back(int(i));
+            }
+        }
+        
+        while(!work.empty())
+        {
+            int i = work.back();
+            work.pop_back();
+            int succ[2];
+            bool exits;
+            int count = successors(i, succ, exits);
+            
+            for(int s = 0; s < count; s++)
+            {
+                if(!reached[succ[s]])
+                {
+                    reached[succ[s]] = true;
+                    work.push_back(succ[s]);
+                }
+            }
+        }
+        
+        bool changed = false;
+        
+        for(size_t i = 0; i < code.size(); i++)
+        {
+            if(!reached[i])
+            {
+                remove(code[i]);
+                changed = true;
+            }
+        }
+        
+        return changed;
+    }
+};
+
+// Finds the functions the scripts and ~Init can reach, which are the only ones assemble() will
+// use, and the labels used by anything other than a jump in the function they're in: function
+// entries, return addresses, and anything ~Init jumps to.
+void findUsedFunctions(IntermediateData *id, set<int> &used, set<int> &pinned)
+{
+    map<int, int> owner;
+    
+    for(map<int, vector<Opcode *> >::iterator it = id->funcs.begin(); it != id->funcs.end(); it++)
+    {
+        for(vector<Opcode *>::iterator it2 = it->second.begin(); it2 != it->second.end(); it2++)
+        {
+            if((*it2)->getLabel() != -1)
+                owner[(*it2)->getLabel()] = it->first;
+        }
+    }
+    
+    vector<pair<int, vector<Opcode *> *> > work;
+    work.push_back(make_pair(-1, &id->globalsInit));
+    work.push_back(make_pair(-1, &id->globalasInit));
+    
+    for(map<string, int>::iterator it = id->scriptRunLabels.begin(); it != id->scriptRunLabels.end(); it++)
+    {
+        if(id->funcs.find(it->second) != id->funcs.end() && used.insert(it->second).second)
+            work.push_back(make_pair(it->second, &id->funcs[it->second]));
+        
+        pinned.insert(it->second);
+    }
+    
+    while(!work.empty())
+    {
+        int func = work.back().first;
+        vector<Opcode *> *code = work.back().second;
+        work.pop_back();
+        
+        for(vector<Opcode *>::iterator it = code->begin(); it != code->end(); it++)
+        {
+            Instr in = decode(*it);
+            Operand *operands[] = { &in.a, &in.b };
+            
+            for(int i = 0; i < 2; i++)
+            {
+                if(operands[i]->type != Operand::LABEL)
+                    continue;
+                
+                int label = operands[i]->value;
+                map<int, int>::iterator target = owner.find(label);
+                
+                if(!isJump(in.op) || target == owner.end() || target->second != func)
+                    pinned.insert(label);
+                
+                if(target != owner.end() && used.insert(target->second).second)
+                {
+                    work.push_back(make_pair(target->second, &id->funcs[target->second]));
+                    pinned.insert(target->second);
+                }
+            }
+        }
+    }
+}
+
+struct OptimizeJob
+{
+    vector<Opcode *> *code;
+    map<int, int> aliases;
+};
+
+struct OptimizeJobs
+{
+    vector<OptimizeJob> jobs;
+    const set<int> *pinned;
+};
+
+void optimizeFunction(int i, void *param)
+{
+    OptimizeJobs *oj = (OptimizeJobs *)param;
+    FunctionOptimizer fo(*oj->jobs[i].code, *oj->pinned, oj->jobs[i].aliases);
+    fo.run();
+}
+
+void renameLabels(vector<Opcode *> &code, map<int, int> &aliases)
+{
+    for(vector<Opcode *>::iterator it = code.begin(); it != code.end(); it++)
+    {
+        RenameLabels temp;
+        (*it)->execute(temp, &aliases);
+    }
+}
+
+}
+
+void ScriptParser::optimize(IntermediateData *id)
+{
+    set<int> used, pinned;
+    findUsedFunctions(id, used, pinned);
+    
+    //the functions are optimized independently, each collecting the labels it renamed
+    OptimizeJobs oj;
+    oj.pinned = &pinned;
+    oj.jobs.resize(used.size());
+    size_t i = 0;
+    
+    for(set<int>::iterator it = used.begin(); it != used.end(); it++, i++)
+        oj.jobs[i].code = &id->funcs[*it];
+    
+    runJobs((int)oj.jobs.size(), optimizeFunction, &oj);
+    map<int, int> aliases;
+    
+    for(vector<OptimizeJob>::iterator it = oj.jobs.begin(); it != oj.jobs.end(); it++)
+        aliases.insert(it->aliases.begin(), it->aliases.end());
+    
+    if(aliases.empty())
+        return;
+    
+    resolveAliases(aliases);
+    
+    for(map<int, vector<Opcode *> >::iterator it = id->funcs.begin(); it != id->funcs.end(); it++)
+        renameLabels(it->second, aliases);
+    
+    renameLabels(id->globalsInit, aliases);
+    renameLabels(id->globalasInit, aliases);
+}
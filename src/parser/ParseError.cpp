@@ -8,6 +8,31 @@
 #include <string>
 #include <sstream>
 using namespace std;
+
+#ifdef _MSC_VER
+static __declspec(thread) vector<string> *errorBuffer = NULL;
+#else
+static __thread vector<string> *errorBuffer = NULL;
+#endif
+
+void setErrorBuffer(vector<string> *buffer)
+{
+    errorBuffer = buffer;
+}
+
+void printErrorLine(const string &msg)
+{
+    if(errorBuffer)
+    {
+        errorBuffer->push_back(msg);
+        return;
+    }
+    
+#ifndef SCRIPTPARSER_COMPILE
+    box_out(msg.c_str());
+    box_eol();
+#endif
+}
 void printErrorMsg(AST *offender, int errorID, string param)
 {
     ostringstream oss;
@@ -209,9 +234,6 @@ void printErrorMsg(AST *offender, int errorID, string param)
         break;
     }
     
-#ifndef SCRIPTPARSER_COMPILE
-    box_out(oss.str().c_str());
-    box_eol();
-#endif
+    printErrorLine(oss.str());
 }
 
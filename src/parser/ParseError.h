@@ -3,10 +3,16 @@
 
 #include "AST.h"
 #include <string>
+#include <vector>
 
 using std::string;
+using std::vector;
 
 void printErrorMsg(AST *offender, int errorID, string param=string());
+//While a thread has a buffer set, its messages are kept there instead of printed, so the ones
+//from code generation workers can be printed in order afterwards
+void setErrorBuffer(vector<string> *buffer);
+void printErrorLine(const string &msg);
 
 #define CANTOPENSOURCE 0
 #define CANTOPENIMPORT 1
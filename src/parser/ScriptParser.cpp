@@ -7,10 +7,12 @@
 #include "GlobalSymbols.h"
 #include "ByteCode.h"
 #include "../zsyssimple.h"
+#include "../mutex.h"
 #include <iostream>
 #include <assert.h>
 #include <string>
 #include <cstdlib>
+#include <cstring>
 
 #include "DataStructs.h"
 #include "SymbolVisitors.h"
@@ -22,7 +24,7 @@ using namespace std;
 
 AST *resAST;
 
-ScriptsData * compile(char *filename);
+ScriptsData * compile(const char *filename, compile_phase_callback phase_done);
 
 #ifdef PARSER_DEBUG
 int main(int argc, char *argv[])
@@ -34,8 +36,10 @@ int main(int argc, char *argv[])
 }
 #endif
 
-ScriptsData * compile(const char *filename)
+ScriptsData * compile(const char *filename, compile_phase_callback phase_done)
 {
+    //the AST and intermediate code all go in here, and are freed together on the way out
+    CompileArena arena;
     ScriptParser::resetState();
 #ifndef SCRIPTPARSER_COMPILE
     box_out("Pass 1: Parsing");
@@ -50,19 +54,28 @@ ScriptsData * compile(const char *filename)
     
     AST *theAST = resAST;
     
+    if(phase_done)
+        phase_done("Parsing");
+    
 #ifndef SCRIPTPARSER_COMPILE
     box_out("Pass 2: Preprocessing");
     box_eol();
 #endif
     map<string, long> *consts = new map<string,long>();
     
-    if(!ScriptParser::preprocess(theAST, RECURSIONLIMIT,consts))
+    bool preprocessed = ScriptParser::preprocess(theAST, RECURSIONLIMIT,consts);
+    ScriptParser::writeImportCache();
+    
+    if(!preprocessed)
     {
         delete theAST;
         delete consts;
         return NULL;
     }
     
+    if(phase_done)
+        phase_done("Preprocessing");
+    
 #ifndef SCRIPTPARSER_COMPILE
     box_out("Pass 3: Building symbol tables");
     box_eol();
@@ -77,6 +90,9 @@ ScriptsData * compile(const char *filename)
     }
     
     //d->symbols->printDiagnostics();
+    if(phase_done)
+        phase_done("Symbol tables");
+        
 #ifndef SCRIPTPARSER_COMPILE
     box_out("Pass 4: Type-checking/Completing function symbol tables/Constant folding");
     box_eol();
@@ -108,6 +124,9 @@ ScriptsData * compile(const char *filename)
         return NULL;
     }
     
+    if(phase_done)
+        phase_done("Type checking");
+        
 #ifndef SCRIPTPARSER_COMPILE
     box_out("Pass 5: Generating object code");
     box_eol();
@@ -162,11 +181,35 @@ ScriptsData * compile(const char *filename)
         return NULL;
     }
     
+    if(phase_done)
+        phase_done("Code generation");
+        
+    if(ScriptParser::isOptimizing())
+    {
+#ifndef SCRIPTPARSER_COMPILE
+        box_out("Pass 6: Optimizing");
+        box_eol();
+#endif
+        ScriptParser::optimize(id);
+        
+        //inlining is done on the optimized code, so the size limit is on the opcodes that are
+        //actually run, and the calls are tidied up afterwards
+        if(ScriptParser::inlineFunctions(id))
+            ScriptParser::optimize(id);
+        
+        if(phase_done)
+            phase_done("Optimization");
+    }
+    
 #ifndef SCRIPTPARSER_COMPILE
-    box_out("Pass 6: Assembling");
+    box_out(ScriptParser::isOptimizing() ? "Pass 7: Assembling" : "Pass 6: Assembling");
     box_eol();
 #endif
     ScriptsData *final = ScriptParser::assemble(id);
+    
+    if(phase_done)
+        phase_done("Assembly");
+        
     box_out("Success!");
     box_eol();
     
@@ -236,6 +279,255 @@ int ScriptParser::vid = 0;
 int ScriptParser::fid = 0;
 int ScriptParser::gid = 1;
 int ScriptParser::lid = 0;
+vector<string> ScriptParser::includePaths;
+bool ScriptParser::optimizing = true;
+map<string, ScriptParser::CachedImport> ScriptParser::importCache;
+map<string, ScriptParser::SavedImport> ScriptParser::savedImports;
+string ScriptParser::importCacheFile;
+bool ScriptParser::importCacheRead = false;
+bool ScriptParser::importCacheChanged = false;
+
+int ScriptParser::threads = 1;
+
+//each code generation worker allocates from an arena of its own
+#ifdef _MSC_VER
+static __declspec(thread) CompileArena *currentArena = NULL;
+#else
+static __thread CompileArena *currentArena = NULL;
+#endif
+
+//Each object in an arena has this in front of it, so delete can tell where it came from
+union arena_header
+{
+    CompileArena *arena;
+    double align;
+    void *palign;
+};
+
+static const size_t ARENA_BLOCK_SIZE = 65536;
+
+CompileArena::CompileArena() : next(NULL), left(0), objects(0), bytes(0), previous(currentArena)
+{
+    currentArena = this;
+}
+
+CompileArena::~CompileArena()
+{
+    for(vector<char *>::iterator it = blocks.begin(); it != blocks.end(); it++)
+        delete[] *it;
+        
+    if(currentArena == this)
+        currentArena = previous;
+}
+
+CompileArena *CompileArena::getCurrent()
+{
+    return currentArena;
+}
+
+void CompileArena::setCurrent(CompileArena *arena)
+{
+    currentArena = arena;
+}
+
+void CompileArena::adopt(CompileArena &other)
+{
+    blocks.insert(blocks.end(), other.blocks.begin(), other.blocks.end());
+    objects += other.objects;
+    bytes += other.bytes;
+    other.blocks.clear();
+    other.next = NULL;
+    other.left = 0;
+}
+
+void *CompileArena::allocate(size_t size)
+{
+    size = (size + sizeof(arena_header) - 1) / sizeof(arena_header) * sizeof(arena_header);
+    objects++;
+    bytes += size;
+    
+    //big things get a block to themselves, so the current one isn't wasted
+    if(size > ARENA_BLOCK_SIZE / 4)
+    {
+        blocks.push_back(new char[size]);
+        return blocks.back();
+    }
+    
+    if(size > left)
+    {
+        next = new char[ARENA_BLOCK_SIZE];
+        left = ARENA_BLOCK_SIZE;
+        blocks.push_back(next);
+    }
+    
+    void *rval = next;
+    next += size;
+    left -= size;
+    return rval;
+}
+
+void *ArenaObject::operator new(size_t size)
+{
+    CompileArena *arena = currentArena;
+    arena_header *h;
+    
+    if(arena)
+        h = (arena_header *)arena->allocate(sizeof(arena_header) + size);
+    else
+        h = (arena_header *)::operator new(sizeof(arena_header) + size);
+        
+    h->arena = arena;
+    return h + 1;
+}
+
+void ArenaObject::operator delete(void *p)
+{
+    if(!p)
+        return;
+        
+    arena_header *h = (arena_header *)p - 1;
+    
+    //objects in an arena are freed with it
+    if(!h->arena)
+        ::operator delete(h);
+}
+
+//Labels are handed out under a lock while workers are running
+static mutex labelLock;
+static bool labelLocking = false;
+
+int ScriptParser::getUniqueLabelID()
+{
+    if(!labelLocking)
+        return lid++;
+        
+    mutex_lock(&labelLock);
+    int rval = lid++;
+    mutex_unlock(&labelLock);
+    return rval;
+}
+
+struct JobPool
+{
+    int count;
+    int next;
+    void (*job)(int, void *);
+    void *param;
+    mutex lock;
+};
+
+struct JobWorker
+{
+    JobPool *pool;
+    CompileArena *arena;
+    bool useArena;
+#ifdef _WIN32
+    HANDLE thread;
+#else
+    pthread_t thread;
+#endif
+};
+
+static void takeJobs(JobPool *pool)
+{
+    for(;;)
+    {
+        mutex_lock(&pool->lock);
+        int i = pool->next++;
+        mutex_unlock(&pool->lock);
+        
+        if(i >= pool->count)
+            return;
+            
+        pool->job(i, pool->param);
+    }
+}
+
+#ifdef _WIN32
+static DWORD WINAPI jobThread(LPVOID param)
+#else
+static void *jobThread(void *param)
+#endif
+{
+    JobWorker *w = (JobWorker *)param;
+    
+    if(w->useArena)
+        w->arena = new CompileArena;
+        
+    takeJobs(w->pool);
+    return 0;
+}
+
+//Runs job(i, param) for each i below count, on up to getThreads() threads including this one.
+//The jobs can be run in any order, so anything they share must only be read. Each worker has
+//its own arena, which this thread's arena takes over once they're all done.
+void ScriptParser::runJobs(int count, void (*job)(int, void *), void *param)
+{
+    int nthreads = threads;
+    
+    if(nthreads > count)
+        nthreads = count;
+        
+    if(nthreads <= 1)
+    {
+        for(int i = 0; i < count; i++)
+            job(i, param);
+            
+        return;
+    }
+    
+    JobPool pool;
+    pool.count = count;
+    pool.next = 0;
+    pool.job = job;
+    pool.param = param;
+    mutex_init(&pool.lock);
+    mutex_init(&labelLock);
+    labelLocking = true;
+    
+    CompileArena *arena = CompileArena::getCurrent();
+    vector<JobWorker> workers(nthreads - 1);
+    vector<bool> started(workers.size(), false);
+    
+    for(size_t i = 0; i < workers.size(); i++)
+    {
+        workers[i].pool = &pool;
+        workers[i].arena = NULL;
+        workers[i].useArena = arena != NULL;
+#ifdef _WIN32
+        workers[i].thread = CreateThread(NULL, 0, jobThread, &workers[i], 0, NULL);
+        started[i] = workers[i].thread != NULL;
+#else
+        started[i] = pthread_create(&workers[i].thread, NULL, jobThread, &workers[i]) == 0;
+#endif
+    }
+    
+    //if a thread couldn't be started, the rest just take its share
+    takeJobs(&pool);
+    
+    for(size_t i = 0; i < workers.size(); i++)
+    {
+        if(!started[i])
+            continue;
+            
+#ifdef _WIN32
+        WaitForSingleObject(workers[i].thread, INFINITE);
+        CloseHandle(workers[i].thread);
+#else
+        pthread_join(workers[i].thread, NULL);
+#endif
+        
+        if(workers[i].arena)
+        {
+            arena->adopt(*workers[i].arena);
+            delete workers[i].arena;
+        }
+    }
+    
+    labelLocking = false;
+    mutex_destroy(&labelLock);
+    mutex_destroy(&pool.lock);
+}
 
 // The following is NOT AT ALL compliant with the C++ standard
 // but apparently required by the MingW gcc...
@@ -261,6 +553,248 @@ string ScriptParser::trimQuotes(string quoteds)
     return rval;
 }
 
+string ScriptParser::findImport(const string &fn)
+{
+    FILE *f = fopen(fn.c_str(), "r");
+    
+    if(f)
+    {
+        fclose(f);
+        return fn;
+    }
+    
+    for(vector<string>::iterator it = includePaths.begin(); it != includePaths.end(); it++)
+    {
+        string path = *it + "/" + fn;
+        f = fopen(path.c_str(), "r");
+        
+        if(f)
+        {
+            fclose(f);
+            return path;
+        }
+    }
+    
+    return fn;
+}
+
+static bool readWholeFile(const string &fn, string &text)
+{
+    FILE *f = fopen(fn.c_str(), "rb");
+    
+    if(!f)
+        return false;
+        
+    char buf[4096];
+    size_t n;
+    
+    while((n = fread(buf, 1, sizeof(buf), f)) > 0)
+        text.append(buf, n);
+        
+    bool ok = !ferror(f);
+    fclose(f);
+    return ok;
+}
+
+//The import cache file is the magic number, a hash of the rest of the file, the number of
+//imports, and then each one's path, text size, text hash and saved AST.
+//Bump the version if the AST or the grammar changes.
+static const char importCacheMagic[8] = { 'Z', 'S', 'I', 'M', 'P', '0', '0', '1' };
+
+//64-bit FNV-1a
+static unsigned long long hashBytes(const char *data, size_t size)
+{
+    unsigned long long hash = 14695981039346656037ULL;
+    
+    for(size_t i = 0; i < size; i++)
+        hash = (hash ^ (unsigned char)data[i]) * 1099511628211ULL;
+        
+    return hash;
+}
+
+static void putNumber(string &out, unsigned long long value, int bytes)
+{
+    for(int k = 0; k < bytes; k++)
+        out += char((value >> (8 * k)) & 0xFF);
+}
+
+static bool getNumber(const string &in, size_t &pos, unsigned long long &value, int bytes)
+{
+    if(in.size() - pos < size_t(bytes))
+        return false;
+        
+    value = 0;
+    
+    for(int k = 0; k < bytes; k++)
+        value |= (unsigned long long)(unsigned char)in[pos++] << (8 * k);
+        
+    return true;
+}
+
+static bool getBlob(const string &in, size_t &pos, string &out)
+{
+    unsigned long long size;
+    
+    if(!getNumber(in, pos, size, 4) || size > in.size() - pos)
+        return false;
+        
+    out = in.substr(pos, size_t(size));
+    pos += size_t(size);
+    return true;
+}
+
+void ScriptParser::readImportCache()
+{
+    if(importCacheRead)
+        return;
+        
+    importCacheRead = true;
+    importCacheChanged = false;
+    savedImports.clear();
+    string data;
+    
+    if(importCacheFile.empty() || !readWholeFile(importCacheFile, data) || data.size() < 16 ||
+       memcmp(data.c_str(), importCacheMagic, sizeof(importCacheMagic)) != 0)
+        return;
+        
+    size_t pos = 8;
+    unsigned long long hash, count;
+    getNumber(data, pos, hash, 8);
+    
+    if(hash != hashBytes(data.c_str() + 16, data.size() - 16) || !getNumber(data, pos, count, 4))
+        return;
+        
+    for(; count > 0; count--)
+    {
+        string path;
+        SavedImport entry;
+        unsigned long long size;
+        
+        if(!getBlob(data, pos, path) || !getNumber(data, pos, size, 8) ||
+           !getNumber(data, pos, entry.hash, 8) || !getBlob(data, pos, entry.ast))
+        {
+            savedImports.clear();
+            return;
+        }
+        
+        entry.size = size_t(size);
+        savedImports[path] = entry;
+    }
+}
+
+void ScriptParser::writeImportCache()
+{
+    if(!importCacheChanged || importCacheFile.empty())
+        return;
+        
+    importCacheChanged = false;
+    string body;
+    putNumber(body, savedImports.size(), 4);
+    
+    for(map<string, SavedImport>::iterator it = savedImports.begin(); it != savedImports.end(); it++)
+    {
+        putNumber(body, it->first.size(), 4);
+        body += it->first;
+        putNumber(body, it->second.size, 8);
+        putNumber(body, it->second.hash, 8);
+        putNumber(body, it->second.ast.size(), 4);
+        body += it->second.ast;
+    }
+    
+    string header(importCacheMagic, sizeof(importCacheMagic));
+    putNumber(header, hashBytes(body.c_str(), body.size()), 8);
+    
+    FILE *f = fopen(importCacheFile.c_str(), "wb");
+    
+    if(!f)
+        return;
+        
+    bool ok = fwrite(header.c_str(), 1, header.size(), f) == header.size() &&
+              fwrite(body.c_str(), 1, body.size(), f) == body.size();
+    ok = fclose(f) == 0 && ok;
+    
+    //a partial file would just be ignored, but there's no sense leaving it around
+    if(!ok)
+        remove(importCacheFile.c_str());
+}
+
+//Parses an imported file, or gets the AST it was parsed into before if it hasn't changed.
+//Libraries like std.zh are imported by every compile but hardly ever edited. Imports parsed
+//earlier in this run are copied from memory; ones parsed in an earlier run are read back
+//from the import cache file, if there is one.
+AST *ScriptParser::parseImport(const string &fn)
+{
+    string text;
+    bool cacheable = readWholeFile(fn, text);
+    
+    if(cacheable)
+    {
+        map<string, CachedImport>::iterator it = importCache.find(fn);
+        
+        if(it != importCache.end() && it->second.text == text)
+        {
+            Clone c;
+            it->second.ast->execute(c, NULL);
+            return c.getResult();
+        }
+    }
+    
+    AST *ast = NULL;
+    bool saving = cacheable && !importCacheFile.empty();
+    unsigned long long hash = 0;
+    
+    if(saving)
+    {
+        readImportCache();
+        hash = hashBytes(text.c_str(), text.size());
+        map<string, SavedImport>::iterator it = savedImports.find(fn);
+        
+        //if it can't be read back for whatever reason, the file's just parsed again
+        if(it != savedImports.end() && it->second.hash == hash && it->second.size == text.size())
+        {
+            LoadAST l(it->second.ast);
+            ast = l.getResult();
+            saving = ast == NULL;
+        }
+    }
+    
+    if(!ast)
+    {
+        if(go(fn.c_str()) != 0 || !resAST)
+            return NULL;
+            
+        ast = resAST;
+    }
+    
+    if(saving)
+    {
+        SaveAST s;
+        ast->execute(s, NULL);
+        SavedImport &entry = savedImports[fn];
+        entry.hash = hash;
+        entry.size = text.size();
+        entry.ast = s.getData();
+        importCacheChanged = true;
+    }
+    
+    if(cacheable)
+    {
+        //the cache outlives the compile, so it can't go in the arena
+        CompileArena *arena = CompileArena::getCurrent();
+        CompileArena::setCurrent(NULL);
+        Clone c;
+        ast->execute(c, NULL);
+        CompileArena::setCurrent(arena);
+        
+        CachedImport &entry = importCache[fn];
+        delete entry.ast;
+        entry.text = text;
+        entry.ast = c.getResult();
+    }
+    
+    return ast;
+}
+
 bool ScriptParser::preprocess(AST *theAST, int reclimit, map<string,long> *constants)
 {
     if(reclimit == 0)
@@ -293,7 +827,10 @@ bool ScriptParser::preprocess(AST *theAST, int reclimit, map<string,long> *const
 #endif
         }
         
-        if(go(fn.c_str()) != 0 || !resAST)
+        fn = findImport(fn);
+        AST *recAST = parseImport(fn);
+        
+        if(!recAST)
         {
             printErrorMsg(*it,CANTOPENIMPORT, fn);
             
@@ -305,8 +842,6 @@ bool ScriptParser::preprocess(AST *theAST, int reclimit, map<string,long> *const
             return false;
         }
         
-        AST *recAST = resAST;
-        
         if(!preprocess(recAST, reclimit-1,constants))
         {
             for(vector<ASTImportDecl *>::iterator it2 = imports.begin(); it2 != imports.end(); it2++)
@@ -422,6 +957,12 @@ SymbolData *ScriptParser::buildSymbolTable(AST *theAST, map<string, long> *const
         int rettype;
         ExtractType temp;
         (*it)->getReturnType()->execute(temp, &rettype);
+        
+        //Older copies of std.zh define Waitframes() themselves, as a loop over Waitframe();
+        //that one is used instead of the built-in one so they still compile
+        if((*it)->getName() == "Waitframes")
+            globalScope->getFuncSymbols().removeFunction("Waitframes", params);
+            
         int id = globalScope->getFuncSymbols().addFunction((*it)->getName(), rettype, params);
         
         if(id == -1)
@@ -856,6 +1397,135 @@ FunctionData *ScriptParser::typeCheck(SymbolData *sdata)
     return fd;
 }
 
+//A function to be generated by generateFunction
+struct FunctionJob
+{
+    ASTFuncDecl *func;
+    int label;
+    bool isarun;
+    int thisptr;
+    int scripttype;
+    vector<Opcode *> code;
+    vector<string> errors;
+    bool ok;
+};
+
+struct FunctionJobs
+{
+    vector<FunctionJob> jobs;
+    SymbolTable *symbols;
+    LinkTable *lt;
+};
+
+//Generates the code for one function. This runs on the code generation workers, so the symbol
+//and link tables are only read, and any errors are kept to be printed in order later.
+static void generateFunction(int i, void *param)
+{
+    FunctionJobs *fj = (FunctionJobs *)param;
+    FunctionJob &job = fj->jobs[i];
+    SymbolTable *symbols = fj->symbols;
+    vector<Opcode *> &funccode = job.code;
+    setErrorBuffer(&job.errors);
+    
+    //count the number of stack-allocated variables
+    vector<int> stackvars;
+    pair<vector<int> *, SymbolTable *> stackparam = pair<vector<int> *, SymbolTable *>(&stackvars, symbols);
+    CountStackSymbols temp;
+    job.func->execute(temp, &stackparam);
+    int offset = 0;
+    StackFrame sf;
+    
+    //if this is a run, there is the this pointer
+    if(job.isarun)
+    {
+        sf.addToFrame(job.thisptr, offset);
+        offset += 10000;
+    }
+    
+    //the params are now the first elements of this list
+    //so assign them depths in reverse order
+    for(vector<int>::reverse_iterator it2 = stackvars.rbegin(); it2 != stackvars.rend(); it2++)
+    {
+        sf.addToFrame(*it2, offset);
+        offset += 10000;
+    }
+    
+    //start of the function
+    Opcode *first = new OSetImmediate(new VarArgument(EXP1), new LiteralArgument(0));
+    first->setLabel(job.label);
+    funccode.push_back(first);
+    //push on the 0s
+    int numtoallocate = (unsigned int)stackvars.size()-(unsigned int)symbols->getFuncParams(symbols->getID(job.func)).size();
+    
+    for(int k = 0; k < numtoallocate; k++)
+    {
+        funccode.push_back(new OPushRegister(new VarArgument(EXP1)));
+    }
+    
+    //push on the this, if a script
+    if(job.isarun)
+    {
+        switch(job.scripttype)
+        {
+        case ScriptParser::TYPE_FFC:
+            funccode.push_back(new OSetRegister(new VarArgument(EXP2), new VarArgument(REFFFC)));
+            break;
+            
+        case ScriptParser::TYPE_ITEMCLASS:
+            funccode.push_back(new OSetRegister(new VarArgument(EXP2), new VarArgument(REFITEMCLASS)));
+            break;
+            
+        case ScriptParser::TYPE_GLOBAL:
+            //don't care, we don't have a valid this pointer
+            break;
+        }
+        
+        funccode.push_back(new OPushRegister(new VarArgument(EXP2)));
+    }
+    
+    //set up the stack frame register
+    funccode.push_back(new OSetRegister(new VarArgument(SFRAME), new VarArgument(SP)));
+    OpcodeContext oc;
+    oc.linktable = fj->lt;
+    oc.symbols = symbols;
+    oc.stackframe = &sf;
+    BuildOpcodes bo;
+    job.func->execute(bo, &oc);
+    job.ok = bo.isOK();
+    vector<Opcode *> code = bo.getResult();
+    
+    for(vector<Opcode *>::iterator it2 = code.begin(); it2 != code.end(); it2++)
+    {
+        funccode.push_back(*it2);
+    }
+    
+    //add appendix code
+    //nop label
+    Opcode *next = new OSetImmediate(new VarArgument(EXP2), new LiteralArgument(0));
+    next->setLabel(bo.getReturnLabelID());
+    funccode.push_back(next);
+    
+    //pop off everything
+    for(unsigned int k=0; k< stackvars.size(); k++)
+    {
+        funccode.push_back(new OPopRegister(new VarArgument(EXP2)));
+    }
+    
+    //if it's a main script, quit.
+    if(job.isarun)
+        funccode.push_back(new OQuit());
+    else
+    {
+        //pop off the return address
+        funccode.push_back(new OPopRegister(new VarArgument(EXP2)));
+        //and return
+        funccode.push_back(new OGotoRegister(new VarArgument(EXP2)));
+    }
+    
+    delete job.func;
+    setErrorBuffer(NULL);
+}
+
 IntermediateData *ScriptParser::generateOCode(FunctionData *fdata)
 {
     //Z_message("yes");
@@ -1034,123 +1704,45 @@ IntermediateData *ScriptParser::generateOCode(FunctionData *fdata)
     
     //Z_message("yes");
     
-    //globals have been initialized, now we repeat for the functions
-    for(vector<ASTFuncDecl *>::iterator it = funcs.begin(); it != funcs.end(); it++)
+    //globals have been initialized, now we repeat for the functions, which don't depend on each
+    //other and so can be generated by several threads at once
+    FunctionJobs fj;
+    fj.jobs.resize(funcs.size());
+    fj.symbols = symbols;
+    fj.lt = &lt;
+    
+    for(size_t i = 0; i < funcs.size(); i++)
     {
-        bool isarun = false;
-        string scriptname;
+        FunctionJob &job = fj.jobs[i];
+        job.func = funcs[i];
+        job.label = lt.functionToLabel(symbols->getID(funcs[i]));
+        job.isarun = false;
+        job.ok = true;
         
         for(map<string,int>::iterator it2 = runsymbols.begin(); it2 != runsymbols.end(); it2++)
         {
-            if(it2->second == symbols->getID(*it))
+            if(it2->second == symbols->getID(funcs[i]))
             {
-                isarun=true;
-                scriptname = it2->first;
+                job.isarun = true;
+                job.thisptr = thisptr[it2->first];
+                job.scripttype = scripttypes[it2->first];
                 break;
             }
         }
-        
-        vector<Opcode *> funccode;
-        //count the number of stack-allocated variables
-        vector<int> stackvars;
-        pair<vector<int> *, SymbolTable *> param = pair<vector<int> *, SymbolTable *>(&stackvars, symbols);
-        CountStackSymbols temp;
-        (*it)->execute(temp, &param);
-        int offset = 0;
-        StackFrame sf;
-        
-        //if this is a run, there is the this pointer
-        if(isarun)
-        {
-            sf.addToFrame(thisptr[scriptname], offset);
-            offset += 10000;
-        }
-        
-        //the params are now the first elements of this list
-        //so assign them depths in reverse order
-        for(vector<int>::reverse_iterator it2 = stackvars.rbegin(); it2 != stackvars.rend(); it2++)
-        {
-            sf.addToFrame(*it2, offset);
-            offset += 10000;
-        }
-        
-        //start of the function
-        Opcode *first = new OSetImmediate(new VarArgument(EXP1), new LiteralArgument(0));
-        first->setLabel(lt.functionToLabel(symbols->getID(*it)));
-        funccode.push_back(first);
-        //push on the 0s
-        int numtoallocate = (unsigned int)stackvars.size()-(unsigned int)symbols->getFuncParams(symbols->getID(*it)).size();
-        
-        for(int i = 0; i < numtoallocate; i++)
-        {
-            funccode.push_back(new OPushRegister(new VarArgument(EXP1)));
-        }
-        
-        //push on the this, if a script
-        if(isarun)
-        {
-            switch(scripttypes[scriptname])
-            {
-            case ScriptParser::TYPE_FFC:
-                funccode.push_back(new OSetRegister(new VarArgument(EXP2), new VarArgument(REFFFC)));
-                break;
-                
-            case ScriptParser::TYPE_ITEMCLASS:
-                funccode.push_back(new OSetRegister(new VarArgument(EXP2), new VarArgument(REFITEMCLASS)));
-                break;
-                
-            case ScriptParser::TYPE_GLOBAL:
-                //don't care, we don't have a valid this pointer
-                break;
-            }
+    }
+    
+    runJobs((int)fj.jobs.size(), generateFunction, &fj);
+    
+    //put them together in the same order as they'd have been generated in one at a time
+    for(vector<FunctionJob>::iterator it = fj.jobs.begin(); it != fj.jobs.end(); it++)
+    {
+        for(vector<string>::iterator it2 = it->errors.begin(); it2 != it->errors.end(); it2++)
+            printErrorLine(*it2);
             
-            funccode.push_back(new OPushRegister(new VarArgument(EXP2)));
-        }
-        
-        //set up the stack frame register
-        funccode.push_back(new OSetRegister(new VarArgument(SFRAME), new VarArgument(SP)));
-        OpcodeContext oc;
-        oc.linktable = &lt;
-        oc.symbols = symbols;
-        oc.stackframe = &sf;
-        BuildOpcodes bo;
-        (*it)->execute(bo, &oc);
-        
-        if(!bo.isOK())
+        if(!it->ok)
             failure = true;
             
-        vector<Opcode *> code = bo.getResult();
-        
-        for(vector<Opcode *>::iterator it2 = code.begin(); it2 != code.end(); it2++)
-        {
-            funccode.push_back(*it2);
-        }
-        
-        //add appendix code
-        //nop label
-        Opcode *next = new OSetImmediate(new VarArgument(EXP2), new LiteralArgument(0));
-        next->setLabel(bo.getReturnLabelID());
-        funccode.push_back(next);
-        
-        //pop off everything
-        for(unsigned int i=0; i< stackvars.size(); i++)
-        {
-            funccode.push_back(new OPopRegister(new VarArgument(EXP2)));
-        }
-        
-        //if it's a main script, quit.
-        if(isarun)
-            funccode.push_back(new OQuit());
-        else
-        {
-            //pop off the return address
-            funccode.push_back(new OPopRegister(new VarArgument(EXP2)));
-            //and return
-            funccode.push_back(new OGotoRegister(new VarArgument(EXP2)));
-        }
-        
-        rval->funcs[lt.functionToLabel(symbols->getID(*it))]=funccode;
-        delete *it;
+        rval->funcs[it->label] = it->code;
     }
     
     //Z_message("yes");
@@ -1196,9 +1788,194 @@ IntermediateData *ScriptParser::generateOCode(FunctionData *fdata)
     return rval;
 }
 
+//Functions with this many opcodes or fewer, not counting the return, are copied into their callers
+static const size_t INLINE_LIMIT = 24;
+
+// Whether a function can be copied into its callers: it has to be short, end by popping the
+// return address and jumping to it, and only jump to its own labels, so it can't call anything.
+static bool canInline(int label, vector<Opcode *> &code)
+{
+    if(code.size() < 3 || code.size() - 2 > INLINE_LIMIT)
+        return false;
+        
+    OPopRegister *pop = dynamic_cast<OPopRegister *>(code[code.size() - 2]);
+    OGotoRegister *ret = dynamic_cast<OGotoRegister *>(code.back());
+    
+    if(!pop || !ret || pop->getLabel() != -1 || ret->getLabel() != -1
+            || pop->getArgument()->toString() != ret->getArgument()->toString())
+        return false;
+        
+    map<int, bool> defined;
+    map<int, bool> used;
+    
+    for(size_t i = 0; i < code.size() - 2; i++)
+    {
+        if(dynamic_cast<OGotoRegister *>(code[i]))
+            return false;
+            
+        if(code[i]->getLabel() != -1)
+            defined[code[i]->getLabel()] = true;
+            
+        GetLabels temp;
+        code[i]->execute(temp, &used);
+    }
+    
+    //recursive
+    if(used.find(label) != used.end())
+        return false;
+        
+    for(map<int, bool>::iterator it = used.begin(); it != used.end(); it++)
+    {
+        if(defined.find(it->first) == defined.end())
+            return false;
+    }
+    
+    return true;
+}
+
+// Replaces each call in code to a function in inlinable with a copy of the function. The
+// return address isn't pushed and the copy doesn't pop it, but the function still sets up
+// its own stack frame, so the offsets of its locals and parameters don't change.
+static bool inlineCalls(vector<Opcode *> &code, map<int, vector<Opcode *> *> &inlinable)
+{
+    vector<Opcode *> rval;
+    bool changed = false;
+    
+    for(size_t i = 0; i < code.size(); i++)
+    {
+        OGotoImmediate *call = dynamic_cast<OGotoImmediate *>(code[i]);
+        map<int, vector<Opcode *> *>::iterator callee = inlinable.end();
+        int retpush = -1;
+        
+        if(call && call->getLabel() == -1 && i + 1 < code.size() && code[i + 1]->getLabel() != -1)
+        {
+            map<int, bool> target;
+            GetLabels temp;
+            call->execute(temp, &target);
+            callee = inlinable.find(target.begin()->first);
+        }
+        
+        //find where the return address is pushed
+        if(callee != inlinable.end())
+        {
+            for(int j = int(rval.size()) - 2; j >= 0 && retpush == -1; j--)
+            {
+                if(!dynamic_cast<OSetImmediate *>(rval[j]))
+                    continue;
+                    
+                map<int, bool> labels;
+                GetLabels temp;
+                rval[j]->execute(temp, &labels);
+                
+                if(labels.find(code[i + 1]->getLabel()) != labels.end())
+                    retpush = j;
+            }
+        }
+        
+        if(retpush == -1 || rval[retpush]->getLabel() != -1 || rval[retpush + 1]->getLabel() != -1
+                || !dynamic_cast<OPushRegister *>(rval[retpush + 1]))
+        {
+            rval.push_back(code[i]);
+            continue;
+        }
+        
+        delete rval[retpush];
+        delete rval[retpush + 1];
+        rval.erase(rval.begin() + retpush, rval.begin() + retpush + 2);
+        delete code[i];
+        
+        //copy everything but the return, with new labels, and without the ones nothing jumps to
+        vector<Opcode *> &body = *callee->second;
+        map<int, bool> used;
+        map<int, int> relabel;
+        
+        for(size_t j = 0; j < body.size() - 2; j++)
+        {
+            GetLabels temp;
+            body[j]->execute(temp, &used);
+        }
+        
+        for(map<int, bool>::iterator it = used.begin(); it != used.end(); it++)
+            relabel[it->first] = ScriptParser::getUniqueLabelID();
+            
+        for(size_t j = 0; j < body.size() - 2; j++)
+        {
+            Opcode *op = body[j]->makeClone();
+            
+            if(op->getLabel() != -1)
+                op->setLabel(used.find(op->getLabel()) == used.end() ? -1 : relabel[op->getLabel()]);
+                
+            RenameLabels temp;
+            op->execute(temp, &relabel);
+            rval.push_back(op);
+        }
+        
+        changed = true;
+    }
+    
+    code.swap(rval);
+    return changed;
+}
+
+bool ScriptParser::inlineFunctions(IntermediateData *id)
+{
+    bool rval = false;
+    
+    //functions that only call inlined functions can be inlined in turn
+    for(int round = 0; round < 4; round++)
+    {
+        map<int, vector<Opcode *> *> inlinable;
+        
+        for(map<int, vector<Opcode *> >::iterator it = id->funcs.begin(); it != id->funcs.end(); it++)
+        {
+            if(canInline(it->first, it->second))
+                inlinable[it->first] = &it->second;
+        }
+        
+        bool changed = false;
+        
+        for(map<int, vector<Opcode *> >::iterator it = id->funcs.begin(); it != id->funcs.end(); it++)
+        {
+            if(inlinable.find(it->first) == inlinable.end())
+                changed |= inlineCalls(it->second, inlinable);
+        }
+        
+        if(!changed)
+            break;
+            
+        rval = true;
+    }
+    
+    return rval;
+}
+
+//A script to be assembled by assembleScript
+struct AssemblyJob
+{
+    string name;
+    vector<Opcode *> *code;
+    int numparams;
+    vector<Opcode *> result;
+};
+
+struct AssemblyJobs
+{
+    vector<AssemblyJob> jobs;
+    map<int, vector<Opcode *> > *funcs;
+};
+
+void ScriptParser::assembleScript(int i, void *param)
+{
+    AssemblyJobs *aj = (AssemblyJobs *)param;
+    AssemblyJob &job = aj->jobs[i];
+    job.result = assembleOne(*job.code, *aj->funcs, job.numparams);
+}
+
 ScriptsData *ScriptParser::assemble(IntermediateData *id)
 {
     //finally, finish off this bitch
+    //the assembled scripts outlive the compile, so they're made on the heap
+    CompileArena *arena = CompileArena::getCurrent();
     ScriptsData *rval = new ScriptsData;
     map<int, vector<Opcode *> > funcs = id->funcs;
     vector<Opcode *> ginit = id->globalsInit;
@@ -1226,16 +2003,36 @@ ScriptsData *ScriptParser::assemble(IntermediateData *id)
         ginit.push_back(new OGotoImmediate(new LabelArgument(label)));
     }
     
-    rval->theScripts["~Init"] = assembleOne(ginit, funcs, 0);
+    //each script is assembled separately, so they can be done at the same time
+    AssemblyJobs aj;
+    aj.funcs = &funcs;
+    aj.jobs.resize(scripts.size() + 1);
+    aj.jobs[0].name = "~Init";
+    aj.jobs[0].code = &ginit;
+    aj.jobs[0].numparams = 0;
     rval->scriptTypes["~Init"] = ScriptParser::TYPE_GLOBAL;
+    size_t i = 1;
     
-    for(map<string, int>::iterator it2 = scripts.begin(); it2 != scripts.end(); it2++)
+    for(map<string, int>::iterator it2 = scripts.begin(); it2 != scripts.end(); it2++, i++)
     {
-        vector<Opcode *> code = funcs[it2->second];
-        rval->theScripts[it2->first] = assembleOne(code, funcs, numparams[it2->first]);
+        aj.jobs[i].name = it2->first;
+        aj.jobs[i].code = &funcs[it2->second];
+        aj.jobs[i].numparams = numparams[it2->first];
         rval->scriptTypes[it2->first] = scripttypes[it2->first];
     }
     
+    CompileArena::setCurrent(NULL);
+    runJobs((int)aj.jobs.size(), assembleScript, &aj);
+    CompileArena::setCurrent(arena);
+    
+    for(vector<AssemblyJob>::iterator it2 = aj.jobs.begin(); it2 != aj.jobs.end(); it2++)
+        rval->theScripts[it2->name] = it2->result;
+        
+    
+    //the intermediate code goes when the arena does
+    if(arena)
+        return rval;
+        
     for(vector<Opcode *>::iterator it2 = ginit.begin(); it2 != ginit.end(); it2++)
     {
         delete *it2;
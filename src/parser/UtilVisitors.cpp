@@ -161,6 +161,9 @@ void Clone::caseArrayDecl(ASTArrayDecl &host, void *param)
     {
         l = new ASTArrayList(host.getLocation());
         
+        if(host.getList()->isString())
+            l->makeString();
+            
         for(list<ASTExpr *>::iterator it = host.getList()->getList().begin(); it != host.getList()->getList().end(); it++)
         {
             (*it)->execute(*this,param);
@@ -483,9 +486,10 @@ void Clone::caseBlock(ASTBlock &host, void *param)
 {
     ASTBlock *b = new ASTBlock(host.getLocation());
     list<ASTStmt *> stmts = host.getStatements();
-    list<ASTStmt *>::reverse_iterator it;
+    list<ASTStmt *>::iterator it;
     
-    for(it = stmts.rbegin(); it != stmts.rend(); it++)
+    //addStatement() appends, unlike the other lists' add functions
+    for(it = stmts.begin(); it != stmts.end(); it++)
     {
         (*it)->execute(*this,param);
         b->addStatement((ASTStmt *)result);
@@ -632,6 +636,878 @@ void Clone::caseStmtContinue(ASTStmtContinue &host, void *param)
     result = new ASTStmtContinue(host.getLocation());
 }
 ////////////////////////////////////////////////////////////////////////////////
+//Every node starts with a tag saying what it is and its location. Lists are written in the
+//order their add functions rebuild them in, and a missing optional child is AST_NONE.
+enum
+{
+    AST_NONE, AST_PROGRAM, AST_FLOAT, AST_STRING, AST_DECLLIST, AST_IMPORTDECL, AST_CONSTDECL,
+    AST_FUNCDECL, AST_TYPEFLOAT, AST_TYPEBOOL, AST_TYPEVOID, AST_TYPEFFC, AST_TYPEGLOBAL,
+    AST_TYPEITEM, AST_TYPEITEMCLASS, AST_TYPENPC, AST_TYPELWPN, AST_TYPEEWPN, AST_VARDECL,
+    AST_ARRAYDECL, AST_VARDECLINITIALIZER, AST_EXPRAND, AST_EXPROR, AST_EXPRGT, AST_EXPRGE,
+    AST_EXPRLT, AST_EXPRLE, AST_EXPREQ, AST_EXPRNE, AST_EXPRPLUS, AST_EXPRMINUS, AST_EXPRTIMES,
+    AST_EXPRDIVIDE, AST_EXPRBITOR, AST_EXPRBITXOR, AST_EXPRBITAND, AST_EXPRLSHIFT,
+    AST_EXPRRSHIFT, AST_EXPRMODULO, AST_EXPRNOT, AST_EXPRNEGATE, AST_EXPRBITNOT,
+    AST_EXPRINCREMENT, AST_EXPRPREINCREMENT, AST_EXPRDECREMENT, AST_EXPRPREDECREMENT,
+    AST_NUMCONSTANT, AST_FUNCCALL, AST_BOOLCONSTANT, AST_BLOCK, AST_STMTASSIGN, AST_EXPRDOT,
+    AST_EXPRARROW, AST_EXPRARRAY, AST_STMTFOR, AST_STMTIF, AST_STMTIFELSE, AST_STMTRETURN,
+    AST_STMTRETURNVAL, AST_STMTEMPTY, AST_SCRIPT, AST_STMTWHILE, AST_STMTDO, AST_STMTBREAK,
+    AST_STMTCONTINUE
+};
+
+void SaveAST::putInt(long value)
+{
+    for(int k = 0; k < 4; k++)
+        data += char((value >> (8 * k)) & 0xFF);
+}
+
+void SaveAST::putString(const string &str)
+{
+    putInt(long(str.size()));
+    data += str;
+}
+
+void SaveAST::putNode(int tag, AST &host)
+{
+    LocationData &loc = host.getLocation();
+    data += char(tag);
+    putInt(loc.first_line);
+    putInt(loc.last_line);
+    putInt(loc.first_column);
+    putInt(loc.last_column);
+    
+    map<string, int>::iterator it = files.find(loc.fname);
+    
+    if(it != files.end())
+        putInt(it->second);
+    else
+    {
+        int index = int(files.size());
+        files[loc.fname] = index;
+        putInt(index);
+        putString(loc.fname);
+    }
+}
+
+void SaveAST::putChild(AST *child)
+{
+    if(child)
+        child->execute(*this, NULL);
+    else
+        data += char(AST_NONE);
+}
+
+void SaveAST::putBinary(int tag, ASTBinaryExpr &host)
+{
+    putNode(tag, host);
+    putChild(host.getFirstOperand());
+    putChild(host.getSecondOperand());
+}
+
+void SaveAST::putUnary(int tag, ASTUnaryExpr &host)
+{
+    putNode(tag, host);
+    putChild(host.getOperand());
+}
+
+void SaveAST::caseDefault(void *)
+{
+    //unreachable
+    assert(false);
+}
+
+void SaveAST::caseProgram(ASTProgram &host, void *)
+{
+    putNode(AST_PROGRAM, host);
+    putChild(host.getDeclarations());
+}
+
+void SaveAST::caseFloat(ASTFloat &host, void *)
+{
+    putNode(AST_FLOAT, host);
+    putString(host.getValue());
+    putInt(host.getType());
+}
+
+void SaveAST::caseString(ASTString &host, void *)
+{
+    putNode(AST_STRING, host);
+    putString(host.getValue());
+}
+
+void SaveAST::caseDeclList(ASTDeclList &host, void *)
+{
+    putNode(AST_DECLLIST, host);
+    list<ASTDecl *> &decls = host.getDeclarations();
+    putInt(long(decls.size()));
+    
+    for(list<ASTDecl *>::reverse_iterator it = decls.rbegin(); it != decls.rend(); it++)
+        putChild(*it);
+}
+
+void SaveAST::caseImportDecl(ASTImportDecl &host, void *)
+{
+    putNode(AST_IMPORTDECL, host);
+    putString(host.getFilename());
+}
+
+void SaveAST::caseConstDecl(ASTConstDecl &host, void *)
+{
+    putNode(AST_CONSTDECL, host);
+    putString(host.getName());
+    putChild(host.getValue());
+}
+
+void SaveAST::caseFuncDecl(ASTFuncDecl &host, void *)
+{
+    putNode(AST_FUNCDECL, host);
+    putString(host.getName());
+    putChild(host.getReturnType());
+    putChild(host.getBlock());
+    list<ASTVarDecl *> &params = host.getParams();
+    putInt(long(params.size()));
+    
+    for(list<ASTVarDecl *>::reverse_iterator it = params.rbegin(); it != params.rend(); it++)
+        putChild(*it);
+}
+
+void SaveAST::caseTypeFloat(ASTTypeFloat &host, void *)
+{
+    putNode(AST_TYPEFLOAT, host);
+}
+
+void SaveAST::caseTypeBool(ASTTypeBool &host, void *)
+{
+    putNode(AST_TYPEBOOL, host);
+}
+
+void SaveAST::caseTypeVoid(ASTTypeVoid &host, void *)
+{
+    putNode(AST_TYPEVOID, host);
+}
+
+void SaveAST::caseTypeFFC(ASTTypeFFC &host, void *)
+{
+    putNode(AST_TYPEFFC, host);
+}
+
+void SaveAST::caseTypeGlobal(ASTTypeGlobal &host, void *)
+{
+    putNode(AST_TYPEGLOBAL, host);
+}
+
+void SaveAST::caseTypeItem(ASTTypeItem &host, void *)
+{
+    putNode(AST_TYPEITEM, host);
+}
+
+void SaveAST::caseTypeItemclass(ASTTypeItemclass &host, void *)
+{
+    putNode(AST_TYPEITEMCLASS, host);
+}
+
+void SaveAST::caseTypeNPC(ASTTypeNPC &host, void *)
+{
+    putNode(AST_TYPENPC, host);
+}
+
+void SaveAST::caseTypeLWpn(ASTTypeLWpn &host, void *)
+{
+    putNode(AST_TYPELWPN, host);
+}
+
+void SaveAST::caseTypeEWpn(ASTTypeEWpn &host, void *)
+{
+    putNode(AST_TYPEEWPN, host);
+}
+
+void SaveAST::caseVarDecl(ASTVarDecl &host, void *)
+{
+    putNode(AST_VARDECL, host);
+    putString(host.getName());
+    putChild(host.getType());
+}
+
+//The initializer list isn't visitable, so it's written as part of the declaration
+void SaveAST::caseArrayDecl(ASTArrayDecl &host, void *)
+{
+    putNode(AST_ARRAYDECL, host);
+    putString(host.getName());
+    putChild(host.getType());
+    putInt(host.isRegister());
+    putChild(host.getSize());
+    
+    ASTArrayList *l = host.getList();
+    putInt(l != NULL);
+    
+    if(l)
+    {
+        putInt(l->isString());
+        putInt(long(l->getList().size()));
+        
+        for(list<ASTExpr *>::iterator it = l->getList().begin(); it != l->getList().end(); it++)
+            putChild(*it);
+    }
+}
+
+void SaveAST::caseVarDeclInitializer(ASTVarDeclInitializer &host, void *)
+{
+    putNode(AST_VARDECLINITIALIZER, host);
+    putString(host.getName());
+    putChild(host.getType());
+    putChild(host.getInitializer());
+}
+
+void SaveAST::caseExprAnd(ASTExprAnd &host, void *)
+{
+    putBinary(AST_EXPRAND, host);
+}
+
+void SaveAST::caseExprOr(ASTExprOr &host, void *)
+{
+    putBinary(AST_EXPROR, host);
+}
+
+void SaveAST::caseExprGT(ASTExprGT &host, void *)
+{
+    putBinary(AST_EXPRGT, host);
+}
+
+void SaveAST::caseExprGE(ASTExprGE &host, void *)
+{
+    putBinary(AST_EXPRGE, host);
+}
+
+void SaveAST::caseExprLT(ASTExprLT &host, void *)
+{
+    putBinary(AST_EXPRLT, host);
+}
+
+void SaveAST::caseExprLE(ASTExprLE &host, void *)
+{
+    putBinary(AST_EXPRLE, host);
+}
+
+void SaveAST::caseExprEQ(ASTExprEQ &host, void *)
+{
+    putBinary(AST_EXPREQ, host);
+}
+
+void SaveAST::caseExprNE(ASTExprNE &host, void *)
+{
+    putBinary(AST_EXPRNE, host);
+}
+
+void SaveAST::caseExprPlus(ASTExprPlus &host, void *)
+{
+    putBinary(AST_EXPRPLUS, host);
+}
+
+void SaveAST::caseExprMinus(ASTExprMinus &host, void *)
+{
+    putBinary(AST_EXPRMINUS, host);
+}
+
+void SaveAST::caseExprTimes(ASTExprTimes &host, void *)
+{
+    putBinary(AST_EXPRTIMES, host);
+}
+
+void SaveAST::caseExprDivide(ASTExprDivide &host, void *)
+{
+    putBinary(AST_EXPRDIVIDE, host);
+}
+
+void SaveAST::caseExprBitOr(ASTExprBitOr &host, void *)
+{
+    putBinary(AST_EXPRBITOR, host);
+}
+
+void SaveAST::caseExprBitXor(ASTExprBitXor &host, void *)
+{
+    putBinary(AST_EXPRBITXOR, host);
+}
+
+void SaveAST::caseExprBitAnd(ASTExprBitAnd &host, void *)
+{
+    putBinary(AST_EXPRBITAND, host);
+}
+
+void SaveAST::caseExprLShift(ASTExprLShift &host, void *)
+{
+    putBinary(AST_EXPRLSHIFT, host);
+}
+
+void SaveAST::caseExprRShift(ASTExprRShift &host, void *)
+{
+    putBinary(AST_EXPRRSHIFT, host);
+}
+
+void SaveAST::caseExprModulo(ASTExprModulo &host, void *)
+{
+    putBinary(AST_EXPRMODULO, host);
+}
+
+void SaveAST::caseExprNot(ASTExprNot &host, void *)
+{
+    putUnary(AST_EXPRNOT, host);
+}
+
+void SaveAST::caseExprNegate(ASTExprNegate &host, void *)
+{
+    putUnary(AST_EXPRNEGATE, host);
+}
+
+void SaveAST::caseExprBitNot(ASTExprBitNot &host, void *)
+{
+    putUnary(AST_EXPRBITNOT, host);
+}
+
+void SaveAST::caseExprIncrement(ASTExprIncrement &host, void *)
+{
+    putUnary(AST_EXPRINCREMENT, host);
+}
+
+void SaveAST::caseExprPreIncrement(ASTExprPreIncrement &host, void *)
+{
+    putUnary(AST_EXPRPREINCREMENT, host);
+}
+
+void SaveAST::caseExprDecrement(ASTExprDecrement &host, void *)
+{
+    putUnary(AST_EXPRDECREMENT, host);
+}
+
+void SaveAST::caseExprPreDecrement(ASTExprPreDecrement &host, void *)
+{
+    putUnary(AST_EXPRPREDECREMENT, host);
+}
+
+void SaveAST::caseNumConstant(ASTNumConstant &host, void *)
+{
+    putNode(AST_NUMCONSTANT, host);
+    putChild(host.getValue());
+}
+
+void SaveAST::caseFuncCall(ASTFuncCall &host, void *)
+{
+    putNode(AST_FUNCCALL, host);
+    putChild(host.getName());
+    list<ASTExpr *> &params = host.getParams();
+    putInt(long(params.size()));
+    
+    for(list<ASTExpr *>::reverse_iterator it = params.rbegin(); it != params.rend(); it++)
+        putChild(*it);
+}
+
+void SaveAST::caseBoolConstant(ASTBoolConstant &host, void *)
+{
+    putNode(AST_BOOLCONSTANT, host);
+    putInt(host.getValue());
+}
+
+void SaveAST::caseBlock(ASTBlock &host, void *)
+{
+    putNode(AST_BLOCK, host);
+    list<ASTStmt *> &stmts = host.getStatements();
+    putInt(long(stmts.size()));
+    
+    for(list<ASTStmt *>::iterator it = stmts.begin(); it != stmts.end(); it++)
+        putChild(*it);
+}
+
+void SaveAST::caseStmtAssign(ASTStmtAssign &host, void *)
+{
+    putNode(AST_STMTASSIGN, host);
+    putChild(host.getLVal());
+    putChild(host.getRVal());
+}
+
+void SaveAST::caseExprDot(ASTExprDot &host, void *)
+{
+    putNode(AST_EXPRDOT, host);
+    putString(host.getNamespace());
+    putString(host.getName());
+}
+
+void SaveAST::caseExprArrow(ASTExprArrow &host, void *)
+{
+    putNode(AST_EXPRARROW, host);
+    putChild(host.getLVal());
+    putString(host.getName());
+    putChild(host.getIndex());
+}
+
+void SaveAST::caseExprArray(ASTExprArray &host, void *)
+{
+    putNode(AST_EXPRARRAY, host);
+    putString(host.getNamespace());
+    putString(host.getName());
+    putChild(host.getIndex());
+}
+
+void SaveAST::caseStmtFor(ASTStmtFor &host, void *)
+{
+    putNode(AST_STMTFOR, host);
+    putChild(host.getPrecondition());
+    putChild(host.getTerminationCondition());
+    putChild(host.getIncrement());
+    putChild(host.getStmt());
+}
+
+void SaveAST::caseStmtIf(ASTStmtIf &host, void *)
+{
+    putNode(AST_STMTIF, host);
+    putChild(host.getCondition());
+    putChild(host.getStmt());
+}
+
+void SaveAST::caseStmtIfElse(ASTStmtIfElse &host, void *)
+{
+    putNode(AST_STMTIFELSE, host);
+    putChild(host.getCondition());
+    putChild(host.getStmt());
+    putChild(host.getElseStmt());
+}
+
+void SaveAST::caseStmtReturn(ASTStmtReturn &host, void *)
+{
+    putNode(AST_STMTRETURN, host);
+}
+
+void SaveAST::caseStmtReturnVal(ASTStmtReturnVal &host, void *)
+{
+    putNode(AST_STMTRETURNVAL, host);
+    putChild(host.getReturnValue());
+}
+
+void SaveAST::caseStmtEmpty(ASTStmtEmpty &host, void *)
+{
+    putNode(AST_STMTEMPTY, host);
+}
+
+void SaveAST::caseScript(ASTScript &host, void *)
+{
+    putNode(AST_SCRIPT, host);
+    putString(host.getName());
+    putChild(host.getType());
+    putChild(host.getScriptBlock());
+}
+
+void SaveAST::caseStmtWhile(ASTStmtWhile &host, void *)
+{
+    putNode(AST_STMTWHILE, host);
+    putChild(host.getCond());
+    putChild(host.getStmt());
+}
+
+void SaveAST::caseStmtDo(ASTStmtDo &host, void *)
+{
+    putNode(AST_STMTDO, host);
+    putChild(host.getCond());
+    putChild(host.getStmt());
+}
+
+void SaveAST::caseStmtBreak(ASTStmtBreak &host, void *)
+{
+    putNode(AST_STMTBREAK, host);
+}
+
+void SaveAST::caseStmtContinue(ASTStmtContinue &host, void *)
+{
+    putNode(AST_STMTCONTINUE, host);
+}
+////////////////////////////////////////////////////////////////////////////////
+AST *LoadAST::getResult()
+{
+    AST *root = getNode();
+    
+    if(failed || pos != data.size())
+        return NULL;
+        
+    return root;
+}
+
+long LoadAST::getInt()
+{
+    if(data.size() - pos < 4)
+    {
+        failed = true;
+        pos = data.size();
+        return 0;
+    }
+    
+    unsigned long value = 0;
+    
+    for(int k = 0; k < 4; k++)
+        value |= (unsigned long)(unsigned char)data[pos++] << (8 * k);
+        
+    return long(int(value));
+}
+
+string LoadAST::getString()
+{
+    long size = getInt();
+    
+    if(size < 0 || size_t(size) > data.size() - pos)
+    {
+        failed = true;
+        pos = data.size();
+        return "";
+    }
+    
+    string str = data.substr(pos, size);
+    pos += size;
+    return str;
+}
+
+template<class T> AST *LoadAST::getBinary(LocationData &loc)
+{
+    T *expr = new T(loc);
+    expr->setFirstOperand(getChild<ASTExpr>());
+    expr->setSecondOperand(getChild<ASTExpr>());
+    return expr;
+}
+
+template<class T> AST *LoadAST::getUnary(LocationData &loc)
+{
+    T *expr = new T(loc);
+    expr->setOperand(getChild<ASTExpr>());
+    return expr;
+}
+
+AST *LoadAST::getNode()
+{
+    if(failed || pos >= data.size())
+    {
+        failed = true;
+        return NULL;
+    }
+    
+    int tag = (unsigned char)data[pos++];
+    
+    if(tag == AST_NONE)
+        return NULL;
+        
+    YYLTYPE yloc;
+    yloc.first_line = getInt();
+    yloc.last_line = getInt();
+    yloc.first_column = getInt();
+    yloc.last_column = getInt();
+    LocationData loc(yloc);
+    
+    long file = getInt();
+    
+    if(file == long(files.size()))
+        files.push_back(getString());
+    else if(file < 0 || file > long(files.size()))
+        failed = true;
+        
+    if(failed)
+        return NULL;
+        
+    loc.fname = files[file];
+    
+    switch(tag)
+    {
+    case AST_PROGRAM:
+        return new ASTProgram(getChild<ASTDeclList>(), loc);
+        
+    case AST_FLOAT:
+    {
+        string value = getString();
+        return new ASTFloat(value.c_str(), getInt(), loc);
+    }
+    
+    case AST_STRING:
+        return new ASTString(getString().c_str(), loc);
+        
+    case AST_DECLLIST:
+    {
+        ASTDeclList *dl = new ASTDeclList(loc);
+        
+        for(long count = getInt(); count > 0 && !failed; count--)
+            dl->addDeclaration(getChild<ASTDecl>());
+            
+        return dl;
+    }
+    
+    case AST_IMPORTDECL:
+        return new ASTImportDecl(getString(), loc);
+        
+    case AST_CONSTDECL:
+    {
+        string name = getString();
+        return new ASTConstDecl(name, getChild<ASTFloat>(), loc);
+    }
+    
+    case AST_FUNCDECL:
+    {
+        ASTFuncDecl *af = new ASTFuncDecl(loc);
+        af->setName(getString());
+        af->setReturnType(getChild<ASTType>());
+        af->setBlock(getChild<ASTBlock>());
+        
+        for(long count = getInt(); count > 0 && !failed; count--)
+            af->addParam(getChild<ASTVarDecl>());
+            
+        return af;
+    }
+    
+    case AST_TYPEFLOAT:
+        return new ASTTypeFloat(loc);
+        
+    case AST_TYPEBOOL:
+        return new ASTTypeBool(loc);
+        
+    case AST_TYPEVOID:
+        return new ASTTypeVoid(loc);
+        
+    case AST_TYPEFFC:
+        return new ASTTypeFFC(loc);
+        
+    case AST_TYPEGLOBAL:
+        return new ASTTypeGlobal(loc);
+        
+    case AST_TYPEITEM:
+        return new ASTTypeItem(loc);
+        
+    case AST_TYPEITEMCLASS:
+        return new ASTTypeItemclass(loc);
+        
+    case AST_TYPENPC:
+        return new ASTTypeNPC(loc);
+        
+    case AST_TYPELWPN:
+        return new ASTTypeLWpn(loc);
+        
+    case AST_TYPEEWPN:
+        return new ASTTypeEWpn(loc);
+        
+    case AST_VARDECL:
+    {
+        string name = getString();
+        return new ASTVarDecl(getChild<ASTType>(), name, loc);
+    }
+    
+    case AST_ARRAYDECL:
+    {
+        string name = getString();
+        ASTType *type = getChild<ASTType>();
+        bool reg = getInt() != 0;
+        AST *size = getChild<AST>();
+        ASTArrayList *l = NULL;
+        
+        if(getInt())
+        {
+            l = new ASTArrayList(loc);
+            
+            if(getInt())
+                l->makeString();
+                
+            for(long count = getInt(); count > 0 && !failed; count--)
+                l->addParam(getChild<ASTExpr>());
+        }
+        
+        return new ASTArrayDecl(type, name, size, reg, l, loc);
+    }
+    
+    case AST_VARDECLINITIALIZER:
+    {
+        string name = getString();
+        ASTType *type = getChild<ASTType>();
+        return new ASTVarDeclInitializer(type, name, getChild<ASTExpr>(), loc);
+    }
+    
+    case AST_EXPRAND:
+        return getBinary<ASTExprAnd>(loc);
+        
+    case AST_EXPROR:
+        return getBinary<ASTExprOr>(loc);
+        
+    case AST_EXPRGT:
+        return getBinary<ASTExprGT>(loc);
+        
+    case AST_EXPRGE:
+        return getBinary<ASTExprGE>(loc);
+        
+    case AST_EXPRLT:
+        return getBinary<ASTExprLT>(loc);
+        
+    case AST_EXPRLE:
+        return getBinary<ASTExprLE>(loc);
+        
+    case AST_EXPREQ:
+        return getBinary<ASTExprEQ>(loc);
+        
+    case AST_EXPRNE:
+        return getBinary<ASTExprNE>(loc);
+        
+    case AST_EXPRPLUS:
+        return getBinary<ASTExprPlus>(loc);
+        
+    case AST_EXPRMINUS:
+        return getBinary<ASTExprMinus>(loc);
+        
+    case AST_EXPRTIMES:
+        return getBinary<ASTExprTimes>(loc);
+        
+    case AST_EXPRDIVIDE:
+        return getBinary<ASTExprDivide>(loc);
+        
+    case AST_EXPRBITOR:
+        return getBinary<ASTExprBitOr>(loc);
+        
+    case AST_EXPRBITXOR:
+        return getBinary<ASTExprBitXor>(loc);
+        
+    case AST_EXPRBITAND:
+        return getBinary<ASTExprBitAnd>(loc);
+        
+    case AST_EXPRLSHIFT:
+        return getBinary<ASTExprLShift>(loc);
+        
+    case AST_EXPRRSHIFT:
+        return getBinary<ASTExprRShift>(loc);
+        
+    case AST_EXPRMODULO:
+        return getBinary<ASTExprModulo>(loc);
+        
+    case AST_EXPRNOT:
+        return getUnary<ASTExprNot>(loc);
+        
+    case AST_EXPRNEGATE:
+        return getUnary<ASTExprNegate>(loc);
+        
+    case AST_EXPRBITNOT:
+        return getUnary<ASTExprBitNot>(loc);
+        
+    case AST_EXPRINCREMENT:
+        return getUnary<ASTExprIncrement>(loc);
+        
+    case AST_EXPRPREINCREMENT:
+        return getUnary<ASTExprPreIncrement>(loc);
+        
+    case AST_EXPRDECREMENT:
+        return getUnary<ASTExprDecrement>(loc);
+        
+    case AST_EXPRPREDECREMENT:
+        return getUnary<ASTExprPreDecrement>(loc);
+        
+    case AST_NUMCONSTANT:
+        return new ASTNumConstant(getChild<ASTFloat>(), loc);
+        
+    case AST_FUNCCALL:
+    {
+        ASTFuncCall *fc = new ASTFuncCall(loc);
+        fc->setName(getChild<ASTExpr>());
+        
+        for(long count = getInt(); count > 0 && !failed; count--)
+            fc->addParam(getChild<ASTExpr>());
+            
+        return fc;
+    }
+    
+    case AST_BOOLCONSTANT:
+        return new ASTBoolConstant(getInt() != 0, loc);
+        
+    case AST_BLOCK:
+    {
+        ASTBlock *b = new ASTBlock(loc);
+        
+        for(long count = getInt(); count > 0 && !failed; count--)
+            b->addStatement(getChild<ASTStmt>());
+            
+        return b;
+    }
+    
+    case AST_STMTASSIGN:
+    {
+        ASTStmt *left = getChild<ASTStmt>();
+        return new ASTStmtAssign(left, getChild<ASTExpr>(), loc);
+    }
+    
+    case AST_EXPRDOT:
+    {
+        string nspace = getString();
+        return new ASTExprDot(nspace, getString(), loc);
+    }
+    
+    case AST_EXPRARROW:
+    {
+        ASTExpr *lval = getChild<ASTExpr>();
+        ASTExprArrow *arrow = new ASTExprArrow(lval, getString(), loc);
+        arrow->setIndex(getChild<ASTExpr>(true));
+        return arrow;
+    }
+    
+    case AST_EXPRARRAY:
+    {
+        string nspace = getString();
+        ASTExprArray *arr = new ASTExprArray(nspace, getString(), loc);
+        arr->setIndex(getChild<ASTExpr>(true));
+        return arr;
+    }
+    
+    case AST_STMTFOR:
+    {
+        ASTStmt *prec = getChild<ASTStmt>();
+        ASTExpr *cond = getChild<ASTExpr>();
+        ASTStmt *incr = getChild<ASTStmt>();
+        return new ASTStmtFor(prec, cond, incr, getChild<ASTStmt>(), loc);
+    }
+    
+    case AST_STMTIF:
+    {
+        ASTExpr *cond = getChild<ASTExpr>();
+        return new ASTStmtIf(cond, getChild<ASTStmt>(), loc);
+    }
+    
+    case AST_STMTIFELSE:
+    {
+        ASTExpr *cond = getChild<ASTExpr>();
+        ASTStmt *stmt = getChild<ASTStmt>();
+        return new ASTStmtIfElse(cond, stmt, getChild<ASTStmt>(), loc);
+    }
+    
+    case AST_STMTRETURN:
+        return new ASTStmtReturn(loc);
+        
+    case AST_STMTRETURNVAL:
+        return new ASTStmtReturnVal(getChild<ASTExpr>(), loc);
+        
+    case AST_STMTEMPTY:
+        return new ASTStmtEmpty(loc);
+        
+    case AST_SCRIPT:
+    {
+        string name = getString();
+        ASTType *type = getChild<ASTType>();
+        return new ASTScript(type, name, getChild<ASTDeclList>(), loc);
+    }
+    
+    case AST_STMTWHILE:
+    {
+        ASTExpr *cond = getChild<ASTExpr>();
+        return new ASTStmtWhile(cond, getChild<ASTStmt>(), loc);
+    }
+    
+    case AST_STMTDO:
+    {
+        ASTExpr *cond = getChild<ASTExpr>();
+        return new ASTStmtDo(cond, getChild<ASTStmt>(), loc);
+    }
+    
+    case AST_STMTBREAK:
+        return new ASTStmtBreak(loc);
+        
+    case AST_STMTCONTINUE:
+        return new ASTStmtContinue(loc);
+    }
+    
+    failed = true;
+    return NULL;
+}
+////////////////////////////////////////////////////////////////////////////////
 void GetImports::caseDefault(void *param)
 {
     if(param != NULL)
@@ -80,6 +80,131 @@ private:
     AST *result;
 };
 
+//Writes an AST out in a form LoadAST can read back, so parsed imports can be kept on disk
+class SaveAST : public ASTVisitor
+{
+public:
+    virtual void caseDefault(void *param);
+    virtual void caseProgram(ASTProgram &host, void *param);
+    virtual void caseFloat(ASTFloat &host, void *param);
+    virtual void caseString(ASTString &host, void *param);
+    virtual void caseDeclList(ASTDeclList &host, void *param);
+    virtual void caseImportDecl(ASTImportDecl &host, void *param);
+    virtual void caseConstDecl(ASTConstDecl &host, void *param);
+    virtual void caseFuncDecl(ASTFuncDecl &host, void *param);
+    virtual void caseTypeFloat(ASTTypeFloat &host, void *param);
+    virtual void caseTypeBool(ASTTypeBool &host, void *param);
+    virtual void caseTypeVoid(ASTTypeVoid &host, void *param);
+    virtual void caseTypeFFC(ASTTypeFFC &host, void *param);
+    virtual void caseTypeItem(ASTTypeItem &host, void *param);
+    virtual void caseTypeItemclass(ASTTypeItemclass &host, void *param);
+    virtual void caseTypeGlobal(ASTTypeGlobal &host, void *param);
+    virtual void caseTypeNPC(ASTTypeNPC &host, void *param);
+    virtual void caseTypeLWpn(ASTTypeLWpn &host, void *param);
+    virtual void caseTypeEWpn(ASTTypeEWpn &host, void *param);
+    virtual void caseVarDecl(ASTVarDecl &host, void *param);
+    virtual void caseArrayDecl(ASTArrayDecl &host, void *param);
+    virtual void caseVarDeclInitializer(ASTVarDeclInitializer &host, void *param);
+    virtual void caseExprAnd(ASTExprAnd &host, void *param);
+    virtual void caseExprOr(ASTExprOr &host, void *param);
+    virtual void caseExprGT(ASTExprGT &host, void *param);
+    virtual void caseExprGE(ASTExprGE &host, void *param);
+    virtual void caseExprLT(ASTExprLT &host, void *param);
+    virtual void caseExprLE(ASTExprLE &host, void *param);
+    virtual void caseExprEQ(ASTExprEQ &host, void *param);
+    virtual void caseExprNE(ASTExprNE &host, void *param);
+    virtual void caseExprPlus(ASTExprPlus &host, void *param);
+    virtual void caseExprMinus(ASTExprMinus &host, void *param);
+    virtual void caseExprTimes(ASTExprTimes &host, void *param);
+    virtual void caseExprDivide(ASTExprDivide &host, void *param);
+    virtual void caseExprNot(ASTExprNot &host, void *param);
+    virtual void caseExprNegate(ASTExprNegate &host, void *param);
+    virtual void caseNumConstant(ASTNumConstant &host, void *param);
+    virtual void caseFuncCall(ASTFuncCall &host, void *param);
+    virtual void caseBoolConstant(ASTBoolConstant &host, void *param);
+    virtual void caseBlock(ASTBlock &host, void *param);
+    virtual void caseStmtAssign(ASTStmtAssign &host, void *param);
+    virtual void caseExprDot(ASTExprDot &host, void *param);
+    virtual void caseExprArrow(ASTExprArrow &host, void *param);
+    virtual void caseExprArray(ASTExprArray &host, void *param);
+    virtual void caseStmtFor(ASTStmtFor &host, void *param);
+    virtual void caseStmtIf(ASTStmtIf &host, void *param);
+    virtual void caseStmtIfElse(ASTStmtIfElse &host, void *param);
+    virtual void caseStmtReturn(ASTStmtReturn &host, void *param);
+    virtual void caseStmtReturnVal(ASTStmtReturnVal &host, void *param);
+    virtual void caseStmtEmpty(ASTStmtEmpty &host, void *param);
+    virtual void caseScript(ASTScript &host, void *param);
+    virtual void caseStmtWhile(ASTStmtWhile &host, void *param);
+    virtual void caseStmtDo(ASTStmtDo &host, void *param);
+    virtual void caseExprBitOr(ASTExprBitOr &host, void *param);
+    virtual void caseExprBitXor(ASTExprBitXor &host, void *param);
+    virtual void caseExprBitAnd(ASTExprBitAnd &host, void *param);
+    virtual void caseExprLShift(ASTExprLShift &host, void *param);
+    virtual void caseExprRShift(ASTExprRShift &host, void *param);
+    virtual void caseExprModulo(ASTExprModulo &host, void *param);
+    virtual void caseExprBitNot(ASTExprBitNot &host, void *param);
+    virtual void caseExprIncrement(ASTExprIncrement &host, void *param);
+    virtual void caseExprPreIncrement(ASTExprPreIncrement &host, void *param);
+    virtual void caseExprDecrement(ASTExprDecrement &host, void *param);
+    virtual void caseExprPreDecrement(ASTExprPreDecrement &host, void *param);
+    virtual void caseStmtBreak(ASTStmtBreak &host, void *param);
+    virtual void caseStmtContinue(ASTStmtContinue &host, void *param);
+    
+    const string &getData()
+    {
+        return data;
+    }
+private:
+    string data;
+    //Each file name is written once, and then referred to by its index
+    map<string, int> files;
+    void putInt(long value);
+    void putString(const string &str);
+    void putNode(int tag, AST &host);
+    void putChild(AST *child);
+    void putBinary(int tag, ASTBinaryExpr &host);
+    void putUnary(int tag, ASTUnaryExpr &host);
+};
+
+//Rebuilds an AST from what SaveAST wrote
+class LoadAST
+{
+public:
+    LoadAST(const string &Data) : data(Data), pos(0), failed(false) {}
+    //NULL if the data's truncated or isn't something SaveAST wrote
+    AST *getResult();
+private:
+    const string &data;
+    size_t pos;
+    bool failed;
+    vector<string> files;
+    long getInt();
+    string getString();
+    AST *getNode();
+    //Reads a node and checks it's the kind expected; NULL is only allowed if optional
+    template<class T> T *getChild(bool optional = false)
+    {
+        AST *node = getNode();
+        
+        if(!node)
+        {
+            if(!optional)
+                failed = true;
+                
+            return NULL;
+        }
+        
+        T *child = dynamic_cast<T *>(node);
+        
+        if(!child)
+            failed = true;
+            
+        return child;
+    }
+    template<class T> AST *getBinary(LocationData &loc);
+    template<class T> AST *getUnary(LocationData &loc);
+};
+
 class RecursiveVisitor : public ASTVisitor
 {
 public:
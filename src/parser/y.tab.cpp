@@ -1874,9 +1874,7 @@ yyreduce:
 #line 121 "ffscript.ypp"
     {
         ASTVarDecl *vd = (ASTVarDecl *)(yyvsp[(1) - (4)]);
-        Clone c;
-        vd->getType()->execute(c,NULL);
-        (yyval) = new ASTVarDeclInitializer((ASTType *)c.getResult(), vd->getName(), (ASTExpr *)(yyvsp[(3) - (4)]),(yylsp[(1) - (4)]));
+        (yyval) = new ASTVarDeclInitializer(vd->releaseType(), vd->getName(), (ASTExpr *)(yyvsp[(3) - (4)]),(yylsp[(1) - (4)]));
         delete vd;;
     }
     break;
@@ -1884,14 +1882,14 @@ yyreduce:
     case 11:
     
         /* Line 1455 of yacc.c  */
-#line 126 "ffscript.ypp"
+#line 124 "ffscript.ypp"
     {(yyval) = (yyvsp[(1) - (2)]);;}
     break;
     
     case 12:
     
         /* Line 1455 of yacc.c  */
-#line 129 "ffscript.ypp"
+#line 127 "ffscript.ypp"
     {
         ASTString *name = (ASTString *)(yyvsp[(3) - (6)]);
         ASTFloat *val = (ASTFloat *)(yyvsp[(5) - (6)]);
@@ -1903,7 +1901,7 @@ yyreduce:
     case 13:
     
         /* Line 1455 of yacc.c  */
-#line 133 "ffscript.ypp"
+#line 131 "ffscript.ypp"
     {
         ASTString *name = (ASTString *)(yyvsp[(3) - (7)]);
         ASTFloat *val = (ASTFloat *)(yyvsp[(6) - (7)]);
@@ -1916,7 +1914,7 @@ yyreduce:
     case 14:
     
         /* Line 1455 of yacc.c  */
-#line 139 "ffscript.ypp"
+#line 137 "ffscript.ypp"
     {
         ASTType *type = (ASTType *)(yyvsp[(1) - (5)]);
         ASTString *name = (ASTString *)(yyvsp[(2) - (5)]);
@@ -1929,7 +1927,7 @@ yyreduce:
     case 15:
     
         /* Line 1455 of yacc.c  */
-#line 145 "ffscript.ypp"
+#line 143 "ffscript.ypp"
     {
         ASTType *type = (ASTType *)(yyvsp[(1) - (9)]);
         ASTString *name = (ASTString *)(yyvsp[(2) - (9)]);
@@ -1943,7 +1941,7 @@ yyreduce:
     case 16:
     
         /* Line 1455 of yacc.c  */
-#line 151 "ffscript.ypp"
+#line 149 "ffscript.ypp"
     {
         ASTType *type = (ASTType *)(yyvsp[(1) - (8)]);
         ASTString *name = (ASTString *)(yyvsp[(2) - (8)]);
@@ -1959,7 +1957,7 @@ yyreduce:
     case 17:
     
         /* Line 1455 of yacc.c  */
-#line 160 "ffscript.ypp"
+#line 158 "ffscript.ypp"
     {
         ASTType *type = (ASTType *)(yyvsp[(1) - (7)]);
         ASTString *name = (ASTString *)(yyvsp[(2) - (7)]);
@@ -1980,7 +1978,7 @@ yyreduce:
     case 18:
     
         /* Line 1455 of yacc.c  */
-#line 174 "ffscript.ypp"
+#line 172 "ffscript.ypp"
     {
         ASTType *type = (ASTType *)(yyvsp[(1) - (6)]);
         ASTString *name = (ASTString *)(yyvsp[(2) - (6)]);
@@ -2001,7 +1999,7 @@ yyreduce:
     case 19:
     
         /* Line 1455 of yacc.c  */
-#line 191 "ffscript.ypp"
+#line 189 "ffscript.ypp"
     {
         ASTArrayList *al = (ASTArrayList *)(yyvsp[(1) - (3)]);
         al->addParam((ASTExpr*)(yyvsp[(3) - (3)]));
@@ -2012,7 +2010,7 @@ yyreduce:
     case 20:
     
         /* Line 1455 of yacc.c  */
-#line 194 "ffscript.ypp"
+#line 192 "ffscript.ypp"
     {
         ASTArrayList *al = new ASTArrayList((yylsp[(1) - (1)]));
         al->addParam((ASTExpr *)(yyvsp[(1) - (1)]));
@@ -2023,7 +2021,7 @@ yyreduce:
     case 21:
     
         /* Line 1455 of yacc.c  */
-#line 199 "ffscript.ypp"
+#line 197 "ffscript.ypp"
     {
         ASTType *type = (ASTType *)(yyvsp[(1) - (4)]);
         int scripttype; //Itemdata pointer instead of item pointer
@@ -2047,21 +2045,21 @@ yyreduce:
     case 22:
     
         /* Line 1455 of yacc.c  */
-#line 215 "ffscript.ypp"
+#line 213 "ffscript.ypp"
     {(yyval) = (yyvsp[(1) - (1)]);;}
     break;
     
     case 23:
     
         /* Line 1455 of yacc.c  */
-#line 216 "ffscript.ypp"
+#line 214 "ffscript.ypp"
     {(yyval) = new ASTTypeGlobal((yylsp[(1) - (1)]));;}
     break;
     
     case 24:
     
         /* Line 1455 of yacc.c  */
-#line 219 "ffscript.ypp"
+#line 217 "ffscript.ypp"
     {
         ASTString *str = (ASTString *)(yyvsp[(2) - (2)]);
         (yyval) = new ASTImportDecl(str->getValue(),(yylsp[(1) - (2)]));
@@ -2072,21 +2070,21 @@ yyreduce:
     case 25:
     
         /* Line 1455 of yacc.c  */
-#line 224 "ffscript.ypp"
+#line 222 "ffscript.ypp"
     {(yyval) = (yyvsp[(2) - (3)]);;}
     break;
     
     case 26:
     
         /* Line 1455 of yacc.c  */
-#line 225 "ffscript.ypp"
+#line 223 "ffscript.ypp"
     {(yyval) = new ASTDeclList((yylsp[(1) - (2)]));;}
     break;
     
     case 27:
     
         /* Line 1455 of yacc.c  */
-#line 228 "ffscript.ypp"
+#line 226 "ffscript.ypp"
     {
         ASTDeclList *dl = (ASTDeclList *)(yyvsp[(2) - (2)]);
         dl->addDeclaration((ASTDecl *)(yyvsp[(1) - (2)]));
@@ -2097,7 +2095,7 @@ yyreduce:
     case 28:
     
         /* Line 1455 of yacc.c  */
-#line 231 "ffscript.ypp"
+#line 229 "ffscript.ypp"
     {
         ASTDeclList *dl = new ASTDeclList((yylsp[(1) - (1)]));
         dl->addDeclaration((ASTDecl *)(yyvsp[(1) - (1)]));
@@ -2108,26 +2106,24 @@ yyreduce:
     case 29:
     
         /* Line 1455 of yacc.c  */
-#line 236 "ffscript.ypp"
+#line 234 "ffscript.ypp"
     {(yyval) = (yyvsp[(1) - (2)]);;}
     break;
     
     case 30:
     
         /* Line 1455 of yacc.c  */
-#line 237 "ffscript.ypp"
+#line 235 "ffscript.ypp"
     {(yyval) = (yyvsp[(1) - (2)]);;}
     break;
     
     case 31:
     
         /* Line 1455 of yacc.c  */
-#line 238 "ffscript.ypp"
+#line 236 "ffscript.ypp"
     {
         ASTVarDecl *vd = (ASTVarDecl *)(yyvsp[(1) - (4)]);
-        Clone c;
-        vd->getType()->execute(c,NULL);
-        (yyval) = new ASTVarDeclInitializer((ASTType *)c.getResult(), vd->getName(), (ASTExpr *)(yyvsp[(3) - (4)]),(yylsp[(1) - (4)]));
+        (yyval) = new ASTVarDeclInitializer(vd->releaseType(), vd->getName(), (ASTExpr *)(yyvsp[(3) - (4)]),(yylsp[(1) - (4)]));
         delete vd;;
     }
     break;
@@ -2135,14 +2131,14 @@ yyreduce:
     case 32:
     
         /* Line 1455 of yacc.c  */
-#line 243 "ffscript.ypp"
+#line 239 "ffscript.ypp"
     {(yyval) = (yyvsp[(1) - (1)]);;}
     break;
     
     case 33:
     
         /* Line 1455 of yacc.c  */
-#line 246 "ffscript.ypp"
+#line 242 "ffscript.ypp"
     {
         ASTType *type = (ASTType *)(yyvsp[(1) - (2)]);
         ASTString *name = (ASTString *)(yyvsp[(2) - (2)]);
@@ -2154,70 +2150,70 @@ yyreduce:
     case 34:
     
         /* Line 1455 of yacc.c  */
-#line 252 "ffscript.ypp"
+#line 248 "ffscript.ypp"
     {(yyval) = new ASTTypeFloat((yylsp[(1) - (1)]));;}
     break;
     
     case 35:
     
         /* Line 1455 of yacc.c  */
-#line 253 "ffscript.ypp"
+#line 249 "ffscript.ypp"
     {(yyval) = new ASTTypeBool((yylsp[(1) - (1)]));;}
     break;
     
     case 36:
     
         /* Line 1455 of yacc.c  */
-#line 254 "ffscript.ypp"
+#line 250 "ffscript.ypp"
     {(yyval) = new ASTTypeVoid((yylsp[(1) - (1)]));;}
     break;
     
     case 37:
     
         /* Line 1455 of yacc.c  */
-#line 255 "ffscript.ypp"
+#line 251 "ffscript.ypp"
     {(yyval) = new ASTTypeFFC((yylsp[(1) - (1)]));;}
     break;
     
     case 38:
     
         /* Line 1455 of yacc.c  */
-#line 256 "ffscript.ypp"
+#line 252 "ffscript.ypp"
     {(yyval) = new ASTTypeItem((yylsp[(1) - (1)]));;}
     break;
     
     case 39:
     
         /* Line 1455 of yacc.c  */
-#line 257 "ffscript.ypp"
+#line 253 "ffscript.ypp"
     {(yyval) = new ASTTypeItemclass((yylsp[(1) - (1)]));;}
     break;
     
     case 40:
     
         /* Line 1455 of yacc.c  */
-#line 258 "ffscript.ypp"
+#line 254 "ffscript.ypp"
     {(yyval) = new ASTTypeNPC((yylsp[(1) - (1)]));;}
     break;
     
     case 41:
     
         /* Line 1455 of yacc.c  */
-#line 259 "ffscript.ypp"
+#line 255 "ffscript.ypp"
     {(yyval) = new ASTTypeLWpn((yylsp[(1) - (1)]));;}
     break;
     
     case 42:
     
         /* Line 1455 of yacc.c  */
-#line 260 "ffscript.ypp"
+#line 256 "ffscript.ypp"
     {(yyval) = new ASTTypeEWpn((yylsp[(1) - (1)]));;}
     break;
     
     case 43:
     
         /* Line 1455 of yacc.c  */
-#line 263 "ffscript.ypp"
+#line 259 "ffscript.ypp"
     {
         ASTFuncDecl *fd = (ASTFuncDecl *)(yyvsp[(4) - (6)]);
         ASTType *rettype = (ASTType *)(yyvsp[(1) - (6)]);
@@ -2234,7 +2230,7 @@ yyreduce:
     case 44:
     
         /* Line 1455 of yacc.c  */
-#line 272 "ffscript.ypp"
+#line 268 "ffscript.ypp"
     {
         ASTFuncDecl *fd = new ASTFuncDecl((yylsp[(1) - (5)]));
         ASTType *rettype = (ASTType *)(yyvsp[(1) - (5)]);
@@ -2251,7 +2247,7 @@ yyreduce:
     case 45:
     
         /* Line 1455 of yacc.c  */
-#line 283 "ffscript.ypp"
+#line 279 "ffscript.ypp"
     {
         ASTFuncDecl *fd = (ASTFuncDecl *)(yyvsp[(3) - (3)]);
         fd->addParam((ASTVarDecl *)(yyvsp[(1) - (3)]));
@@ -2262,7 +2258,7 @@ yyreduce:
     case 46:
     
         /* Line 1455 of yacc.c  */
-#line 286 "ffscript.ypp"
+#line 282 "ffscript.ypp"
     {
         ASTFuncDecl *fd = new ASTFuncDecl((yylsp[(1) - (1)]));
         fd->addParam((ASTVarDecl *)(yyvsp[(1) - (1)]));
@@ -2273,21 +2269,21 @@ yyreduce:
     case 47:
     
         /* Line 1455 of yacc.c  */
-#line 291 "ffscript.ypp"
+#line 287 "ffscript.ypp"
     {(yyval)=(yyvsp[(2) - (3)]);;}
     break;
     
     case 48:
     
         /* Line 1455 of yacc.c  */
-#line 292 "ffscript.ypp"
+#line 288 "ffscript.ypp"
     {(yyval) = new ASTBlock((yylsp[(1) - (2)]));;}
     break;
     
     case 49:
     
         /* Line 1455 of yacc.c  */
-#line 295 "ffscript.ypp"
+#line 291 "ffscript.ypp"
     {
         ASTBlock *block = (ASTBlock *)(yyvsp[(1) - (2)]);
         ASTStmt *stmt = (ASTStmt *)(yyvsp[(2) - (2)]);
@@ -2299,7 +2295,7 @@ yyreduce:
     case 50:
     
         /* Line 1455 of yacc.c  */
-#line 299 "ffscript.ypp"
+#line 295 "ffscript.ypp"
     {
         ASTBlock *block = new ASTBlock((yylsp[(1) - (1)]));
         ASTStmt *stmt = (ASTStmt *)(yyvsp[(1) - (1)]);
@@ -2311,308 +2307,308 @@ yyreduce:
     case 51:
     
         /* Line 1455 of yacc.c  */
-#line 305 "ffscript.ypp"
+#line 301 "ffscript.ypp"
     {(yyval) = (yyvsp[(1) - (2)]);;}
     break;
     
     case 52:
     
         /* Line 1455 of yacc.c  */
-#line 306 "ffscript.ypp"
+#line 302 "ffscript.ypp"
     {(yyval) = (yyvsp[(1) - (2)]);;}
     break;
     
     case 53:
     
         /* Line 1455 of yacc.c  */
-#line 307 "ffscript.ypp"
+#line 303 "ffscript.ypp"
     {(yyval) = (yyvsp[(1) - (2)]);;}
     break;
     
     case 54:
     
         /* Line 1455 of yacc.c  */
-#line 308 "ffscript.ypp"
+#line 304 "ffscript.ypp"
     {(yyval)=(yyvsp[(1) - (2)]);;}
     break;
     
     case 55:
     
         /* Line 1455 of yacc.c  */
-#line 309 "ffscript.ypp"
+#line 305 "ffscript.ypp"
     {(yyval) = (yyvsp[(1) - (1)]);;}
     break;
     
     case 56:
     
         /* Line 1455 of yacc.c  */
-#line 310 "ffscript.ypp"
+#line 306 "ffscript.ypp"
     {(yyval) = (yyvsp[(1) - (1)]);;}
     break;
     
     case 57:
     
         /* Line 1455 of yacc.c  */
-#line 311 "ffscript.ypp"
+#line 307 "ffscript.ypp"
     {(yyval) = (yyvsp[(1) - (1)]);;}
     break;
     
     case 58:
     
         /* Line 1455 of yacc.c  */
-#line 312 "ffscript.ypp"
+#line 308 "ffscript.ypp"
     {(yyval) = (yyvsp[(1) - (2)]);;}
     break;
     
     case 59:
     
         /* Line 1455 of yacc.c  */
-#line 313 "ffscript.ypp"
+#line 309 "ffscript.ypp"
     {(yyval) = (yyvsp[(1) - (1)]);;}
     break;
     
     case 60:
     
         /* Line 1455 of yacc.c  */
-#line 314 "ffscript.ypp"
+#line 310 "ffscript.ypp"
     {(yyval) = (yyvsp[(1) - (1)]);;}
     break;
     
     case 61:
     
         /* Line 1455 of yacc.c  */
-#line 315 "ffscript.ypp"
+#line 311 "ffscript.ypp"
     {(yyval) = new ASTStmtEmpty((yylsp[(1) - (1)]));;}
     break;
     
     case 62:
     
         /* Line 1455 of yacc.c  */
-#line 316 "ffscript.ypp"
+#line 312 "ffscript.ypp"
     {(yyval)=(yyvsp[(1) - (2)]);;}
     break;
     
     case 63:
     
         /* Line 1455 of yacc.c  */
-#line 317 "ffscript.ypp"
+#line 313 "ffscript.ypp"
     {(yyval) = new ASTStmtBreak((yylsp[(1) - (2)]));;}
     break;
     
     case 64:
     
         /* Line 1455 of yacc.c  */
-#line 318 "ffscript.ypp"
+#line 314 "ffscript.ypp"
     {(yyval) = new ASTStmtContinue((yylsp[(1) - (2)]));;}
     break;
     
     case 65:
     
         /* Line 1455 of yacc.c  */
-#line 321 "ffscript.ypp"
+#line 317 "ffscript.ypp"
     {(yyval) = (yyvsp[(1) - (1)]);;}
     break;
     
     case 66:
     
         /* Line 1455 of yacc.c  */
-#line 322 "ffscript.ypp"
+#line 318 "ffscript.ypp"
     {(yyval) = (yyvsp[(1) - (1)]);;}
     break;
     
     case 67:
     
         /* Line 1455 of yacc.c  */
-#line 323 "ffscript.ypp"
+#line 319 "ffscript.ypp"
     {(yyval) = (yyvsp[(1) - (1)]);;}
     break;
     
     case 68:
     
         /* Line 1455 of yacc.c  */
-#line 324 "ffscript.ypp"
+#line 320 "ffscript.ypp"
     {(yyval)=(yyvsp[(1) - (1)]);;}
     break;
     
     case 69:
     
         /* Line 1455 of yacc.c  */
-#line 325 "ffscript.ypp"
+#line 321 "ffscript.ypp"
     {(yyval) = (yyvsp[(1) - (1)]);;}
     break;
     
     case 70:
     
         /* Line 1455 of yacc.c  */
-#line 326 "ffscript.ypp"
+#line 322 "ffscript.ypp"
     {(yyval) = (yyvsp[(1) - (1)]);;}
     break;
     
     case 71:
     
         /* Line 1455 of yacc.c  */
-#line 327 "ffscript.ypp"
+#line 323 "ffscript.ypp"
     {(yyval) = (yyvsp[(1) - (1)]);;}
     break;
     
     case 72:
     
         /* Line 1455 of yacc.c  */
-#line 328 "ffscript.ypp"
+#line 324 "ffscript.ypp"
     {(yyval) = (yyvsp[(1) - (1)]);;}
     break;
     
     case 73:
     
         /* Line 1455 of yacc.c  */
-#line 329 "ffscript.ypp"
+#line 325 "ffscript.ypp"
     {(yyval) = (yyvsp[(1) - (1)]);;}
     break;
     
     case 74:
     
         /* Line 1455 of yacc.c  */
-#line 330 "ffscript.ypp"
+#line 326 "ffscript.ypp"
     {(yyval) = (yyvsp[(1) - (1)]);;}
     break;
     
     case 75:
     
         /* Line 1455 of yacc.c  */
-#line 331 "ffscript.ypp"
+#line 327 "ffscript.ypp"
     {(yyval) = new ASTStmtEmpty(noloc);;}
     break;
     
     case 76:
     
         /* Line 1455 of yacc.c  */
-#line 332 "ffscript.ypp"
+#line 328 "ffscript.ypp"
     {(yyval)=(yyvsp[(1) - (1)]);;}
     break;
     
     case 77:
     
         /* Line 1455 of yacc.c  */
-#line 333 "ffscript.ypp"
+#line 329 "ffscript.ypp"
     {(yyval) = new ASTStmtBreak((yylsp[(1) - (1)]));;}
     break;
     
     case 78:
     
         /* Line 1455 of yacc.c  */
-#line 334 "ffscript.ypp"
+#line 330 "ffscript.ypp"
     {(yyval) = new ASTStmtContinue((yylsp[(1) - (1)]));;}
     break;
     
     case 79:
     
         /* Line 1455 of yacc.c  */
-#line 337 "ffscript.ypp"
+#line 333 "ffscript.ypp"
     {SHORTCUT(ASTExprPlus,(yyvsp[(1) - (3)]),(yyvsp[(3) - (3)]),(yyval),(yylsp[(1) - (3)]),(yylsp[(2) - (3)])) ;}
     break;
     
     case 80:
     
         /* Line 1455 of yacc.c  */
-#line 338 "ffscript.ypp"
+#line 334 "ffscript.ypp"
     {SHORTCUT(ASTExprMinus,(yyvsp[(1) - (3)]),(yyvsp[(3) - (3)]),(yyval),(yylsp[(1) - (3)]),(yylsp[(2) - (3)])) ;}
     break;
     
     case 81:
     
         /* Line 1455 of yacc.c  */
-#line 339 "ffscript.ypp"
+#line 335 "ffscript.ypp"
     {SHORTCUT(ASTExprTimes,(yyvsp[(1) - (3)]),(yyvsp[(3) - (3)]),(yyval),(yylsp[(1) - (3)]),(yylsp[(2) - (3)])) ;}
     break;
     
     case 82:
     
         /* Line 1455 of yacc.c  */
-#line 340 "ffscript.ypp"
+#line 336 "ffscript.ypp"
     {SHORTCUT(ASTExprDivide,(yyvsp[(1) - (3)]),(yyvsp[(3) - (3)]),(yyval),(yylsp[(1) - (3)]),(yylsp[(2) - (3)])) ;}
     break;
     
     case 83:
     
         /* Line 1455 of yacc.c  */
-#line 341 "ffscript.ypp"
+#line 337 "ffscript.ypp"
     {SHORTCUT(ASTExprAnd,(yyvsp[(1) - (3)]),(yyvsp[(3) - (3)]),(yyval),(yylsp[(1) - (3)]),(yylsp[(2) - (3)])) ;}
     break;
     
     case 84:
     
         /* Line 1455 of yacc.c  */
-#line 342 "ffscript.ypp"
+#line 338 "ffscript.ypp"
     {SHORTCUT(ASTExprOr,(yyvsp[(1) - (3)]),(yyvsp[(3) - (3)]),(yyval),(yylsp[(1) - (3)]),(yylsp[(2) - (3)])) ;}
     break;
     
     case 85:
     
         /* Line 1455 of yacc.c  */
-#line 343 "ffscript.ypp"
+#line 339 "ffscript.ypp"
     {SHORTCUT(ASTExprBitAnd,(yyvsp[(1) - (3)]),(yyvsp[(3) - (3)]),(yyval),(yylsp[(1) - (3)]),(yylsp[(2) - (3)])) ;}
     break;
     
     case 86:
     
         /* Line 1455 of yacc.c  */
-#line 344 "ffscript.ypp"
+#line 340 "ffscript.ypp"
     {SHORTCUT(ASTExprBitOr,(yyvsp[(1) - (3)]),(yyvsp[(3) - (3)]),(yyval),(yylsp[(1) - (3)]),(yylsp[(2) - (3)])) ;}
     break;
     
     case 87:
     
         /* Line 1455 of yacc.c  */
-#line 345 "ffscript.ypp"
+#line 341 "ffscript.ypp"
     {SHORTCUT(ASTExprBitXor,(yyvsp[(1) - (3)]),(yyvsp[(3) - (3)]),(yyval),(yylsp[(1) - (3)]),(yylsp[(2) - (3)])) ;}
     break;
     
     case 88:
     
         /* Line 1455 of yacc.c  */
-#line 346 "ffscript.ypp"
+#line 342 "ffscript.ypp"
     {SHORTCUT(ASTExprLShift,(yyvsp[(1) - (3)]),(yyvsp[(3) - (3)]),(yyval),(yylsp[(1) - (3)]),(yylsp[(2) - (3)])) ;}
     break;
     
     case 89:
     
         /* Line 1455 of yacc.c  */
-#line 347 "ffscript.ypp"
+#line 343 "ffscript.ypp"
     {SHORTCUT(ASTExprRShift,(yyvsp[(1) - (3)]),(yyvsp[(3) - (3)]),(yyval),(yylsp[(1) - (3)]),(yylsp[(2) - (3)])) ;}
     break;
     
     case 90:
     
         /* Line 1455 of yacc.c  */
-#line 348 "ffscript.ypp"
+#line 344 "ffscript.ypp"
     {SHORTCUT(ASTExprModulo,(yyvsp[(1) - (3)]),(yyvsp[(3) - (3)]),(yyval),(yylsp[(1) - (3)]),(yylsp[(2) - (3)])) ;}
     break;
     
     case 91:
     
         /* Line 1455 of yacc.c  */
-#line 352 "ffscript.ypp"
+#line 348 "ffscript.ypp"
     {(yyval) = new ASTStmtAssign((ASTStmt *)(yyvsp[(1) - (3)]), (ASTExpr *)(yyvsp[(3) - (3)]),(yylsp[(1) - (3)]));;}
     break;
     
     case 92:
     
         /* Line 1455 of yacc.c  */
-#line 355 "ffscript.ypp"
+#line 351 "ffscript.ypp"
     {(yyval) = (yyvsp[(1) - (1)]);;}
     break;
     
     case 93:
     
         /* Line 1455 of yacc.c  */
-#line 356 "ffscript.ypp"
+#line 352 "ffscript.ypp"
     {(yyval) = (yyvsp[(1) - (1)]);;}
     break;
     
     case 94:
     
         /* Line 1455 of yacc.c  */
-#line 359 "ffscript.ypp"
+#line 355 "ffscript.ypp"
     {
         ASTString *lval = (ASTString *)(yyvsp[(1) - (3)]);
         ASTString *rval = (ASTString *)(yyvsp[(3) - (3)]);
@@ -2625,7 +2621,7 @@ yyreduce:
     case 95:
     
         /* Line 1455 of yacc.c  */
-#line 363 "ffscript.ypp"
+#line 359 "ffscript.ypp"
     {
         ASTString *name = (ASTString *)(yyvsp[(1) - (4)]);
         ASTExpr *num = (ASTExpr *)(yyvsp[(3) - (4)]);
@@ -2639,7 +2635,7 @@ yyreduce:
     case 96:
     
         /* Line 1455 of yacc.c  */
-#line 369 "ffscript.ypp"
+#line 365 "ffscript.ypp"
     {
         ASTString *name = (ASTString *)(yyvsp[(1) - (6)]);
         ASTString *name2 = (ASTString *)(yyvsp[(3) - (6)]);
@@ -2655,7 +2651,7 @@ yyreduce:
     case 97:
     
         /* Line 1455 of yacc.c  */
-#line 377 "ffscript.ypp"
+#line 373 "ffscript.ypp"
     {
         ASTString *rval = (ASTString *)(yyvsp[(1) - (1)]);
         (yyval) = new ASTExprDot("", rval->getValue(),(yylsp[(1) - (1)]));
@@ -2666,7 +2662,7 @@ yyreduce:
     case 98:
     
         /* Line 1455 of yacc.c  */
-#line 380 "ffscript.ypp"
+#line 376 "ffscript.ypp"
     {
         ASTExpr *id = (ASTExpr *)(yyvsp[(1) - (3)]);
         ASTString *rval = (ASTString *)(yyvsp[(3) - (3)]);
@@ -2678,7 +2674,7 @@ yyreduce:
     case 99:
     
         /* Line 1455 of yacc.c  */
-#line 384 "ffscript.ypp"
+#line 380 "ffscript.ypp"
     {
         ASTExpr *id = (ASTExpr *)(yyvsp[(1) - (6)]);
         ASTString *rval = (ASTString *)(yyvsp[(3) - (6)]);
@@ -2692,7 +2688,7 @@ yyreduce:
     case 100:
     
         /* Line 1455 of yacc.c  */
-#line 392 "ffscript.ypp"
+#line 388 "ffscript.ypp"
     {
         ASTLogExpr *e = new ASTExprOr((yylsp[(2) - (3)]));
         ASTExpr *left = (ASTExpr *)(yyvsp[(1) - (3)]);
@@ -2706,14 +2702,14 @@ yyreduce:
     case 101:
     
         /* Line 1455 of yacc.c  */
-#line 398 "ffscript.ypp"
+#line 394 "ffscript.ypp"
     {(yyval)=(yyvsp[(1) - (1)]);;}
     break;
     
     case 102:
     
         /* Line 1455 of yacc.c  */
-#line 401 "ffscript.ypp"
+#line 397 "ffscript.ypp"
     {
         ASTLogExpr *e = new ASTExprAnd((yylsp[(2) - (3)]));
         ASTExpr *left = (ASTExpr *)(yyvsp[(1) - (3)]);
@@ -2727,14 +2723,14 @@ yyreduce:
     case 103:
     
         /* Line 1455 of yacc.c  */
-#line 407 "ffscript.ypp"
+#line 403 "ffscript.ypp"
     {(yyval)=(yyvsp[(1) - (1)]);;}
     break;
     
     case 104:
     
         /* Line 1455 of yacc.c  */
-#line 410 "ffscript.ypp"
+#line 406 "ffscript.ypp"
     {
         ASTBitExpr *e = new ASTExprBitOr((yylsp[(2) - (3)]));
         ASTExpr *left = (ASTExpr *)(yyvsp[(1) - (3)]);
@@ -2748,14 +2744,14 @@ yyreduce:
     case 105:
     
         /* Line 1455 of yacc.c  */
-#line 416 "ffscript.ypp"
+#line 412 "ffscript.ypp"
     {(yyval)=(yyvsp[(1) - (1)]);;}
     break;
     
     case 106:
     
         /* Line 1455 of yacc.c  */
-#line 419 "ffscript.ypp"
+#line 415 "ffscript.ypp"
     {
         ASTBitExpr *e = new ASTExprBitXor((yylsp[(2) - (3)]));
         ASTExpr *left = (ASTExpr *)(yyvsp[(1) - (3)]);
@@ -2769,14 +2765,14 @@ yyreduce:
     case 107:
     
         /* Line 1455 of yacc.c  */
-#line 425 "ffscript.ypp"
+#line 421 "ffscript.ypp"
     {(yyval) = (yyvsp[(1) - (1)]);;}
     break;
     
     case 108:
     
         /* Line 1455 of yacc.c  */
-#line 428 "ffscript.ypp"
+#line 424 "ffscript.ypp"
     {
         ASTBitExpr *e = new ASTExprBitAnd((yylsp[(2) - (3)]));
         ASTExpr *left = (ASTExpr *)(yyvsp[(1) - (3)]);
@@ -2790,14 +2786,14 @@ yyreduce:
     case 109:
     
         /* Line 1455 of yacc.c  */
-#line 434 "ffscript.ypp"
+#line 430 "ffscript.ypp"
     {(yyval)=(yyvsp[(1) - (1)]);;}
     break;
     
     case 110:
     
         /* Line 1455 of yacc.c  */
-#line 437 "ffscript.ypp"
+#line 433 "ffscript.ypp"
     {
         ASTRelExpr *e = (ASTRelExpr *)(yyvsp[(2) - (3)]);
         ASTExpr *left = (ASTExpr *)(yyvsp[(1) - (3)]);
@@ -2811,14 +2807,14 @@ yyreduce:
     case 111:
     
         /* Line 1455 of yacc.c  */
-#line 443 "ffscript.ypp"
+#line 439 "ffscript.ypp"
     {(yyval) = (yyvsp[(1) - (1)]);;}
     break;
     
     case 112:
     
         /* Line 1455 of yacc.c  */
-#line 446 "ffscript.ypp"
+#line 442 "ffscript.ypp"
     {
         ASTShiftExpr *e = (ASTShiftExpr *)(yyvsp[(2) - (3)]);
         ASTExpr *left = (ASTExpr *)(yyvsp[(1) - (3)]);
@@ -2832,70 +2828,70 @@ yyreduce:
     case 113:
     
         /* Line 1455 of yacc.c  */
-#line 452 "ffscript.ypp"
+#line 448 "ffscript.ypp"
     {(yyval)=(yyvsp[(1) - (1)]);;}
     break;
     
     case 114:
     
         /* Line 1455 of yacc.c  */
-#line 455 "ffscript.ypp"
+#line 451 "ffscript.ypp"
     {(yyval) = new ASTExprLShift((yylsp[(1) - (1)]));;}
     break;
     
     case 115:
     
         /* Line 1455 of yacc.c  */
-#line 456 "ffscript.ypp"
+#line 452 "ffscript.ypp"
     {(yyval) = new ASTExprRShift((yylsp[(1) - (1)]));;}
     break;
     
     case 116:
     
         /* Line 1455 of yacc.c  */
-#line 459 "ffscript.ypp"
+#line 455 "ffscript.ypp"
     {(yyval) = new ASTExprGT((yylsp[(1) - (1)]));;}
     break;
     
     case 117:
     
         /* Line 1455 of yacc.c  */
-#line 460 "ffscript.ypp"
+#line 456 "ffscript.ypp"
     {(yyval) = new ASTExprGE((yylsp[(1) - (1)]));;}
     break;
     
     case 118:
     
         /* Line 1455 of yacc.c  */
-#line 461 "ffscript.ypp"
+#line 457 "ffscript.ypp"
     {(yyval) = new ASTExprLT((yylsp[(1) - (1)]));;}
     break;
     
     case 119:
     
         /* Line 1455 of yacc.c  */
-#line 462 "ffscript.ypp"
+#line 458 "ffscript.ypp"
     {(yyval) = new ASTExprLE((yylsp[(1) - (1)]));;}
     break;
     
     case 120:
     
         /* Line 1455 of yacc.c  */
-#line 463 "ffscript.ypp"
+#line 459 "ffscript.ypp"
     {(yyval) = new ASTExprEQ((yylsp[(1) - (1)]));;}
     break;
     
     case 121:
     
         /* Line 1455 of yacc.c  */
-#line 464 "ffscript.ypp"
+#line 460 "ffscript.ypp"
     {(yyval) = new ASTExprNE((yylsp[(1) - (1)]));;}
     break;
     
     case 122:
     
         /* Line 1455 of yacc.c  */
-#line 467 "ffscript.ypp"
+#line 463 "ffscript.ypp"
     {
         ASTAddExpr *e = (ASTAddExpr *)(yyvsp[(2) - (3)]);
         ASTExpr *left = (ASTExpr *)(yyvsp[(1) - (3)]);
@@ -2909,28 +2905,28 @@ yyreduce:
     case 123:
     
         /* Line 1455 of yacc.c  */
-#line 473 "ffscript.ypp"
+#line 469 "ffscript.ypp"
     {(yyval) = (yyvsp[(1) - (1)]);;}
     break;
     
     case 124:
     
         /* Line 1455 of yacc.c  */
-#line 476 "ffscript.ypp"
+#line 472 "ffscript.ypp"
     {(yyval) = new ASTExprPlus((yylsp[(1) - (1)]));;}
     break;
     
     case 125:
     
         /* Line 1455 of yacc.c  */
-#line 477 "ffscript.ypp"
+#line 473 "ffscript.ypp"
     {(yyval) = new ASTExprMinus((yylsp[(1) - (1)]));;}
     break;
     
     case 126:
     
         /* Line 1455 of yacc.c  */
-#line 480 "ffscript.ypp"
+#line 476 "ffscript.ypp"
     {
         ASTMultExpr *e = (ASTMultExpr *)(yyvsp[(2) - (3)]);
         ASTExpr *left = (ASTExpr *)(yyvsp[(1) - (3)]);
@@ -2944,35 +2940,35 @@ yyreduce:
     case 127:
     
         /* Line 1455 of yacc.c  */
-#line 486 "ffscript.ypp"
+#line 482 "ffscript.ypp"
     {(yyval)=(yyvsp[(1) - (1)]);;}
     break;
     
     case 128:
     
         /* Line 1455 of yacc.c  */
-#line 489 "ffscript.ypp"
+#line 485 "ffscript.ypp"
     {(yyval) = new ASTExprTimes((yylsp[(1) - (1)]));;}
     break;
     
     case 129:
     
         /* Line 1455 of yacc.c  */
-#line 490 "ffscript.ypp"
+#line 486 "ffscript.ypp"
     {(yyval) = new ASTExprDivide((yylsp[(1) - (1)]));;}
     break;
     
     case 130:
     
         /* Line 1455 of yacc.c  */
-#line 491 "ffscript.ypp"
+#line 487 "ffscript.ypp"
     {(yyval) = new ASTExprModulo((yylsp[(1) - (1)]));;}
     break;
     
     case 131:
     
         /* Line 1455 of yacc.c  */
-#line 494 "ffscript.ypp"
+#line 490 "ffscript.ypp"
     {
         ASTUnaryExpr *e = new ASTExprNot((yylsp[(1) - (2)]));
         ASTExpr *op = (ASTExpr *)(yyvsp[(2) - (2)]);
@@ -2984,7 +2980,7 @@ yyreduce:
     case 132:
     
         /* Line 1455 of yacc.c  */
-#line 498 "ffscript.ypp"
+#line 494 "ffscript.ypp"
     {
         ASTUnaryExpr *e = new ASTExprNegate((yylsp[(1) - (2)]));
         ASTExpr *op = (ASTExpr *)(yyvsp[(2) - (2)]);
@@ -2996,7 +2992,7 @@ yyreduce:
     case 133:
     
         /* Line 1455 of yacc.c  */
-#line 502 "ffscript.ypp"
+#line 498 "ffscript.ypp"
     {
         ASTUnaryExpr *e = new ASTExprBitNot((yylsp[(1) - (2)]));
         ASTExpr *op = (ASTExpr *)(yyvsp[(2) - (2)]);
@@ -3008,28 +3004,28 @@ yyreduce:
     case 134:
     
         /* Line 1455 of yacc.c  */
-#line 506 "ffscript.ypp"
+#line 502 "ffscript.ypp"
     {(yyval)=(yyvsp[(1) - (1)]);;}
     break;
     
     case 135:
     
         /* Line 1455 of yacc.c  */
-#line 509 "ffscript.ypp"
+#line 505 "ffscript.ypp"
     {(yyval)=(yyvsp[(2) - (3)]);;}
     break;
     
     case 136:
     
         /* Line 1455 of yacc.c  */
-#line 510 "ffscript.ypp"
+#line 506 "ffscript.ypp"
     {(yyval) = (yyvsp[(1) - (1)]);;}
     break;
     
     case 137:
     
         /* Line 1455 of yacc.c  */
-#line 511 "ffscript.ypp"
+#line 507 "ffscript.ypp"
     {
         ASTUnaryExpr *e = new ASTExprIncrement((yylsp[(2) - (2)]));
         ASTExpr *op = (ASTExpr *)(yyvsp[(1) - (2)]);
@@ -3041,7 +3037,7 @@ yyreduce:
     case 138:
     
         /* Line 1455 of yacc.c  */
-#line 515 "ffscript.ypp"
+#line 511 "ffscript.ypp"
     {
         ASTUnaryExpr *e = new ASTExprPreIncrement((yylsp[(1) - (2)]));
         ASTExpr *op = (ASTExpr *)(yyvsp[(2) - (2)]);
@@ -3053,7 +3049,7 @@ yyreduce:
     case 139:
     
         /* Line 1455 of yacc.c  */
-#line 519 "ffscript.ypp"
+#line 515 "ffscript.ypp"
     {
         ASTUnaryExpr *e = new ASTExprDecrement((yylsp[(2) - (2)]));
         ASTExpr *op = (ASTExpr *)(yyvsp[(1) - (2)]);
@@ -3065,7 +3061,7 @@ yyreduce:
     case 140:
     
         /* Line 1455 of yacc.c  */
-#line 523 "ffscript.ypp"
+#line 519 "ffscript.ypp"
     {
         ASTUnaryExpr *e = new ASTExprPreDecrement((yylsp[(1) - (2)]));
         ASTExpr *op = (ASTExpr *)(yyvsp[(2) - (2)]);
@@ -3077,7 +3073,7 @@ yyreduce:
     case 141:
     
         /* Line 1455 of yacc.c  */
-#line 527 "ffscript.ypp"
+#line 523 "ffscript.ypp"
     {
         ASTFloat *val = (ASTFloat *)(yyvsp[(1) - (1)]);
         (yyval) = new ASTNumConstant(val,(yylsp[(1) - (1)]));;
@@ -3087,7 +3083,7 @@ yyreduce:
     case 142:
     
         /* Line 1455 of yacc.c  */
-#line 529 "ffscript.ypp"
+#line 525 "ffscript.ypp"
     {
         ASTString *as = (ASTString *)(yyvsp[(1) - (1)]);
         char val[15];
@@ -3099,35 +3095,35 @@ yyreduce:
     case 143:
     
         /* Line 1455 of yacc.c  */
-#line 533 "ffscript.ypp"
+#line 529 "ffscript.ypp"
     {(yyval) = (yyvsp[(1) - (1)]);;}
     break;
     
     case 144:
     
         /* Line 1455 of yacc.c  */
-#line 534 "ffscript.ypp"
+#line 530 "ffscript.ypp"
     {(yyval)=(yyvsp[(1) - (1)]);;}
     break;
     
     case 145:
     
         /* Line 1455 of yacc.c  */
-#line 537 "ffscript.ypp"
+#line 533 "ffscript.ypp"
     {(yyval) = new ASTBoolConstant(true,(yylsp[(1) - (1)]));;}
     break;
     
     case 146:
     
         /* Line 1455 of yacc.c  */
-#line 538 "ffscript.ypp"
+#line 534 "ffscript.ypp"
     {(yyval) = new ASTBoolConstant(false,(yylsp[(1) - (1)]));;}
     break;
     
     case 147:
     
         /* Line 1455 of yacc.c  */
-#line 541 "ffscript.ypp"
+#line 537 "ffscript.ypp"
     {
         ASTFuncCall *fc = (ASTFuncCall *)(yyvsp[(3) - (4)]);
         ASTExpr *name = (ASTExpr *)(yyvsp[(1) - (4)]);
@@ -3139,7 +3135,7 @@ yyreduce:
     case 148:
     
         /* Line 1455 of yacc.c  */
-#line 545 "ffscript.ypp"
+#line 541 "ffscript.ypp"
     {
         ASTFuncCall *fc = new ASTFuncCall((yylsp[(1) - (3)]));
         ASTExpr *name = (ASTExpr *)(yyvsp[(1) - (3)]);
@@ -3151,7 +3147,7 @@ yyreduce:
     case 149:
     
         /* Line 1455 of yacc.c  */
-#line 551 "ffscript.ypp"
+#line 547 "ffscript.ypp"
     {
         ASTFuncCall *fc = (ASTFuncCall *)(yyvsp[(3) - (3)]);
         ASTExpr *e = (ASTExpr *)(yyvsp[(1) - (3)]);
@@ -3163,7 +3159,7 @@ yyreduce:
     case 150:
     
         /* Line 1455 of yacc.c  */
-#line 555 "ffscript.ypp"
+#line 551 "ffscript.ypp"
     {
         ASTFuncCall *fc = new ASTFuncCall((yylsp[(1) - (1)]));
         ASTExpr *e = (ASTExpr *)(yyvsp[(1) - (1)]);
@@ -3175,7 +3171,7 @@ yyreduce:
     case 151:
     
         /* Line 1455 of yacc.c  */
-#line 561 "ffscript.ypp"
+#line 557 "ffscript.ypp"
     {
         ASTStmt *prec = (ASTStmt *)(yyvsp[(3) - (9)]);
         ASTExpr *term = (ASTExpr *)(yyvsp[(5) - (9)]);
@@ -3188,7 +3184,7 @@ yyreduce:
     case 152:
     
         /* Line 1455 of yacc.c  */
-#line 568 "ffscript.ypp"
+#line 564 "ffscript.ypp"
     {
         ASTExpr *cond = (ASTExpr *)(yyvsp[(3) - (5)]);
         ASTStmt *stmt = (ASTStmt *)(yyvsp[(5) - (5)]);
@@ -3199,7 +3195,7 @@ yyreduce:
     case 153:
     
         /* Line 1455 of yacc.c  */
-#line 572 "ffscript.ypp"
+#line 568 "ffscript.ypp"
     {
         ASTExpr *cond = (ASTExpr *)(yyvsp[(5) - (6)]);
         ASTStmt *stmt = (ASTStmt *)(yyvsp[(2) - (6)]);
@@ -3210,7 +3206,7 @@ yyreduce:
     case 154:
     
         /* Line 1455 of yacc.c  */
-#line 576 "ffscript.ypp"
+#line 572 "ffscript.ypp"
     {
         ASTExpr *cond = (ASTExpr *)(yyvsp[(3) - (5)]);
         ASTStmt *stmt = (ASTStmt *)(yyvsp[(5) - (5)]);
@@ -3221,7 +3217,7 @@ yyreduce:
     case 155:
     
         /* Line 1455 of yacc.c  */
-#line 579 "ffscript.ypp"
+#line 575 "ffscript.ypp"
     {
         ASTExpr *cond = (ASTExpr *)(yyvsp[(3) - (7)]);
         ASTStmt *ifstmt = (ASTStmt *)(yyvsp[(5) - (7)]);
@@ -3233,14 +3229,14 @@ yyreduce:
     case 156:
     
         /* Line 1455 of yacc.c  */
-#line 585 "ffscript.ypp"
+#line 581 "ffscript.ypp"
     {(yyval) = new ASTStmtReturnVal((ASTExpr *)(yyvsp[(2) - (2)]),(yylsp[(1) - (2)]));;}
     break;
     
     case 157:
     
         /* Line 1455 of yacc.c  */
-#line 586 "ffscript.ypp"
+#line 582 "ffscript.ypp"
     {(yyval) = new ASTStmtReturn((yylsp[(1) - (1)]));;}
     break;
     
@@ -3488,7 +3484,7 @@ yyreturn:
 
 
 /* Line 1675 of yacc.c  */
-#line 589 "ffscript.ypp"
+#line 585 "ffscript.ypp"
 
 
 /*        programs */
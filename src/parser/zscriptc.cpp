@@ -0,0 +1,344 @@
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// modified version 3 of the GNU General Public License. See License.txt for details.
+
+//Compiles a ZScript file without ZQuest, printing how long each pass took and how much memory
+//it used, and how many opcodes each script came to. For benchmarking the compiler and for
+//compiling scripts in batches.
+//
+//  zscriptc [-I dir]... [-zasm dir] [-gotolessnotequal] [-O0] [-j n] [-repeat n] [-cache file] file.z
+
+#include "../precompiled.h" //always first
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+#include <string>
+#include <vector>
+#include <map>
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__APPLE__)
+#include <mach/mach_time.h>
+#else
+#include <time.h>
+#include <sys/time.h>
+#endif
+
+#include "Compiler.h"
+#include "../mutex.h"
+
+using std::string;
+using std::vector;
+using std::map;
+
+bool gotoless_not_equal = false; // Used by BuildVisitors.cpp
+
+void box_out(const char *msg)
+{
+    fputs(msg, stdout);
+}
+
+void box_eol()
+{
+    fputc('\n', stdout);
+}
+
+// Every allocation is counted, so each pass can report the most it had in use at once.
+// The size is kept in front of the block so it can be taken off again when it's freed.
+// With -j the counts are locked, since the compiler allocates from several threads.
+static size_t heap_current = 0;
+static size_t heap_peak = 0;
+static unsigned long heap_allocations = 0;
+static bool heap_locking = false;
+static mutex heap_lock;
+
+union alloc_header
+{
+    size_t size;
+    double align;
+    void *palign;
+};
+
+static void *counted_alloc(size_t size)
+{
+    alloc_header *h = (alloc_header *)malloc(sizeof(alloc_header) + size);
+    
+    if(!h)
+        throw std::bad_alloc();
+    
+    h->size = size;
+    
+    if(heap_locking)
+        mutex_lock(&heap_lock);
+        
+    heap_current += size;
+    heap_allocations++;
+    
+    if(heap_current > heap_peak)
+        heap_peak = heap_current;
+        
+    if(heap_locking)
+        mutex_unlock(&heap_lock);
+        
+    return h + 1;
+}
+
+static void counted_free(void *p)
+{
+    if(!p)
+        return;
+    
+    alloc_header *h = (alloc_header *)p - 1;
+    
+    if(heap_locking)
+        mutex_lock(&heap_lock);
+        
+    heap_current -= h->size;
+    
+    if(heap_locking)
+        mutex_unlock(&heap_lock);
+        
+    free(h);
+}
+
+void *operator new(size_t size)
+{
+    return counted_alloc(size);
+}
+
+void *operator new[](size_t size)
+{
+    return counted_alloc(size);
+}
+
+void operator delete(void *p)
+{
+    counted_free(p);
+}
+
+void operator delete[](void *p)
+{
+    counted_free(p);
+}
+
+#ifdef __cpp_sized_deallocation
+void operator delete(void *p, size_t)
+{
+    counted_free(p);
+}
+
+void operator delete[](void *p, size_t)
+{
+    counted_free(p);
+}
+#endif
+
+static double now_ms()
+{
+#if defined(_WIN32)
+    LARGE_INTEGER count, freq;
+    QueryPerformanceCounter(&count);
+    QueryPerformanceFrequency(&freq);
+    return count.QuadPart * 1000.0 / freq.QuadPart;
+#elif defined(__APPLE__)
+    static mach_timebase_info_data_t base;
+    
+    if(base.denom == 0)
+        mach_timebase_info(&base);
+    
+    return mach_absolute_time() * (double)base.numer / base.denom / 1000000.0;
+#elif defined(CLOCK_MONOTONIC)
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+#else
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+#endif
+}
+
+struct phase_stats
+{
+    string name;
+    double ms;
+    size_t peak;
+    size_t live;
+    unsigned long allocations;
+    unsigned long arena_objects;
+};
+
+static vector<phase_stats> phases;
+static double phase_start;
+static unsigned long phase_allocations;
+static unsigned long phase_arena_objects;
+
+// The AST and intermediate code go in the compile's arena rather than on the heap, so they're
+// counted separately
+static unsigned long arena_objects()
+{
+    CompileArena *arena = CompileArena::getCurrent();
+    return arena ? arena->getObjectCount() : 0;
+}
+
+static void start_phase()
+{
+    heap_peak = heap_current;
+    phase_allocations = heap_allocations;
+    phase_arena_objects = arena_objects();
+    phase_start = now_ms();
+}
+
+static void phase_done(const char *phase)
+{
+    phase_stats s;
+    s.ms = now_ms() - phase_start;
+    s.name = phase;
+    s.peak = heap_peak;
+    s.live = heap_current;
+    s.allocations = heap_allocations - phase_allocations;
+    s.arena_objects = arena_objects() - phase_arena_objects;
+    phases.push_back(s);
+    start_phase();
+}
+
+static void usage()
+{
+    fprintf(stderr, "Usage: zscriptc [-I dir]... [-zasm dir] [-gotolessnotequal] [-O0] [-j n] [-repeat n] [-cache file] file.z\n");
+    fprintf(stderr, "  -I dir              Look in dir for imports not found in the working directory\n");
+    fprintf(stderr, "  -zasm dir           Write each script's ZASM to dir/<script>.zasm\n");
+    fprintf(stderr, "  -gotolessnotequal   Compile as with the \"Old GOTOLESS Behavior\" quest rule on\n");
+    fprintf(stderr, "  -O0                 Don't optimize the object code\n");
+    fprintf(stderr, "  -j n                Generate and assemble code on n threads\n");
+    fprintf(stderr, "  -repeat n           Compile n times and report the last, as when recompiling in ZQuest\n");
+    fprintf(stderr, "  -cache file         Keep parsed imports in file, so later runs don't parse them again\n");
+}
+
+int main(int argc, char *argv[])
+{
+    const char *filename = NULL;
+    const char *zasmdir = NULL;
+    int repeat = 1;
+    
+    for(int i = 1; i < argc; i++)
+    {
+        if(!strcmp(argv[i], "-I") && i + 1 < argc)
+            ScriptParser::addIncludePath(argv[++i]);
+        else if(!strncmp(argv[i], "-I", 2) && argv[i][2])
+            ScriptParser::addIncludePath(argv[i] + 2);
+        else if(!strcmp(argv[i], "-zasm") && i + 1 < argc)
+            zasmdir = argv[++i];
+        else if(!strcmp(argv[i], "-gotolessnotequal"))
+            gotoless_not_equal = true;
+        else if(!strcmp(argv[i], "-O0"))
+            ScriptParser::setOptimizing(false);
+        else if(!strcmp(argv[i], "-j") && i + 1 < argc && atoi(argv[i + 1]) > 0)
+        {
+            ScriptParser::setThreads(atoi(argv[++i]));
+            heap_locking = ScriptParser::getThreads() > 1;
+            
+            if(heap_locking)
+                mutex_init(&heap_lock);
+        }
+        else if(!strcmp(argv[i], "-repeat") && i + 1 < argc && atoi(argv[i + 1]) > 0)
+            repeat = atoi(argv[++i]);
+        else if(!strcmp(argv[i], "-cache") && i + 1 < argc)
+            ScriptParser::setImportCacheFile(argv[++i]);
+        else if(argv[i][0] != '-' && !filename)
+            filename = argv[i];
+        else
+        {
+            usage();
+            return 2;
+        }
+    }
+    
+    if(!filename)
+    {
+        usage();
+        return 2;
+    }
+    
+    ScriptsData *result = NULL;
+    double total_ms = 0;
+    
+    for(int i = 0; i < repeat; i++)
+    {
+        if(result)
+        {
+            for(map<string, vector<Opcode *> >::iterator it = result->theScripts.begin(); it != result->theScripts.end(); it++)
+            {
+                for(vector<Opcode *>::iterator line = it->second.begin(); line != it->second.end(); line++)
+                    delete *line;
+            }
+            
+            delete result;
+        }
+        
+        phases.clear();
+        double total_start = now_ms();
+        start_phase();
+        result = compile(filename, phase_done);
+        total_ms = now_ms() - total_start;
+        
+        if(!result)
+            break;
+    }
+    
+    printf("\n%-16s %10s %12s %12s %12s %12s\n", "Pass", "ms", "peak KB", "live KB", "allocations", "arena objs");
+    
+    for(vector<phase_stats>::iterator it = phases.begin(); it != phases.end(); it++)
+        printf("%-16s %10.2f %12.1f %12.1f %12lu %12lu\n", it->name.c_str(), it->ms, it->peak / 1024.0, it->live / 1024.0, it->allocations, it->arena_objects);
+    
+    printf("%-16s %10.2f\n", "Total", total_ms);
+    
+    if(!result)
+        return 1;
+    
+    printf("\n%-32s %-10s %8s\n", "Script", "Type", "Opcodes");
+    size_t total_opcodes = 0;
+    
+    for(map<string, vector<Opcode *> >::iterator it = result->theScripts.begin(); it != result->theScripts.end(); it++)
+    {
+        printf("%-32s %-10s %8u\n", it->first.c_str(), ScriptParser::printType(result->scriptTypes[it->first]).c_str(), (unsigned)it->second.size());
+        total_opcodes += it->second.size();
+    }
+    
+    printf("%-32s %-10s %8u\n", "Total", "", (unsigned)total_opcodes);
+    int ret = 0;
+    
+    if(zasmdir)
+    {
+        for(map<string, vector<Opcode *> >::iterator it = result->theScripts.begin(); it != result->theScripts.end(); it++)
+        {
+            string path = string(zasmdir) + "/" + it->first + ".zasm";
+            FILE *f = fopen(path.c_str(), "w");
+            
+            if(!f)
+            {
+                fprintf(stderr, "Can't write %s\n", path.c_str());
+                ret = 1;
+                continue;
+            }
+            
+            for(vector<Opcode *>::iterator line = it->second.begin(); line != it->second.end(); line++)
+            {
+                string theline = (*line)->printLine();
+                fwrite(theline.c_str(), sizeof(char), theline.size(), f);
+            }
+            
+            fclose(f);
+        }
+    }
+    
+    for(map<string, vector<Opcode *> >::iterator it = result->theScripts.begin(); it != result->theScripts.end(); it++)
+    {
+        for(vector<Opcode *>::iterator line = it->second.begin(); line != it->second.end(); line++)
+            delete *line;
+    }
+    
+    delete result;
+    return ret;
+}
@@ -7880,6 +7880,7 @@ int readffscript(PACKFILE *f, zquestheader *Header, bool keepdata)
         }
     }
     
+    decodeZScripts(); //After the bindings, which can still change the scripts
     return 0;
 }
 
@@ -7970,6 +7971,8 @@ void reset_scripts()
         linkscripts[i] = new ffscript[1];
         linkscripts[i][0].command = 0xFFFF;
     }
+    
+    decodeZScripts();
 }
 
 int read_one_ffscript(PACKFILE *f, zquestheader *, bool keepdata, int , word s_version, word , ffscript **script)
@@ -7977,7 +7980,7 @@ int read_one_ffscript(PACKFILE *f, zquestheader *, bool keepdata, int , word s_v
 
     //Please also update loadquest() when modifying this method -DD
     ffscript temp_script;
-    temp_script.ptr=NULL;
+    long temp_arg1 = 0, temp_arg2 = 0; //Stored as longs in the quest
     long num_commands=1000;
     
     if(s_version>=2)
@@ -8018,12 +8021,12 @@ int read_one_ffscript(PACKFILE *f, zquestheader *, bool keepdata, int , word s_v
             }
             else
             {
-                if(!p_igetl(&(temp_script.arg1),f,keepdata))
+                if(!p_igetl(&temp_arg1,f,keepdata))
                 {
                     return qe_invalid;
                 }
                 
-                if(!p_igetl(&(temp_script.arg2),f,keepdata))
+                if(!p_igetl(&temp_arg2,f,keepdata))
                 {
                     return qe_invalid;
                 }
@@ -8032,14 +8035,8 @@ int read_one_ffscript(PACKFILE *f, zquestheader *, bool keepdata, int , word s_v
             if(keepdata)
             {
                 (*script)[j].command = temp_script.command;
-                (*script)[j].arg1 = temp_script.arg1;
-                (*script)[j].arg2 = temp_script.arg2;
-                // I'll comment this out until the whole routine is finished using ptr
-                //if(is_string_command(temp_script.command))
-                //{
-                //( *script)[j].ptr=(char *)zc_malloc(256);
-                //memcpy((*script)[j].ptr, temp_script.ptr, 256);
-                //}
+                (*script)[j].arg1 = temp_arg1;
+                (*script)[j].arg2 = temp_arg2;
             }
         }
     }
@@ -12,6 +12,7 @@ public:
     long a[2]; //a regsisters (reference to another ffc on screen)
     byte sp; //stack pointer for current script
     dword scriptflag; //stores whether various operations were true/false etc.
+    dword waitframes; //frames left to skip after a WAITFRAMESR
     
     byte ffcref, idata; //current object pointers
     dword itemref, guyref, lwpn, ewpn;
@@ -19,6 +20,7 @@ public:
     
     refInfo();
     void Clear();
+    void ClearState(); //Everything but the d and a registers, for when they're about to be set anyway
 };
 
 #endif
@@ -0,0 +1,164 @@
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// modified version 3 of the GNU General Public License. See License.txt for details.
+
+
+#include "precompiled.h" //always first
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include "spatialIndex.h"
+
+SpatialIndex::SpatialIndex(sprite_list &l) : list(l), valid(false), count(0)
+{
+}
+
+void SpatialIndex::invalidate()
+{
+    valid = false;
+}
+
+int SpatialIndex::column(const double x)
+{
+    const double c = floor(x / CELL_SIZE);
+    return c < 0 ? 0 : (c >= COLUMNS ? COLUMNS - 1 : int(c));
+}
+
+int SpatialIndex::row(const double y)
+{
+    const double r = floor(y / CELL_SIZE);
+    return r < 0 ? 0 : (r >= ROWS ? ROWS - 1 : int(r));
+}
+
+// Counting sort of the sprites into cells
+void SpatialIndex::update()
+{
+    // In case sprites were added or removed without an invalidate()
+    if(valid && count == list.Count())
+        return;
+    
+    count = list.Count();
+    int cell[SLMAX];
+    memset(cellStart, 0, sizeof(cellStart));
+    
+    for(int i = 0; i < count; i++)
+    {
+        sprite *s = list.spr(i);
+        xs[i] = int(s->x);
+        ys[i] = int(s->y);
+        cell[i] = row(ys[i]) * COLUMNS + column(xs[i]);
+        cellStart[cell[i] + 1]++;
+    }
+    
+    for(int c = 0; c < CELLS; c++)
+        cellStart[c + 1] += cellStart[c];
+    
+    int next[CELLS];
+    memcpy(next, cellStart, sizeof(next));
+    
+    for(int i = 0; i < count; i++)
+        cellSprites[next[cell[i]]++] = i;
+    
+    valid = true;
+}
+
+// Orders indices by distance, then by index
+struct nearer
+{
+    const double *dist;
+    
+    nearer(const double *d) : dist(d) {}
+    
+    bool operator()(const int a, const int b) const
+    {
+        return dist[a] < dist[b] || (dist[a] == dist[b] && a < b);
+    }
+};
+
+int SpatialIndex::inRadius(const long x, const long y, const long radius, int *results)
+{
+    if(radius < 0)
+        return 0;
+    
+    update();
+    
+    const double px = x / 10000.0, py = y / 10000.0, r = radius / 10000.0;
+    const int left = column(px - r), right = column(px + r);
+    const int top = row(py - r), bottom = row(py + r);
+    double dist[SLMAX];
+    int found = 0;
+    
+    for(int cy = top; cy <= bottom; cy++)
+    {
+        for(int cx = left; cx <= right; cx++)
+        {
+            const int c = cy * COLUMNS + cx;
+            
+            for(int k = cellStart[c]; k < cellStart[c + 1]; k++)
+            {
+                const int i = cellSprites[k];
+                const double dx = xs[i] - px, dy = ys[i] - py;
+                dist[i] = dx * dx + dy * dy;
+                
+                if(dist[i] <= r * r)
+                    results[found++] = i;
+            }
+        }
+    }
+    
+    std::sort(results, results + found, nearer(dist));
+    return found;
+}
+
+int SpatialIndex::inRect(const long x1, const long y1, const long x2, const long y2, int *results)
+{
+    update();
+    
+    const double left = zc_min(x1, x2) / 10000.0, right = zc_max(x1, x2) / 10000.0;
+    const double top = zc_min(y1, y2) / 10000.0, bottom = zc_max(y1, y2) / 10000.0;
+    int found = 0;
+    
+    for(int cy = row(top); cy <= row(bottom); cy++)
+    {
+        for(int cx = column(left); cx <= column(right); cx++)
+        {
+            const int c = cy * COLUMNS + cx;
+            
+            for(int k = cellStart[c]; k < cellStart[c + 1]; k++)
+            {
+                const int i = cellSprites[k];
+                
+                if(xs[i] >= left && xs[i] <= right && ys[i] >= top && ys[i] <= bottom)
+                    results[found++] = i;
+            }
+        }
+    }
+    
+    std::sort(results, results + found);
+    return found;
+}
+
+// The cells around the edge hold everything off the screen, so they can't be searched outwards
+// by distance; with at most SLMAX sprites a straight pass over the positions is quick enough.
+int SpatialIndex::nearest(const long x, const long y)
+{
+    update();
+    
+    const double px = x / 10000.0, py = y / 10000.0;
+    double best = 0;
+    int found = -1;
+    
+    for(int i = 0; i < count; i++)
+    {
+        const double dx = xs[i] - px, dy = ys[i] - py;
+        const double dist = dx * dx + dy * dy;
+        
+        if(found < 0 || dist < best)
+        {
+            best = dist;
+            found = i;
+        }
+    }
+    
+    return found;
+}
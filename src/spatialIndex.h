@@ -0,0 +1,50 @@
+//A grid of where the sprites in a sprite_list are, for the Screen->NPCsInRadius() family of
+//script functions. It's built the first time it's asked after invalidate(), so it costs nothing
+//when no script uses it. Sprites off the screen go in the cells around the edge.
+
+#ifndef _ZC_SPATIALINDEX_H_
+#define _ZC_SPATIALINDEX_H_
+
+#include "sprite.h"
+
+class SpatialIndex
+{
+public:
+    SpatialIndex(sprite_list &list);
+    
+    //Call whenever the sprites may have been added, removed or moved
+    void invalidate();
+    
+    //These take ZScript fixed point values and return indices into the list, in results,
+    //which must have room for SLMAX of them. They return how many were found.
+    
+    //Those with X and Y within radius of (x, y), nearest first
+    int inRadius(const long x, const long y, const long radius, int *results);
+    
+    //Those with X from x1 to x2 and Y from y1 to y2, in list order
+    int inRect(const long x1, const long y1, const long x2, const long y2, int *results);
+    
+    //The one nearest to (x, y), or -1 if the list is empty. Ties go to the lowest index.
+    int nearest(const long x, const long y);
+
+private:
+    enum { CELL_SIZE = 32, COLUMNS = 8, ROWS = 6, CELLS = COLUMNS * ROWS };
+    
+    sprite_list &list;
+    bool valid;
+    int count;
+    
+    //Positions as X and Y give them to scripts
+    int xs[SLMAX];
+    int ys[SLMAX];
+    
+    //The sprites in cell c are cellSprites[cellStart[c]] to cellSprites[cellStart[c+1]-1]
+    int cellStart[CELLS + 1];
+    int cellSprites[SLMAX];
+    
+    void update();
+    static int column(const double x);
+    static int row(const double y);
+};
+
+#endif
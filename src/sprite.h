@@ -117,6 +117,7 @@ public:
     inline bool isMarkedForDeletion() const { return toBeDeleted; }
     
     inline void setScriptData(EntityScriptData* esd) { scriptData=esd; }
+    inline EntityScriptData* getScriptData() { return scriptData; }
     asIScriptObject* getScriptObject();
     
 protected:
@@ -40,8 +40,128 @@ Array<*>{
 #ifndef __zc_array_h_
 #define __zc_array_h_
 
+#include <string.h>
+#include <vector>
+
 //#define _DEBUGZCARRAY
 
+// Storage for ZScript arrays. Scripts that make a temporary array every frame would otherwise
+// go through new[] and delete[] every frame, so freed blocks are kept by size and handed out
+// again. Each block keeps its size class in the element just before the array.
+class ZCArrayPool
+{
+public:
+    struct Stats
+    {
+        unsigned long allocations;
+        unsigned long reused; //Allocations that were given a kept block
+        unsigned long kept; //Blocks waiting to be reused
+    };
+    
+    static long *Allocate(const unsigned int size)
+    {
+        const int c = SizeClass(size);
+        Stats &stats = GetStats();
+        long *block;
+        
+        stats.allocations++;
+        
+        if(c == NUM_CLASSES) //Too big to bother keeping
+            block = new long[size + 1];
+        else if(!FreeLists()[c].empty())
+        {
+            block = FreeLists()[c].back();
+            FreeLists()[c].pop_back();
+            stats.reused++;
+            stats.kept--;
+        }
+        else
+            block = new long[(1 << c) + 1];
+            
+        block[0] = c;
+        return block + 1;
+    }
+    
+    static void Free(long *p)
+    {
+        long *block = p - 1;
+        
+        if(block[0] == NUM_CLASSES)
+            delete[] block;
+        else
+        {
+            FreeLists()[block[0]].push_back(block);
+            GetStats().kept++;
+        }
+    }
+    
+    static Stats &GetStats()
+    {
+        static Stats stats = { 0, 0, 0 };
+        return stats;
+    }
+    
+private:
+    enum { MIN_CLASS = 3, NUM_CLASSES = 17 }; //8 to 65536 elements
+    
+    static int SizeClass(const unsigned int size)
+    {
+        int c = MIN_CLASS;
+        
+        while(c < NUM_CLASSES && (1u << c) < size)
+            c++;
+            
+        return c;
+    }
+    
+    //Never destroyed, since global arrays are still being freed as the program exits
+    static std::vector<long *> *FreeLists()
+    {
+        static std::vector<long *> *lists = new std::vector<long *>[NUM_CLASSES];
+        return lists;
+    }
+};
+
+// Where a ZCArray gets its storage from
+template <typename T>
+struct ZCArrayStorage
+{
+    static T *Allocate(const unsigned int size)
+    {
+        return new T[size];
+    }
+    
+    static void Free(T *p)
+    {
+        delete[] p;
+    }
+    
+    static void Zero(T *p, const unsigned int size)
+    {
+        for(unsigned int i = 0; i < size; i++)
+            p[i] = T();
+    }
+};
+
+template <>
+struct ZCArrayStorage<long>
+{
+    static long *Allocate(const unsigned int size)
+    {
+        return ZCArrayPool::Allocate(size);
+    }
+    
+    static void Free(long *p)
+    {
+        ZCArrayPool::Free(p);
+    }
+    
+    static void Zero(long *p, const unsigned int size)
+    {
+        memset(p, 0, size * sizeof(long));
+    }
+};
+
 
 template <typename T>
 class ZCArray
@@ -275,6 +395,11 @@ public:
             _ptr[ i ] = _Val;
     }
     
+    void Zero()
+    {
+        ZCArrayStorage<T>::Zero(_ptr, _size);
+    }
+    
     void Resize(const size_type _Size)
     {
         Resize(0, 0, _Size);
@@ -365,14 +490,14 @@ protected:
 #endif
         }
         
-        _ptr = new type[ size ];
+        _ptr = ZCArrayStorage<T>::Allocate(size);
         _size = size;
     }
     
     void _ReAssign(const size_type _OldSize, const size_type _NewSize)
     {
         pointer _oldPtr = _ptr;
-        _ptr = new type[ _NewSize ];
+        _ptr = ZCArrayStorage<T>::Allocate(_NewSize);
         
         const size_type _copyRange = (_OldSize < _NewSize ? _OldSize : _NewSize);
         
@@ -386,7 +511,7 @@ protected:
     void _Delete()
     {
         if(_ptr)
-            delete [] _ptr;
+            ZCArrayStorage<T>::Free(_ptr);
             
         _ptr = NULL;
         
@@ -396,7 +521,7 @@ protected:
     void _Delete(pointer _Ptr)
     {
         if(_Ptr)
-            delete [] _Ptr;
+            ZCArrayStorage<T>::Free(_Ptr);
             
         _Ptr = NULL;
     }
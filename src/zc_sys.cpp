@@ -71,6 +71,9 @@
 #include "screenWipe.h"
 #include "sound.h"
 #include "mem_debug.h"
+#include "zscriptversion.h"
+#include "zscriptprofiler.h"
+#include "angelscript/aszc.h"
 
 int d_stringloader(int msg,DIALOG *d,int c);
 
@@ -368,6 +371,12 @@ void load_game_configs()
     sfxdat = get_config_int(cfg_sect,"use_sfx_dat",1);
     fullscreen = get_config_int(cfg_sect,"fullscreen",1);
     use_save_indicator = get_config_int(cfg_sect,"save_indicator",0);
+    ZScriptVersion::setThreaded(get_config_int(cfg_sect,"zasm_threaded",1)!=0);
+    zasm_optimize = get_config_int(cfg_sect,"zasm_optimize",1)!=0;
+    zasm_jit = get_config_int(cfg_sect,"zasm_jit",0)!=0;
+    zasm_jit_verify = get_config_int(cfg_sect,"zasm_jit_verify",0)!=0;
+    zasm_command_budget = vbound(get_config_int(cfg_sect,"zasm_command_budget",10000000), 0, INT_MAX);
+    setAngelScriptJIT(get_config_int(cfg_sect,"angelscript_jit",0)!=0);
 }
 
 void save_game_configs()
@@ -5026,6 +5035,54 @@ int onDebug()
     return D_O_K;
 }
 
+int onProfileScripts()
+{
+    if(debug_enabled)
+        ZScriptProfiler::setEnabled(!ZScriptProfiler::Enabled);
+        
+    return D_O_K;
+}
+
+int onWriteScriptProfile()
+{
+    if(debug_enabled)
+        ZScriptProfiler::write("zscript_profile.csv");
+        
+    return D_O_K;
+}
+
+int onClearScriptProfile()
+{
+    if(debug_enabled)
+        ZScriptProfiler::reset();
+        
+    return D_O_K;
+}
+
+int onBenchmarkItemScripts()
+{
+    if(debug_enabled)
+        benchmark_item_scripts();
+    
+    return D_O_K;
+}
+
+int onBenchmarkWeaponScripts()
+{
+    if(debug_enabled)
+        benchmarkWeaponScripts();
+    
+    return D_O_K;
+}
+
+int onBenchmarkEnemyScripts()
+{
+    if(debug_enabled)
+        benchmarkEnemyScripts();
+    
+    return D_O_K;
+}
+
 int onHeartBeep()
 {
     heart_beep=!heart_beep;
@@ -5405,6 +5462,17 @@ static MENU name_entry_mode_menu[] =
     { NULL,                                 NULL,                    NULL,                      0, NULL }
 };
 
+static MENU script_profiler_menu[] =
+{
+    { (char *)"&Profile Scripts",           onProfileScripts,        NULL,                      0, NULL },
+    { (char *)"&Write Profile",             onWriteScriptProfile,    NULL,                      0, NULL },
+    { (char *)"&Clear Profile",             onClearScriptProfile,    NULL,                      0, NULL },
+    { (char *)"&Benchmark Item Scripts",    onBenchmarkItemScripts,  NULL,                      0, NULL },
+    { (char *)"Benchmark &Weapon Scripts",  onBenchmarkWeaponScripts, NULL,                     0, NULL },
+    { (char *)"Benchmark &Enemy Scripts",   onBenchmarkEnemyScripts, NULL,                      0, NULL },
+    { NULL,                                 NULL,                    NULL,                      0, NULL }
+};
+
 static MENU settings_menu[] =
 {
     { (char *)"C&ontrols",                  NULL,                    controls_menu,             0, NULL },
@@ -5424,6 +5492,7 @@ static MENU settings_menu[] =
     { (char *)"S&napshot Format",           NULL,                    snapshot_format_menu,      0, NULL },
     { (char *)"",                           NULL,                    NULL,                      0, NULL },
     { (char *)"Debu&g",                     onDebug,                 NULL,                      0, NULL },
+    { (char *)"Script &Profiler",           NULL,                    script_profiler_menu,      0, NULL },
     { NULL,                                 NULL,                    NULL,                      0, NULL }
 };
 
@@ -6387,6 +6456,7 @@ void System()
         if(debug_enabled)
         {
             settings_menu[16].flags = get_debug() ? D_SELECTED : 0;
+            script_profiler_menu[0].flags = ZScriptProfiler::Enabled ? D_SELECTED : 0;
         }
         
         if(gui_mouse_b() && !mouse_down)
@@ -15,7 +15,6 @@
 //Conditional Debugging Compilation
 //Script related
 #define _FFDEBUG
-//#define _SCRIPT_COUNTER
 //#define _FFDISSASSEMBLY
 //#define _FFONESCRIPTDISSASSEMBLY
 
@@ -601,6 +600,8 @@ enum
     // 19
     qr_SMASWIPE, qr_NOSOLIDDAMAGECOMBOS /* Compatibility */, qr_SHOPCHEAT, qr_HOOKSHOTDOWNBUG /* Compatibility */,
     qr_OLDHOOKSHOTGRAB /* Compatibility */, qr_PEAHATCLOCKVULN /* Compatibility */, qr_VERYFASTSCROLLING, qr_OFFSCREENWEAPONS /* Compatibility */,
+    // 20
+    qr_KILLRUNAWAYSCRIPTS,
     qr_MAX
 };
 
@@ -1370,12 +1371,14 @@ struct mapscr
     FFC* getFFC(int index) { return ffcs.getPtr(index); }
 };
 
+// One ZASM command as it's kept in memory; 12 bytes, even where long is 64 bits. The quest file
+// still stores the arguments as longs. If a command ever needs a string, it should go in a table
+// of its own indexed by command number rather than in here.
 struct ffscript
 {
     word command;
-    long arg1;
-    long arg2;
-    char *ptr;
+    int arg1;
+    int arg2;
 };
 
 
@@ -49,6 +49,7 @@
 #include "zc_malloc.h"
 #include "mem_debug.h"
 #include "zscriptversion.h"
+#include "zscriptprofiler.h"
 #include "zcmusic.h"
 #include "zdefs.h"
 #include "zelda.h"
@@ -142,15 +143,6 @@ void update_logic_counter()
 }
 END_OF_FUNCTION(update_logic_counter)
 
-#ifdef _SCRIPT_COUNTER
-volatile int script_counter=0;
-void update_script_counter()
-{
-    ++script_counter;
-}
-END_OF_FUNCTION(update_script_counter)
-#endif
-
 
 void zcUSecSleep(int microseconds)
 {
@@ -397,6 +389,11 @@ void setZScriptVersion(int s_version)
     ZScriptVersion::setVersion(s_version);
 }
 
+void decodeZScripts()
+{
+    decode_scripts();
+}
+
 void initZScriptArrayRAM(bool firstplay)
 {
     for(word i = 0; i < MAX_ZCARRAY_SIZE; i++)
@@ -405,6 +402,9 @@ void initZScriptArrayRAM(bool firstplay)
         arrayOwner[i]=255;
     }
     
+    clearLocalArraySlots();
+    clearGlobalArraySlots();
+    
     if(game->globalRAM.size() != 0)
         game->globalRAM.clear();
         
@@ -588,10 +588,7 @@ void Z_eventlog(const char *format,...)
         va_start(ap, format);
         vsprintf(buf, format, ap);
         va_end(ap);
-        al_trace("%s",buf);
-        
-        if(zconsole)
-            printf("%s",buf);
+        zc_trace_console(buf);
     }
 }
 
@@ -627,10 +624,7 @@ void Z_scripterrlog(const char * const format,...)
         va_start(ap, format);
         vsprintf(buf, format, ap);
         va_end(ap);
-        al_trace("%s",buf);
-        
-        if(zconsole)
-            printf("%s",buf);
+        zc_trace_console(buf);
     }
 }
 
@@ -1543,6 +1537,12 @@ void show_ffscript_names()
             ypos+=12;
         }
     }
+    
+    // How much the script arrays are being allocated, and how often that reuses a freed block
+    const ZCArrayPool::Stats &stats = ZCArrayPool::GetStats();
+    char buf[80];
+    sprintf(buf, "Arrays: %d local, %lu allocs, %lu reused", localArrayCount(), stats.allocations, stats.reused);
+    textout_shadowed_ex(framebuf,font,buf,2,ypos,WHITE,BLACK,-1);
 }
 
 void do_dcounters()
@@ -2166,6 +2166,9 @@ int main(int argc, char* argv[])
         quit_game();
     }
     
+    // From here on allegro.log is written in the background, so tracing doesn't hold up the game
+    zc_trace_start_async();
+    
     three_finger_flag=false;
     //atexit(&dumb_exit);
     //dumb_register_stdfiles();
@@ -2229,12 +2232,6 @@ int main(int argc, char* argv[])
     LOCK_FUNCTION(update_logic_counter);
     install_int_ex(update_logic_counter, BPS_TO_TIMER(60));
     
-#ifdef _SCRIPT_COUNTER
-    LOCK_VARIABLE(script_counter);
-    LOCK_FUNCTION(update_script_counter);
-    install_int_ex(update_script_counter, 1);
-#endif
-    
     if(!Z_init_timers())
     {
         Z_error("Couldn't Allocate Timers");
@@ -2373,6 +2370,9 @@ int main(int argc, char* argv[])
     debug_enabled = used_switch(argc,argv,"-d") && !strcmp(get_config_string("zeldadx","debug",""),zeldapwd);
     set_debug(debug_enabled);
     
+    if(used_switch(argc,argv,"-scriptprofile"))
+        ZScriptProfiler::setEnabled(true);
+        
     skipicon = standalone_mode || used_switch(argc,argv,"-quickload");
     
     int load_save=0;
@@ -2962,6 +2962,10 @@ quick_quit:
     show_saving(screen);
     save_savedgames();
     save_game_configs();
+    
+    if(ZScriptProfiler::hasData())
+        ZScriptProfiler::write("zscript_profile.csv");
+        
     Triplebuffer.Destroy();
     set_gfx_mode(GFX_TEXT,80,25,0,0);
     //rest(250); // ???
@@ -2988,10 +2992,6 @@ void remove_installed_timers()
     al_trace("Removing timers. \n");
     remove_int(update_logic_counter);
     Z_remove_timers();
-#ifdef _SCRIPT_COUNTER
-    remove_int(update_script_counter);
-#endif
-    
 }
 
 
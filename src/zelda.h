@@ -229,9 +229,6 @@ extern short    lensclk;
 extern int     lensid;
 extern int    Bpos;
 extern volatile int logic_counter;
-#ifdef _SCRIPT_COUNTER
-extern volatile int script_counter;
-#endif
 extern bool halt;
 extern bool screenscrolling;
 extern bool close_button_quit;
@@ -243,10 +240,6 @@ extern byte frame_rest_suggest, forceExit, zc_vsync;
 extern byte zc_color_depth;
 extern byte use_debug_console, use_win32_proc; //windows only
 
-#ifdef _SCRIPT_COUNTER
-void update_script_counter();
-#endif
-
 extern PALETTE tempbombpal;
 extern bool usebombpal;
 
@@ -46,6 +46,7 @@
 #include "zc_alleg.h"
 #include "mem_debug.h"
 void setZScriptVersion(int) { } //bleh...
+void decodeZScripts() { }
 
 #include <png.h>
 #include <pngconf.h>
@@ -18357,6 +18358,9 @@ void compileZScript()
     fclose(tempfile);
     box_start(1, "Compile Progress", lfont, sfont,true);
     gotoless_not_equal = (0 != get_bit(quest_rules, qr_GOTOLESSNOTEQUAL)); // Used by BuildVisitors.cpp
+    ScriptParser::setOptimizing(get_config_int("zquest","optimize_zscript",1) != 0);
+    ScriptParser::setThreads(get_config_int("zquest","zscript_threads",1));
+    ScriptParser::setImportCacheFile(get_config_string("zquest","zscript_import_cache","zscript_imports.cache"));
     ScriptsData *result = compile("tmp");
     unlink("tmp");
     box_end(true);
@@ -18457,34 +18461,19 @@ void compileZScript()
             {
                 if(it->second.second != "")
                 {
-                    tempfile = fopen("tmp","w");
-                    
-                    if(!tempfile)
-                    {
-                        jwin_alert("Error","Unable to create a temporary file in current directory!",NULL,NULL,"O&K",NULL,'k',0,lfont);
-                        return;
-                    }
-                    
                     if(output)
                     {
                         al_trace("\n");
                         al_trace("%s",it->second.second.c_str());
                         al_trace("\n");
-                    }
-                    
-                    for(std::vector<Opcode *>::iterator line = scripts[it->second.second].begin(); line != scripts[it->second.second].end(); line++)
-                    {
-                        std::string theline = (*line)->printLine();
-                        fwrite(theline.c_str(), sizeof(char), theline.size(),tempfile);
                         
-                        if(output)
+                        for(std::vector<Opcode *>::iterator line = scripts[it->second.second].begin(); line != scripts[it->second.second].end(); line++)
                         {
-                            al_trace("%s",theline.c_str());
+                            al_trace("%s",(*line)->printLine().c_str());
                         }
                     }
                     
-                    fclose(tempfile);
-                    parse_script_file(&ffscripts[it->first+1],"tmp",false);
+                    load_compiled_script(&ffscripts[it->first+1],scripts[it->second.second],it->second.second.c_str());
                 }
                 else if(ffscripts[it->first+1])
                 {
@@ -18498,34 +18487,19 @@ void compileZScript()
             {
                 if(it->second.second != "")
                 {
-                    tempfile = fopen("tmp","w");
-                    
-                    if(!tempfile)
-                    {
-                        jwin_alert("Error","Unable to create a temporary file in current directory!",NULL,NULL,"O&K",NULL,'k',0,lfont);
-                        return;
-                    }
-                    
                     if(output)
                     {
                         al_trace("\n");
                         al_trace("%s",it->second.second.c_str());
                         al_trace("\n");
-                    }
-                    
-                    for(std::vector<Opcode *>::iterator line = scripts[it->second.second].begin(); line != scripts[it->second.second].end(); line++)
-                    {
-                        std::string theline = (*line)->printLine();
-                        fwrite(theline.c_str(), sizeof(char), theline.size(),tempfile);
                         
-                        if(output)
+                        for(std::vector<Opcode *>::iterator line = scripts[it->second.second].begin(); line != scripts[it->second.second].end(); line++)
                         {
-                            al_trace("%s",theline.c_str());
+                            al_trace("%s",(*line)->printLine().c_str());
                         }
                     }
                     
-                    fclose(tempfile);
-                    parse_script_file(&globalscripts[it->first],"tmp",false);
+                    load_compiled_script(&globalscripts[it->first],scripts[it->second.second],it->second.second.c_str());
                 }
                 else if(globalscripts[it->first])
                 {
@@ -18539,34 +18513,19 @@ void compileZScript()
             {
                 if(it->second.second != "")
                 {
-                    tempfile = fopen("tmp","w");
-                    
-                    if(!tempfile)
-                    {
-                        jwin_alert("Error","Unable to create a temporary file in current directory!",NULL,NULL,"O&K",NULL,'k',0,lfont);
-                        return;
-                    }
-                    
                     if(output)
                     {
                         al_trace("\n");
                         al_trace("%s",it->second.second.c_str());
                         al_trace("\n");
-                    }
-                    
-                    for(std::vector<Opcode *>::iterator line = scripts[it->second.second].begin(); line != scripts[it->second.second].end(); line++)
-                    {
-                        std::string theline = (*line)->printLine();
-                        fwrite(theline.c_str(), sizeof(char), theline.size(),tempfile);
                         
-                        if(output)
+                        for(std::vector<Opcode *>::iterator line = scripts[it->second.second].begin(); line != scripts[it->second.second].end(); line++)
                         {
-                            al_trace("%s",theline.c_str());
+                            al_trace("%s",(*line)->printLine().c_str());
                         }
                     }
                     
-                    fclose(tempfile);
-                    parse_script_file(&itemscripts[it->first+1],"tmp",false);
+                    load_compiled_script(&itemscripts[it->first+1],scripts[it->second.second],it->second.second.c_str());
                 }
                 else if(itemscripts[it->first+1])
                 {
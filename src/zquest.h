@@ -66,6 +66,7 @@ extern bool disable_saving, OverwriteProtection;
 extern int zq_scale, TileProtection;
 
 void setZScriptVersion(int); //Intentionally does nothing >_<
+void decodeZScripts(); //Likewise
 
 enum
 {
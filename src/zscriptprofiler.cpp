@@ -0,0 +1,268 @@
+// This program is free software; you can redistribute it and/or modify it under the terms of the
+// modified version 3 of the GNU General Public License. See License.txt for details.
+
+
+#include "precompiled.h" //always first
+
+#include <stdio.h>
+#include <string.h>
+#include <map>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "zc_alleg.h"
+#include "zscriptprofiler.h"
+#include "ffscript.h"
+#include "ffdebug.h"
+#include "zsys.h"
+
+#ifdef ALLEGRO_MACOSX
+#include <mach/mach_time.h>
+#elif !defined(ALLEGRO_WINDOWS)
+#include <time.h>
+#endif
+
+extern std::map<int, std::pair<std::string, std::string> > ffcmap;
+extern std::map<int, std::pair<std::string, std::string> > globalmap;
+extern std::map<int, std::pair<std::string, std::string> > itemmap;
+
+bool ZScriptProfiler::Enabled = false;
+unsigned long long ZScriptProfiler::CommandCount[NUMCOMMANDS];
+unsigned long long ZScriptProfiler::CommandTicks[NUMCOMMANDS];
+
+struct script_profile
+{
+    unsigned long long runs;
+    unsigned long long commands;
+    unsigned long long ticks;
+    word script; //Only used by the FFCs; the script the FFC ran last
+};
+
+static script_profile ffc_profile[NUMSCRIPTFFC];
+static script_profile item_profile[NUMSCRIPTITEM];
+static script_profile global_profile[NUMSCRIPTGLOBAL];
+static script_profile ffc_index_profile[MAXFFCS];
+
+void ZScriptProfiler::setEnabled(bool enabled)
+{
+    Enabled = enabled;
+    al_trace("ZScript profiler %s\n", enabled ? "on" : "off");
+}
+
+unsigned long long ZScriptProfiler::now()
+{
+#if defined(ALLEGRO_WINDOWS)
+    LARGE_INTEGER count;
+    QueryPerformanceCounter(&count);
+    return count.QuadPart;
+#elif defined(ALLEGRO_MACOSX)
+    return mach_absolute_time();
+#elif defined(ALLEGRO_LINUX)
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#else
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (unsigned long long)tv.tv_sec * 1000000ULL + tv.tv_usec;
+#endif
+}
+
+unsigned long long ZScriptProfiler::ticksPerSecond()
+{
+#if defined(ALLEGRO_WINDOWS)
+    LARGE_INTEGER freq;
+    QueryPerformanceFrequency(&freq);
+    return freq.QuadPart;
+#elif defined(ALLEGRO_MACOSX)
+    mach_timebase_info_data_t info;
+    mach_timebase_info(&info);
+    return (1000000000ULL * info.denom) / info.numer;
+#elif defined(ALLEGRO_LINUX)
+    return 1000000000ULL;
+#else
+    return 1000000ULL;
+#endif
+}
+
+void ZScriptProfiler::recordScript(const byte type, const word script, const byte i, const dword commands, const unsigned long long ticks)
+{
+    script_profile *p;
+    
+    switch(type)
+    {
+    case SCRIPT_FFC:
+        if(script >= NUMSCRIPTFFC)
+            return;
+        
+        p = &ffc_profile[script];
+        
+        if(i < MAXFFCS)
+        {
+            ffc_index_profile[i].runs++;
+            ffc_index_profile[i].commands += commands;
+            ffc_index_profile[i].ticks += ticks;
+            ffc_index_profile[i].script = script;
+        }
+        
+        break;
+    
+    case SCRIPT_ITEM:
+        if(script >= NUMSCRIPTITEM)
+            return;
+        
+        p = &item_profile[script];
+        break;
+    
+    case SCRIPT_GLOBAL:
+        if(script >= NUMSCRIPTGLOBAL)
+            return;
+        
+        p = &global_profile[script];
+        break;
+    
+    default:
+        return;
+    }
+    
+    p->runs++;
+    p->commands += commands;
+    p->ticks += ticks;
+}
+
+bool ZScriptProfiler::hasData()
+{
+    for(int j = 0; j < NUMCOMMANDS; j++)
+    {
+        if(CommandCount[j])
+            return true;
+    }
+    
+    return false;
+}
+
+void ZScriptProfiler::reset()
+{
+    memset(CommandCount, 0, sizeof(CommandCount));
+    memset(CommandTicks, 0, sizeof(CommandTicks));
+    memset(ffc_profile, 0, sizeof(ffc_profile));
+    memset(item_profile, 0, sizeof(item_profile));
+    memset(global_profile, 0, sizeof(global_profile));
+    memset(ffc_index_profile, 0, sizeof(ffc_index_profile));
+}
+
+// One line of the CSV
+struct profile_row
+{
+    const char *kind;
+    int slot;
+    std::string name;
+    unsigned long long runs;
+    unsigned long long commands;
+    unsigned long long ticks;
+};
+
+static bool slower(const profile_row &a, const profile_row &b)
+{
+    return a.ticks > b.ticks;
+}
+
+static std::string script_name(std::map<int, std::pair<std::string, std::string> > &names, const int slot)
+{
+    std::map<int, std::pair<std::string, std::string> >::const_iterator it = names.find(slot);
+    return (it != names.end()) ? it->second.second : std::string();
+}
+
+static void add_scripts(std::vector<profile_row> &rows, const char *kind, const script_profile *profile, const int count,
+                        std::map<int, std::pair<std::string, std::string> > &names, const int offset)
+{
+    for(int j = 0; j < count; j++)
+    {
+        if(!profile[j].runs)
+            continue;
+        
+        profile_row row = { kind, j + offset, script_name(names, j + offset - 1), profile[j].runs, profile[j].commands, profile[j].ticks };
+        rows.push_back(row);
+    }
+}
+
+static void write_rows(FILE *f, std::vector<profile_row> &rows, const double ticks_per_us, const unsigned long long total)
+{
+    std::stable_sort(rows.begin(), rows.end(), slower);
+    
+    for(unsigned int j = 0; j < rows.size(); j++)
+    {
+        std::string name = rows[j].name;
+        
+        //Double up any quotes so the name can be quoted
+        for(std::string::size_type q = name.find('"'); q != std::string::npos; q = name.find('"', q + 2))
+            name.insert(q, 1, '"');
+        
+        fprintf(f, "%s,%d,\"%s\",%.0f,%.0f,%.3f,%.2f\n", rows[j].kind, rows[j].slot, name.c_str(),
+                double(rows[j].runs), double(rows[j].commands), rows[j].ticks / ticks_per_us,
+                total ? (rows[j].ticks * 100.0) / total : 0.0);
+    }
+}
+
+// Commands first, then scripts by slot, then the FFCs they ran on; each slowest first
+bool ZScriptProfiler::write(const char *filename)
+{
+    FILE *f = fopen(filename, "w");
+    
+    if(!f)
+    {
+        al_trace("Couldn't write the ZScript profile to %s\n", filename);
+        return false;
+    }
+    
+    const double ticks_per_us = ticksPerSecond() / 1000000.0;
+    unsigned long long total = 0;
+    
+    for(int j = 0; j < NUMCOMMANDS; j++)
+        total += CommandTicks[j];
+    
+    fprintf(f, "type,slot,name,runs,commands,microseconds,percent\n");
+    
+    std::vector<profile_row> rows;
+    
+    for(int j = 0; j < NUMCOMMANDS; j++)
+    {
+        if(!CommandCount[j])
+            continue;
+        
+        profile_row row = { "command", j, ffdebug::command_list[j].name, CommandCount[j], CommandCount[j], CommandTicks[j] };
+        rows.push_back(row);
+    }
+    
+    write_rows(f, rows, ticks_per_us, total);
+    
+    //Global scripts are named by slot, the others by script number (see Z_scripterrlog)
+    rows.clear();
+    add_scripts(rows, "ffc script", ffc_profile, NUMSCRIPTFFC, ffcmap, 0);
+    add_scripts(rows, "item script", item_profile, NUMSCRIPTITEM, itemmap, 0);
+    add_scripts(rows, "global script", global_profile, NUMSCRIPTGLOBAL, globalmap, 1);
+    write_rows(f, rows, ticks_per_us, total);
+    
+    rows.clear();
+    
+    for(int j = 0; j < MAXFFCS; j++)
+    {
+        if(!ffc_index_profile[j].runs)
+            continue;
+        
+        //Named after the script it ran last
+        const word script = ffc_index_profile[j].script;
+        char name[16];
+        sprintf(name, "%u: ", script);
+        profile_row row = { "ffc", j + 1, name + script_name(ffcmap, script - 1), ffc_index_profile[j].runs,
+                            ffc_index_profile[j].commands, ffc_index_profile[j].ticks
+                          };
+        rows.push_back(row);
+    }
+    
+    write_rows(f, rows, ticks_per_us, total);
+    
+    fclose(f);
+    al_trace("ZScript profile written to %s\n", filename);
+    return true;
+}
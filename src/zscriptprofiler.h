@@ -0,0 +1,42 @@
+//Counts how many ZASM commands each script runs and how long they take, so that
+//the scripts eating up the frame can be found. Turned on with -scriptprofile or
+//from the debug menu, and written out as a CSV on exit or when asked.
+
+#ifndef _ZSCRIPTPROFILER_H
+#define _ZSCRIPTPROFILER_H
+
+#include "ffscript.h"
+
+class ZScriptProfiler
+{
+public:
+    static bool Enabled;
+    
+    static void setEnabled(bool enabled);
+    
+    //High resolution timestamp, in ticks of ticksPerSecond()
+    static unsigned long long now();
+    static unsigned long long ticksPerSecond();
+    
+    static inline void recordCommand(const word command, const unsigned long long ticks)
+    {
+        if(command < NUMCOMMANDS)
+        {
+            CommandCount[command]++;
+            CommandTicks[command] += ticks;
+        }
+    }
+    
+    //Once at the end of each run, with the totals of the commands it ran
+    static void recordScript(const byte type, const word script, const byte i, const dword commands, const unsigned long long ticks);
+    
+    static bool hasData();
+    static void reset();
+    static bool write(const char *filename);
+
+private:
+    static unsigned long long CommandCount[NUMCOMMANDS];
+    static unsigned long long CommandTicks[NUMCOMMANDS];
+};
+
+#endif
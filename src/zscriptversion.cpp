@@ -10,9 +10,10 @@
 
 extern LinkClass Link;
 
-int (*ZScriptVersion::Interpreter)(const byte, const word, const byte) = &run_script;
+int (*ZScriptVersion::Interpreter)(const byte, const word, const byte) = &run_script_threaded;
 void (*ZScriptVersion::onScrolling)(int, int, int, int, bool) = &ScrollingScript;
 int    ZScriptVersion::CurrentVersion = V_FFSCRIPT; //Set to current version by default
+bool   ZScriptVersion::Threaded = true;
 
 void ZScriptVersion::ScrollingScript(int scrolldir, int cx, int sx, int sy, bool end_frames)
 {
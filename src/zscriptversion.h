@@ -20,18 +20,31 @@ public:
         if(CurrentVersion < 6) //Old ZScript
         {
             onScrolling = &NullScrollingScript;
-            Interpreter = &run_script;
+            Interpreter = Threaded ? &run_script_threaded : &run_script;
         }
         else
         {
             onScrolling = &ScrollingScript;
+            Interpreter = Threaded ? &run_script_threaded : &run_script;
             //Watch this space...
         }
     }
     
+    //The threaded interpreter is used unless this is turned off; the old one is
+    //kept around so that the two can be compared command for command
+    static inline void setThreaded(bool threaded)
+    {
+        Threaded = threaded;
+        setVersion(CurrentVersion);
+    }
+    
     //Only one if check at quest load, rather than each time we use the function
     static inline int RunScript(const byte type, const word script, const byte i = -1)
     {
+        //A script waiting out a WAITFRAMESR isn't run at all until it's done
+        if(script_sleeping(type, i))
+            return 0;
+            
         return (*Interpreter)(type, script, i);
     }
     
@@ -42,6 +55,7 @@ public:
     
 private:
     static int CurrentVersion;
+    static bool Threaded;
     static int (*Interpreter)(const byte, const word, const byte);
     static void (*onScrolling)(int, int, int, int, bool);
     
@@ -39,11 +39,19 @@
 #include <conio.h>
 #endif
 
+#ifdef ALLEGRO_WINDOWS
+#include <winalleg.h>
+#else
+#include <signal.h>
+#include <unistd.h>
+#endif
+
 #include "zdefs.h"
 #include "zsys.h"
 #include "zc_sys.h"
 #include "jwin.h"
 #include "mem_debug.h"
+#include "mutex.h"
 
 #ifdef _MSC_VER
 #define stricmp _stricmp
@@ -344,10 +352,7 @@ void Z_message(const char *format,...)
 #if defined(ALLEGRO_DOS ) || defined(ALLEGRO_MAXOSX)
     printf("%s",buf);
 #endif
-    al_trace("%s",buf);
-    
-    if(zconsole)
-        printf("%s",buf);
+    zc_trace_console(buf);
 }
 
 void Z_title(const char *format,...)
@@ -389,11 +394,8 @@ void Z_title(const char *format,...)
     }
     
 #else
-    al_trace("%s\n",buf);
-    
-    if(zconsole)
-        printf("%s\n",buf);
-    
+    zc_trace_console(buf);
+    zc_trace_console("\n");
 #endif
 }
 
@@ -1892,7 +1894,30 @@ int lcm(int a, int b)
 
 FILE * trace_file;
 
-int zc_trace_handler(const char * msg)
+//Once zc_trace_start_async() is called, messages go in a ring buffer and a background thread writes
+//them out, so the game never waits on the disk or the console. Each one is stored as two bytes of
+//length, a byte saying whether it's for the console too, and the text. Only the writer moves
+//trace_tail and only the (locked) adders move trace_head, so the writer never takes a lock
+//to read the buffer; trace_write_lock is held by whoever's writing, the thread or otherwise.
+#define TRACE_RING_SIZE 262144
+#define TRACE_HEADER    3
+
+static char trace_ring[TRACE_RING_SIZE];
+static volatile dword trace_head = 0;
+static volatile dword trace_tail = 0;
+static volatile dword trace_dropped = 0;
+static dword trace_dropped_written = 0;
+static volatile bool trace_async = false;
+static mutex trace_add_lock;
+static mutex trace_write_lock;
+
+#ifdef _WIN32
+#define trace_barrier() MemoryBarrier()
+#else
+#define trace_barrier() __sync_synchronize()
+#endif
+
+static void trace_write(const char *msg, const bool console)
 {
     if(trace_file == 0)
     {
@@ -1900,17 +1925,241 @@ int zc_trace_handler(const char * msg)
         
         if(0==trace_file)
         {
-            return 0; // blargh.
+            return; // blargh.
+        }
+    }
+    
+    fputs(msg, trace_file);
+    
+    if(console && zconsole)
+        printf("%s", msg);
+}
+
+static void trace_add(const char *msg, const bool console)
+{
+    const dword len = zc_min(strlen(msg), size_t(65535));
+    
+    mutex_lock(&trace_add_lock);
+    
+    const dword head = trace_head;
+    
+    if(head - trace_tail + TRACE_HEADER + len > TRACE_RING_SIZE)
+    {
+        trace_dropped++;
+        mutex_unlock(&trace_add_lock);
+        return;
+    }
+    
+    const char header[TRACE_HEADER] = { char(len & 0xFF), char(len >> 8), char(console) };
+    
+    for(dword k = 0; k < TRACE_HEADER + len; k++)
+        trace_ring[(head + k) % TRACE_RING_SIZE] = k < TRACE_HEADER ? header[k] : msg[k - TRACE_HEADER];
+        
+    trace_barrier();
+    trace_head = head + TRACE_HEADER + len;
+    mutex_unlock(&trace_add_lock);
+}
+
+// Writes out what's in the buffer; the caller holds trace_write_lock
+static void trace_drain()
+{
+    static char msg[65536];
+    const dword head = trace_head;
+    dword tail = trace_tail;
+    
+    if(tail == head && trace_dropped == trace_dropped_written)
+        return;
+        
+    trace_barrier();
+    
+    while(tail != head)
+    {
+        const dword len = byte(trace_ring[tail % TRACE_RING_SIZE]) | (byte(trace_ring[(tail + 1) % TRACE_RING_SIZE]) << 8);
+        const bool console = trace_ring[(tail + 2) % TRACE_RING_SIZE] != 0;
+        
+        for(dword k = 0; k < len; k++)
+            msg[k] = trace_ring[(tail + TRACE_HEADER + k) % TRACE_RING_SIZE];
+            
+        msg[len] = 0;
+        trace_write(msg, console);
+        tail += TRACE_HEADER + len;
+    }
+    
+    trace_barrier();
+    trace_tail = tail;
+    
+    if(trace_dropped != trace_dropped_written)
+    {
+        sprintf(msg, "(%lu messages dropped, the log couldn't keep up)\n", (unsigned long)(trace_dropped - trace_dropped_written));
+        trace_dropped_written = trace_dropped;
+        trace_write(msg, true);
+    }
+    
+    if(trace_file)
+        fflush(trace_file);
+}
+
+#ifdef _WIN32
+static DWORD WINAPI trace_thread(LPVOID)
+#else
+static void *trace_thread(void *)
+#endif
+{
+    while(trace_async)
+    {
+        mutex_lock(&trace_write_lock);
+        
+        if(trace_async)
+            trace_drain();
+            
+        mutex_unlock(&trace_write_lock);
+        
+#ifdef _WIN32
+        Sleep(10);
+#else
+        usleep(10000);
+#endif
+    }
+    
+    return 0;
+}
+
+//Get what we can into the log before going down. The writer only holds the lock for as long
+//as a drain takes, so if it can't be had in half a second, something's stuck (perhaps this
+//thread crashed while writing) and it's better to lose the log than to write it twice.
+//Afterwards the writer stops and anything else goes straight to the file.
+static void trace_crash_drain()
+{
+    if(!trace_async)
+        return;
+        
+    for(int k = 0; k < 50; k++)
+    {
+        if(mutex_trylock(&trace_write_lock))
+        {
+            trace_drain();
+            trace_async = false;
+            mutex_unlock(&trace_write_lock);
+            return;
         }
+        
+#ifdef _WIN32
+        Sleep(10);
+#else
+        usleep(10000);
+#endif
     }
+}
+
+#ifdef _WIN32
+static LONG WINAPI trace_crash(EXCEPTION_POINTERS *)
+{
+    trace_crash_drain();
+    return EXCEPTION_CONTINUE_SEARCH;
+}
+#else
+static void (*trace_old_handlers[NSIG])(int);
+
+static void trace_crash(int sig)
+{
+    trace_crash_drain();
+    signal(sig, trace_old_handlers[sig] == SIG_ERR ? SIG_DFL : trace_old_handlers[sig]);
+    raise(sig);
+}
+#endif
+
+//The thread is left to stop by itself, but it mustn't write anything once we've gone
+static void trace_exit()
+{
+    mutex_lock(&trace_write_lock);
+    trace_drain();
+    trace_async = false;
+    mutex_unlock(&trace_write_lock);
+}
+
+void zc_trace_start_async()
+{
+    if(trace_async)
+        return;
+        
+    mutex_init(&trace_add_lock);
+    mutex_init(&trace_write_lock);
+    trace_async = true;
+    
+#ifdef _WIN32
+    HANDLE thread = CreateThread(NULL, 0, trace_thread, NULL, 0, NULL);
     
-    fprintf(trace_file, "%s", msg);
+    if(!thread)
+    {
+        trace_async = false;
+        return;
+    }
+    
+    CloseHandle(thread);
+    SetUnhandledExceptionFilter(trace_crash);
+#else
+    pthread_t thread;
+    
+    if(pthread_create(&thread, NULL, trace_thread, NULL) != 0)
+    {
+        trace_async = false;
+        return;
+    }
+    
+    pthread_detach(thread);
+    
+    //After allegro_init(), so Allegro's handlers are still called afterwards
+    const int sigs[] = { SIGSEGV, SIGABRT, SIGFPE, SIGILL, SIGBUS };
+    
+    for(int k = 0; k < 5; k++)
+        trace_old_handlers[sigs[k]] = signal(sigs[k], trace_crash);
+        
+#endif
+    
+    atexit(trace_exit);
+}
+
+int zc_trace_handler(const char * msg)
+{
+    if(trace_async)
+    {
+        trace_add(msg, false);
+        return 1;
+    }
+    
+    trace_write(msg, false);
+    
+    if(!trace_file)
+        return 0;
+        
     fflush(trace_file);
     return 1;
 }
 
+void zc_trace_console(const char *msg)
+{
+    if(trace_async)
+        trace_add(msg, true);
+    else
+    {
+        al_trace("%s", msg);
+        
+        if(zconsole)
+            printf("%s", msg);
+    }
+}
+
 void zc_trace_clear()
 {
+    if(trace_async)
+    {
+        //Anything still waiting was meant for the old log
+        mutex_lock(&trace_write_lock);
+        mutex_lock(&trace_add_lock);
+        trace_tail = trace_head;
+        mutex_unlock(&trace_add_lock);
+    }
+    
     if(trace_file)
     {
         fclose(trace_file);
@@ -1918,5 +2167,8 @@ void zc_trace_clear()
     
     trace_file = fopen("allegro.log", "w");
     ASSERT(trace_file);
+    
+    if(trace_async)
+        mutex_unlock(&trace_write_lock);
 }
 
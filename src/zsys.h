@@ -173,6 +173,8 @@ void quit_game();
 
 int zc_trace_handler(const char *);
 void zc_trace_clear();
+void zc_trace_console(const char *msg); //To allegro.log, and the console if it's open
+void zc_trace_start_async(); //Hands writing the log over to a background thread
 
 extern bool zconsole;
 